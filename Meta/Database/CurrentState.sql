@@ -32,6 +32,13 @@ CREATE TABLE IF NOT EXISTS "Migration" (
 	"AppliedAt"	INTEGER NOT NULL DEFAULT (unixepoch()),
 	PRIMARY KEY("Version")
 );
+CREATE TABLE IF NOT EXISTS "ResolvedHost" (
+	"Family"	INTEGER NOT NULL CHECK("Family" IN (4, 6)),
+	"IPAddress"	BLOB NOT NULL,
+	"Hostname"	TEXT NOT NULL,
+	"ExpiresAt"	INTEGER NOT NULL,
+	PRIMARY KEY("Family","IPAddress")
+);
 CREATE TABLE IF NOT EXISTS "Rule" (
 	"ID"	INTEGER,
 	"Target"	TEXT NOT NULL,
@@ -0,0 +1,7 @@
+CREATE TABLE IF NOT EXISTS "ResolvedHost" (
+	"Family"	INTEGER NOT NULL CHECK("Family" IN (4, 6)),
+	"IPAddress"	BLOB NOT NULL,
+	"Hostname"	TEXT NOT NULL,
+	"ExpiresAt"	INTEGER NOT NULL,
+	PRIMARY KEY("Family","IPAddress")
+);
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "Bench.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <unistd.h>
+
+#include "spdlog/spdlog.h"
+
+#include "Json.hpp"
+
+void WBenchRunner::Run(
+	std::string const& Name, std::function<void(uint64_t Iterations)> const& Body, double const BytesPerOp)
+{
+	if (!IsEnabled(Name))
+	{
+		return;
+	}
+
+	constexpr uint64_t MaxIterations = 1ull << 40;
+	uint64_t           Iterations = 1;
+	double             Elapsed = 0;
+	while (true)
+	{
+		auto const Start = std::chrono::steady_clock::now();
+		Body(Iterations);
+		Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+		if (Elapsed >= MinTime || Iterations >= MaxIterations)
+		{
+			break;
+		}
+
+		// Aim a bit past MinTime with the next run, but don't trust very short runs too much
+		auto Next = Iterations * 10;
+		if (Elapsed > 0)
+		{
+			Next = static_cast<uint64_t>(static_cast<double>(Iterations) * MinTime * 1.2 / Elapsed);
+		}
+		Iterations = std::clamp(Next, Iterations + 1, std::min(Iterations * 10, MaxIterations));
+	}
+
+	WBenchResult Result{};
+	Result.Name = Name;
+	Result.Iterations = Iterations;
+	Result.NsPerOp = Elapsed * 1e9 / static_cast<double>(Iterations);
+	Result.BytesPerOp = BytesPerOp;
+	Report(std::move(Result));
+}
+
+void WBenchRunner::Report(WBenchResult Result)
+{
+	if (Result.BytesPerOp > 0)
+	{
+		spdlog::info("{:<48} {:>12.1f} ns/op {:>10.1f} MiB/s ({} iterations)", Result.Name, Result.NsPerOp,
+			Result.BytesPerOp / Result.NsPerOp * 1e9 / (1024.0 * 1024.0), Result.Iterations);
+	}
+	else
+	{
+		spdlog::info("{:<48} {:>12.1f} ns/op ({} iterations)", Result.Name, Result.NsPerOp, Result.Iterations);
+	}
+	Results.emplace_back(std::move(Result));
+}
+
+std::string WBenchRunner::ToJson() const
+{
+	WJson::array Benchmarks{};
+	for (auto const& Result : Results)
+	{
+		WJson::object Entry{
+			{ "name", Result.Name },
+			{ "iterations", static_cast<double>(Result.Iterations) },
+			{ "ns_per_op", Result.NsPerOp },
+			{ "ops_per_second", 1e9 / Result.NsPerOp },
+		};
+		if (Result.BytesPerOp > 0)
+		{
+			Entry["bytes_per_second"] = Result.BytesPerOp / Result.NsPerOp * 1e9;
+		}
+		Benchmarks.emplace_back(Entry);
+	}
+
+	return WJson(WJson::object{ { "min_time", MinTime }, { "benchmarks", Benchmarks } }).dump();
+}
+
+WBenchTempDirectory::WBenchTempDirectory(std::string const& Name)
+	: Path(std::filesystem::temp_directory_path() / fmt::format("waechter-bench-{}-{}", Name, getpid()))
+{
+	std::filesystem::create_directories(Path);
+}
+
+WBenchTempDirectory::~WBenchTempDirectory()
+{
+	std::error_code Error;
+	std::filesystem::remove_all(Path, Error);
+}
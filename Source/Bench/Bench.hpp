@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Keeps the compiler from optimizing away a result that is never used
+template <typename T>
+void DoNotOptimize(T const& Value)
+{
+	asm volatile("" : : "r,m"(Value) : "memory");
+}
+
+struct WBenchResult
+{
+	std::string Name{};
+	uint64_t    Iterations{};
+	double      NsPerOp{};
+	double      BytesPerOp{}; // 0 if the benchmark doesn't process a meaningful amount of bytes
+};
+
+/**
+ * Runs each benchmark with a growing number of iterations until a single run takes at least MinTime,
+ * the result of that last run is reported.
+ */
+class WBenchRunner
+{
+	std::vector<WBenchResult> Results{};
+	std::string               Filter{};
+	double                    MinTime{ 0.5 }; // seconds
+
+public:
+	WBenchRunner(std::string Filter_, double MinTime_) : Filter(std::move(Filter_)), MinTime(MinTime_) {}
+
+	// Benchmarks with expensive setup check this first, so filtering them out also skips the setup.
+	// Also true for groups that contain the filtered benchmark (e.g. "Serialization" for "Serialization/Tree")
+	[[nodiscard]] bool IsEnabled(std::string_view Name) const
+	{
+		return Filter.empty() || Name.find(Filter) != std::string_view::npos
+			|| Filter.find(Name) != std::string::npos;
+	}
+
+	// Body has to run the measured operation Iterations times
+	void Run(std::string const& Name, std::function<void(uint64_t Iterations)> const& Body, double BytesPerOp = 0);
+
+	// Logs and records a result that was measured elsewhere, e.g. by the kernel
+	void Report(WBenchResult Result);
+
+	[[nodiscard]] std::vector<WBenchResult> const& GetResults() const { return Results; }
+
+	[[nodiscard]] std::string ToJson() const;
+};
+
+// Scratch directory for benchmarks that need input files, removed again on destruction
+class WBenchTempDirectory
+{
+	std::filesystem::path Path{};
+
+public:
+	explicit WBenchTempDirectory(std::string const& Name);
+	~WBenchTempDirectory();
+
+	WBenchTempDirectory(WBenchTempDirectory const&) = delete;
+	WBenchTempDirectory& operator=(WBenchTempDirectory const&) = delete;
+
+	[[nodiscard]] std::filesystem::path const& GetPath() const { return Path; }
+};
+
+void RunPacketParserBenchmarks(WBenchRunner& Runner);
+void RunHashBenchmarks(WBenchRunner& Runner);
+void RunBufferBenchmarks(WBenchRunner& Runner);
+void RunSerializationBenchmarks(WBenchRunner& Runner);
+void RunIP2AsnBenchmarks(WBenchRunner& Runner);
+void RunSocketStateParserBenchmarks(WBenchRunner& Runner);
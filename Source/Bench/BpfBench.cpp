@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+// Measures what the traffic programs cost per packet by running them through BPF_PROG_TEST_RUN,
+// the kernel runs each program Repeat times on the same packet and reports the average duration.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <linux/if_ether.h>
+#include <netinet/in.h>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <bpf/bpf.h>
+
+#include "spdlog/spdlog.h"
+
+#include "WaechterEBPF.skel.h"
+#include "Bench.hpp"
+#include "EBPFCommon.h"
+#include "ErrnoUtil.hpp"
+#include "EBPF/EbpfRingBuffer.hpp"
+
+namespace
+{
+	enum class ELinkHeader
+	{
+		None, // raw IP, like on the ifb device
+		Ethernet,
+		Vlan
+	};
+
+	struct WTestPacket
+	{
+		std::string          Name{};
+		std::vector<uint8_t> Data{};
+	};
+
+	void AppendU16(std::vector<uint8_t>& Packet, uint16_t const Value)
+	{
+		Packet.push_back(static_cast<uint8_t>(Value >> 8));
+		Packet.push_back(static_cast<uint8_t>(Value & 0xFF));
+	}
+
+	std::vector<uint8_t> MakePacket(bool const bIPv6, uint8_t const L4Proto, ELinkHeader const LinkHeader)
+	{
+		constexpr uint16_t PayloadSize = 64;
+		auto const         L4Size = static_cast<uint16_t>((L4Proto == IPPROTO_TCP ? 20 : 8) + PayloadSize);
+
+		std::vector<uint8_t> Packet{};
+		Packet.reserve(18 + 40 + L4Size);
+		if (LinkHeader != ELinkHeader::None)
+		{
+			// Locally administered MAC addresses
+			for (uint8_t const Byte : { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x00, 0x00, 0x00, 0x00, 0x02 })
+			{
+				Packet.push_back(Byte);
+			}
+			if (LinkHeader == ELinkHeader::Vlan)
+			{
+				AppendU16(Packet, ETH_P_8021Q);
+				AppendU16(Packet, 42); // VLAN id
+			}
+			AppendU16(Packet, bIPv6 ? ETH_P_IPV6 : ETH_P_IP);
+		}
+
+		if (bIPv6)
+		{
+			AppendU16(Packet, 0x6000); // version, traffic class and flow label
+			AppendU16(Packet, 0);
+			AppendU16(Packet, L4Size);
+			Packet.push_back(L4Proto);
+			Packet.push_back(64); // hop limit
+			// 2001:db8::1 -> 2001:db8::2
+			for (uint16_t const Host : { 1, 2 })
+			{
+				AppendU16(Packet, 0x2001);
+				AppendU16(Packet, 0x0db8);
+				for (int i = 0; i < 5; ++i)
+				{
+					AppendU16(Packet, 0);
+				}
+				AppendU16(Packet, Host);
+			}
+		}
+		else
+		{
+			Packet.push_back(0x45);
+			Packet.push_back(0);
+			AppendU16(Packet, static_cast<uint16_t>(20 + L4Size));
+			AppendU16(Packet, 0);      // id
+			AppendU16(Packet, 0x4000); // don't fragment
+			Packet.push_back(64);      // ttl
+			Packet.push_back(L4Proto);
+			AppendU16(Packet, 0); // checksum, nothing verifies it
+			// 192.0.2.1 -> 198.51.100.1
+			for (uint8_t const Byte : { 192, 0, 2, 1, 198, 51, 100, 1 })
+			{
+				Packet.push_back(Byte);
+			}
+		}
+
+		AppendU16(Packet, 50000);
+		AppendU16(Packet, 443);
+		if (L4Proto == IPPROTO_TCP)
+		{
+			for (int i = 0; i < 4; ++i) // sequence and acknowledgement number
+			{
+				AppendU16(Packet, 0);
+			}
+			Packet.push_back(5 << 4); // data offset, no options
+			Packet.push_back(0x10);   // ACK
+			AppendU16(Packet, 64240); // window
+			AppendU16(Packet, 0);     // checksum
+			AppendU16(Packet, 0);     // urgent pointer
+		}
+		else
+		{
+			AppendU16(Packet, L4Size);
+			AppendU16(Packet, 0); // checksum
+		}
+		Packet.resize(Packet.size() + PayloadSize);
+		return Packet;
+	}
+
+	// The kernel always builds the test skb from an Ethernet frame, cgroup programs only see the part after it
+	std::vector<WTestPacket> MakePackets(bool const bWithRawIP, bool const bWithVlan)
+	{
+		std::vector<WTestPacket> Packets{};
+		for (bool const bIPv6 : { false, true })
+		{
+			for (uint8_t const L4Proto : { IPPROTO_TCP, IPPROTO_UDP })
+			{
+				std::string const Name =
+					std::string(bIPv6 ? "IPv6" : "IPv4") + (L4Proto == IPPROTO_TCP ? "/TCP" : "/UDP");
+				Packets.push_back({ Name, MakePacket(bIPv6, L4Proto, ELinkHeader::Ethernet) });
+				if (bWithVlan)
+				{
+					Packets.push_back({ Name + "/VLAN", MakePacket(bIPv6, L4Proto, ELinkHeader::Vlan) });
+				}
+				if (bWithRawIP)
+				{
+					Packets.push_back({ Name + "/RawIP", MakePacket(bIPv6, L4Proto, ELinkHeader::None) });
+				}
+			}
+		}
+		return Packets;
+	}
+
+	void RunProgram(WBenchRunner& Runner, bpf_program* Program, std::vector<WTestPacket> const& Packets,
+		int const Repeat, std::string const& Consumer)
+	{
+		for (auto const& Packet : Packets)
+		{
+			auto const Name = fmt::format("BPF/{}/{}/{}", bpf_program__name(Program), Packet.Name, Consumer);
+			if (!Runner.IsEnabled(Name))
+			{
+				continue;
+			}
+
+			bpf_test_run_opts Opts{};
+			Opts.sz = sizeof(Opts);
+			Opts.data_in = Packet.Data.data();
+			Opts.data_size_in = static_cast<uint32_t>(Packet.Data.size());
+			Opts.repeat = Repeat;
+
+			// The first run gets the ring buffer and the maps into the state they stay in
+			int Result = bpf_prog_test_run_opts(bpf_program__fd(Program), &Opts);
+			if (Result == 0)
+			{
+				Result = bpf_prog_test_run_opts(bpf_program__fd(Program), &Opts);
+			}
+			if (Result != 0)
+			{
+				spdlog::error("Test run of {} failed: {}", Name, WErrnoUtil::StrError(-Result));
+				continue;
+			}
+
+			WBenchResult BenchResult{};
+			BenchResult.Name = Name;
+			BenchResult.Iterations = static_cast<uint64_t>(Repeat);
+			BenchResult.NsPerOp = Opts.duration;
+			Runner.Report(std::move(BenchResult));
+		}
+	}
+
+	void RunPrograms(WBenchRunner& Runner, waechter_ebpf const& Skeleton, int const Repeat, std::string const& Consumer)
+	{
+		auto const L3Packets = MakePackets(false, false);
+		RunProgram(Runner, Skeleton.progs.cgskb_ingress, L3Packets, Repeat, Consumer);
+		RunProgram(Runner, Skeleton.progs.cgskb_egress, L3Packets, Repeat, Consumer);
+		RunProgram(Runner, Skeleton.progs.cls_egress, MakePackets(false, true), Repeat, Consumer);
+		RunProgram(Runner, Skeleton.progs.ifb_cls_egress, MakePackets(true, true), Repeat, Consumer);
+	}
+} // namespace
+
+// waechter-bpf-bench [--filter <substring>] [--repeat <count>] [--json <file or ->]
+//                    [--no-dns-snooping] [--no-udp-flows] [--no-cgroups]
+int main(int Argc, char* Argv[])
+{
+	std::string Filter{};
+	std::string JsonPath{};
+	int         Repeat{ 1000000 };
+	bool        bDnsSnooping{ true };
+	bool        bUdpFlows{ true };
+	bool        bCgroups{ true };
+	for (int i = 1; i < Argc; ++i)
+	{
+		std::string_view const Arg = Argv[i];
+		if (Arg == "--filter" && i + 1 < Argc)
+		{
+			Filter = Argv[++i];
+		}
+		else if (Arg == "--repeat" && i + 1 < Argc)
+		{
+			Repeat = std::max(1, std::atoi(Argv[++i]));
+		}
+		else if (Arg == "--json" && i + 1 < Argc)
+		{
+			JsonPath = Argv[++i];
+		}
+		else if (Arg == "--no-dns-snooping")
+		{
+			bDnsSnooping = false;
+		}
+		else if (Arg == "--no-udp-flows")
+		{
+			bUdpFlows = false;
+		}
+		else if (Arg == "--no-cgroups")
+		{
+			bCgroups = false;
+		}
+		else
+		{
+			spdlog::error("Unknown argument {}", Arg);
+			spdlog::info("Usage: {} [--filter <substring>] [--repeat <count>] [--json <file or ->] [--no-dns-snooping] "
+						 "[--no-udp-flows] [--no-cgroups]",
+				Argv[0]);
+			return -1;
+		}
+	}
+
+	if (JsonPath == "-")
+	{
+		spdlog::set_level(spdlog::level::warn);
+	}
+
+	if (geteuid() != 0)
+	{
+		spdlog::critical("Loading the eBPF programs requires root");
+		return -1;
+	}
+
+	// Only loaded, nothing is attached so the benchmark doesn't see any real traffic
+	waechter_ebpf* Skeleton = waechter_ebpf__open();
+	if (!Skeleton)
+	{
+		spdlog::critical("Failed to open eBPF object");
+		return -1;
+	}
+	Skeleton->rodata->DnsSnoopingEnabled = bDnsSnooping ? 1 : 0;
+	Skeleton->rodata->UdpFlowAccountingEnabled = bUdpFlows ? 1 : 0;
+	Skeleton->rodata->CgroupAccountingEnabled = bCgroups ? 1 : 0;
+	if (auto const Result = waechter_ebpf__load(Skeleton); Result != 0)
+	{
+		spdlog::critical("Failed to load eBPF object: {}", Result);
+		waechter_ebpf__destroy(Skeleton);
+		return -1;
+	}
+
+	WBenchRunner Runner(Filter, 0);
+
+	// Without a consumer the ring fills up during the first run and the programs take the path where
+	// reserving an event fails, like they do when the daemon falls behind
+	RunPrograms(Runner, *Skeleton, Repeat, "ConsumerIdle");
+
+	{
+		// Drains the ring the same way the daemon does
+		TEbpfRingBuffer<WSocketEvent> SocketEvents(Skeleton->maps.socket_event_ring);
+		std::atomic<bool>             bStop{ false };
+		std::thread                   Consumer([&SocketEvents, &bStop] {
+			while (!bStop)
+			{
+				SocketEvents.Poll(10);
+				std::lock_guard Lock(SocketEvents.GetDataMutex());
+				SocketEvents.GetData().clear();
+			}
+		});
+		RunPrograms(Runner, *Skeleton, Repeat, "ConsumerActive");
+		bStop = true;
+		Consumer.join();
+	}
+
+	waechter_ebpf__destroy(Skeleton);
+
+	if (JsonPath == "-")
+	{
+		std::cout << Runner.ToJson() << std::endl;
+	}
+	else if (!JsonPath.empty())
+	{
+		std::ofstream File(JsonPath);
+		File << Runner.ToJson() << std::endl;
+		if (!File)
+		{
+			spdlog::error("Failed to write results to {}", JsonPath);
+			return -1;
+		}
+	}
+	return 0;
+}
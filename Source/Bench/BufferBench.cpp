@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "Bench.hpp"
+
+#include <vector>
+
+#include "Buffer.hpp"
+
+namespace
+{
+	struct WSmallMessage
+	{
+		uint64_t Id{};
+		uint32_t Size{};
+		uint16_t Type{};
+		uint16_t Flags{};
+	};
+} // namespace
+
+void RunBufferBenchmarks(WBenchRunner& Runner)
+{
+	Runner.Run(
+		"Buffer/WriteRead/Small",
+		[](uint64_t const Iterations) {
+			WBuffer       Buffer{};
+			WSmallMessage Message{};
+			for (uint64_t i = 0; i < Iterations; ++i)
+			{
+				Message.Id = i;
+				Buffer.Write(Message);
+				WSmallMessage Out{};
+				DoNotOptimize(Buffer.Read(Out));
+				DoNotOptimize(Out);
+				Buffer.Reset();
+			}
+		},
+		sizeof(WSmallMessage));
+
+	// Roughly the size of a traffic update for a busy system
+	for (std::size_t const Size : { 4096u, 64u * 1024u })
+	{
+		std::vector<char> Payload(Size, 'x');
+		std::vector<char> Out(Size);
+		Runner.Run(
+			"Buffer/WriteRead/" + std::to_string(Size),
+			[&](uint64_t const Iterations) {
+				WBuffer Buffer{};
+				for (uint64_t i = 0; i < Iterations; ++i)
+				{
+					Buffer.Write(std::span<char const>(Payload));
+					DoNotOptimize(Buffer.Read(std::span<char>(Out)));
+					Buffer.Reset();
+				}
+				DoNotOptimize(Out.data());
+			},
+			static_cast<double>(Size));
+	}
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "Bench.hpp"
+
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "IPAddress.hpp"
+
+namespace
+{
+	constexpr std::size_t KeyCount = 10000;
+
+	WIPAddress MakeAddress(std::size_t const Index, bool const bIPv6)
+	{
+		WIPAddress Address{};
+		Address.Family = bIPv6 ? EIPFamily::IPv6 : EIPFamily::IPv4;
+		auto const Value = static_cast<uint32_t>(Index * 2654435761u);
+		if (bIPv6)
+		{
+			Address.Bytes[0] = 0x2a;
+			Address.Bytes[1] = 0x01;
+			std::memcpy(Address.Bytes.data() + 12, &Value, sizeof(Value));
+		}
+		else
+		{
+			std::memcpy(Address.Bytes.data(), &Value, sizeof(Value));
+		}
+		return Address;
+	}
+
+	// Looks up every key once per iteration, half of the lookups miss
+	template <typename TKey>
+	void RunLookup(WBenchRunner& Runner, std::string const& Name, std::vector<TKey> const& Keys)
+	{
+		if (!Runner.IsEnabled(Name))
+		{
+			return;
+		}
+
+		std::unordered_map<TKey, uint64_t> Map{};
+		for (std::size_t i = 0; i < Keys.size(); i += 2)
+		{
+			Map.emplace(Keys[i], i);
+		}
+
+		std::size_t Next = 0;
+		Runner.Run(Name, [&](uint64_t const Iterations) {
+			for (uint64_t i = 0; i < Iterations; ++i)
+			{
+				DoNotOptimize(Map.find(Keys[Next]) != Map.end());
+				Next = Next + 1 == Keys.size() ? 0 : Next + 1;
+			}
+		});
+	}
+} // namespace
+
+void RunHashBenchmarks(WBenchRunner& Runner)
+{
+	for (bool const bIPv6 : { false, true })
+	{
+		std::vector<WIPAddress> Addresses{};
+		std::vector<WEndpoint>  Endpoints{};
+		Addresses.reserve(KeyCount);
+		Endpoints.reserve(KeyCount);
+		for (std::size_t i = 0; i < KeyCount; ++i)
+		{
+			Addresses.push_back(MakeAddress(i, bIPv6));
+			Endpoints.push_back({ Addresses.back(), static_cast<uint16_t>(1024 + i % 50000) });
+		}
+
+		std::string const Family = bIPv6 ? "IPv6" : "IPv4";
+		RunLookup(Runner, "Hash/WIPAddress/" + Family, Addresses);
+		RunLookup(Runner, "Hash/WEndpoint/" + Family, Endpoints);
+	}
+}
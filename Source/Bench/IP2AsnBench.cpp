@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "Bench.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+#include "IP2Asn/IP2AsnDB.hpp"
+
+namespace
+{
+	// The real database has around 500k ranges, most of them IPv4
+	constexpr uint32_t RangeCountV4 = 400000;
+	constexpr uint32_t RangeCountV6 = 100000;
+
+	// Consecutive /24 (IPv4) and /48 (IPv6) ranges, every fourth range is a gap without an entry
+	bool WriteDatabase(std::filesystem::path const& Path)
+	{
+		std::ofstream File(Path);
+		for (uint32_t i = 0; i < RangeCountV4; ++i)
+		{
+			if (i % 4 == 3)
+			{
+				continue;
+			}
+			auto const A = 1 + (i >> 16), B = (i >> 8) & 0xFF, C = i & 0xFF;
+			File << fmt::format(
+				"{}.{}.{}.0\t{}.{}.{}.255\t{}\tUS\tORGANIZATION-{}\n", A, B, C, A, B, C, 1000 + i % 60000, i % 60000);
+		}
+		for (uint32_t i = 0; i < RangeCountV6; ++i)
+		{
+			if (i % 4 == 3)
+			{
+				continue;
+			}
+			auto const High = i >> 16, Low = i & 0xFFFF;
+			File << fmt::format("2a01:{:x}:{:x}::\t2a01:{:x}:{:x}:ffff:ffff:ffff:ffff:ffff\t{}\tDE\tORGANIZATION-{}\n",
+				High, Low, High, Low, 1000 + i % 60000, i % 60000);
+		}
+		return static_cast<bool>(File);
+	}
+
+	std::vector<WIPAddress> MakeLookupAddresses()
+	{
+		std::vector<WIPAddress> Addresses{};
+		for (uint32_t i = 0; i < 4096; ++i)
+		{
+			auto const Range = i * 2654435761u % RangeCountV4;
+			WIPAddress Address{};
+			Address.Family = EIPFamily::IPv4;
+			Address.Bytes[0] = static_cast<uint8_t>(1 + (Range >> 16));
+			Address.Bytes[1] = static_cast<uint8_t>(Range >> 8);
+			Address.Bytes[2] = static_cast<uint8_t>(Range);
+			Address.Bytes[3] = static_cast<uint8_t>(i);
+			Addresses.push_back(Address);
+		}
+		return Addresses;
+	}
+} // namespace
+
+void RunIP2AsnBenchmarks(WBenchRunner& Runner)
+{
+	if (!Runner.IsEnabled("IP2Asn"))
+	{
+		return;
+	}
+
+	WBenchTempDirectory const Directory("ip2asn");
+	auto const                DatabasePath = Directory.GetPath() / "ip2asn-combined.tsv";
+	if (!WriteDatabase(DatabasePath))
+	{
+		spdlog::error("Failed to write test database to {}", DatabasePath.string());
+		return;
+	}
+
+	// Happens on every daemon start after a database update. BuildIndex logs a summary each time, which would
+	// drown out the results
+	auto const LogLevel = spdlog::get_level();
+	Runner.Run("IP2Asn/BuildIndex", [&](uint64_t const Iterations) {
+		spdlog::set_level(std::max(LogLevel, spdlog::level::warn));
+		for (uint64_t i = 0; i < Iterations; ++i)
+		{
+			DoNotOptimize(WIP2AsnDB::BuildIndex(DatabasePath, WIP2AsnDB::GetIndexPath(DatabasePath)));
+		}
+		spdlog::set_level(LogLevel);
+	});
+
+	WIP2AsnDB Database(DatabasePath);
+	if (!Database.Init())
+	{
+		spdlog::error("Failed to load test database");
+		return;
+	}
+
+	auto const  Addresses = MakeLookupAddresses();
+	std::size_t Next = 0;
+	Runner.Run("IP2Asn/Lookup/IPv4", [&](uint64_t const Iterations) {
+		for (uint64_t i = 0; i < Iterations; ++i)
+		{
+			DoNotOptimize(Database.Lookup(Addresses[Next]));
+			Next = Next + 1 == Addresses.size() ? 0 : Next + 1;
+		}
+	});
+
+	auto const IPv6Address = WIPAddress::FromString("2a01:0:1234::1");
+	Runner.Run("IP2Asn/Lookup/IPv6", [&](uint64_t const Iterations) {
+		for (uint64_t i = 0; i < Iterations; ++i)
+		{
+			DoNotOptimize(Database.Lookup(*IPv6Address));
+		}
+	});
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+#include "spdlog/spdlog.h"
+
+#include "Bench.hpp"
+
+// waechter-bench [--filter <substring>] [--min-time <seconds>] [--json <file or ->]
+int main(int Argc, char* Argv[])
+{
+	std::string Filter{};
+	std::string JsonPath{};
+	double      MinTime{ 0.5 };
+	for (int i = 1; i < Argc; ++i)
+	{
+		std::string_view const Arg = Argv[i];
+		if (Arg == "--filter" && i + 1 < Argc)
+		{
+			Filter = Argv[++i];
+		}
+		else if (Arg == "--min-time" && i + 1 < Argc)
+		{
+			MinTime = std::strtod(Argv[++i], nullptr);
+		}
+		else if (Arg == "--json" && i + 1 < Argc)
+		{
+			JsonPath = Argv[++i];
+		}
+		else
+		{
+			spdlog::error("Unknown argument {}", Arg);
+			spdlog::info("Usage: {} [--filter <substring>] [--min-time <seconds>] [--json <file or ->]", Argv[0]);
+			return -1;
+		}
+	}
+
+	// The JSON goes to stdout, so the log has to go somewhere else
+	if (JsonPath == "-")
+	{
+		spdlog::set_level(spdlog::level::warn);
+	}
+
+	WBenchRunner Runner(Filter, MinTime);
+	RunPacketParserBenchmarks(Runner);
+	RunHashBenchmarks(Runner);
+	RunBufferBenchmarks(Runner);
+	RunSerializationBenchmarks(Runner);
+	RunIP2AsnBenchmarks(Runner);
+	RunSocketStateParserBenchmarks(Runner);
+
+	if (JsonPath == "-")
+	{
+		std::cout << Runner.ToJson() << std::endl;
+	}
+	else if (!JsonPath.empty())
+	{
+		std::ofstream File(JsonPath);
+		File << Runner.ToJson() << std::endl;
+		if (!File)
+		{
+			spdlog::error("Failed to write results to {}", JsonPath);
+			return -1;
+		}
+	}
+	return 0;
+}
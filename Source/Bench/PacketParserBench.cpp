@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "Bench.hpp"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+#include "Net/PacketParser.hpp"
+
+namespace
+{
+	void WriteTcpHeader(uint8_t* Header)
+	{
+		Header[0] = 0xC3; // 50000
+		Header[1] = 0x50;
+		Header[2] = 0x01; // 443
+		Header[3] = 0xBB;
+		Header[12] = 5 << 4; // data offset, no options
+	}
+
+	std::vector<uint8_t> MakeIPv4TcpPacket()
+	{
+		std::vector<uint8_t> Packet(20 + 20 + 64);
+		Packet[0] = 0x45;
+		Packet[9] = 6;
+		std::array<uint8_t, 8> const Addresses{ 192, 168, 1, 10, 93, 184, 216, 34 };
+		std::copy(Addresses.begin(), Addresses.end(), Packet.begin() + 12);
+		WriteTcpHeader(Packet.data() + 20);
+		return Packet;
+	}
+
+	template <std::size_t ExtensionSize>
+	std::vector<uint8_t> MakeIPv6Packet(
+		std::array<uint8_t, ExtensionSize> const& ExtensionHeaders, uint8_t const FirstNextHeader)
+	{
+		std::array<uint8_t, 40 + ExtensionSize + 20 + 64> Packet{};
+		Packet[0] = 0x60;
+		Packet[6] = FirstNextHeader;
+		std::iota(Packet.begin() + 8, Packet.begin() + 40, uint8_t{ 0x20 });
+		std::copy(ExtensionHeaders.begin(), ExtensionHeaders.end(), Packet.begin() + 40);
+		WriteTcpHeader(Packet.data() + 40 + ExtensionSize);
+		return { Packet.begin(), Packet.end() };
+	}
+
+	// The ports are at the same offset for UDP and TCP
+	std::vector<uint8_t> MakeIPv6UdpPacket() { return MakeIPv6Packet(std::array<uint8_t, 0>{}, 17); }
+
+	// Hop-by-hop options, routing and destination options before the TCP header
+	std::vector<uint8_t> MakeIPv6ExtensionHeaderPacket()
+	{
+		std::array<uint8_t, 32> const Headers{
+			43, 0, 1, 4, 0, 0, 0, 0,  // hop-by-hop -> routing
+			60, 0, 0, 0, 0, 0, 0, 0,  // routing -> destination options
+			6, 1, 1, 12, 0, 0, 0, 0,  // destination options -> TCP
+			0, 0, 0, 0, 0, 0, 0, 0,   // rest of the 16 byte destination options
+		};
+		return MakeIPv6Packet(Headers, 0);
+	}
+
+	void RunPacket(WBenchRunner& Runner, std::string const& Name, std::vector<uint8_t> const& Packet)
+	{
+		WPacketHeaderParser Parser{};
+		if (!Parser.ParsePacket(Packet.data(), Packet.size()))
+		{
+			spdlog::error("{}: test packet doesn't parse", Name);
+			return;
+		}
+
+		Runner.Run(Name, [&](uint64_t const Iterations) {
+			for (uint64_t i = 0; i < Iterations; ++i)
+			{
+				DoNotOptimize(Parser.ParsePacket(Packet.data(), Packet.size()));
+				DoNotOptimize(Parser);
+			}
+		});
+	}
+} // namespace
+
+void RunPacketParserBenchmarks(WBenchRunner& Runner)
+{
+	RunPacket(Runner, "PacketParser/IPv4/TCP", MakeIPv4TcpPacket());
+	RunPacket(Runner, "PacketParser/IPv6/UDP", MakeIPv6UdpPacket());
+	RunPacket(Runner, "PacketParser/IPv6/ExtensionHeaders", MakeIPv6ExtensionHeaderPacket());
+}
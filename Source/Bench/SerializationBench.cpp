@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "Bench.hpp"
+
+#include "cereal/types/array.hpp"
+#include "cereal/types/memory.hpp"
+#include "cereal/types/string.hpp"
+#include "cereal/types/unordered_map.hpp"
+#include "cereal/types/vector.hpp"
+
+#include "Messages.hpp"
+#include "Data/SystemItem.hpp"
+#include "Data/TrafficTreeUpdate.hpp"
+
+namespace
+{
+	WSocketTuple MakeTuple(uint64_t const Index)
+	{
+		WSocketTuple Tuple{};
+		Tuple.LocalEndpoint.Address.Family = EIPFamily::IPv4;
+		Tuple.LocalEndpoint.Address.Bytes = { 192, 168, 1, 10 };
+		Tuple.LocalEndpoint.Port = static_cast<uint16_t>(32768 + Index % 28000);
+		Tuple.RemoteEndpoint.Address.Family = EIPFamily::IPv4;
+		Tuple.RemoteEndpoint.Address.Bytes = { 93, 184, static_cast<uint8_t>(Index >> 8), static_cast<uint8_t>(Index) };
+		Tuple.RemoteEndpoint.Port = 443;
+		return Tuple;
+	}
+
+	// Ten processes per application and ten sockets per process, like a system with many browser tabs
+	std::shared_ptr<WSystemItem> MakeTree(std::size_t const NodeCount)
+	{
+		auto System = std::make_shared<WSystemItem>();
+		WTrafficItemId NextId = 1;
+		std::size_t    Nodes = 1;
+		for (std::size_t App = 0; Nodes < NodeCount; ++App)
+		{
+			auto Application = std::make_shared<WApplicationItem>();
+			Application->ItemId = NextId++;
+			Application->ApplicationName = "application-" + std::to_string(App);
+			Application->ApplicationPath = "/usr/bin/" + Application->ApplicationName;
+			Application->ApplicationCommandLine = Application->ApplicationPath + " --some-flag";
+			System->Applications.emplace(Application->ApplicationPath, Application);
+			++Nodes;
+
+			for (WProcessId Pid = 0; Pid < 10 && Nodes < NodeCount; ++Pid)
+			{
+				auto Process = std::make_shared<WProcessItem>();
+				Process->ItemId = NextId++;
+				Process->ProcessId = static_cast<WProcessId>(App * 10 + static_cast<std::size_t>(Pid) + 1000);
+				Application->Processes.emplace(Process->ProcessId, Process);
+				++Nodes;
+
+				for (int i = 0; i < 10 && Nodes < NodeCount; ++i)
+				{
+					auto Socket = std::make_shared<WSocketItem>();
+					Socket->ItemId = NextId++;
+					Socket->Cookie = Socket->ItemId;
+					Socket->SocketTuple = MakeTuple(Socket->ItemId);
+					Socket->ConnectionState = ESocketConnectionState::Connected;
+					Socket->DownloadSpeed = 1024;
+					Socket->TotalDownloadBytes = Socket->ItemId * 4096;
+					Process->Sockets.emplace(Socket->Cookie, Socket);
+					++Nodes;
+				}
+			}
+		}
+		return System;
+	}
+
+	// What a busy second looks like: most items changed their speed, some sockets came and went
+	WTrafficTreeUpdates MakeUpdates(std::size_t const UpdatedCount)
+	{
+		WTrafficTreeUpdates Updates{};
+		for (std::size_t i = 0; i < UpdatedCount; ++i)
+		{
+			WTrafficTreeTrafficUpdate Update{};
+			Update.ItemId = i;
+			Update.NewDownloadSpeed = 1024.0 * static_cast<double>(i);
+			Update.TotalDownloadBytes = i * 4096;
+			Updates.UpdatedItems.push_back(Update);
+		}
+
+		for (std::size_t i = 0; i < UpdatedCount / 10; ++i)
+		{
+			WTrafficTreeSocketAddition Addition{};
+			Addition.ItemId = UpdatedCount + i;
+			Addition.ProcessId = 1000;
+			Addition.ApplicationName = "application";
+			Addition.ApplicationPath = "/usr/bin/application";
+			Addition.SocketTuple = MakeTuple(i);
+			Updates.AddedSockets.push_back(Addition);
+			Updates.RemovedItems.push_back(i);
+		}
+		return Updates;
+	}
+
+	template <typename T>
+	void RunSerialize(WBenchRunner& Runner, std::string const& Name, T const& Data, EMessageType const Type)
+	{
+		auto const Size = static_cast<double>(SerializeMessage(Type, Data).size());
+		Runner.Run(
+			Name,
+			[&](uint64_t const Iterations) {
+				for (uint64_t i = 0; i < Iterations; ++i)
+				{
+					DoNotOptimize(SerializeMessage(Type, Data));
+				}
+			},
+			Size);
+	}
+} // namespace
+
+void RunSerializationBenchmarks(WBenchRunner& Runner)
+{
+	for (std::size_t const Count : { 100u, 1000u, 10000u })
+	{
+		auto const Name = "Serialization/TrafficTreeUpdates/" + std::to_string(Count);
+		if (Runner.IsEnabled(Name))
+		{
+			RunSerialize(Runner, Name, MakeUpdates(Count), MT_TrafficTreeUpdate);
+		}
+	}
+
+	// The initial sync sends the whole tree to every client that connects
+	for (std::size_t const Count : { 1000u, 10000u, 100000u })
+	{
+		auto const Name = "Serialization/TrafficTree/" + std::to_string(Count);
+		if (Runner.IsEnabled(Name))
+		{
+			auto const Tree = MakeTree(Count);
+			RunSerialize(Runner, Name, *Tree, MT_TrafficTree);
+		}
+	}
+}
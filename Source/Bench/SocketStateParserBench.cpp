@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "Bench.hpp"
+
+#include <fstream>
+
+#include "spdlog/spdlog.h"
+
+#include "Data/SocketStateParser.hpp"
+
+namespace
+{
+	// Same layout as /proc/net/{tcp,udp}, the IPv6 tables only have a longer address
+	bool WriteTable(std::filesystem::path const& Path, uint32_t const SocketCount, bool const bIPv6, bool const bUdp)
+	{
+		std::ofstream File(Path);
+		File << "  sl  local_address rem_address   st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout "
+				"inode\n";
+		for (uint32_t i = 0; i < SocketCount; ++i)
+		{
+			// Every tenth socket listens, the rest are connected to some remote
+			bool const        bListen = i % 10 == 0;
+			std::string const Local = bIPv6 ? "0000000000000000FFFF00000100007F" : "0100007F";
+			std::string const Remote
+				= bListen ? std::string(Local.size(), '0') : fmt::format("{:0{}X}", i, Local.size());
+			auto const        State = bUdp ? 0x07 : (bListen ? 0x0A : 0x01);
+			File << fmt::format("{:>4}: {}:{:04X} {}:{:04X} {:02X} 00000000:00000000 00:00000000 00000000  1000  "
+								"      0 {} 1 0000000000000000 20 4 30 10 -1\n",
+				i, Local, 1024 + i % 60000, Remote, bListen ? 0 : 443, State, 100000 + i);
+		}
+		return static_cast<bool>(File);
+	}
+} // namespace
+
+void RunSocketStateParserBenchmarks(WBenchRunner& Runner)
+{
+	WSocketStateParser const Parser{};
+	for (uint32_t const SocketCount : { 100u, 1000u, 10000u })
+	{
+		auto const Name = "SocketStateParser/ParseNetFiles/" + std::to_string(SocketCount);
+		if (!Runner.IsEnabled(Name))
+		{
+			continue;
+		}
+
+		WBenchTempDirectory const Directory("net");
+		auto const&               Path = Directory.GetPath();
+		bool const bWritten = WriteTable(Path / "tcp", SocketCount, false, false)
+			&& WriteTable(Path / "tcp6", SocketCount, true, false) && WriteTable(Path / "udp", SocketCount, false, true)
+			&& WriteTable(Path / "udp6", SocketCount, true, true);
+		if (!bWritten)
+		{
+			spdlog::error("Failed to write socket tables to {}", Path.string());
+			return;
+		}
+
+		// Each socket appears once in every table, so this is the time to parse four of them
+		Runner.Run(Name, [&](uint64_t const Iterations) {
+			for (uint64_t i = 0; i < Iterations; ++i)
+			{
+				Parser.ParseNetFiles(Path.string());
+			}
+			DoNotOptimize(Parser.GetEndpointPID({}));
+		});
+	}
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+// Measures what a socket close event costs depending on how many sockets the system map knows about.
+// Built from the daemon sources, the processes are made up by the replay backend so no /proc/ access is needed.
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+#include "Bench.hpp"
+#include "EBPFCommon.h"
+#include "Data/ProcessInfoCache.hpp"
+#include "Data/SystemMap.hpp"
+#include "EBPF/SocketEventReplay.hpp"
+
+namespace
+{
+	// Roughly what a busy server looks like, a bunch of workers that share a few hundred local ports
+	constexpr uint32_t SocketsPerProcess = 64;
+	constexpr uint32_t LocalPortCount = 512;
+
+	[[nodiscard]] uint16_t GetLocalPort(uint32_t const Index)
+	{
+		return static_cast<uint16_t>(1024 + Index % LocalPortCount);
+	}
+
+	// Maps sockets until there are Count of them, their cookies start at 1
+	void AddSockets(std::vector<WSocketCookie>& Cookies, uint32_t const Count)
+	{
+		auto& SystemMap = WSystemMap::GetInstance();
+		while (Cookies.size() < Count)
+		{
+			auto const Index = static_cast<uint32_t>(Cookies.size());
+			WSocketEvent Event{};
+			Event.EventType = NE_SocketCreate;
+			Event.Cookie = Index + 1;
+
+			auto const Socket = SystemMap.MapSocket(Event, static_cast<WProcessId>(1000 + Index / SocketsPerProcess));
+			if (!Socket)
+			{
+				spdlog::error("Failed to map socket {}", Event.Cookie);
+				return;
+			}
+			Socket->TrafficItem->SocketTuple.LocalEndpoint.Port = GetLocalPort(Index);
+			// Puts it into the local port index
+			SystemMap.MergeSyntheticSocket(Socket);
+			Cookies.push_back(Event.Cookie);
+		}
+	}
+
+	void RunSocketCloseBenchmarks(WBenchRunner& Runner)
+	{
+		// Nothing is removed until the next cleanup, so the sizes can build on each other
+		std::vector<WSocketCookie> Cookies{};
+		for (uint32_t const SocketCount : { 1000u, 10000u, 100000u })
+		{
+			auto const Name = "SystemMap/MarkSocketForRemoval/" + std::to_string(SocketCount);
+			if (!Runner.IsEnabled(Name))
+			{
+				continue;
+			}
+
+			AddSockets(Cookies, SocketCount);
+			if (Cookies.size() < SocketCount)
+			{
+				return;
+			}
+
+			// After the first round the sockets are already marked, which skips the counter slab but still
+			// does both lookups, and those are what depends on the socket count
+			Runner.Run(Name, [&](uint64_t const Iterations) {
+				auto& SystemMap = WSystemMap::GetInstance();
+				for (uint64_t i = 0; i < Iterations; ++i)
+				{
+					auto const   Index = static_cast<uint32_t>(i % SocketCount);
+					WSocketEvent Event{};
+					Event.EventType = NE_SocketClosed;
+					Event.Cookie = Cookies[Index];
+					Event.Data.SocketCloseEventData.LocalPort = GetLocalPort(Index);
+					SystemMap.MarkSocketForRemoval(Event);
+				}
+			});
+		}
+	}
+} // namespace
+
+// waechter-systemmap-bench [--filter <substring>] [--min-time <seconds>] [--json <file or ->]
+int main(int Argc, char* Argv[])
+{
+	std::string Filter{};
+	std::string JsonPath{};
+	double      MinTime{ 0.5 };
+	for (int i = 1; i < Argc; ++i)
+	{
+		std::string_view const Arg = Argv[i];
+		if (Arg == "--filter" && i + 1 < Argc)
+		{
+			Filter = Argv[++i];
+		}
+		else if (Arg == "--min-time" && i + 1 < Argc)
+		{
+			MinTime = std::strtod(Argv[++i], nullptr);
+		}
+		else if (Arg == "--json" && i + 1 < Argc)
+		{
+			JsonPath = Argv[++i];
+		}
+		else
+		{
+			spdlog::error("Unknown argument {}", Arg);
+			spdlog::info("Usage: {} [--filter <substring>] [--min-time <seconds>] [--json <file or ->]", Argv[0]);
+			return -1;
+		}
+	}
+
+	// The JSON goes to stdout, so the log has to go somewhere else. Mapping sockets logs a lot on debug
+	spdlog::set_level(JsonPath == "-" ? spdlog::level::warn : spdlog::level::info);
+
+	WProcessInfoCache::GetInstance().SetBackend(std::make_unique<WReplayProcessInfoBackend>());
+	WProcessInfoCache::GetInstance().UseKernelProcessEvents();
+
+	WBenchRunner Runner(Filter, MinTime);
+	RunSocketCloseBenchmarks(Runner);
+
+	if (JsonPath == "-")
+	{
+		std::cout << Runner.ToJson() << std::endl;
+	}
+	else if (!JsonPath.empty())
+	{
+		std::ofstream File(JsonPath);
+		File << Runner.ToJson() << std::endl;
+		if (!File)
+		{
+			spdlog::error("Failed to write results to {}", JsonPath);
+			return -1;
+		}
+	}
+	return 0;
+}
@@ -4,6 +4,10 @@
  */
 
 #pragma once
+#include <linux/sockios.h>
+#include <sys/ioctl.h>
+
+#include "EventLoop.hpp"
 #include "Communication/IClientSocket.hpp"
 
 class WClientUnixSocket final : public IClientSocket
@@ -16,7 +20,15 @@ public:
 	sigslot::signal<>&         GetClosedSignal() override { return Socket->OnClosed; }
 	sigslot::signal<WBuffer&>& GetDataSignal() override { return Socket->OnData; }
 
-	void StartListenThread() override { Socket->StartListenThread(); }
+	void StartListenThread() override
+	{
+		if (auto& Loop = WEventLoop::GetInstance(); Loop.IsEnabled())
+		{
+			Loop.AddSocket(Socket);
+			return;
+		}
+		Socket->StartListenThread();
+	}
 
 	[[nodiscard]] bool IsConnected() const override { return Socket->IsConnected(); }
 
@@ -26,4 +38,15 @@ public:
 	{
 		return Socket->SendFramed(Data) ? static_cast<ssize_t>(Data.size()) : -1;
 	}
+
+	// Sends block, so anything pending is still in the kernel's socket buffer
+	[[nodiscard]] std::size_t GetSendBacklog() const override
+	{
+		int Pending = 0;
+		if (ioctl(Socket->GetFd(), SIOCOUTQ, &Pending) != 0 || Pending < 0)
+		{
+			return 0;
+		}
+		return static_cast<std::size_t>(Pending);
+	}
 };
@@ -47,6 +47,7 @@ ssize_t WClientWebSocket::SendFramed(std::string const& Data)
 	{
 		std::lock_guard Lock(SendMutex);
 		SendQueue.push(std::move(FramedData));
+		SendQueueBytes += Data.size();
 	}
 
 	RequestWrite();
@@ -90,6 +91,7 @@ void WClientWebSocket::HandleWritable()
 	}
 
 	SendQueue.pop();
+	SendQueueBytes -= DataLen;
 
 	// If more data to send, request another write callback
 	if (!SendQueue.empty())
@@ -26,6 +26,7 @@ class WClientWebSocket final : public IClientSocket
 	// Outgoing message queue (one serialized message per WebSocket frame)
 	std::mutex                    SendMutex;
 	std::queue<std::vector<char>> SendQueue;
+	std::atomic<std::size_t>      SendQueueBytes{ 0 };
 
 	// Buffer for a fragmented WebSocket message
 	std::vector<char> ReceiveBuffer;
@@ -44,6 +45,8 @@ public:
 
 	ssize_t SendFramed(std::string const& Data) override;
 
+	[[nodiscard]] std::size_t GetSendBacklog() const override { return SendQueueBytes; }
+
 	// Called by DaemonWebSocket callback
 	void HandleReceive(char const* Data, size_t Len, bool bIsFinalFragment);
 	void HandleWritable();
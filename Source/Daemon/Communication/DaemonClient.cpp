@@ -5,17 +5,42 @@
 
 #include "DaemonClient.hpp"
 
+#include "Daemon.hpp"
 #include "DaemonConfig.hpp"
+#include "EventLoop.hpp"
 #include "spdlog/spdlog.h"
 
 #include "Messages.hpp"
 #include "Data/IP2Asn.hpp"
 #include "Data/ResolveData.hpp"
 #include "Data/Stats.hpp"
+#include "Data/SystemMap.hpp"
 #include "Db/StatsManager.hpp"
+#include "Net/DnsCache.hpp"
 #include "Net/Resolver.hpp"
 #include "Rules/RuleManager.hpp"
 
+void WDaemonClient::OnSocketData(WBuffer& RecvBuf)
+{
+	if (!WEventLoop::GetInstance().IsEnabled())
+	{
+		// The client has its own receive thread, which can wait for the request to be handled
+		OnDataReceived(RecvBuf);
+		return;
+	}
+
+	// Handling a request can block (database, resolver, sending large responses), which must not stall the
+	// event loop. The receive buffer is reused for the next read, so the request is copied
+	WBuffer Request(RecvBuf.GetReadableSize());
+	Request.Write(RecvBuf.GetReadableData());
+	SerialQueue->Post([Self = weak_from_this(), Request = std::move(Request)]() mutable {
+		if (auto const Client = Self.lock())
+		{
+			Client->OnDataReceived(Request);
+		}
+	});
+}
+
 void WDaemonClient::OnDataReceived(WBuffer& RecvBuf)
 {
 	auto const Type = ReadMessageTypeFromBuffer(RecvBuf);
@@ -27,6 +52,9 @@ void WDaemonClient::OnDataReceived(WBuffer& RecvBuf)
 
 	switch (Type)
 	{
+		case MT_ClientHandshake:
+			WDaemon::GetInstance().GetDaemonSocket()->HandleClientHandshake(this, RecvBuf);
+			break;
 		case MT_RuleUpdate:
 			WRuleManager::GetInstance().HandleRuleChange(RecvBuf, this);
 			break;
@@ -37,18 +65,19 @@ void WDaemonClient::OnDataReceived(WBuffer& RecvBuf)
 		case MT_StatsRequest:
 			WStatsManager::GetInstance()
 				.RequestStats(RecvBuf, Type)
-				.Then([Socket = ClientSocket](std::string const& Response) {
+				.Then(*SerialQueue, [Self = weak_from_this()](std::string const& Response) {
+					auto const Client = Self.lock();
 					if (Response.empty())
 					{
 						spdlog::warn("Failed to process stats request, response is empty");
 					}
-					else if (!Socket->IsConnected())
+					else if (!Client || !Client->IsRunning())
 					{
 						spdlog::warn("Client disconnected before stats response could be sent");
 					}
-					else
+					else if (Client->SendFramedData(Response) < 0)
 					{
-						Socket->SendFramed(Response);
+						spdlog::error("Failed to send stats response");
 					}
 				});
 			break;
@@ -61,6 +90,9 @@ void WDaemonClient::OnDataReceived(WBuffer& RecvBuf)
 		case MT_DaemonConfig:
 			WDaemonConfig::GetInstance().HandleConfigMessage(RecvBuf);
 			break;
+		case MT_PeerPageRequest:
+			HandlePeerPageRequest(RecvBuf);
+			break;
 		default:
 			break;
 	}
@@ -74,21 +106,43 @@ void WDaemonClient::HandleResolveRequest(WBuffer const& Buf)
 		spdlog::error("Failed to deserialize resolve request");
 		return;
 	}
-	WResolver::GetInstance()
-		.Resolve(Request.AddressToResolve)
-		.Then([Request, Socket = ClientSocket](std::string const& Hostname) {
-			if (!Socket->IsConnected())
+
+	// Answers from the DNS cache are sent along with the ones that have to be resolved first
+	WResolveResponse                          Response{};
+	std::vector<WIPAddress>                   Pending{};
+	std::vector<TPromise<std::string const&>> Promises{};
+	for (auto const& Address : Request.AddressesToResolve)
+	{
+		if (std::string Hostname{}; WDnsCache::GetInstance().Lookup(Address, Hostname))
+		{
+			Response.Results.push_back({ Address, std::move(Hostname) });
+		}
+		else
+		{
+			Pending.push_back(Address);
+			Promises.push_back(WResolver::GetInstance().Resolve(Address));
+		}
+	}
+
+	WhenAll(Promises).Then(*SerialQueue,
+		[Response = std::move(Response), Pending = std::move(Pending), Self = weak_from_this()](
+			std::vector<std::string> const& Hostnames) mutable {
+			auto const Client = Self.lock();
+			if (!Client || !Client->IsRunning())
 			{
-				spdlog::warn("Client disconnected before resolve response could be sent for {}",
-					Request.AddressToResolve.ToString());
+				spdlog::warn("Client disconnected before resolve response could be sent for {} addresses",
+					Response.Results.size() + Pending.size());
 				return;
 			}
-			spdlog::debug(
-				"Finished resolve request for address: {} -> {}", Request.AddressToResolve.ToString(), Hostname);
-			WResolveResponse Response{};
-			Response.AddressToResolve = Request.AddressToResolve;
-			Response.ResolveResult = Hostname;
-			Socket->SendFramed(MakeMessage(MT_ResolveResponse, Response));
+			for (std::size_t i = 0; i < Pending.size(); ++i)
+			{
+				spdlog::debug("Finished resolve request for address: {} -> {}", Pending[i].ToString(), Hostnames[i]);
+				Response.Results.push_back({ Pending[i], Hostnames[i] });
+			}
+			if (Client->SendFramedData(MakeMessage(MT_ResolveResponse, Response)) < 0)
+			{
+				spdlog::error("Failed to send resolve response for {} addresses", Response.Results.size());
+			}
 		});
 }
 
@@ -104,8 +158,9 @@ void WDaemonClient::HandleIPLookupRequest(WBuffer const& Buf)
 
 	WIP2Asn::GetInstance()
 		.Lookup(Request.AddressToLookup)
-		.Then([Request, Socket = ClientSocket](std::optional<WIP2AsnLookupResult> const& Result) {
-			if (!Socket->IsConnected())
+		.Then(*SerialQueue, [Request, Self = weak_from_this()](std::optional<WIP2AsnLookupResult> const& Result) {
+			auto const Client = Self.lock();
+			if (!Client || !Client->IsRunning())
 			{
 				spdlog::warn("Client disconnected before IP lookup response could be sent for {}",
 					Request.AddressToLookup.ToString());
@@ -118,6 +173,20 @@ void WDaemonClient::HandleIPLookupRequest(WBuffer const& Buf)
 			}
 			spdlog::debug("Finished IP lookup request for address: {} -> ASN: {}, Country: {}, Organization: {}",
 				Request.AddressToLookup.ToString(), Result->ASN, Result->Country, Result->Organization);
-			Socket->SendFramed(MakeMessage(MT_IPLookupResponse, Result.value()));
+			if (Client->SendFramedData(MakeMessage(MT_IPLookupResponse, Result.value())) < 0)
+			{
+				spdlog::error("Failed to send IP lookup response for {}", Request.AddressToLookup.ToString());
+			}
 		});
-}
\ No newline at end of file
+}
+
+void WDaemonClient::HandlePeerPageRequest(WBuffer const& Buf)
+{
+	WPeerPageRequest Request{};
+	if (!DeserializeMessage(Buf, Request))
+	{
+		spdlog::error("Failed to deserialize peer page request");
+		return;
+	}
+	SendMessage(MT_PeerPage, WSystemMap::GetInstance().GetPeerPage(Request));
+}
@@ -7,7 +7,9 @@
 #include "Messages.hpp"
 
 #include <atomic>
+#include <mutex>
 #include <utility>
+#include <vector>
 
 #include "spdlog/spdlog.h"
 #include "tracy/Tracy.hpp"
@@ -18,32 +20,63 @@
 #include "cereal/types/unordered_map.hpp"
 #include "cereal/types/memory.hpp"
 #include "cereal/types/string.hpp"
+#include "cereal/types/utility.hpp"
 // (cereal/archives/binary.hpp provided via Messages.hpp)
 // ReSharper restore CppUnusedIncludeDirective
 
 #include "Socket.hpp"
 #include "ErrnoUtil.hpp"
+#include "EventLoop.hpp"
 #include "Types.hpp"
 #include "Communication/IClientSocket.hpp"
 
 class WDaemonSocket;
 
-class WDaemonClient
+class WDaemonClient : public std::enable_shared_from_this<WDaemonClient>
 {
 	std::shared_ptr<IClientSocket> ClientSocket;
 
 	WProcessId ClientPid{ 0 };
 
+	// Responses that finish on other threads are sent from here, one at a time and in order
+	std::shared_ptr<WSerialExecutor> SerialQueue{ std::make_shared<WSerialExecutor>(
+		WEventLoop::GetInstance().GetWorkers()) };
+
+	// A message is sent as a length and a body, which must not interleave with another message
+	mutable std::mutex SendMutex;
+
+	// Everything sent to the client while its initial sync is still going out is held back until it's done,
+	// so the updates apply on top of the state it was synced to
+	mutable std::mutex               SyncMutex;
+	mutable std::vector<std::string> HeldBackMessages{};
+	bool                             bSyncing{};
+
+	[[nodiscard]] ssize_t SendFramedDataNow(std::string const& Data) const
+	{
+		ZoneScopedN("SendFramedData");
+		std::scoped_lock Lock(SendMutex);
+		if (!ClientSocket->IsConnected())
+		{
+			return 0;
+		}
+		return ClientSocket->SendFramed(Data);
+	}
+
+	// Called on the thread that read the data, hands it on to OnDataReceived
+	void OnSocketData(WBuffer& RecvBuf);
+
 	void OnDataReceived(WBuffer& RecvBuf);
 
 	void HandleResolveRequest(WBuffer const& Buf);
 
 	void HandleIPLookupRequest(WBuffer const& Buf);
 
+	void HandlePeerPageRequest(WBuffer const& Buf);
+
 public:
 	explicit WDaemonClient(std::shared_ptr<IClientSocket> CS) : ClientSocket(std::move(CS))
 	{
-		ClientSocket->GetDataSignal().connect([this](WBuffer& Buffer) { OnDataReceived(Buffer); });
+		ClientSocket->GetDataSignal().connect([this](WBuffer& Buffer) { OnSocketData(Buffer); });
 		ClientSocket->GetClosedSignal().connect([] { spdlog::info("Client disconnected"); });
 		ClientSocket->StartListenThread();
 	}
@@ -56,12 +89,47 @@ public:
 
 	[[nodiscard]] ssize_t SendFramedData(std::string const& Data) const
 	{
-		ZoneScopedN("SendFramedData");
-		if (!ClientSocket->IsConnected())
 		{
-			return 0;
+			std::scoped_lock Lock(SyncMutex);
+			if (bSyncing)
+			{
+				HeldBackMessages.push_back(Data);
+				return static_cast<ssize_t>(Data.size());
+			}
 		}
-		return ClientSocket->SendFramed(Data);
+		return SendFramedDataNow(Data);
+	}
+
+	// Has to be called before the client can receive any broadcasts
+	void BeginSync()
+	{
+		std::scoped_lock Lock(SyncMutex);
+		bSyncing = true;
+	}
+
+	// Sends a message that is part of the initial sync, right away
+	template <class T>
+	ssize_t SendSyncMessage(EMessageType Type, T const& Data) const
+	{
+		return SendSyncData(SerializeMessage(Type, Data));
+	}
+
+	[[nodiscard]] ssize_t SendSyncData(std::string const& Data) const { return SendFramedDataNow(Data); }
+
+	// Sends everything that was held back during the sync
+	void FinishSync()
+	{
+		std::scoped_lock Lock(SyncMutex);
+		for (auto const& Message : HeldBackMessages)
+		{
+			if (SendFramedDataNow(Message) < 0)
+			{
+				break;
+			}
+		}
+		HeldBackMessages.clear();
+		HeldBackMessages.shrink_to_fit();
+		bSyncing = false;
 	}
 
 	template <class T>
@@ -6,6 +6,7 @@
 #include "DaemonSocket.hpp"
 
 #include <filesystem>
+#include <ranges>
 #include <sys/sysinfo.h>
 
 #include "spdlog/sinks/base_sink.h"
@@ -18,6 +19,7 @@
 #include "cereal/types/unordered_map.hpp"
 #include "cereal/types/memory.hpp"
 #include "cereal/types/string.hpp"
+#include "cereal/types/utility.hpp"
 #include "cereal/archives/binary.hpp"
 // ReSharper restore CppUnusedIncludeDirective
 
@@ -31,6 +33,7 @@
 #include "MemoryUsage.hpp"
 #include "Messages.hpp"
 #include "NetworkInterface.hpp"
+#include "PipelineMetricsCollector.hpp"
 #include "Time.hpp"
 #include "Data/AppIconAtlasBuilder.hpp"
 #include "Data/ConnectionHistory.hpp"
@@ -84,51 +87,255 @@ static WSec GetSystemBootTime()
 	return WTime::GetEpochSeconds() - Info.uptime;
 }
 
-// ReSharper disable once CppDFAUnreachableFunctionCall
-static void SendInitialDataToClient(std::shared_ptr<WDaemonClient> const& Client)
+namespace
 {
-	auto& SystemMap = WSystemMap::GetInstance();
-	auto const&        Cfg = WDaemonConfig::GetInstance();
-	WDaemonConfigMessage InitialConfig{};
-	InitialConfig.bFirstTimeSetupRan = Cfg.bFirstTimeSetupRun;
-	InitialConfig.SocketMode = static_cast<int>(Cfg.DaemonSocketMode);
-	InitialConfig.DaemonGroup = Cfg.DaemonGroup;
-	InitialConfig.DaemonUser = Cfg.DaemonUser;
-	InitialConfig.SocketPath = Cfg.DaemonSocketPath;
-	InitialConfig.MainInterface = Cfg.NetworkInterfaceName;
-	InitialConfig.VpnInterface = Cfg.IngressNetworkInterfaceName;
-	InitialConfig.NetworkInterfaces = WNetworkInterface::List();
-
-	Client->SendMessage(
-		MT_Handshake, WProtocolHandshake{ WAECHTER_PROTOCOL_VERSION, GetSystemBootTime(), GIT_COMMIT_HASH });
+	// Applications, processes, sockets and peers per chunk of the initial traffic tree
+	constexpr std::size_t MaxItemsPerChunk = 1024;
+
+	// Everything a new client starts out with, copied at a single point so the updates after it apply on top.
+	// A client that resumes its session only gets the logged messages it missed instead
+	struct WInitialSync
+	{
+		WSystemItem                    Root{};
+		std::vector<WTrafficTreeChunk> Chunks{};
+		WConnectionHistoryUpdate       History{};
+		WAppIconAtlasDelta             Atlas{};
+		std::vector<std::string>       Missed{};
+		WSyncVersion                   Version{};
+	};
+
+	void CopyTraffic(ITrafficItem const& From, ITrafficItem& To)
+	{
+		To.ItemId = From.ItemId;
+		To.DownloadSpeed = From.DownloadSpeed;
+		To.UploadSpeed = From.UploadSpeed;
+		To.TotalDownloadBytes = From.TotalDownloadBytes;
+		To.TotalUploadBytes = From.TotalUploadBytes;
+	}
+
+	// The items are updated in place while counting traffic, so this only copies their values.
+	// Has to be called while DataMutex is held, serializing and sending happens outside of it
+	void CopyTrafficTree(WSystemItem const& SystemItem, WInitialSync& Sync)
 	{
-		std::lock_guard Lock(SystemMap.DataMutex);
-		Client->SendMessage(MT_TrafficTree, *SystemMap.GetSystemItem());
-		Client->SendMessage(MT_ConnectionHistory, WConnectionHistory::GetInstance().Serialize());
-		Client->SendMessage(MT_DaemonConfig, InitialConfig);
+		ZoneScopedN("CopyTrafficTree");
+		auto& Root = Sync.Root;
+		CopyTraffic(SystemItem, Root);
+		Root.HostName = SystemItem.HostName;
+		for (auto const& Filter : SystemItem.Filters)
+		{
+			Root.Filters.push_back(std::make_shared<WFilterItem>(*Filter));
+		}
+		for (auto const& Cgroup : SystemItem.Cgroups)
+		{
+			Root.Cgroups.push_back(std::make_shared<WCgroupItem>(*Cgroup));
+		}
+
+		std::size_t ItemsInChunk{};
+		auto        AddItems = [&](std::size_t const Count) -> WTrafficTreeChunk& {
+			if (Sync.Chunks.empty() || ItemsInChunk + Count > MaxItemsPerChunk)
+			{
+				Sync.Chunks.emplace_back();
+				ItemsInChunk = 0;
+			}
+			ItemsInChunk += Count;
+			return Sync.Chunks.back();
+		};
+
+		for (auto const& App : SystemItem.Applications | std::views::values)
+		{
+			auto& Copy = AddItems(1).Applications.emplace_back();
+			CopyTraffic(*App, Copy);
+			Copy.ApplicationName = App->ApplicationName;
+			Copy.ApplicationPath = App->ApplicationPath;
+			Copy.ApplicationCommandLine = App->ApplicationCommandLine;
+		}
+
+		for (auto const& App : SystemItem.Applications | std::views::values)
+		{
+			for (auto const& Process : App->Processes | std::views::values)
+			{
+				auto& Copy = AddItems(1).Processes.emplace_back(App->ItemId, WProcessItem{}).second;
+				CopyTraffic(*Process, Copy);
+				Copy.ProcessId = Process->ProcessId;
+			}
+		}
+
+		for (auto const& App : SystemItem.Applications | std::views::values)
+		{
+			for (auto const& Process : App->Processes | std::views::values)
+			{
+				for (auto const& Socket : Process->Sockets | std::views::values)
+				{
+					auto const Peers = std::min(Socket->UDPPerConnectionTraffic.size(), WSocketItem::MaxPeersInTree);
+					auto&      Copy = AddItems(1 + Peers).Sockets.emplace_back(Process->ItemId, WSocketItem{}).second;
+					CopyTraffic(*Socket, Copy);
+					Copy.SocketTuple = Socket->SocketTuple;
+					Copy.Cookie = Socket->Cookie;
+					Copy.SocketType = Socket->SocketType;
+					Copy.ConnectionState = Socket->ConnectionState;
+					Copy.PeerCount = static_cast<uint32_t>(Socket->UDPPerConnectionTraffic.size());
+					Copy.UDPPerConnectionTraffic.reserve(Peers);
+					for (std::size_t i = 0; i < Peers; ++i)
+					{
+						Copy.UDPPerConnectionTraffic.push_back(
+							std::make_shared<WTupleItem>(*Socket->UDPPerConnectionTraffic[i]));
+					}
+				}
+			}
+		}
+
+		if (Sync.Chunks.empty())
+		{
+			Sync.Chunks.emplace_back();
+		}
+		Sync.Chunks.back().bLast = true;
 	}
+} // namespace
+
+static WDaemonConfigMessage MakeConfigMessage()
+{
+	auto const&          Cfg = WDaemonConfig::GetInstance();
+	WDaemonConfigMessage Config{};
+	Config.bFirstTimeSetupRan = Cfg.bFirstTimeSetupRun;
+	Config.SocketMode = static_cast<int>(Cfg.DaemonSocketMode);
+	Config.DaemonGroup = Cfg.DaemonGroup;
+	Config.DaemonUser = Cfg.DaemonUser;
+	Config.SocketPath = Cfg.DaemonSocketPath;
+	Config.MainInterface = Cfg.NetworkInterfaceName;
+	Config.VpnInterface = Cfg.IngressNetworkInterfaceName;
+	Config.NetworkInterfaces = WNetworkInterface::List();
+	return Config;
+}
 
-	Client->SendMessage(MT_MemoryStats, WMemoryUsage::GetMemoryStats());
+// Sent before the client receives any broadcasts, anything broadcast in the meantime is held back until it's done
+static void SendInitialDataToClient(std::shared_ptr<WDaemonClient> const& Client, WInitialSync const& Sync)
+{
+	ZoneScopedN("SendInitialDataToClient");
+	Client->SendSyncMessage(MT_TrafficTree, Sync.Root);
 
-	WRuleManager::GetInstance().SendCurrentRulesToClient(Client);
+	// One chunk at a time, so the client can show the tree while the rest is still on its way
+	for (auto const& Chunk : Sync.Chunks)
+	{
+		if (Client->SendSyncMessage(MT_TrafficTreeChunk, Chunk) < 0)
+		{
+			spdlog::error("Failed to send traffic tree to client: {}", WErrnoUtil::StrError());
+			return;
+		}
+	}
+	Client->SendSyncMessage(MT_ConnectionHistory, Sync.History);
+	Client->SendSyncMessage(MT_AppIconAtlasDelta, Sync.Atlas);
+	Client->SendSyncMessage(MT_SyncVersion, Sync.Version);
+	Client->SendSyncMessage(MT_DaemonConfig, MakeConfigMessage());
+	Client->SendSyncMessage(MT_MemoryStats, WMemoryUsage::GetMemoryStats());
+	Client->SendSyncMessage(MT_PipelineMetrics, WPipelineMetricsCollector::GetInstance().Collect(false));
+}
 
-	// Send app icon atlas
-	auto const        ActiveApps = SystemMap.GetActiveApplicationPaths();
-	WAppIconAtlasData Data{};
-	if (WAppIconAtlasBuilder::GetInstance().GetAtlasData(Data, ActiveApps))
+// The missed messages end with a version marker, so the client can resume again later
+static void SendResumeDataToClient(std::shared_ptr<WDaemonClient> const& Client, WInitialSync const& Sync)
+{
+	ZoneScopedN("SendResumeDataToClient");
+	for (auto const& Message : Sync.Missed)
 	{
-		spdlog::info("Atlas has {} icons", Data.UvData.size());
-		Client->SendMessage(MT_AppIconAtlasData, Data);
+		if (Client->SendSyncData(Message) < 0)
+		{
+			spdlog::error("Failed to send missed updates to client: {}", WErrnoUtil::StrError());
+			return;
+		}
 	}
+	Client->SendSyncMessage(MT_DaemonConfig, MakeConfigMessage());
+	Client->SendSyncMessage(MT_MemoryStats, WMemoryUsage::GetMemoryStats());
+	Client->SendSyncMessage(MT_PipelineMetrics, WPipelineMetricsCollector::GetInstance().Collect(false));
 }
 
 void WDaemonSocket::OnNewConnection(std::shared_ptr<WDaemonClient> const& NewClient)
 {
-	SendInitialDataToClient(NewClient);
-	ClientsMutex.lock();
-	Clients.push_back(NewClient);
-	bHasClients = true;
-	ClientsMutex.unlock();
+	{
+		// It's synced once it told us what it still has from an earlier connection
+		std::lock_guard Lock(ClientsMutex);
+		PendingClients.push_back(NewClient);
+	}
+	NewClient->SendMessage(
+		MT_Handshake, WProtocolHandshake{ WAECHTER_PROTOCOL_VERSION, GetSystemBootTime(), GIT_COMMIT_HASH });
+	RemoveInactiveClients();
+}
+
+void WDaemonSocket::HandleClientHandshake(WDaemonClient const* Client, WBuffer const& Buffer)
+{
+	WClientHandshake Handshake{};
+	if (!DeserializeMessage(Buffer, Handshake))
+	{
+		spdlog::error("Failed to deserialize client handshake");
+		return;
+	}
+
+	std::shared_ptr<WDaemonClient> PendingClient{};
+	{
+		std::lock_guard Lock(ClientsMutex);
+		auto const      It =
+			std::ranges::find_if(PendingClients, [Client](auto const& Pending) { return Pending.get() == Client; });
+		if (It == PendingClients.end())
+		{
+			spdlog::warn("Ignoring handshake from a client that is already synced");
+			return;
+		}
+		PendingClient = *It;
+		PendingClients.erase(It);
+	}
+
+	// Requests are handled on the client's receive thread, or on its serial queue when the event loop is used.
+	// Either way sending the initial data, which blocks until the client read it, only holds up this client
+	SyncClient(PendingClient, Handshake);
+}
+
+void WDaemonSocket::SyncClient(std::shared_ptr<WDaemonClient> const& Client, WClientHandshake const& Handshake)
+{
+	auto&        SystemMap = WSystemMap::GetInstance();
+	WInitialSync Sync{};
+	bool         bResumed{};
+	{
+		// The copy and the client joining the broadcasts happen at the same point, so it doesn't miss any update.
+		// Icons of new applications are added to the atlas by the next broadcast
+		std::lock_guard Lock(ClientsMutex);
+
+		// Clients resume at a version marker, so everything logged so far has to be followed by one
+		FinishLogTick();
+		bResumed = bResumable && SessionLog.CollectSince(Handshake, Sync.Missed);
+		Sync.Version = SessionLog.GetVersion();
+
+		Client->BeginSync();
+		Clients.push_back(Client);
+		bHasClients = true;
+		LastClientSeen = WTime::GetEpochSeconds();
+		bResumable = WDaemonConfig::GetInstance().SessionResumeWindow > 0;
+
+		if (!bResumed)
+		{
+			WAppIconAtlasBuilder::GetInstance().GetFullAtlas(Sync.Atlas);
+			std::lock_guard DataLock(SystemMap.DataMutex);
+			CopyTrafficTree(*SystemMap.GetSystemItem(), Sync);
+			Sync.History = WConnectionHistory::GetInstance().Serialize();
+		}
+	}
+
+	if (bResumed)
+	{
+		SendResumeDataToClient(Client, Sync);
+		spdlog::info("Client resumed its session at version {}, sent {} missed messages", Handshake.SyncVersion.Version,
+			Sync.Missed.size());
+	}
+	else
+	{
+		SendInitialDataToClient(Client, Sync);
+		spdlog::info("Sent traffic tree in {} chunks and {} icons to new client", Sync.Chunks.size(),
+			Sync.Atlas.UpdatedSlots.size());
+	}
+	Client->FinishSync();
+
+	// Rule changes are part of the missed messages
+	if (!bResumed)
+	{
+		WRuleManager::GetInstance().SendCurrentRulesToClient(Client);
+	}
 	RemoveInactiveClients();
 }
 
@@ -187,9 +394,29 @@ void WDaemonSocket::BroadcastMemoryUsageUpdate()
 	}
 }
 
+void WDaemonSocket::BroadcastPipelineMetrics()
+{
+	std::lock_guard Lock(ClientsMutex);
+	auto            Metrics = WPipelineMetricsCollector::GetInstance().Collect(true);
+	for (std::size_t i = 0; i < Clients.size(); ++i)
+	{
+		Metrics.Clients.push_back({ fmt::format("Client {}", i + 1), Clients[i]->GetSocket()->GetSendBacklog() });
+	}
+
+	std::string const Msg = WDaemonClient::MakeMessage(MT_PipelineMetrics, Metrics);
+	for (auto const& Client : Clients)
+	{
+		if (Client->SendFramedData(Msg) < 0)
+		{
+			spdlog::error("Failed to send pipeline metrics to client: {}", WErrnoUtil::StrError());
+			Client->GetSocket()->Close();
+		}
+	}
+}
+
 void WDaemonSocket::BroadcastTrafficUpdate()
 {
-	if (!HasClients())
+	if (!IsTrackingUpdates())
 	{
 		return;
 	}
@@ -199,59 +426,113 @@ void WDaemonSocket::BroadcastTrafficUpdate()
 	std::stringstream Os{};
 	{
 		std::lock_guard            DataLock(SystemMap.DataMutex);
+		WStageTimer                CollectTimer(EPipelineStage::CollectUpdates);
 		WTrafficTreeUpdates const& Updates = SystemMap.GetUpdates();
+		CollectTimer.Stop();
+		WStageTimer const SerializeTimer(EPipelineStage::SerializeUpdates);
 		Os << MT_TrafficTreeUpdate;
 		cereal::BinaryOutputArchive Archive(Os);
 		ZoneScopedN("Archive");
 		Archive(Updates);
 	}
-	std::string const& Str = Os.str();
+	ZoneScopedN("SendTrafficUpdate");
+	LogAndSendToClients(Os.str(), "traffic update");
+}
+
+void WDaemonSocket::BroadcastConnectionHistoryUpdate(WConnectionHistoryUpdate const& Update)
+{
+	auto const      Msg = WDaemonClient::MakeMessage(MT_ConnectionHistoryUpdate, Update);
+	std::lock_guard Lock(ClientsMutex);
+	LogAndSendToClients(Msg, "connection history update");
+}
+
+void WDaemonSocket::BroadcastAtlasUpdate()
+{
+	std::lock_guard Lock(ClientsMutex);
+	BroadcastAtlasDelta();
+}
+
+void WDaemonSocket::BroadcastAtlasDelta()
+{
+	auto&              Builder = WAppIconAtlasBuilder::GetInstance();
+	auto const         ActiveApps = WSystemMap::GetInstance().GetActiveApplicationPaths();
+	WAppIconAtlasDelta Delta{};
+	Builder.ClearDirty();
+	if (Builder.Update(Delta, ActiveApps))
+	{
+		auto Msg = WDaemonClient::MakeMessage(MT_AppIconAtlasDelta, Delta);
+		spdlog::debug("App icon atlas changed, broadcasting {} new and {} removed icons ({} KiB) to clients",
+			Delta.UpdatedSlots.size(), Delta.RemovedApps.size(), Msg.length() / 1024);
+		ZoneScopedN("BroadcastAtlasUpdate.SendMessage");
+		LogAndSendToClients(Msg, "app icon atlas update");
+	}
+}
+
+void WDaemonSocket::LogAndSendToClients(std::string const& Message, std::string_view const What)
+{
+	if (bResumable)
+	{
+		SessionLog.Append(Message);
+	}
 
 	for (auto const& Client : Clients)
 	{
-		ZoneScopedN("SendTrafficUpdate");
-		if (Client->SendFramedData(Str) < 0)
+		if (Client->SendFramedData(Message) < 0)
 		{
-			spdlog::error("Failed to send traffic update to client: {}", WErrnoUtil::StrError());
+			spdlog::error("Failed to send {} to client: {}", What, WErrnoUtil::StrError());
 			Client->GetSocket()->Close();
 		}
 	}
 }
 
-void WDaemonSocket::BroadcastConnectionHistoryUpdate(WConnectionHistoryUpdate const& Update)
+void WDaemonSocket::FinishLogTick()
 {
-	std::lock_guard Lock(ClientsMutex);
+	auto const Marker = SessionLog.FinishTick(WDaemonConfig::GetInstance().SessionResumeWindow);
+	if (Marker.empty())
+	{
+		return;
+	}
+
 	for (auto const& Client : Clients)
 	{
-		if (Client->SendMessage(MT_ConnectionHistoryUpdate, Update) < 0)
+		if (Client->SendFramedData(Marker) < 0)
 		{
-			spdlog::error("Failed to send app icon atlas update to client: {}", WErrnoUtil::StrError());
+			spdlog::error("Failed to send sync version to client: {}", WErrnoUtil::StrError());
 			Client->GetSocket()->Close();
 		}
 	}
 }
 
-void WDaemonSocket::BroadcastAtlasUpdate()
+void WDaemonSocket::FinishBroadcastTick()
 {
-	auto&             SystemMap = WSystemMap::GetInstance();
-	std::lock_guard   Lock(ClientsMutex);
-	auto              ActiveApps = SystemMap.GetActiveApplicationPaths();
-	WAppIconAtlasData Data{};
-	if (WAppIconAtlasBuilder::GetInstance().GetAtlasData(Data, ActiveApps))
-	{
-		auto Msg = WDaemonClient::MakeMessage(MT_AppIconAtlasData, Data);
-		spdlog::debug("App icon atlas is dirty, broadcasting atlas update with {} KiB to clients", Msg.length() / 1024);
-		ZoneScopedN("BroadcastAtlasUpdate.SendMessage");
-		for (auto const& Client : Clients)
-		{
-			if (Client->SendFramedData(Msg) < 0)
-			{
-				spdlog::error("Failed to send app icon atlas update to client: {}", WErrnoUtil::StrError());
-				Client->GetSocket()->Close();
-			}
-		}
+	auto const      Window = static_cast<WSec>(WDaemonConfig::GetInstance().SessionResumeWindow);
+	auto const      Now = WTime::GetEpochSeconds();
+	std::lock_guard Lock(ClientsMutex);
+	std::erase_if(Clients, [](auto& Client) { return !Client->IsRunning(); });
+	bHasClients = !Clients.empty();
+	if (bHasClients)
+	{
+		LastClientSeen = Now;
 	}
-	WAppIconAtlasBuilder::GetInstance().ClearDirty();
+
+	if (bResumable && (Window == 0 || LastClientSeen + Window < Now))
+	{
+		// Nobody came back in time, the next client is synced from scratch and updates aren't tracked until then
+		SessionLog.Reset();
+		bResumable = false;
+		spdlog::debug("Session can't be resumed anymore");
+	}
+	else if (bHasClients)
+	{
+		bResumable = Window > 0;
+	}
+	FinishLogTick();
+}
+
+std::size_t WDaemonSocket::GetSessionLogMemoryUsage()
+{
+	std::lock_guard Lock(ClientsMutex);
+	return SessionLog.GetMemoryUsage();
 }
 
 void WDaemonSocket::AttachLogSink()
@@ -11,6 +11,7 @@
 #include <string_view>
 
 #include "DaemonClient.hpp"
+#include "SessionLog.hpp"
 #include "Communication/IServerSocket.hpp"
 #include "spdlog/spdlog.h"
 
@@ -25,9 +26,24 @@ class WDaemonSocket
 	std::atomic<bool>                           bHasClients{};
 	std::vector<std::shared_ptr<WDaemonClient>> Clients;
 
+	// Connected, but they didn't answer the handshake yet
+	std::vector<std::shared_ptr<WDaemonClient>> PendingClients;
+
+	// Guarded by ClientsMutex, updates are still tracked for a while after the last client left so it can resume.
+	// Broadcasts are only logged while bResumable is set
+	WSessionLog       SessionLog{};
+	WSec              LastClientSeen{};
+	std::atomic<bool> bResumable{};
+
 	void        AttachLogSink();
 	static void DetachLogSink();
 	void OnNewConnection(std::shared_ptr<WDaemonClient> const& NewClient);
+	void SyncClient(std::shared_ptr<WDaemonClient> const& Client, WClientHandshake const& Handshake);
+
+	// Have to be called with ClientsMutex held
+	void BroadcastAtlasDelta();
+	void LogAndSendToClients(std::string const& Message, std::string_view What);
+	void FinishLogTick();
 
 public:
 	explicit WDaemonSocket(std::string const& Path);
@@ -48,19 +64,53 @@ public:
 
 	[[nodiscard]] bool HasClients() const { return bHasClients; }
 
+	// Also true while a client that lost its connection can still resume its session
+	[[nodiscard]] bool IsTrackingUpdates() const { return bHasClients || bResumable; }
+
 	void RemoveInactiveClients()
 	{
 		ClientsMutex.lock();
 		std::erase_if(Clients, [](auto& Client) { return !Client->IsRunning(); });
+		std::erase_if(PendingClients, [](auto& Client) { return !Client->IsRunning(); });
 		bHasClients = !Clients.empty();
 		ClientsMutex.unlock();
 	}
 
+	// The client's answer to the handshake, it's synced from the version it last received if that's still logged
+	void HandleClientHandshake(WDaemonClient const* Client, WBuffer const& Buffer);
+
+	// Ends a round of broadcasts, clients that reconnect can resume after it
+	void FinishBroadcastTick();
+
+	std::size_t GetSessionLogMemoryUsage();
+
 	void BroadcastMemoryUsageUpdate();
+	void BroadcastPipelineMetrics();
 	void BroadcastTrafficUpdate();
 	void BroadcastConnectionHistoryUpdate(WConnectionHistoryUpdate const& Update);
 	void BroadcastAtlasUpdate();
 
+	// For messages that change the state of clients, a client that reconnects receives them again if it missed them
+	template <typename T>
+	void BroadcastLoggedMessage(EMessageType Type, T const& Message, WDaemonClient const* Except = nullptr)
+	{
+		std::string const& Msg = WDaemonClient::MakeMessage(Type, Message);
+		std::lock_guard    Lock(ClientsMutex);
+		if (bResumable)
+		{
+			SessionLog.Append(Msg, Except == nullptr);
+		}
+
+		for (auto const& Client : Clients)
+		{
+			if (Client.get() != Except && Client->SendFramedData(Msg) < 0)
+			{
+				spdlog::error("Failed to send message to client: {}", WErrnoUtil::StrError());
+				Client->GetSocket()->Close();
+			}
+		}
+	}
+
 	template <typename T>
 	void BroadcastMessage(EMessageType Type, T const& Message, WDaemonClient const* Except = nullptr)
 	{
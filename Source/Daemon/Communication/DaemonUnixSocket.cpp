@@ -14,10 +14,12 @@
 #include "Filesystem.hpp"
 #include "DaemonClient.hpp"
 #include "DaemonConfig.hpp"
+#include "EventLoop.hpp"
 
 void WDaemonUnixSocket::Stop()
 {
 	Running = false;
+	WEventLoop::GetInstance().Remove(ListenWatch);
 	Socket->Close();
 	if (ListenThread.joinable())
 	{
@@ -43,6 +45,11 @@ bool WDaemonUnixSocket::StartListenThread()
 		return false;
 	}
 	Running = true;
+	if (auto& Loop = WEventLoop::GetInstance(); Loop.IsEnabled())
+	{
+		ListenWatch = Loop.Add(Socket->GetFd(), EPOLLIN, [this](uint32_t) { AcceptClient(0); });
+		return ListenWatch != 0;
+	}
 	ListenThread = std::thread(&WDaemonUnixSocket::ListenThreadFunction, this);
 	return true;
 }
@@ -51,17 +58,30 @@ void WDaemonUnixSocket::ListenThreadFunction() const
 {
 	tracy::SetThreadName("DaemonSocket");
 	pthread_setname_np(pthread_self(), "us-server");
-	WBuffer Buffer;
 	while (Running)
 	{
-		if (auto ClientSocket = Socket->Accept(500))
-		{
-			spdlog::info("Client connected");
-			auto NewSocket = std::make_shared<WClientUnixSocket>(ClientSocket);
-			auto NewClient = std::make_shared<WDaemonClient>(NewSocket);
-			OnNewConnection(NewClient);
-		}
+		AcceptClient(500);
+	}
+}
+
+void WDaemonUnixSocket::AcceptClient(int const TimeoutMs) const
+{
+	auto ClientSocket = Socket->Accept(TimeoutMs);
+	if (!ClientSocket)
+	{
+		return;
+	}
+
+	spdlog::info("Client connected");
+	auto NewSocket = std::make_shared<WClientUnixSocket>(ClientSocket);
+	auto NewClient = std::make_shared<WDaemonClient>(NewSocket);
+	if (auto& Loop = WEventLoop::GetInstance(); Loop.IsEnabled())
+	{
+		// Sending the initial data blocks until the client read it
+		Loop.Post([this, NewClient] { OnNewConnection(NewClient); });
+		return;
 	}
+	OnNewConnection(NewClient);
 }
 
 WDaemonUnixSocket::WDaemonUnixSocket()
@@ -16,8 +16,10 @@ class WDaemonUnixSocket final : public IServerSocket
 	std::atomic<bool> Running{ false };
 	std::thread       ListenThread{};
 	std::string       SocketPath{};
+	uint64_t          ListenWatch{}; // set if the event loop accepts the clients
 
 	void                                                   ListenThreadFunction() const;
+	void                                                   AcceptClient(int TimeoutMs) const;
 	sigslot::signal<std::shared_ptr<WDaemonClient> const&> OnNewConnection;
 
 public:
@@ -22,4 +22,7 @@ public:
 	virtual void Close() = 0;
 
 	virtual ssize_t SendFramed(std::string const&) { return -1; }
+
+	// Bytes that were accepted by SendFramed but haven't reached the client yet
+	[[nodiscard]] virtual std::size_t GetSendBacklog() const { return 0; }
 };
\ No newline at end of file
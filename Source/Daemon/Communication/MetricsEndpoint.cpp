@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "MetricsEndpoint.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "spdlog/spdlog.h"
+#include "tracy/Tracy.hpp"
+
+#include "DaemonConfig.hpp"
+#include "ErrnoUtil.hpp"
+#include "Filesystem.hpp"
+#include "Types.hpp"
+
+namespace
+{
+	constexpr std::chrono::milliseconds RequestTimeout{ 2000 };
+	constexpr std::size_t               MaxRequestSize = 8 WKiB;
+
+	bool SendAll(int const Fd, std::string_view Data)
+	{
+		while (!Data.empty())
+		{
+			auto const Sent = send(Fd, Data.data(), Data.size(), MSG_NOSIGNAL);
+			if (Sent < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return false;
+			}
+			Data.remove_prefix(static_cast<std::size_t>(Sent));
+		}
+		return true;
+	}
+
+	void SendResponse(int const Fd, std::string_view const Status, std::string_view const ContentType,
+		std::string_view const Body, bool const bHeadOnly)
+	{
+		auto const Header = fmt::format(
+			"HTTP/1.1 {}\r\nContent-Type: {}\r\nContent-Length: {}\r\nConnection: close\r\n\r\n", Status,
+			ContentType, Body.size());
+		if (SendAll(Fd, Header) && !bHeadOnly)
+		{
+			SendAll(Fd, Body);
+		}
+	}
+} // namespace
+
+bool WMetricsEndpoint::ListenUnix()
+{
+	sockaddr_un Addr{};
+	Addr.sun_family = AF_UNIX;
+	if (Address.size() >= sizeof(Addr.sun_path))
+	{
+		errno = ENAMETOOLONG;
+		return false;
+	}
+	strncpy(Addr.sun_path, Address.c_str(), sizeof(Addr.sun_path) - 1);
+	unlink(Address.c_str());
+
+	ListenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (ListenFd < 0 || bind(ListenFd, reinterpret_cast<sockaddr*>(&Addr), sizeof(Addr)) != 0
+		|| listen(ListenFd, 16) != 0)
+	{
+		return false;
+	}
+
+	auto const& Cfg = WDaemonConfig::GetInstance();
+	return WFilesystem::SetSocketOwnerAndPermsByName(Address, Cfg.DaemonUser, Cfg.DaemonGroup, Cfg.DaemonSocketMode);
+}
+
+bool WMetricsEndpoint::ListenTcp()
+{
+	auto const Separator = Address.rfind(':');
+	if (Separator == std::string::npos)
+	{
+		errno = EINVAL;
+		return false;
+	}
+	std::string       Host = Address.substr(0, Separator);
+	std::string const Port = Address.substr(Separator + 1);
+	if (Host.size() >= 2 && Host.front() == '[' && Host.back() == ']')
+	{
+		Host = Host.substr(1, Host.size() - 2);
+	}
+
+	// An empty host listens on every address
+	addrinfo Hints{};
+	Hints.ai_family = AF_UNSPEC;
+	Hints.ai_socktype = SOCK_STREAM;
+	Hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST | AI_NUMERICSERV;
+	addrinfo* Result{};
+	if (auto const Error = getaddrinfo(Host.empty() ? nullptr : Host.c_str(), Port.c_str(), &Hints, &Result);
+		Error != 0)
+	{
+		spdlog::error("Invalid metrics address {}: {}", Address, gai_strerror(Error));
+		errno = EINVAL;
+		return false;
+	}
+
+	int const One = 1;
+	ListenFd = socket(Result->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	bool const bListening = ListenFd >= 0 && setsockopt(ListenFd, SOL_SOCKET, SO_REUSEADDR, &One, sizeof(One)) == 0
+		&& bind(ListenFd, Result->ai_addr, Result->ai_addrlen) == 0 && listen(ListenFd, 16) == 0;
+	freeaddrinfo(Result);
+	return bListening;
+}
+
+bool WMetricsEndpoint::Start()
+{
+	if (!(IsUnixSocket() ? ListenUnix() : ListenTcp()))
+	{
+		spdlog::error("Failed to listen for metrics scrapes on {}: {}", Address, WErrnoUtil::StrError());
+		if (ListenFd >= 0)
+		{
+			close(ListenFd);
+			ListenFd = -1;
+		}
+		return false;
+	}
+
+	bRunning = true;
+	ListenThread = std::thread(&WMetricsEndpoint::ListenThreadFunction, this);
+	spdlog::info("Serving metrics on {}", Address);
+	return true;
+}
+
+void WMetricsEndpoint::Stop()
+{
+	bRunning = false;
+	if (ListenThread.joinable())
+	{
+		ListenThread.join();
+	}
+	if (ListenFd >= 0)
+	{
+		close(ListenFd);
+		ListenFd = -1;
+		if (IsUnixSocket())
+		{
+			unlink(Address.c_str());
+		}
+	}
+}
+
+void WMetricsEndpoint::ListenThreadFunction() const
+{
+	tracy::SetThreadName("MetricsEndpoint");
+	pthread_setname_np(pthread_self(), "metrics");
+	while (bRunning)
+	{
+		pollfd Pfd{ ListenFd, POLLIN, 0 };
+		if (poll(&Pfd, 1, 500) <= 0 || !(Pfd.revents & POLLIN))
+		{
+			continue;
+		}
+
+		// Scrapes are rare and cheap, so they are answered one after another on this thread
+		if (int const ClientFd = accept4(ListenFd, nullptr, nullptr, SOCK_CLOEXEC); ClientFd >= 0)
+		{
+			HandleConnection(ClientFd);
+			close(ClientFd);
+		}
+	}
+}
+
+void WMetricsEndpoint::HandleConnection(int const Fd) const
+{
+	ZoneScopedN("WMetricsEndpoint::HandleConnection");
+	timeval const SendTimeout{ std::chrono::duration_cast<std::chrono::seconds>(RequestTimeout).count(), 0 };
+	setsockopt(Fd, SOL_SOCKET, SO_SNDTIMEO, &SendTimeout, sizeof(SendTimeout));
+
+	// Read the whole header, closing with unread data would reset the connection before the response arrives
+	auto const  Deadline = std::chrono::steady_clock::now() + RequestTimeout;
+	std::string Request{};
+	char        Buffer[1024];
+	while (Request.find("\r\n\r\n") == std::string::npos && Request.size() < MaxRequestSize)
+	{
+		auto const Remaining =
+			std::chrono::duration_cast<std::chrono::milliseconds>(Deadline - std::chrono::steady_clock::now());
+		pollfd Pfd{ Fd, POLLIN, 0 };
+		if (Remaining.count() <= 0 || poll(&Pfd, 1, static_cast<int>(Remaining.count())) <= 0)
+		{
+			return;
+		}
+		auto const Received = recv(Fd, Buffer, sizeof(Buffer), 0);
+		if (Received <= 0)
+		{
+			return;
+		}
+		Request.append(Buffer, static_cast<std::size_t>(Received));
+	}
+
+	// Only the request line matters: "<method> <target> HTTP/1.x"
+	std::string_view const Line = std::string_view(Request).substr(0, Request.find("\r\n"));
+	auto const             MethodEnd = Line.find(' ');
+	std::string_view const Method = Line.substr(0, MethodEnd);
+	std::string_view       Target{};
+	if (MethodEnd != std::string_view::npos)
+	{
+		Target = Line.substr(MethodEnd + 1);
+		Target = Target.substr(0, Target.find_first_of(" ?"));
+	}
+
+	constexpr std::string_view TextType = "text/plain; charset=utf-8";
+	bool const                 bHeadOnly = Method == "HEAD";
+	if (Method != "GET" && !bHeadOnly)
+	{
+		SendResponse(Fd, "405 Method Not Allowed", TextType, "Only GET and HEAD are supported\n", false);
+	}
+	else if (Target != "/metrics")
+	{
+		SendResponse(Fd, "404 Not Found", TextType, "Metrics are served on /metrics\n", bHeadOnly);
+	}
+	else
+	{
+		SendResponse(
+			Fd, "200 OK", "application/openmetrics-text; version=1.0.0; charset=utf-8", Render(), bHeadOnly);
+	}
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+// Just enough HTTP/1.x for a scraper: GET /metrics returns whatever Render produces, every connection
+// is closed after one response. Listens on "<host>:<port>" (IPv6 hosts in brackets) or on a unix socket
+// if the address is a path, which can be exposed through a local reverse proxy.
+class WMetricsEndpoint
+{
+	std::string                  Address{};
+	std::function<std::string()> Render{};
+
+	int               ListenFd{ -1 };
+	std::atomic<bool> bRunning{ false };
+	std::thread       ListenThread{};
+
+	[[nodiscard]] bool IsUnixSocket() const { return Address.starts_with("/"); }
+
+	bool ListenUnix();
+	bool ListenTcp();
+
+	void ListenThreadFunction() const;
+	void HandleConnection(int Fd) const;
+
+public:
+	WMetricsEndpoint(std::string Address_, std::function<std::string()> Render_)
+		: Address(std::move(Address_)), Render(std::move(Render_))
+	{
+	}
+
+	~WMetricsEndpoint() { Stop(); }
+
+	WMetricsEndpoint(WMetricsEndpoint const&) = delete;
+	WMetricsEndpoint& operator=(WMetricsEndpoint const&) = delete;
+
+	bool Start();
+	void Stop();
+};
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "SessionLog.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+
+#include "Messages.hpp"
+#include "Time.hpp"
+
+WSessionLog::WSessionLog()
+{
+	// Clients compare it to the one they synced with, so it has to change on every start
+	std::random_device Random{};
+	while (SessionId == 0)
+	{
+		SessionId = (static_cast<uint64_t>(Random()) << 32) | Random();
+	}
+}
+
+void WSessionLog::Append(std::string const& Message, bool const bSentToAll)
+{
+	Entries.push_back({ Version + 1, WTime::GetEpochSeconds(), Message, bSentToAll });
+	Bytes += Message.size();
+	bPendingMarker = true;
+}
+
+std::string WSessionLog::FinishTick(WSec const MaxAge)
+{
+	std::string Marker{};
+	if (bPendingMarker)
+	{
+		++Version;
+		Marker = SerializeMessage(MT_SyncVersion, GetVersion());
+		Entries.push_back({ Version, WTime::GetEpochSeconds(), Marker, true });
+		Bytes += Marker.size();
+		bPendingMarker = false;
+	}
+	Trim(MaxAge);
+	return Marker;
+}
+
+void WSessionLog::Trim(WSec const MaxAge)
+{
+	auto const Now = WTime::GetEpochSeconds();
+	while (!Entries.empty() && Entries.front().Version <= Version
+		&& (Bytes > MaxBytes || Entries.front().Time + MaxAge < Now))
+	{
+		// Only whole ticks, a client at the last dropped version can still resume
+		auto const Dropped = Entries.front().Version;
+		while (!Entries.empty() && Entries.front().Version == Dropped)
+		{
+			Bytes -= Entries.front().Message.size();
+			Entries.pop_front();
+		}
+		OldestVersion = Dropped;
+	}
+}
+
+void WSessionLog::Reset()
+{
+	Entries.clear();
+	Entries.shrink_to_fit();
+	Bytes = 0;
+	bPendingMarker = false;
+	++Version;
+	OldestVersion = Version;
+}
+
+bool WSessionLog::CollectSince(WClientHandshake const& Client, std::vector<std::string>& Out) const
+{
+	auto const& [ClientSession, ClientVersion] = Client.SyncVersion;
+	if (ClientSession != SessionId || ClientVersion < OldestVersion || ClientVersion > Version)
+	{
+		return false;
+	}
+
+	auto const First = std::ranges::partition_point(
+		Entries, [ClientVersion](WEntry const& Entry) { return Entry.Version <= ClientVersion; });
+
+	// The connection was lost in the middle of a tick, the client already has the start of it
+	uint32_t Skipped{};
+	for (auto It = First; It != Entries.end(); ++It)
+	{
+		bool const bIsMarker = std::next(It) == Entries.end() || std::next(It)->Version != It->Version;
+		if (It->Version == ClientVersion + 1 && It->bSentToAll && !bIsMarker && Skipped < Client.ReceivedSinceVersion)
+		{
+			++Skipped;
+			continue;
+		}
+		Out.push_back(It->Message);
+	}
+	return true;
+}
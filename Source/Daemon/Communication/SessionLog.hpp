@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "Types.hpp"
+#include "Data/Protocol.hpp"
+
+/**
+ * Recent broadcasts that changed what clients know (traffic tree updates, connection history, icon atlas and rules),
+ * so a client that lost its connection only receives what it missed instead of everything again.
+ * Every broadcast tick that logged something ends with a version marker, a client resumes after the last
+ * marker it received. Only keeps whole ticks of the last few minutes, older versions need a full sync.
+ * Not thread safe, the daemon socket uses it with its clients mutex held.
+ */
+class WSessionLog
+{
+	struct WEntry
+	{
+		uint64_t    Version{}; // the marker this message is followed by
+		WSec        Time{};
+		std::string Message{};
+		bool        bSentToAll{};
+	};
+
+	std::deque<WEntry> Entries{};
+	std::size_t        Bytes{};
+	uint64_t           SessionId{};
+	uint64_t           Version{};
+
+	// Clients at an older version missed messages that aren't logged anymore
+	uint64_t OldestVersion{};
+
+	bool bPendingMarker{};
+
+	void Trim(WSec MaxAge);
+
+public:
+	// Upper bound for the size of the logged messages
+	static constexpr std::size_t MaxBytes = 32 * 1024 * 1024;
+
+	WSessionLog();
+
+	// Messages that didn't go to every client (rule changes skip the client that made them) aren't counted
+	// in WClientHandshake::ReceivedSinceVersion, they're always sent again and have to be idempotent
+	void Append(std::string const& Message, bool bSentToAll = true);
+
+	// Returns the marker that has to be broadcast, or an empty string if nothing was logged since the last one.
+	// Drops ticks older than MaxAge
+	std::string FinishTick(WSec MaxAge);
+
+	// Nothing before this point can be resumed anymore, e.g. because updates weren't tracked for a while
+	void Reset();
+
+	// Appends everything the client missed to Out, returns false if it needs a full sync instead
+	bool CollectSince(WClientHandshake const& Client, std::vector<std::string>& Out) const;
+
+	[[nodiscard]] WSyncVersion GetVersion() const { return { SessionId, Version }; }
+
+	[[nodiscard]] std::size_t GetMemoryUsage() const { return Bytes + Entries.size() * sizeof(WEntry); }
+};
@@ -12,10 +12,14 @@
 
 #include "DaemonConfig.hpp"
 #include "ErrnoUtil.hpp"
+#include "EventLoop.hpp"
+#include "MetricsExporter.hpp"
+#include "PipelineMetricsCollector.hpp"
 #include "SignalHandler.hpp"
 #include "Communication/ClientWebSocket.hpp"
 #include "Data/AppIconAtlasBuilder.hpp"
 #include "Data/ConnectionHistory.hpp"
+#include "Data/ProcessInfoCache.hpp"
 #include "Data/SystemMap.hpp"
 #include "Db/StatsManager.hpp"
 #include "EBPF/EbpfData.hpp"
@@ -31,6 +35,15 @@ void WDaemon::EbpfPollThreadFunction()
 	pthread_setname_np(pthread_self(), "ebpf-poll");
 	auto const& SignalHandler = WSignalHandler::GetInstance();
 
+	if (Replay)
+	{
+		auto const Result = Replay->Run(&WWaechterEbpf::HandleRecordedEvent, SignalHandler.bStop);
+		// The daemon keeps running, so clients can still look at the result
+		spdlog::info("Replayed {} socket events in {} ms ({:.0f} events/s)", Result.Events, Result.Duration,
+			Result.GetEventsPerSecond());
+		return;
+	}
+
 	while (!SignalHandler.bStop)
 	{
 		EbpfObj.UpdateData();
@@ -39,7 +52,7 @@ void WDaemon::EbpfPollThreadFunction()
 
 void WDaemon::BroadcastUpdates() const
 {
-	if (!DaemonSocket->HasClients())
+	if (!DaemonSocket->IsTrackingUpdates())
 	{
 		return;
 	}
@@ -66,24 +79,31 @@ void WDaemon::BroadcastUpdates() const
 			DaemonSocket->BroadcastConnectionHistoryUpdate(Updates);
 		}
 	}
+
+	{
+		ZoneScopedN("BroadcastPipelineMetrics");
+		DaemonSocket->BroadcastPipelineMetrics();
+	}
+	DaemonSocket->FinishBroadcastTick();
 }
 
-void WDaemon::PeriodicUpdatesThreadFunction() const
+template <typename TTimers>
+void WDaemon::AddPeriodicTimers(TTimers& Timers) const
 {
-	tracy::SetThreadName("periodic-updates");
-	pthread_setname_np(pthread_self(), "per-updates");
-
-	auto const& SignalHandler = WSignalHandler::GetInstance();
-	auto&       TimerManager = WTimerManager::GetInstance();
-	double      Time = 0;
-
-	TimerManager.Start(Time);
-	TimerManager.AddTimer(1, [this] {
-		ZoneScopedN("RefreshAllTrafficCounters");
-		WSystemMap::GetInstance().RefreshAllTrafficCounters();
+	Timers.AddTimer(1, [this] {
+		EbpfObj.SweepKernelCounters();
+		{
+			ZoneScopedN("RefreshAllTrafficCounters");
+			WStageTimer const Timer(EPipelineStage::RefreshCounters);
+			WSystemMap::GetInstance().RefreshAllTrafficCounters();
+		}
+		if (WMetricsExporter::GetInstance().IsEnabled())
+		{
+			WMetricsExporter::GetInstance().UpdateSnapshot();
+		}
 		BroadcastUpdates();
 	});
-	TimerManager.AddTimer(5, [this] {
+	Timers.AddTimer(5, [this] {
 		if (!DaemonSocket->HasClients())
 		{
 			return;
@@ -91,17 +111,37 @@ void WDaemon::PeriodicUpdatesThreadFunction() const
 		ZoneScopedN("BroadcastMemoryUsageUpdate");
 		DaemonSocket->BroadcastMemoryUsageUpdate();
 	});
-	TimerManager.AddAlignedTimer(60 * 60, [] { WStatsManager::GetInstance().MakeSnapshot(); });
+	Timers.AddTimer(5, [] {
+		// Newly installed applications might have brought icons for apps we couldn't resolve before
+		if (auto& AtlasBuilder = WAppIconAtlasBuilder::GetInstance(); AtlasBuilder.GetResolver().CheckForChanges())
+		{
+			AtlasBuilder.MarkDirty();
+		}
+	});
+	Timers.AddAlignedTimer(60 * 60, [] { WStatsManager::GetInstance().MakeSnapshot(); });
 
 #if WDEBUG
 	// WStatsManager::GetInstance().PushDebugSnapshots();
 #endif
+}
+
+void WDaemon::PeriodicUpdatesThreadFunction() const
+{
+	tracy::SetThreadName("periodic-updates");
+	pthread_setname_np(pthread_self(), "per-updates");
+
+	auto const&      SignalHandler = WSignalHandler::GetInstance();
+	auto&            TimerManager = WTimerManager::GetInstance();
+	WStopwatch const Clock{};
+
+	TimerManager.Start(0);
+	AddPeriodicTimers(TimerManager);
 
 	while (!SignalHandler.bStop)
 	{
 		std::this_thread::sleep_for(std::chrono::milliseconds(100));
-		Time += 0.1;
-		TimerManager.UpdateTimers(Time);
+		// The sleep and the timers themselves take longer than 100 ms, so the actual time is passed on
+		TimerManager.UpdateTimers(static_cast<double>(Clock.ElapsedUs()) / 1e6);
 		if (SignalHandler.bStop)
 		{
 			break;
@@ -109,6 +149,26 @@ void WDaemon::PeriodicUpdatesThreadFunction() const
 	}
 }
 
+void WDaemon::RunEventLoop()
+{
+	auto&       Loop = WEventLoop::GetInstance();
+	auto const& Data = EbpfObj.GetData();
+
+	// The ring buffers' epoll fds become readable once the eBPF programs submitted something
+	auto const OnRingBufferData = [this](uint32_t) { EbpfObj.ConsumeData(); };
+	Loop.Add(Data->SocketEvents->GetEpollFd(), EPOLLIN, OnRingBufferData);
+	if (Data->DnsAnswers && Data->DnsAnswers->IsValid())
+	{
+		Loop.Add(Data->DnsAnswers->GetEpollFd(), EPOLLIN, OnRingBufferData);
+	}
+	AddPeriodicTimers(Loop);
+
+	std::thread LoopThread(&WEventLoop::Run, &Loop);
+	WSignalHandler::GetInstance().Wait();
+	Loop.Stop();
+	LoopThread.join();
+}
+
 WDaemon::WDaemon()
 {
 	WDaemonConfig::BTFTest();
@@ -124,6 +184,21 @@ bool WDaemon::InitEbpfObj()
 	return true;
 }
 
+bool WDaemon::InitReplay(std::string const& Path, double const Speed)
+{
+	Replay = std::make_unique<WSocketEventReplay>(Path, Speed);
+	if (!Replay->IsValid())
+	{
+		Replay.reset();
+		return false;
+	}
+
+	// The recorded processes don't exist here, their exits are part of the log (if the eBPF program reported them)
+	WProcessInfoCache::GetInstance().SetBackend(std::make_unique<WReplayProcessInfoBackend>());
+	WProcessInfoCache::GetInstance().UseKernelProcessEvents();
+	return true;
+}
+
 bool WDaemon::InitSocket()
 {
 	DaemonSocket = std::make_shared<WDaemonSocket>(WDaemonConfig::GetInstance().DaemonSocketPath);
@@ -134,6 +209,9 @@ bool WDaemon::InitSocket()
 		return false;
 	}
 
+	// Optional, the daemon is still usable without it
+	WMetricsExporter::GetInstance().Start();
+
 	return true;
 }
 
@@ -147,13 +225,21 @@ void WDaemon::RunLoop()
 	tracy::SetThreadName("main");
 	pthread_setname_np(pthread_self(), "main");
 
-	EbpfPollThread = std::thread(&WDaemon::EbpfPollThreadFunction, this);
-	PeriodicUpdatesThread = std::thread(&WDaemon::PeriodicUpdatesThreadFunction, this);
+	if (WEventLoop::GetInstance().IsEnabled())
+	{
+		RunEventLoop();
+	}
+	else
+	{
+		EbpfPollThread = std::thread(&WDaemon::EbpfPollThreadFunction, this);
+		PeriodicUpdatesThread = std::thread(&WDaemon::PeriodicUpdatesThreadFunction, this);
 
-	WSignalHandler::GetInstance().Wait();
-	EbpfPollThread.join();
-	PeriodicUpdatesThread.join();
+		WSignalHandler::GetInstance().Wait();
+		EbpfPollThread.join();
+		PeriodicUpdatesThread.join();
+	}
 	DaemonSocket->Stop();
+	WMetricsExporter::GetInstance().Stop();
 }
 
 WMemoryStat WDaemon::GetMemoryUsage()
@@ -163,13 +249,24 @@ WMemoryStat WDaemon::GetMemoryUsage()
 
 	WMemoryStatEntry EbpfDataEntry{};
 	EbpfDataEntry.Name = "Ebpf data";
-	auto const& Data = EbpfObj.GetData();
-	EbpfDataEntry.Usage += sizeof(Data->PidDownloadMarks) * 3; // all three maps should be the same, none cache any data
+	if (auto const& Data = EbpfObj.GetData())
+	{
+		// all three maps should be the same, none cache any data
+		EbpfDataEntry.Usage += sizeof(Data->PidDownloadMarks) * 3;
 
-	EbpfDataEntry.Usage += sizeof(Data->SocketEvents);
-	Data->SocketEvents->GetDataMutex().lock();
-	EbpfDataEntry.Usage += Data->SocketEvents->GetData().size() * sizeof(WSocketEvent);
-	Data->SocketEvents->GetDataMutex().unlock();
+		EbpfDataEntry.Usage += sizeof(Data->SocketEvents);
+		Data->SocketEvents->GetDataMutex().lock();
+		EbpfDataEntry.Usage += Data->SocketEvents->GetData().size() * sizeof(WSocketEvent);
+		Data->SocketEvents->GetDataMutex().unlock();
+		if (Data->UdpFlows)
+		{
+			EbpfDataEntry.Usage += Data->UdpFlows->GetMemoryUsage();
+		}
+		if (Data->CgroupTraffic)
+		{
+			EbpfDataEntry.Usage += Data->CgroupTraffic->GetMemoryUsage();
+		}
+	}
 
 	WMemoryStatEntry SocketEntry{};
 	SocketEntry.Name = "Daemon socket";
@@ -185,7 +282,12 @@ WMemoryStat WDaemon::GetMemoryUsage()
 	}
 #endif
 
+	WMemoryStatEntry SessionLogEntry{};
+	SessionLogEntry.Name = "Session log";
+	SessionLogEntry.Usage = DaemonSocket->GetSessionLogMemoryUsage();
+
 	Stats.ChildEntries.emplace_back(EbpfDataEntry);
 	Stats.ChildEntries.emplace_back(SocketEntry);
+	Stats.ChildEntries.emplace_back(SessionLogEntry);
 	return Stats;
 }
\ No newline at end of file
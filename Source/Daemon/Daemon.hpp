@@ -7,6 +7,7 @@
 #include "Singleton.hpp"
 #include "MemoryStats.hpp"
 #include "EBPF/WaechterEbpf.hpp"
+#include "EBPF/SocketEventReplay.hpp"
 #include "Communication/DaemonSocket.hpp"
 
 class WDaemon : public TSingleton<WDaemon>, public IMemoryTrackable
@@ -15,22 +16,35 @@ class WDaemon : public TSingleton<WDaemon>, public IMemoryTrackable
 	std::thread   EbpfPollThread{};
 	std::thread   PeriodicUpdatesThread{};
 
+	// Set if the daemon runs on a recorded socket event log instead of the eBPF programs
+	std::unique_ptr<WSocketEventReplay> Replay{};
+
 	std::shared_ptr<WDaemonSocket> DaemonSocket{};
 
 	void EbpfPollThreadFunction();
 
 	void PeriodicUpdatesThreadFunction() const;
 
+	// Used with the epoll event loop instead of the two threads above
+	void RunEventLoop();
+
+	// Works with both WTimerManager and WEventLoop
+	template <typename TTimers>
+	void AddPeriodicTimers(TTimers& Timers) const;
+
 	void BroadcastUpdates() const;
 
 public:
 	WDaemon();
 	bool        InitEbpfObj();
 	bool        InitSocket();
+	bool        InitReplay(std::string const& Path, double Speed);
 	static void RegisterSignalHandlers();
 
 	WWaechterEbpf& GetEbpfObj() { return EbpfObj; }
 
+	[[nodiscard]] bool IsReplaying() const { return Replay != nullptr; }
+
 	void RunLoop();
 
 	[[nodiscard]] std::shared_ptr<WDaemonSocket> const& GetDaemonSocket() const { return DaemonSocket; }
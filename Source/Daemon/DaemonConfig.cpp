@@ -125,6 +125,25 @@ void WDaemonConfig::Load(std::string const& Path)
 	SafeGet("daemon", "ip_proc_socket_path", IpLinkProcSocketPath);
 	SafeGet("daemon", "websocket_auth_token", WebSocketAuthToken);
 	SafeGetBool("daemon", "first_time_setup_run", bFirstTimeSetupRun);
+	SafeGetInt("daemon", "udp_peer_limit", UdpPeerLimit);
+	UdpPeerLimit = std::clamp(UdpPeerLimit, 1, 65536);
+	SafeGetBool("daemon", "kernel_udp_accounting", bKernelUdpAccounting);
+	SafeGetBool("daemon", "cgroup_accounting", bCgroupAccounting);
+	SafeGetBool("daemon", "epoll_event_loop", bEpollEventLoop);
+	SafeGetInt("daemon", "worker_threads", WorkerThreads);
+	WorkerThreads = std::clamp(WorkerThreads, 1, 16);
+	SafeGetBool("daemon", "hot_restart", bHotRestart);
+	SafeGetInt("daemon", "session_resume_window", SessionResumeWindow);
+	SessionResumeWindow = std::clamp(SessionResumeWindow, 0, 3600);
+
+	SafeGetInt("resolver", "threads", ResolverThreads);
+	ResolverThreads = std::clamp(ResolverThreads, 1, 64);
+	std::string PersistResolvedHosts{};
+	SafeGet("resolver", "persist_hostnames", PersistResolvedHosts);
+	bPersistResolvedHosts = PersistResolvedHosts != "false";
+	std::string SnoopDns{};
+	SafeGet("resolver", "snoop_dns", SnoopDns);
+	bSnoopDns = SnoopDns != "false";
 
 	int SocketMode{ static_cast<int>(DaemonSocketMode) };
 	SafeGetInt("daemon", "socket_permissions", SocketMode);
@@ -138,7 +157,7 @@ void WDaemonConfig::Load(std::string const& Path)
 	std::string IgnoredConnectionHistoryAppNamesStr{};
 	std::string IgnoredConnectionHistoryPortsStr{};
 	SafeGet("daemon", "ignored_connection_history_app_names", IgnoredConnectionHistoryAppNamesStr);
-	SafeGet("daemon", "ignored_connection_history_remote_ports", IgnoredConnectionHistoryAppNamesStr);
+	SafeGet("daemon", "ignored_connection_history_remote_ports", IgnoredConnectionHistoryPortsStr);
 
 	IgnoredConnectionHistoryApps = WStringFormat::SplitString(IgnoredConnectionHistoryAppNamesStr, ';');
 	for (auto const& PortStr : WStringFormat::SplitString(IgnoredConnectionHistoryPortsStr, ';'))
@@ -153,6 +172,38 @@ void WDaemonConfig::Load(std::string const& Path)
 			spdlog::error("Invalid port '{}' in ignored_connection_history_remote_ports: {}", PortStr, e.what());
 		}
 	}
+
+	SafeGet("metrics", "listen", MetricsListenAddress);
+	SafeGetInt("metrics", "max_apps", MetricsMaxApps);
+	MetricsMaxApps = std::clamp(MetricsMaxApps, 0, 10000);
+
+	SafeGetBool("exclusions", "loopback", Exclusions.bLoopback);
+	SafeGet("exclusions", "interfaces", Exclusions.Interfaces);
+	SafeGet("exclusions", "ports", Exclusions.Ports);
+	SafeGet("exclusions", "cgroups", Exclusions.Cgroups);
+
+	Filters.clear();
+	for (auto const& [Section, Values] : Ini)
+	{
+		if (!WStringFormat::StartsWith(Section, "filter."))
+		{
+			continue;
+		}
+
+		WFilterConfig Filter{};
+		Filter.Section = Section;
+		SafeGet(Section, "name", Filter.Name);
+		SafeGet(Section, "cidrs", Filter.Cidrs);
+		SafeGet(Section, "excluded_cidrs", Filter.ExcludedCidrs);
+		SafeGet(Section, "ports", Filter.Ports);
+		SafeGet(Section, "protocols", Filter.Protocols);
+		SafeGet(Section, "asns", Filter.Asns);
+		if (Filter.Name.empty())
+		{
+			Filter.Name = Section.substr(7);
+		}
+		Filters.emplace_back(Filter);
+	}
 	ConfigPath = Path;
 }
 
@@ -199,8 +250,45 @@ bool WDaemonConfig::Write()
 		{ "ignored_connection_history_app_names", WStringFormat::JoinStrings(IgnoredConnectionHistoryApps, ';') },
 		{ "ignored_connection_history_remote_ports", WStringFormat::JoinStrings(IgnoredConnectionHistoryPorts, ';') },
 		{ "first_time_setup_run", bFirstTimeSetupRun ? "true" : "false" },
+		{ "udp_peer_limit", std::to_string(UdpPeerLimit) },
+		{ "kernel_udp_accounting", bKernelUdpAccounting ? "true" : "false" },
+		{ "cgroup_accounting", bCgroupAccounting ? "true" : "false" },
+		{ "epoll_event_loop", bEpollEventLoop ? "true" : "false" },
+		{ "worker_threads", std::to_string(WorkerThreads) },
+		{ "hot_restart", bHotRestart ? "true" : "false" },
+		{ "session_resume_window", std::to_string(SessionResumeWindow) },
+	});
+
+	Ini["resolver"].set({
+		{ "threads", std::to_string(ResolverThreads) },
+		{ "persist_hostnames", bPersistResolvedHosts ? "true" : "false" },
+		{ "snoop_dns", bSnoopDns ? "true" : "false" },
+	});
+
+	Ini["metrics"].set({
+		{ "listen", MetricsListenAddress },
+		{ "max_apps", std::to_string(MetricsMaxApps) },
 	});
 
+	Ini["exclusions"].set({
+		{ "loopback", Exclusions.bLoopback ? "true" : "false" },
+		{ "interfaces", Exclusions.Interfaces },
+		{ "ports", Exclusions.Ports },
+		{ "cgroups", Exclusions.Cgroups },
+	});
+
+	for (auto const& Filter : Filters)
+	{
+		Ini[Filter.Section].set({
+			{ "name", Filter.Name },
+			{ "cidrs", Filter.Cidrs },
+			{ "excluded_cidrs", Filter.ExcludedCidrs },
+			{ "ports", Filter.Ports },
+			{ "protocols", Filter.Protocols },
+			{ "asns", Filter.Asns },
+		});
+	}
+
 	return File.write(Ini, true);
 }
 
@@ -13,6 +13,30 @@
 #include <algorithm>
 
 class WBuffer;
+
+// User defined traffic filter, read from a [filter.<id>] section
+// all lists are semicolon separated, see WFilterEngine::ParseDefinition
+struct WFilterConfig
+{
+	std::string Section{};
+	std::string Name{};
+	std::string Cidrs{};
+	std::string ExcludedCidrs{};
+	std::string Ports{};
+	std::string Protocols{};
+	std::string Asns{};
+};
+
+// Traffic that isn't accounted at all, read from the [exclusions] section
+// lists are semicolon separated, see WKernelExclusions::FromConfig
+struct WExclusionConfig
+{
+	bool        bLoopback{};
+	std::string Interfaces{};
+	std::string Ports{};
+	std::string Cgroups{};
+};
+
 struct WDaemonConfig final : TSingleton<WDaemonConfig>
 {
 	std::string NetworkInterfaceName{};
@@ -25,7 +49,21 @@ struct WDaemonConfig final : TSingleton<WDaemonConfig>
 	std::string WebSocketAuthToken{};
 	std::vector<std::string> IgnoredConnectionHistoryApps{};
 	std::vector<uint16_t>    IgnoredConnectionHistoryPorts{};
+	std::vector<WFilterConfig> Filters{};
+	WExclusionConfig         Exclusions{};
 	bool                     bFirstTimeSetupRun{};
+	int                      ResolverThreads{ 4 };        // concurrent reverse DNS lookups
+	bool                     bPersistResolvedHosts{ true }; // keep resolved hostnames in the database
+	bool                     bSnoopDns{ true };             // name remote hosts from observed DNS responses
+	int                      UdpPeerLimit{ 256 };           // remote endpoints tracked per UDP socket
+	bool                     bKernelUdpAccounting{ true };  // count UDP traffic per peer in the eBPF program
+	bool                     bCgroupAccounting{ true };     // count traffic per cgroup in the eBPF program
+	bool                     bEpollEventLoop{};             // one epoll thread instead of the polling threads
+	int                      WorkerThreads{ 2 };            // blocking work posted by the event loop
+	bool                     bHotRestart{};                 // keep the eBPF state and system map across SIGUSR2
+	int                      SessionResumeWindow{ 300 };    // seconds a disconnected client can resume, 0 disables
+	std::string              MetricsListenAddress{};        // OpenMetrics endpoint, disabled if empty
+	int                      MetricsMaxApps{ 20 };          // applications with their own label on the endpoint
 
 	mode_t      DaemonSocketMode{ 0660 };
 
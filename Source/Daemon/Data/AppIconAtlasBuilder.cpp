@@ -5,121 +5,114 @@
 
 #include "AppIconAtlasBuilder.hpp"
 
-#include <memory>
+#include <unordered_set>
 
 #define STB_IMAGE_IMPLEMENTATION
-#define STB_RECT_PACK_IMPLEMENTATION
 #define STB_IMAGE_RESIZE_IMPLEMENTATION
 #include "tracy/Tracy.hpp"
 #include "spdlog/spdlog.h"
 #include "stb_image.h"
-#include "stb_rect_pack.h"
 #include "stb_image_resize2.h"
 
-struct WPackedIcon
+uint32_t WAppIconAtlasBuilder::AllocateSlot()
 {
-	std::string                      Path{};
-	std::string                      BinaryName{};
-	unsigned int                     W{}, H{};
-	std::unique_ptr<unsigned char[]> Pixels{}; // RGBA
-};
+	if (!FreeSlots.empty())
+	{
+		auto const Slot = FreeSlots.back();
+		FreeSlots.pop_back();
+		return Slot;
+	}
+
+	if (NextSlot >= PageCount * SlotsPerPage)
+	{
+		++PageCount;
+		spdlog::debug("App icon atlas is full, growing to {} pages", PageCount);
+	}
+	return NextSlot++;
+}
 
-bool WAppIconAtlasBuilder::GetAtlasData(WAppIconAtlasData& outData, std::vector<std::string> const& BinaryNames,
-	std::size_t AtlasSize, std::size_t IconSize)
+WAppIconAtlasSlot WAppIconAtlasBuilder::MakeSlotData(std::string const& BinaryName, WSlot const& Slot)
+{
+	WAppIconAtlasSlot Data{};
+	Data.BinaryName = BinaryName;
+	Data.Slot = Slot.Index;
+	Data.Width = static_cast<uint16_t>(Slot.Icon->W);
+	Data.Height = static_cast<uint16_t>(Slot.Icon->H);
+	Data.Pixels = Slot.Icon->Pixels;
+	return Data;
+}
+
+bool WAppIconAtlasBuilder::Update(WAppIconAtlasDelta& OutDelta, std::vector<std::string> const& BinaryNames)
 {
-	ZoneScopedN("GetAtlasData");
-	std::vector<WPackedIcon> PackedIcons{};
-	PackedIcons.reserve(BinaryNames.size());
-	spdlog::debug("Building atlas for {} apps", BinaryNames.size());
+	ZoneScopedN("WAppIconAtlasBuilder::Update");
+	std::scoped_lock Lock(Mutex);
 
+	std::unordered_set<std::string> ActiveApps{};
 	for (auto const& BinaryName : BinaryNames)
 	{
-		std::string IconPath = Resolver.ResolveIcon(BinaryName);
-		if (IconPath.empty())
+		ActiveApps.insert(BinaryName);
+		auto const IconPath = Resolver.ResolveIcon(BinaryName);
+		auto       Icon = IconPath.empty() ? nullptr : Cache.Get(IconPath);
+		auto       It = Slots.find(BinaryName);
+
+		if (!Icon)
 		{
+			if (It != Slots.end())
+			{
+				// The icon was uninstalled
+				FreeSlots.push_back(It->second.Index);
+				OutDelta.RemovedApps.emplace_back(BinaryName);
+				Slots.erase(It);
+			}
 			continue;
 		}
 
-		int            IconW, IconH, N;
-		unsigned char* Data = stbi_load(IconPath.c_str(), &IconW, &IconH, &N, 4); // Force RGBA
-		if (!Data)
+		if (It == Slots.end())
 		{
-			spdlog::warn("Failed to load app icon from path '{}'", IconPath);
-			continue;
+			It = Slots.emplace(BinaryName, WSlot{ AllocateSlot(), std::move(Icon) }).first;
 		}
-
-		if (IconW > static_cast<int>(IconSize) || IconH > static_cast<int>(IconSize))
+		else if (It->second.Icon != Icon)
 		{
-			// Resize icon to fit
-			auto ResizedData = std::make_unique<unsigned char[]>(IconSize * IconSize * 4);
-			stbir_resize_uint8_srgb(Data, IconW, IconH, 0, ResizedData.get(), static_cast<int>(IconSize),
-				static_cast<int>(IconSize), 0, STBIR_RGBA);
-			stbi_image_free(Data);
-			Data = ResizedData.release();
-			IconW = static_cast<int>(IconSize);
-			IconH = static_cast<int>(IconSize);
+			// The icon file changed since it was sent
+			It->second.Icon = std::move(Icon);
 		}
-		WPackedIcon Icon;
-		Icon.Path = IconPath;
-		Icon.BinaryName = BinaryName;
-		Icon.W = static_cast<uint>(IconW);
-		Icon.H = static_cast<uint>(IconH);
-		Icon.Pixels = std::make_unique<unsigned char[]>(Icon.W * Icon.H * 4);
-		std::memcpy(Icon.Pixels.get(), Data, Icon.W * Icon.H * 4);
-		stbi_image_free(Data);
-		PackedIcons.emplace_back(std::move(Icon));
-	}
-
-	auto                    NumIcons = PackedIcons.size();
-	std::vector<stbrp_rect> Rects(NumIcons);
-	for (std::size_t i = 0; i < NumIcons; ++i)
-	{
-		Rects[i].id = static_cast<int>(i);
-		Rects[i].w = static_cast<int>(PackedIcons[i].W);
-		Rects[i].h = static_cast<int>(PackedIcons[i].H);
-		Rects[i].x = Rects[i].y = 0;
-	}
-
-	std::vector<stbrp_node> Nodes(AtlasSize);
-	stbrp_context           Context;
-	stbrp_init_target(&Context, static_cast<int>(AtlasSize), static_cast<int>(AtlasSize), Nodes.data(),
-		static_cast<int>(Nodes.size()));
-	stbrp_pack_rects(&Context, Rects.data(), static_cast<int>(NumIcons));
-
-	for (std::size_t i = 0; i < NumIcons; ++i)
-	{
-		if (Rects[i].was_packed == 0)
+		else
 		{
-			spdlog::error("Icon '{}' ({}/{})) does not fit in the atlas.", PackedIcons[i].Path, i, NumIcons);
-			return false;
+			continue;
 		}
+		OutDelta.UpdatedSlots.emplace_back(MakeSlotData(BinaryName, It->second));
 	}
 
-	outData.AtlasImageData.resize(AtlasSize * AtlasSize * 4, 0);
-	for (std::size_t i = 0; i < NumIcons; ++i)
+	for (auto It = Slots.begin(); It != Slots.end();)
 	{
-		auto const X = static_cast<std::size_t>(Rects[i].x);
-		auto const Y = static_cast<std::size_t>(Rects[i].y);
-		auto const W = static_cast<std::size_t>(PackedIcons[i].W);
-		auto const H = static_cast<std::size_t>(PackedIcons[i].H);
-
-		// Copy icon pixels into atlas
-		for (std::size_t Row = 0; Row < H; ++Row)
+		if (ActiveApps.contains(It->first))
 		{
-			auto const Idx = ((Y + Row) * AtlasSize + X) * 4;
-			auto const Idx2 = Row * W * 4;
-			std::memcpy(&outData.AtlasImageData[Idx], &PackedIcons[i].Pixels[Idx2], W * 4);
+			++It;
+			continue;
 		}
+		FreeSlots.push_back(It->second.Index);
+		OutDelta.RemovedApps.emplace_back(It->first);
+		It = Slots.erase(It);
+	}
+	std::ranges::sort(FreeSlots, std::greater{});
+	Cache.Save();
 
-		WAtlasUv Uv{};
-		Uv.U1 = static_cast<float>(X) / static_cast<float>(AtlasSize);
-		Uv.V1 = static_cast<float>(Y) / static_cast<float>(AtlasSize);
-		Uv.U2 = static_cast<float>(X + W) / static_cast<float>(AtlasSize);
-		Uv.V2 = static_cast<float>(Y + H) / static_cast<float>(AtlasSize);
+	OutDelta.SlotSize = SlotSize;
+	OutDelta.SlotsPerRow = SlotsPerRow;
+	OutDelta.PageCount = PageCount;
+	return !OutDelta.IsEmpty();
+}
 
-		outData.UvData[PackedIcons[i].BinaryName] = Uv;
+void WAppIconAtlasBuilder::GetFullAtlas(WAppIconAtlasDelta& OutDelta)
+{
+	std::scoped_lock Lock(Mutex);
+	OutDelta.bReset = true;
+	OutDelta.SlotSize = SlotSize;
+	OutDelta.SlotsPerRow = SlotsPerRow;
+	OutDelta.PageCount = PageCount;
+	OutDelta.UpdatedSlots.reserve(Slots.size());
+	for (auto const& [BinaryName, Slot] : Slots)
+	{
+		OutDelta.UpdatedSlots.emplace_back(MakeSlotData(BinaryName, Slot));
 	}
-	outData.AtlasSize = static_cast<int>(AtlasSize);
-
-	return !outData.UvData.empty();
-}
\ No newline at end of file
+}
@@ -5,20 +5,55 @@
 
 #pragma once
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
+#include "IconCache.hpp"
 #include "IconResolver.hpp"
 #include "Singleton.hpp"
 #include "Data/AppIconAtlasData.hpp"
 
+/**
+ * Assigns every active application with an icon a slot in the atlas. Slots are kept until the
+ * application goes away, so clients only have to be sent the slots that changed.
+ */
 class WAppIconAtlasBuilder : public TSingleton<WAppIconAtlasBuilder>
 {
+	static constexpr uint16_t SlotSize = 32;
+	static constexpr uint16_t SlotsPerRow = 8;
+	static constexpr uint32_t SlotsPerPage = SlotsPerRow * SlotsPerRow;
+
+	struct WSlot
+	{
+		uint32_t                            Index{};
+		std::shared_ptr<WDecodedIcon const> Icon{};
+	};
+
 	WIconResolver     Resolver;
+	WIconCache        Cache{ SlotSize };
 	std::atomic<bool> bDirty;
 
+	std::mutex                             Mutex;
+	std::unordered_map<std::string, WSlot> Slots{};
+	std::vector<uint32_t>                  FreeSlots{}; // sorted descending, so the lowest slot is reused first
+	uint32_t                               NextSlot{};
+	uint32_t                               PageCount{ 1 };
+
+	uint32_t AllocateSlot();
+
+	static WAppIconAtlasSlot MakeSlotData(std::string const& BinaryName, WSlot const& Slot);
+
 public:
 	WIconResolver& GetResolver() { return Resolver; }
-	bool           GetAtlasData(WAppIconAtlasData& outData, std::vector<std::string> const& BinaryNames,
-				  std::size_t AtlasSize = 256, std::size_t IconSize = 32);
+	WIconCache&    GetCache() { return Cache; }
+
+	// Assigns slots to new applications and frees the slots of inactive ones,
+	// returns false if nothing changed since the last call
+	bool Update(WAppIconAtlasDelta& OutDelta, std::vector<std::string> const& BinaryNames);
+
+	// All slots as of the last update, for new clients
+	void GetFullAtlas(WAppIconAtlasDelta& OutDelta);
 
 	void MarkDirty() { bDirty = true; }
 	bool IsDirty() const { return bDirty; }
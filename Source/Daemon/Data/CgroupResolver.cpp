@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "CgroupResolver.hpp"
+
+#include <filesystem>
+#include <sys/stat.h>
+
+#include "spdlog/spdlog.h"
+#include "tracy/Tracy.hpp"
+
+#include "Time.hpp"
+
+void WCgroupResolver::Scan()
+{
+	ZoneScopedN("WCgroupResolver::Scan");
+	LastScanTime = WTime::GetEpochMs();
+
+	std::error_code Error{};
+	auto const      Options = std::filesystem::directory_options::skip_permission_denied;
+	std::unordered_map<uint64_t, std::string> NewPaths{};
+
+	struct stat Stat{};
+	if (stat(Root.c_str(), &Stat) == 0)
+	{
+		NewPaths[Stat.st_ino] = "/";
+	}
+
+	for (auto It = std::filesystem::recursive_directory_iterator(Root, Options, Error);
+		!Error && It != std::filesystem::recursive_directory_iterator(); It.increment(Error))
+	{
+		if (!It->is_directory(Error) || It->is_symlink(Error))
+		{
+			continue;
+		}
+
+		auto const Path = It->path().string();
+		if (stat(Path.c_str(), &Stat) == 0)
+		{
+			NewPaths[Stat.st_ino] = std::filesystem::relative(It->path(), Root, Error).string();
+		}
+	}
+
+	if (Error)
+	{
+		spdlog::warn("Failed to walk the cgroup hierarchy at {}: {}", Root, Error.message());
+	}
+	spdlog::debug("Found {} cgroups in {}", NewPaths.size(), Root);
+	Paths = std::move(NewPaths);
+}
+
+std::string WCgroupResolver::Resolve(uint64_t const CgroupId)
+{
+	auto It = Paths.find(CgroupId);
+	if (It == Paths.end() && WTime::GetEpochMs() - LastScanTime >= MinRescanInterval)
+	{
+		Scan();
+		It = Paths.find(CgroupId);
+	}
+	return It != Paths.end() ? It->second : std::string{};
+}
+
+bool WCgroupResolver::Exists(uint64_t const CgroupId)
+{
+	auto const It = Paths.find(CgroupId);
+	if (It == Paths.end())
+	{
+		return false;
+	}
+
+	// The inode number can be reused by a new cgroup in a different place
+	auto const  Path = It->second == "/" ? Root : Root + "/" + It->second;
+	struct stat Stat{};
+	if (stat(Path.c_str(), &Stat) == 0 && Stat.st_ino == CgroupId)
+	{
+		return true;
+	}
+	Paths.erase(It);
+	return false;
+}
+
+WBytes WCgroupResolver::GetMemoryUsage() const
+{
+	WBytes Usage = Paths.size() * (sizeof(uint64_t) + sizeof(std::string) + sizeof(void*) * 2);
+	for (auto const& Path : Paths)
+	{
+		Usage += Path.second.capacity();
+	}
+	return Usage;
+}
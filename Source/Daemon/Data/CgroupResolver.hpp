@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "Types.hpp"
+
+/**
+ * Resolves cgroup ids to their path in the cgroup v2 hierarchy. The id of a cgroup is the inode number
+ * of its directory, so the hierarchy is walked once and every directory is remembered. Ids that aren't known
+ * yet trigger another walk, but at most every few seconds since containers tend to start in bursts.
+ */
+class WCgroupResolver
+{
+	static constexpr WMsec MinRescanInterval = 5000;
+
+	std::string                               Root{};
+	std::unordered_map<uint64_t, std::string> Paths{}; // relative to the root, "/" for the root itself
+	WMsec                                     LastScanTime{};
+
+	void Scan();
+
+public:
+	explicit WCgroupResolver(std::string CgroupRoot) : Root(std::move(CgroupRoot)) {}
+
+	// Returns an empty string if the cgroup doesn't exist (anymore)
+	std::string Resolve(uint64_t CgroupId);
+
+	// Checks if the directory of a resolved cgroup is still there, without walking the hierarchy
+	bool Exists(uint64_t CgroupId);
+
+	[[nodiscard]] WBytes GetMemoryUsage() const;
+};
@@ -5,6 +5,8 @@
 
 #include "ConnectionHistory.hpp"
 
+#include <atomic>
+
 #include "spdlog/spdlog.h"
 #include "sqlpp11/sqlpp11.h"
 
@@ -12,6 +14,7 @@
 #include "DaemonConfig.hpp"
 #include "IP2Asn.hpp"
 #include "NetworkEvents.hpp"
+#include "PipelineMetricsCollector.hpp"
 #include "SystemMap.hpp"
 
 #include "Db/DbManager.hpp"
@@ -64,13 +67,14 @@ bool WConnectionHistoryEntry::Update()
 	return bChanged;
 }
 
-WConnectionHistoryEntry::WConnectionHistoryEntry(std::shared_ptr<WAppCounter> const& App_,
+WConnectionHistoryEntry::WConnectionHistoryEntry(std::shared_ptr<WApplicationItem> const& App_,
 	std::shared_ptr<WConnectionSet> const& Set_, WEndpoint const& RemoteEndpoint_)
 	: App(App_), Set(Set_), RemoteEndpoint(RemoteEndpoint_)
 {
 	// Generate a unique ID for this connection history entry,
 	// no relation to any traffic items
-	ConnectionId = WSystemMap::GetInstance().GetNextItemId();
+	static std::atomic<WTrafficItemId> NextConnectionId{ 1 };
+	ConnectionId = NextConnectionId.fetch_add(1);
 }
 
 void WConnectionHistory::OnSocketConnected(WSocketCounter const* SocketCounter)
@@ -81,9 +85,13 @@ void WConnectionHistory::OnSocketConnected(WSocketCounter const* SocketCounter)
 		return;
 	}
 
-	auto const App = SocketCounter->ParentProcess->ParentApp;
-	auto       AppName = App->TrafficItem->ApplicationPath;
-	auto       Endpoint = SocketCounter->TrafficItem->SocketTuple.RemoteEndpoint;
+	auto const App = SocketCounter->GetAppItem();
+	if (!App)
+	{
+		return;
+	}
+	auto AppName = App->ApplicationPath;
+	auto Endpoint = SocketCounter->TrafficItem->SocketTuple.RemoteEndpoint;
 
 	std::scoped_lock Lock(Mutex);
 
@@ -113,13 +121,13 @@ void WConnectionHistory::OnSocketConnected(WSocketCounter const* SocketCounter)
 void WConnectionHistory::OnSocketRemoved(std::shared_ptr<WSocketCounter> const& SocketCounter)
 {
 	std::scoped_lock Lock(Mutex);
-	auto const       App = SocketCounter->ParentProcess->ParentApp;
+	auto const       App = SocketCounter->GetAppItem();
 	if (!App)
 	{
 		spdlog::error("No app for socket {}", SocketCounter->TrafficItem->ItemId);
 		return;
 	}
-	auto             AppName = App->TrafficItem->ApplicationPath;
+	auto             AppName = App->ApplicationPath;
 	auto             Endpoint = SocketCounter->TrafficItem->SocketTuple.RemoteEndpoint;
 	auto const       Key = std::make_pair(AppName, Endpoint);
 
@@ -163,13 +171,13 @@ void WConnectionHistory::OnSocketRemoved(std::shared_ptr<WSocketCounter> const&
 
 void WConnectionHistory::OnUDPTupleCreated(std::shared_ptr<WTupleCounter> const& TupleCounter)
 {
-	auto const App = TupleCounter->ParentSocket->ParentProcess->ParentApp;
+	auto const App = TupleCounter->GetAppItem();
 	if (!App)
 	{
 		spdlog::info("No app for tuple {}", TupleCounter->TrafficItem->ItemId);
 		return;
 	}
-	auto             AppName = App->TrafficItem->ApplicationPath;
+	auto             AppName = App->ApplicationPath;
 	std::scoped_lock Lock(Mutex);
 
 	auto const Key = std::make_pair(AppName, TupleCounter->TrafficItem->Endpoint);
@@ -196,12 +204,12 @@ void WConnectionHistory::OnUDPTupleCreated(std::shared_ptr<WTupleCounter> const&
 
 void WConnectionHistory::OnUDPTupleRemoved(std::shared_ptr<WTupleCounter> const& TupleCounter)
 {
-	auto const App = TupleCounter->ParentSocket->ParentProcess->ParentApp;
+	auto const App = TupleCounter->GetAppItem();
 	if (!App)
 	{
 		return;
 	}
-	auto             AppName = App->TrafficItem->ApplicationPath;
+	auto             AppName = App->ApplicationPath;
 	std::scoped_lock Lock(Mutex);
 
 	auto const Key = std::make_pair(AppName, TupleCounter->TrafficItem->Endpoint);
@@ -222,10 +230,10 @@ void WConnectionHistory::OnUDPTupleRemoved(std::shared_ptr<WTupleCounter> const&
 	}
 }
 
-std::shared_ptr<WConnectionHistoryEntry> WConnectionHistory::Push(std::shared_ptr<WAppCounter> const& App,
+std::shared_ptr<WConnectionHistoryEntry> WConnectionHistory::Push(std::shared_ptr<WApplicationItem> const& App,
 	std::shared_ptr<WConnectionSet> const& Set, WEndpoint const& RemoteEndpoint)
 {
-	if (WDaemonConfig::GetInstance().IsIgnoredConnectionHistoryApp(App->TrafficItem->ApplicationName)
+	if (WDaemonConfig::GetInstance().IsIgnoredConnectionHistoryApp(App->ApplicationName)
 		|| WDaemonConfig::GetInstance().IsIgnoredConnectionHistoryPort(RemoteEndpoint.Port))
 	{
 		return {};
@@ -235,7 +243,7 @@ std::shared_ptr<WConnectionHistoryEntry> WConnectionHistory::Push(std::shared_pt
 	auto Entry = std::make_shared<WConnectionHistoryEntry>(App, Set, RemoteEndpoint);
 	// WriteToDatabase(Entry);
 	History.push_back(Entry);
-	spdlog::debug("New connection for app {}", App->TrafficItem->ApplicationName);
+	spdlog::debug("New connection for app {}", App->ApplicationName);
 	++NewItemCounter;
 	if (History.size() > kMaxHistorySize)
 	{
@@ -277,6 +285,7 @@ void WConnectionHistory::HandleEmptySet(std::shared_ptr<WConnectionSet> const& E
 
 void WConnectionHistory::WriteToDatabase(std::shared_ptr<WConnectionHistoryEntry> const& Entry)
 {
+	WStageTimer const DbWriteTimer(EPipelineStage::DbWrite);
 	WDbManager::GetInstance().Run([&](auto& DbConn) {
 		constexpr Db::Schema::TrafficItem            TrafficItem;
 		constexpr Db::Schema::Host                   Host;
@@ -293,11 +302,11 @@ void WConnectionHistory::WriteToDatabase(std::shared_ptr<WConnectionHistoryEntry
 
 		auto AppResult = DbConn(sqlpp::select(TrafficItem.ID)
 				.from(TrafficItem)
-				.where(TrafficItem.Name == Entry->App->TrafficItem->ApplicationPath));
+				.where(TrafficItem.Name == Entry->App->ApplicationPath));
 
 		int64_t const AppID = AppResult.empty()
 			? static_cast<int64_t>(DbConn(
-				  sqlpp::insert_into(TrafficItem).set(TrafficItem.Name = Entry->App->TrafficItem->ApplicationPath)))
+				  sqlpp::insert_into(TrafficItem).set(TrafficItem.Name = Entry->App->ApplicationPath)))
 			: AppResult.front().ID.value();
 
 		auto const HostResult = DbConn(
@@ -403,7 +412,7 @@ WConnectionHistoryUpdate WConnectionHistory::Update()
 		{
 			auto const&                Entry = *It;
 			spdlog::debug("New connection: app='{}', remote='{}', start={}, id={}",
-				Entry->App->TrafficItem->ApplicationName, Entry->RemoteEndpoint.ToString(), Entry->StartTime,
+				Entry->App->ApplicationName, Entry->RemoteEndpoint.ToString(), Entry->StartTime,
 				Entry->ConnectionId);
 			assert(Entry->App);
 			if (!Entry->App)
@@ -411,7 +420,7 @@ WConnectionHistoryUpdate WConnectionHistory::Update()
 				continue;
 			}
 			WNewConnectionHistoryEntry NewEntry{};
-			NewEntry.AppId = Entry->App->TrafficItem->ItemId;
+			NewEntry.AppId = Entry->App->ItemId;
 			NewEntry.RemoteEndpoint = Entry->RemoteEndpoint;
 			NewEntry.StartTime = Entry->StartTime;
 			NewEntry.EndTime = Entry->EndTime;
@@ -437,7 +446,7 @@ WConnectionHistoryUpdate WConnectionHistory::Serialize()
 			continue;
 		}
 		WNewConnectionHistoryEntry NewEntry{};
-		NewEntry.AppId = Entry->App->TrafficItem->ItemId;
+		NewEntry.AppId = Entry->App->ItemId;
 		NewEntry.RemoteEndpoint = Entry->RemoteEndpoint;
 		NewEntry.StartTime = Entry->StartTime;
 		NewEntry.EndTime = Entry->EndTime;
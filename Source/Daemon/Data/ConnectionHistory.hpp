@@ -20,7 +20,6 @@
 
 #include <spdlog/spdlog.h>
 
-struct WAppCounter;
 struct WSocketItem;
 struct WSocketCounter;
 struct WTupleCounter;
@@ -44,9 +43,9 @@ struct WConnectionSet
 
 struct WConnectionHistoryEntry
 {
-	std::shared_ptr<WAppCounter>  App{};
-	std::weak_ptr<WConnectionSet> Set{};
-	WTrafficItemId                  ConnectionId{};
+	std::shared_ptr<WApplicationItem> App{};
+	std::weak_ptr<WConnectionSet>     Set{};
+	WTrafficItemId                    ConnectionId{};
 
 	WEndpoint RemoteEndpoint{};
 	WSec      StartTime{ WTime::GetEpochSeconds() };
@@ -63,8 +62,8 @@ struct WConnectionHistoryEntry
 
 	bool Update(); // return true if anything changed
 
-	WConnectionHistoryEntry(std::shared_ptr<WAppCounter> const& App_, std::shared_ptr<WConnectionSet> const& Set_,
-		WEndpoint const& RemoteEndpoint_);
+	WConnectionHistoryEntry(std::shared_ptr<WApplicationItem> const& App_,
+		std::shared_ptr<WConnectionSet> const& Set_, WEndpoint const& RemoteEndpoint_);
 };
 
 struct WConnectionKeyHash
@@ -94,7 +93,7 @@ class WConnectionHistory : public TSingleton<WConnectionHistory>, public IMemory
 
 	void OnUDPTupleCreated(std::shared_ptr<WTupleCounter> const& TupleCounter);
 	void OnUDPTupleRemoved(std::shared_ptr<WTupleCounter> const& TupleCounter);
-	std::shared_ptr<WConnectionHistoryEntry> Push(std::shared_ptr<WAppCounter> const& App,
+	std::shared_ptr<WConnectionHistoryEntry> Push(std::shared_ptr<WApplicationItem> const& App,
 		std::shared_ptr<WConnectionSet> const& Set, WEndpoint const& RemoteEndpoint);
 
 	static void HandleEmptySet(std::shared_ptr<WConnectionSet> const& EmptySet);
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "CounterSlab.hpp"
+
+WCounterSlab::WCounterSlab()
+{
+	// The root slot is never released, so its generation stays 0
+	Allocate(nullptr);
+	Generation[GetIndex(RootId)] = GetGeneration(RootId);
+}
+
+WTrafficItemId WCounterSlab::Allocate(std::shared_ptr<ITrafficItem> const& Item)
+{
+	uint32_t Index{};
+	if (!FreeSlots.empty())
+	{
+		Index = FreeSlots.back();
+		FreeSlots.pop_back();
+	}
+	else
+	{
+		Index = static_cast<uint32_t>(Generation.size());
+		RecentUpload.emplace_back();
+		RecentDownload.emplace_back();
+		TimeWindowStart.emplace_back();
+		RemovalTimeStamp.emplace_back();
+		State.emplace_back();
+		InactiveCounter.emplace_back();
+		Parent.emplace_back();
+		// Starts at 1, so no item besides the root ends up with id 0
+		Generation.emplace_back(1);
+		Items.emplace_back();
+	}
+
+	RecentUpload[Index] = 0;
+	RecentDownload[Index] = 0;
+	TimeWindowStart[Index] = WTime::GetEpochMs();
+	RemovalTimeStamp[Index] = 0;
+	State[Index] = CS_Inactive;
+	InactiveCounter[Index] = 0;
+	Parent[Index] = InvalidId;
+	Items[Index] = Item;
+	return static_cast<WTrafficItemId>(Generation[Index]) << 32 | Index;
+}
+
+void WCounterSlab::Release(WTrafficItemId const Id)
+{
+	std::scoped_lock Lock(ReleaseMutex);
+	ReleasedIds.push_back(Id);
+}
+
+void WCounterSlab::Reclaim()
+{
+	std::scoped_lock Lock(ReleaseMutex);
+	for (auto const Id : ReleasedIds)
+	{
+		if (!IsValid(Id))
+		{
+			continue;
+		}
+		// Outstanding ids of this slot are now stale
+		auto const Index = GetIndex(Id);
+		++Generation[Index];
+		Parent[Index] = InvalidId;
+		Items[Index].reset();
+		FreeSlots.push_back(Index);
+	}
+	ReleasedIds.clear();
+}
+
+WBytes WCounterSlab::GetAllocatedBytes() const
+{
+	std::scoped_lock Lock(ReleaseMutex);
+	return Generation.capacity() * GetSlotSize() + FreeSlots.capacity() * sizeof(uint32_t)
+		+ ReleasedIds.capacity() * sizeof(WTrafficItemId);
+}
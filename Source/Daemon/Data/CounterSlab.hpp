@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "Types.hpp"
+#include "Time.hpp"
+#include "TrafficCounter.hpp"
+#include "Data/TrafficItem.hpp"
+
+struct WSystemItem;
+
+/**
+ * Traffic counter state of every item in the system map, stored as a structure of arrays.
+ * The id of a counted item is its handle into the slab, the slot index in the lower and the generation of the slot
+ * in the upper 32 bits, so the id of a removed item never resolves to whatever reuses its slot.
+ * A packet only touches the few arrays it needs and walks the parent ids (socket -> process -> application)
+ * instead of chasing pointers. The slab also keeps the item of each slot, that's how an id is resolved to an item
+ * or to the items above it. The items themselves form the tree that is sent to clients.
+ * Access is guarded by the data mutex of the system map, only releasing a slot is thread safe.
+ */
+class WCounterSlab
+{
+public:
+	// The root of the tree is always in the first slot, clients expect it to have id 0
+	static constexpr WTrafficItemId RootId{ 0 };
+	static constexpr WTrafficItemId InvalidId{ std::numeric_limits<WTrafficItemId>::max() };
+
+private:
+	std::vector<WBytes>         RecentUpload{};
+	std::vector<WBytes>         RecentDownload{};
+	std::vector<WMsec>          TimeWindowStart{};
+	std::vector<WMsec>          RemovalTimeStamp{};
+	std::vector<uint8_t>        State{};
+	std::vector<uint8_t>        InactiveCounter{};
+	std::vector<WTrafficItemId> Parent{};
+	std::vector<uint32_t>       Generation{};
+
+	std::vector<std::shared_ptr<ITrafficItem>> Items{};
+
+	std::vector<uint32_t> FreeSlots{};
+
+	// Counters can be destroyed by whoever holds the last reference, so their slots
+	// are only handed back to the free list by Reclaim while the system map is locked
+	mutable std::mutex          ReleaseMutex;
+	std::vector<WTrafficItemId> ReleasedIds{};
+
+	WCounterSlab();
+
+	[[nodiscard]] static uint32_t GetIndex(WTrafficItemId const Id) { return static_cast<uint32_t>(Id); }
+
+	[[nodiscard]] static uint32_t GetGeneration(WTrafficItemId const Id) { return static_cast<uint32_t>(Id >> 32); }
+
+	void PushTraffic(std::vector<WBytes>& Recent, WTrafficItemId Id, WBytes Bytes)
+	{
+		// A parent that was removed ends the walk, e.g. the process of a socket that is waiting for a new one
+		for (; IsValid(Id); Id = Parent[GetIndex(Id)])
+		{
+			auto const Index = GetIndex(Id);
+			Recent[Index] += Bytes;
+			State[Index] = CS_Active;
+			InactiveCounter[Index] = 0;
+		}
+	}
+
+public:
+	// Never destroyed, counters owned by other singletons may outlive it
+	static WCounterSlab& GetInstance()
+	{
+		static auto* Instance = new WCounterSlab();
+		return *Instance;
+	}
+
+	WTrafficItemId Allocate(std::shared_ptr<ITrafficItem> const& Item);
+	void           SetRootItem(std::shared_ptr<ITrafficItem> const& Item) { Items[GetIndex(RootId)] = Item; }
+	void           Release(WTrafficItemId Id);
+	void           Reclaim();
+
+	[[nodiscard]] bool IsValid(WTrafficItemId const Id) const
+	{
+		auto const Index = GetIndex(Id);
+		return Index < Generation.size() && Generation[Index] == GetGeneration(Id);
+	}
+
+	// Traffic pushed to the child is also counted for the parent (and its parents)
+	void SetParent(WTrafficItemId const Child, WTrafficItemId const NewParent) { Parent[GetIndex(Child)] = NewParent; }
+
+	// InvalidId if the item has no parent or was removed. The parent itself might have been removed as well
+	[[nodiscard]] WTrafficItemId GetParent(WTrafficItemId const Id) const
+	{
+		return IsValid(Id) ? Parent[GetIndex(Id)] : InvalidId;
+	}
+
+	[[nodiscard]] std::shared_ptr<ITrafficItem> GetItem(WTrafficItemId const Id) const
+	{
+		return IsValid(Id) ? Items[GetIndex(Id)] : nullptr;
+	}
+
+	template <typename T>
+	[[nodiscard]] std::shared_ptr<T> GetItem(WTrafficItemId const Id) const
+	{
+		return std::dynamic_pointer_cast<T>(GetItem(Id));
+	}
+
+	void PushOutgoingTraffic(WTrafficItemId const Id, WBytes const Bytes) { PushTraffic(RecentUpload, Id, Bytes); }
+	void PushIncomingTraffic(WTrafficItemId const Id, WBytes const Bytes) { PushTraffic(RecentDownload, Id, Bytes); }
+
+	[[nodiscard]] WBytes GetRecentUpload(WTrafficItemId const Id) const { return RecentUpload[GetIndex(Id)]; }
+	[[nodiscard]] WBytes GetRecentDownload(WTrafficItemId const Id) const { return RecentDownload[GetIndex(Id)]; }
+	[[nodiscard]] ECounterState GetState(WTrafficItemId const Id) const
+	{
+		return static_cast<ECounterState>(State[GetIndex(Id)]);
+	}
+	[[nodiscard]] uint8_t GetInactiveCounter(WTrafficItemId const Id) const { return InactiveCounter[GetIndex(Id)]; }
+
+	void MarkForRemoval(WTrafficItemId const Id, WMsec const RemovalTime)
+	{
+		State[GetIndex(Id)] = CS_PendingRemoval;
+		RemovalTimeStamp[GetIndex(Id)] = RemovalTime;
+	}
+
+	[[nodiscard]] bool DueForRemoval(WTrafficItemId const Id) const
+	{
+		auto const Index = GetIndex(Id);
+		return State[Index] == CS_PendingRemoval && WTime::GetEpochMs() >= RemovalTimeStamp[Index];
+	}
+
+	// Applies the traffic of the last time window to the item, see TTrafficCounter::Refresh
+	template <typename T>
+	void Refresh(WTrafficItemId Id, T& Item, WMsec RecentTrafficTimeWindow);
+
+	[[nodiscard]] std::size_t GetSlotCount() const { return Generation.size(); }
+
+	[[nodiscard]] std::size_t GetLiveCount() const { return Generation.size() - FreeSlots.size(); }
+
+	static constexpr std::size_t GetSlotSize()
+	{
+		return sizeof(WBytes) * 2 + sizeof(WMsec) * 2 + sizeof(uint8_t) * 2 + sizeof(WTrafficItemId)
+			+ sizeof(uint32_t) + sizeof(std::shared_ptr<ITrafficItem>);
+	}
+
+	// Everything the slab allocated, including the slots that are currently free
+	[[nodiscard]] WBytes GetAllocatedBytes() const;
+};
+
+template <typename T>
+void WCounterSlab::Refresh(WTrafficItemId const Id, T& Item, WMsec const RecentTrafficTimeWindow)
+{
+	auto const Index = GetIndex(Id);
+	if (State[Index] == CS_PendingRemoval)
+	{
+		Item.DownloadSpeed = 0;
+		Item.UploadSpeed = 0;
+		return;
+	}
+
+	auto const TimeStampMS = WTime::GetEpochMs();
+	if (TimeStampMS - TimeWindowStart[Index] < RecentTrafficTimeWindow)
+	{
+		return;
+	}
+
+	auto const WindowSeconds = static_cast<double>(RecentTrafficTimeWindow) / 1000.0;
+	auto const NewDownloadSpeed = static_cast<double>(RecentDownload[Index]) / WindowSeconds;
+	auto const NewUploadSpeed = static_cast<double>(RecentUpload[Index]) / WindowSeconds;
+
+	if (std::abs(NewDownloadSpeed - Item.DownloadSpeed) > 0.01)
+	{
+		Item.DownloadSpeed = NewDownloadSpeed;
+		State[Index] = CS_Active;
+	}
+
+	if (std::abs(NewUploadSpeed - Item.UploadSpeed) > 0.01)
+	{
+		Item.UploadSpeed = NewUploadSpeed;
+		State[Index] = CS_Active;
+	}
+
+	if (Item.DownloadSpeed < 1)
+	{
+		Item.DownloadSpeed = 0;
+	}
+
+	if (Item.UploadSpeed < 1)
+	{
+		Item.UploadSpeed = 0;
+	}
+
+	if (Item.DownloadSpeed == 0 && Item.UploadSpeed == 0)
+	{
+		InactiveCounter[Index] = std::min<uint8_t>(static_cast<uint8_t>(InactiveCounter[Index] + 1), 255);
+	}
+
+	// Same as TTrafficCounter, the item stays active for a few ticks so clients see the speed drop to zero
+	if (InactiveCounter[Index] >= 3)
+	{
+		State[Index] = CS_Inactive;
+	}
+
+	Item.TotalDownloadBytes += RecentDownload[Index];
+	Item.TotalUploadBytes += RecentUpload[Index];
+	RecentDownload[Index] = 0;
+	RecentUpload[Index] = 0;
+	TimeWindowStart[Index] = TimeStampMS;
+}
+
+/**
+ * Counter of a single item in the system map, the traffic state lives in the counter slab under the id of the item.
+ * Same interface as TTrafficCounter, which the client still uses.
+ */
+template <typename T>
+struct TSlabCounter
+{
+	std::shared_ptr<T> TrafficItem;
+
+	static constexpr WMsec RecentTrafficTimeWindow{ 1000 };
+	static constexpr WMsec RemovalTimeWindow{ 5000 }; // Time between pending removal and actual removal
+
+	// Gives the item its id
+	explicit TSlabCounter(std::shared_ptr<T> const& TrafficItem_) : TrafficItem(TrafficItem_)
+	{
+		if constexpr (std::is_same_v<T, WSystemItem>)
+		{
+			TrafficItem->ItemId = WCounterSlab::RootId;
+			WCounterSlab::GetInstance().SetRootItem(TrafficItem);
+		}
+		else
+		{
+			TrafficItem->ItemId = WCounterSlab::GetInstance().Allocate(TrafficItem);
+		}
+	}
+
+	~TSlabCounter()
+	{
+		if constexpr (!std::is_same_v<T, WSystemItem>)
+		{
+			WCounterSlab::GetInstance().Release(GetId());
+		}
+	}
+
+	TSlabCounter(TSlabCounter const&) = delete;
+	TSlabCounter& operator=(TSlabCounter const&) = delete;
+
+	[[nodiscard]] WTrafficItemId GetId() const { return TrafficItem->ItemId; }
+
+	[[nodiscard]] WTrafficItemId GetParentId() const { return WCounterSlab::GetInstance().GetParent(GetId()); }
+
+	uint8_t GetInactiveCounter() const { return WCounterSlab::GetInstance().GetInactiveCounter(GetId()); }
+
+	WBytes GetRecentUpload() const { return WCounterSlab::GetInstance().GetRecentUpload(GetId()); }
+	WBytes GetRecentDownload() const { return WCounterSlab::GetInstance().GetRecentDownload(GetId()); }
+
+	// Also counts the traffic for all parents of this counter
+	void PushOutgoingTraffic(WBytes Bytes) const { WCounterSlab::GetInstance().PushOutgoingTraffic(GetId(), Bytes); }
+	void PushIncomingTraffic(WBytes Bytes) const { WCounterSlab::GetInstance().PushIncomingTraffic(GetId(), Bytes); }
+
+	[[nodiscard]] bool IsActive() const { return GetState() == CS_Active; }
+
+	void Refresh() { WCounterSlab::GetInstance().Refresh(GetId(), *TrafficItem, RecentTrafficTimeWindow); }
+
+	[[nodiscard]] ECounterState GetState() const { return WCounterSlab::GetInstance().GetState(GetId()); }
+
+	[[nodiscard]] bool IsMarkedForRemoval() const { return GetState() == CS_PendingRemoval; }
+
+	void MarkForRemoval()
+	{
+		if (IsMarkedForRemoval())
+		{
+			return;
+		}
+		WCounterSlab::GetInstance().MarkForRemoval(GetId(), WTime::GetEpochMs() + RemovalTimeWindow);
+		TrafficItem->UploadSpeed = 0;
+		TrafficItem->DownloadSpeed = 0;
+	}
+
+	[[nodiscard]] bool DueForRemoval() const { return WCounterSlab::GetInstance().DueForRemoval(GetId()); }
+};
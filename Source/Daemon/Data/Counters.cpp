@@ -9,6 +9,15 @@
 #include "NetworkEvents.hpp"
 #include "SystemMap.hpp"
 
+WSocketCounter::WPeerIterator WSocketCounter::ErasePeer(WPeerIterator const It)
+{
+	if (!It->second->IsOtherPeers())
+	{
+		PeerLru.erase(It->second->LruPosition);
+	}
+	return UDPPerConnectionCounters.erase(It);
+}
+
 void WSocketCounter::ProcessSocketEvent(WSocketEvent const& Event) const
 {
 	auto const OldItemState = *TrafficItem.get();
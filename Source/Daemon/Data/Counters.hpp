@@ -4,64 +4,134 @@
  */
 
 #pragma once
+#include <list>
 #include <memory>
 #include <unordered_map>
-#include <functional>
 
 #include "spdlog/spdlog.h"
 
-#include "TrafficCounter.hpp"
 #include "Data/ApplicationItem.hpp"
+#include "Data/CounterSlab.hpp"
+#include "Data/CgroupItem.hpp"
 #include "Data/FilterItem.hpp"
+#include "Data/FilterEngine.hpp"
 #include "EBPFCommon.h"
 
-struct WAppCounter : TTrafficCounter<WApplicationItem>
+// The parents of a counter are kept in the counter slab, which also counts the traffic of a socket for its process
+// and application. Getting from a counter to the items above it goes through the slab as well
+struct WAppCounter : TSlabCounter<WApplicationItem>
 {
-	explicit WAppCounter(std::shared_ptr<WApplicationItem> const& Item) : TTrafficCounter(Item) {}
+	explicit WAppCounter(std::shared_ptr<WApplicationItem> const& Item) : TSlabCounter(Item) {}
 };
 
-struct WProcessCounter : TTrafficCounter<WProcessItem>
+struct WProcessCounter : TSlabCounter<WProcessItem>
 {
-	explicit WProcessCounter(std::shared_ptr<WProcessItem> const& Item, std::shared_ptr<WAppCounter> const& ParentApp_)
-		: TTrafficCounter(Item), ParentApp(ParentApp_)
+	explicit WProcessCounter(std::shared_ptr<WProcessItem> const& Item, WAppCounter const& ParentApp)
+		: TSlabCounter(Item)
 	{
+		WCounterSlab::GetInstance().SetParent(GetId(), ParentApp.GetId());
+	}
+
+	[[nodiscard]] std::shared_ptr<WApplicationItem> GetAppItem() const
+	{
+		return WCounterSlab::GetInstance().GetItem<WApplicationItem>(GetParentId());
 	}
-	std::shared_ptr<WAppCounter> ParentApp;
 };
 
 struct WTupleCounter;
 
-struct WSocketCounter : TTrafficCounter<WSocketItem>
+struct WSocketCounter : TSlabCounter<WSocketItem>
 {
-	explicit WSocketCounter(
-		std::shared_ptr<WSocketItem> const& Item, std::shared_ptr<WProcessCounter> const& ParentProcess_)
-		: TTrafficCounter(Item), ParentProcess(ParentProcess_)
+	explicit WSocketCounter(std::shared_ptr<WSocketItem> const& Item, WProcessCounter const& ParentProcess)
+		: TSlabCounter(Item)
 	{
+		SetParentProcess(ParentProcess);
 	}
 
 	void ProcessSocketEvent(WSocketEvent const& Event) const;
 
-	std::shared_ptr<WProcessCounter>                              ParentProcess;
+	void SetParentProcess(WProcessCounter const& NewParentProcess)
+	{
+		WCounterSlab::GetInstance().SetParent(GetId(), NewParentProcess.GetId());
+	}
+
+	// Null if the process is gone, e.g. while the socket waits for the process that inherited it
+	[[nodiscard]] std::shared_ptr<WProcessItem> GetProcessItem() const
+	{
+		return WCounterSlab::GetInstance().GetItem<WProcessItem>(GetParentId());
+	}
+
+	[[nodiscard]] std::shared_ptr<WApplicationItem> GetAppItem() const
+	{
+		auto const& Slab = WCounterSlab::GetInstance();
+		return Slab.GetItem<WApplicationItem>(Slab.GetParent(GetParentId()));
+	}
+
+	// Remote endpoints of a UDP socket. Once there are too many, the least recently used ones are merged
+	// into the "other peers" tuple, which is stored under an empty endpoint and isn't part of PeerLru.
 	std::unordered_map<WEndpoint, std::shared_ptr<WTupleCounter>> UDPPerConnectionCounters{};
+	std::list<WEndpoint>                                          PeerLru{}; // most recently used first
+
+	using WPeerIterator = std::unordered_map<WEndpoint, std::shared_ptr<WTupleCounter>>::iterator;
+
+	// Only removes the counter, the caller takes care of the traffic item and events
+	WPeerIterator ErasePeer(WPeerIterator It);
+
+	void ClearPeers()
+	{
+		UDPPerConnectionCounters.clear();
+		PeerLru.clear();
+	}
+
+	// Set if the socket was handed to a forked child when its process exited, which child actually kept it isn't
+	// known. The next event that carries the PID of the process using the socket moves it there
+	bool bGuessedOwner{};
+
+	// Local port this socket is listed under in the port index of the system map, 0 if it isn't
+	uint16_t IndexedPort{};
+
+	// Filters matching this socket, only recomputed if the tuple or the compiled filters change
+	WFilterMask  FilterMask{};
+	WSocketTuple ClassifiedTuple{};
+	uint32_t     FilterGeneration{};
 };
 
-struct WTupleCounter : TTrafficCounter<WTupleItem>
+struct WTupleCounter : TSlabCounter<WTupleItem>
 {
-	explicit WTupleCounter(
-		std::shared_ptr<WTupleItem> const& Item, std::shared_ptr<WSocketCounter> const& ParentSocket_)
-		: TTrafficCounter(Item), ParentSocket(ParentSocket_)
+	explicit WTupleCounter(std::shared_ptr<WTupleItem> const& Item, WSocketCounter const& ParentSocket)
+		: TSlabCounter(Item), SocketId(ParentSocket.GetId())
 	{
 	}
 
-	std::shared_ptr<WSocketCounter> ParentSocket;
+	// Not the parent in the counter slab, the socket counts its traffic itself
+	WTrafficItemId SocketId{};
 
-	void Refresh() override
+	[[nodiscard]] std::shared_ptr<WSocketItem> GetSocketItem() const
 	{
-		TTrafficCounter::Refresh();
+		return WCounterSlab::GetInstance().GetItem<WSocketItem>(SocketId);
+	}
+
+	[[nodiscard]] std::shared_ptr<WApplicationItem> GetAppItem() const
+	{
+		auto const& Slab = WCounterSlab::GetInstance();
+		return Slab.GetItem<WApplicationItem>(Slab.GetParent(Slab.GetParent(SocketId)));
+	}
+
+	std::list<WEndpoint>::iterator LruPosition{};
+
+	WFilterMask FilterMask{};
+	uint32_t    FilterGeneration{};
+
+	// Traffic of peers that were dropped because the socket talks to too many of them
+	[[nodiscard]] bool IsOtherPeers() const { return TrafficItem->Endpoint.Address.IsZero(); }
+
+	void Refresh()
+	{
+		TSlabCounter::Refresh();
 		// If a UDP socket has not sent/received data on a connection for five seconds,
 		// we'll treat it as dead. In the worst case it'll be re-added once traffic
 		// is detected for it again
-		if (State != CS_PendingRemoval && InactiveCounter >= 5)
+		if (!IsMarkedForRemoval() && GetInactiveCounter() >= 5)
 		{
 			spdlog::debug("Marking udp counter for removal");
 			MarkForRemoval();
@@ -69,9 +139,12 @@ struct WTupleCounter : TTrafficCounter<WTupleItem>
 	}
 };
 
-struct WFilterCounter : TTrafficCounter<WFilterItem>
+struct WFilterCounter : TSlabCounter<WFilterItem>
 {
-	std::function<bool(WTrafficItemId const&, WEndpoint const*, WEndpoint const*)> FilterFunction;
+	explicit WFilterCounter(std::shared_ptr<WFilterItem> const& Item) : TSlabCounter(Item) {}
+};
 
-	explicit WFilterCounter(std::shared_ptr<WFilterItem> const& Item) : TTrafficCounter(Item) {}
+struct WCgroupCounter : TSlabCounter<WCgroupItem>
+{
+	explicit WCgroupCounter(std::shared_ptr<WCgroupItem> const& Item) : TSlabCounter(Item) {}
 };
@@ -0,0 +1,392 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "FilterEngine.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#include "spdlog/spdlog.h"
+
+#include "DaemonConfig.hpp"
+#include "Format.hpp"
+#include "IP2Asn.hpp"
+
+namespace
+{
+WCidr MakeCidr(std::string const& Str)
+{
+	auto const Cidr = WCidr::FromString(Str);
+	assert(Cidr);
+	return Cidr.value_or(WCidr{});
+}
+
+std::vector<std::string> SplitList(std::string const& Str)
+{
+	std::vector<std::string> Result{};
+	for (auto const& Entry : WStringFormat::SplitString(Str, ';'))
+	{
+		if (auto Trimmed = WStringFormat::Trim(Entry); !Trimmed.empty())
+		{
+			Result.emplace_back(std::move(Trimmed));
+		}
+	}
+	return Result;
+}
+
+bool ParsePort(std::string const& Str, uint16_t& OutPort)
+{
+	bool       bOk{};
+	auto const Value = WStringFormat::ParseInt(WStringFormat::Trim(Str), 0, &bOk);
+	if (!bOk || Value > 0xffff)
+	{
+		return false;
+	}
+	OutPort = static_cast<uint16_t>(Value);
+	return true;
+}
+} // namespace
+
+std::optional<WPortRange> WPortRange::FromString(std::string const& Str)
+{
+	WPortRange Range{};
+	auto const DashPos = Str.find('-');
+	bool const bValid = DashPos == std::string::npos
+		? ParsePort(Str, Range.Low) && ParsePort(Str, Range.High)
+		: ParsePort(Str.substr(0, DashPos), Range.Low) && ParsePort(Str.substr(DashPos + 1), Range.High);
+	if (!bValid || Range.Low > Range.High)
+	{
+		return std::nullopt;
+	}
+	return Range;
+}
+
+std::optional<WCidr> WCidr::FromString(std::string const& Str)
+{
+	WCidr       Cidr{};
+	auto const  SlashPos = Str.find('/');
+	auto const  AddressStr = WStringFormat::Trim(Str.substr(0, SlashPos));
+	auto const  Address = WIPAddress::FromString(AddressStr);
+	if (!Address)
+	{
+		return std::nullopt;
+	}
+	Cidr.Address = *Address;
+
+	uint32_t const MaxPrefixLength = Cidr.Address.Family == EIPFamily::IPv4 ? 32 : 128;
+	uint32_t       PrefixLength = MaxPrefixLength;
+	if (SlashPos != std::string::npos)
+	{
+		bool bOk{};
+		PrefixLength = WStringFormat::ParseInt(WStringFormat::Trim(Str.substr(SlashPos + 1)), 0, &bOk);
+		if (!bOk || PrefixLength > MaxPrefixLength)
+		{
+			return std::nullopt;
+		}
+	}
+	Cidr.PrefixLength = static_cast<uint8_t>(PrefixLength);
+	return Cidr;
+}
+
+std::vector<WFilterDefinition> WFilterEngine::GetDefaultFilters()
+{
+	std::vector<WFilterDefinition> Defaults{};
+
+	// Same ranges as WIPAddress::IsInternetAddress
+	WFilterDefinition Internet{};
+	Internet.Name = "Internet";
+	for (auto const* Cidr : { "0.0.0.0/8", "10.0.0.0/8", "100.64.0.0/10", "127.0.0.0/8", "169.254.0.0/16",
+			 "172.16.0.0/12", "192.168.0.0/16", "224.0.0.0/4", "240.0.0.0/4", "::/128", "::1/128", "ff00::/8",
+			 "fc00::/7", "fe80::/10" })
+	{
+		Internet.ExcludedCidrs.emplace_back(MakeCidr(Cidr));
+	}
+	Defaults.emplace_back(std::move(Internet));
+
+	// Same ranges as WIPAddress::IsLANAddress
+	WFilterDefinition Lan{};
+	Lan.Name = "LAN";
+	for (auto const* Cidr : { "10.0.0.0/8", "172.16.0.0/12", "192.168.0.0/16", "fc00::/7" })
+	{
+		Lan.IncludedCidrs.emplace_back(MakeCidr(Cidr));
+	}
+	Defaults.emplace_back(std::move(Lan));
+
+	WFilterDefinition Localhost{};
+	Localhost.Name = "Localhost";
+	Localhost.IncludedCidrs.emplace_back(MakeCidr("127.0.0.0/8"));
+	Localhost.IncludedCidrs.emplace_back(MakeCidr("::1/128"));
+	Defaults.emplace_back(std::move(Localhost));
+
+	return Defaults;
+}
+
+std::optional<WFilterDefinition> WFilterEngine::ParseDefinition(WFilterConfig const& Config)
+{
+	WFilterDefinition Definition{};
+	Definition.Name = WStringFormat::Trim(Config.Name);
+	if (Definition.Name.empty())
+	{
+		spdlog::error("Filter in section '{}' has no name", Config.Section);
+		return std::nullopt;
+	}
+
+	auto ParseCidrs = [&](std::string const& Str, std::vector<WCidr>& Out) {
+		for (auto const& Entry : SplitList(Str))
+		{
+			if (auto const Cidr = WCidr::FromString(Entry))
+			{
+				Out.emplace_back(*Cidr);
+			}
+			else
+			{
+				spdlog::error("Invalid CIDR '{}' in filter '{}'", Entry, Definition.Name);
+				return false;
+			}
+		}
+		return true;
+	};
+
+	if (!ParseCidrs(Config.Cidrs, Definition.IncludedCidrs) || !ParseCidrs(Config.ExcludedCidrs, Definition.ExcludedCidrs))
+	{
+		return std::nullopt;
+	}
+
+	for (auto const& Entry : SplitList(Config.Ports))
+	{
+		auto const Range = WPortRange::FromString(Entry);
+		if (!Range)
+		{
+			spdlog::error("Invalid port range '{}' in filter '{}'", Entry, Definition.Name);
+			return std::nullopt;
+		}
+		Definition.Ports.emplace_back(*Range);
+	}
+
+	for (auto const& Entry : SplitList(Config.Protocols))
+	{
+		auto const Protocol = WStringFormat::ToLower(Entry);
+		if (Protocol == "tcp")
+		{
+			Definition.Protocols.emplace_back(EProtocol::TCP);
+		}
+		else if (Protocol == "udp")
+		{
+			Definition.Protocols.emplace_back(EProtocol::UDP);
+		}
+		else if (Protocol == "icmp")
+		{
+			Definition.Protocols.emplace_back(EProtocol::ICMP);
+			Definition.Protocols.emplace_back(EProtocol::ICMPv6);
+		}
+		else if (Protocol == "esp")
+		{
+			Definition.Protocols.emplace_back(EProtocol::ESP);
+		}
+		else
+		{
+			spdlog::error("Invalid protocol '{}' in filter '{}'", Entry, Definition.Name);
+			return std::nullopt;
+		}
+	}
+
+	for (auto const& Entry : SplitList(Config.Asns))
+	{
+		// Allow both "AS13335" and "13335"
+		auto const Number = WStringFormat::StartsWith(WStringFormat::ToLower(Entry), "as") ? Entry.substr(2) : Entry;
+		bool       bOk{};
+		auto const Asn = WStringFormat::ParseInt(Number, 0, &bOk);
+		if (!bOk)
+		{
+			spdlog::error("Invalid ASN '{}' in filter '{}'", Entry, Definition.Name);
+			return std::nullopt;
+		}
+		Definition.Asns.insert(Asn);
+	}
+
+	return Definition;
+}
+
+void WFilterEngine::InsertPrefix(std::vector<WTrieNode>& Trie, WCidr const& Cidr, WFilterMask const Bit, bool const bExclude)
+{
+	std::size_t Node = 0;
+	for (uint32_t i = 0; i < Cidr.PrefixLength; ++i)
+	{
+		auto const Branch = static_cast<std::size_t>((Cidr.Address.Bytes[i / 8] >> (7 - i % 8)) & 1);
+		if (Trie[Node].Children[Branch] < 0)
+		{
+			Trie[Node].Children[Branch] = static_cast<int32_t>(Trie.size());
+			Trie.emplace_back();
+		}
+		Node = static_cast<std::size_t>(Trie[Node].Children[Branch]);
+	}
+
+	if (bExclude)
+	{
+		Trie[Node].ExcludeMask |= Bit;
+	}
+	else
+	{
+		Trie[Node].IncludeMask |= Bit;
+	}
+}
+
+bool WFilterEngine::Compile(std::vector<WFilterDefinition> const& Definitions)
+{
+	V4Trie.assign(1, WTrieNode{});
+	V6Trie.assign(1, WTrieNode{});
+	Filters.clear();
+	AnyAddressMask = 0;
+	PortConstrainedMask = 0;
+	ProtocolConstrainedMask = 0;
+	AsnConstrainedMask = 0;
+	++Generation;
+
+	bool bAllCompiled{ true };
+	for (auto const& Definition : Definitions)
+	{
+		if (Filters.size() >= kMaxFilterCount)
+		{
+			spdlog::error("Too many filters, ignoring filter '{}' (at most {} are supported)", Definition.Name,
+				kMaxFilterCount);
+			bAllCompiled = false;
+			continue;
+		}
+
+		WFilterMask const Bit = WFilterMask{ 1 } << Filters.size();
+		if (Definition.IncludedCidrs.empty())
+		{
+			AnyAddressMask |= Bit;
+		}
+
+		for (auto const& Cidr : Definition.IncludedCidrs)
+		{
+			InsertPrefix(Cidr.Address.Family == EIPFamily::IPv4 ? V4Trie : V6Trie, Cidr, Bit, false);
+		}
+		for (auto const& Cidr : Definition.ExcludedCidrs)
+		{
+			InsertPrefix(Cidr.Address.Family == EIPFamily::IPv4 ? V4Trie : V6Trie, Cidr, Bit, true);
+		}
+
+		if (!Definition.Ports.empty())
+		{
+			PortConstrainedMask |= Bit;
+		}
+		if (!Definition.Protocols.empty())
+		{
+			ProtocolConstrainedMask |= Bit;
+		}
+		if (!Definition.Asns.empty())
+		{
+			AsnConstrainedMask |= Bit;
+		}
+		Filters.emplace_back(Definition);
+	}
+
+	spdlog::debug("Compiled {} filters ({} IPv4 and {} IPv6 trie nodes)", Filters.size(), V4Trie.size(), V6Trie.size());
+	return bAllCompiled;
+}
+
+WFilterMask WFilterEngine::LookupAddress(WIPAddress const& Address) const
+{
+	if (Address.Family != EIPFamily::IPv4 && Address.Family != EIPFamily::IPv6)
+	{
+		return 0;
+	}
+
+	auto const&    Trie = Address.Family == EIPFamily::IPv4 ? V4Trie : V6Trie;
+	uint32_t const BitCount = Address.Family == EIPFamily::IPv4 ? 32 : 128;
+
+	// Every prefix on the path contains the address, so all of their masks apply
+	WFilterMask Include = AnyAddressMask;
+	WFilterMask Exclude{};
+	std::size_t Node = 0;
+	for (uint32_t i = 0;; ++i)
+	{
+		Include |= Trie[Node].IncludeMask;
+		Exclude |= Trie[Node].ExcludeMask;
+		if (i == BitCount)
+		{
+			break;
+		}
+
+		auto const Branch = static_cast<std::size_t>((Address.Bytes[i / 8] >> (7 - i % 8)) & 1);
+		auto const Child = Trie[Node].Children[Branch];
+		if (Child < 0)
+		{
+			break;
+		}
+		Node = static_cast<std::size_t>(Child);
+	}
+	return Include & ~Exclude;
+}
+
+WFilterMask WFilterEngine::Classify(WEndpoint const& Local, WEndpoint const& Remote, EProtocol::Type const Protocol) const
+{
+	// Until the remote endpoint is known the traffic can't be attributed to any filter
+	if (Remote.Address.IsZero())
+	{
+		return 0;
+	}
+
+	WFilterMask Mask = LookupAddress(Remote.Address);
+
+	for (WFilterMask Pending = Mask & ProtocolConstrainedMask; Pending != 0; Pending &= Pending - 1)
+	{
+		auto const& Protocols = Filters[static_cast<std::size_t>(std::countr_zero(Pending))].Protocols;
+		if (std::ranges::find(Protocols, Protocol) == Protocols.end())
+		{
+			Mask &= ~(Pending & -Pending);
+		}
+	}
+
+	for (WFilterMask Pending = Mask & PortConstrainedMask; Pending != 0; Pending &= Pending - 1)
+	{
+		auto const& Ports = Filters[static_cast<std::size_t>(std::countr_zero(Pending))].Ports;
+		bool const  bMatches = std::ranges::any_of(Ports, [&](WPortRange const& Range) {
+			return (Local.Port >= Range.Low && Local.Port <= Range.High)
+				|| (Remote.Port >= Range.Low && Remote.Port <= Range.High);
+		});
+		if (!bMatches)
+		{
+			Mask &= ~(Pending & -Pending);
+		}
+	}
+
+	if (WFilterMask const AsnPending = Mask & AsnConstrainedMask; AsnPending != 0)
+	{
+		auto const Asn = WIP2Asn::GetInstance().LookupAsn(Remote.Address);
+		for (WFilterMask Pending = AsnPending; Pending != 0; Pending &= Pending - 1)
+		{
+			auto const& Asns = Filters[static_cast<std::size_t>(std::countr_zero(Pending))].Asns;
+			if (!Asn || !Asns.contains(*Asn))
+			{
+				Mask &= ~(Pending & -Pending);
+			}
+		}
+	}
+
+	return Mask;
+}
+
+uint32_t WFilterEngine::GetGeneration() const
+{
+	// Both only ever grow, so the sum changes whenever one of them does
+	return Generation + WIP2Asn::GetInstance().GetDatabaseGeneration();
+}
+
+std::size_t WFilterEngine::GetMemoryUsage() const
+{
+	std::size_t Usage = sizeof(WFilterEngine);
+	Usage += (V4Trie.capacity() + V6Trie.capacity()) * sizeof(WTrieNode);
+	for (auto const& Filter : Filters)
+	{
+		Usage += sizeof(WFilterDefinition) + Filter.Name.capacity();
+		Usage += Filter.IncludedCidrs.capacity() * sizeof(WCidr) + Filter.ExcludedCidrs.capacity() * sizeof(WCidr);
+		Usage += Filter.Ports.capacity() * sizeof(WPortRange) + Filter.Protocols.capacity();
+		Usage += Filter.Asns.size() * sizeof(uint32_t);
+	}
+	return Usage;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "IPAddress.hpp"
+#include "MemoryStats.hpp"
+
+// One bit per filter, the bit index is the index into WSystemMap::FilterCounters
+using WFilterMask = uint64_t;
+
+static constexpr std::size_t kMaxFilterCount = sizeof(WFilterMask) * 8;
+
+struct WFilterConfig;
+
+struct WCidr
+{
+	WIPAddress Address{};
+	uint8_t    PrefixLength{};
+
+	static std::optional<WCidr> FromString(std::string const& Str);
+};
+
+struct WPortRange
+{
+	uint16_t Low{};
+	uint16_t High{};
+
+	// Either a single port or "low-high"
+	static std::optional<WPortRange> FromString(std::string const& Str);
+};
+
+struct WFilterDefinition
+{
+	std::string Name{};
+
+	// If empty, every remote address matches unless it is excluded
+	std::vector<WCidr>           IncludedCidrs{};
+	std::vector<WCidr>           ExcludedCidrs{};
+	std::vector<WPortRange>      Ports{};     // local or remote port, empty means any
+	std::vector<EProtocol::Type> Protocols{}; // empty means any
+	std::unordered_set<uint32_t> Asns{};      // empty means any
+};
+
+/**
+ * Compiles the traffic filters into one prefix trie per address family, where every
+ * node carries the bitmask of filters whose include/exclude prefixes end there.
+ * Classifying an endpoint walks the trie once and ORs the masks along the path, port, protocol
+ * and ASN constraints are then applied to the resulting mask.
+ *
+ * Classification happens once per socket/tuple when its endpoints change and the result is
+ * cached on the counter, so pushing traffic only has to walk the set bits of the mask.
+ */
+class WFilterEngine
+{
+	struct WTrieNode
+	{
+		int32_t     Children[2]{ -1, -1 };
+		WFilterMask IncludeMask{};
+		WFilterMask ExcludeMask{};
+	};
+
+	std::vector<WTrieNode> V4Trie{ 1 };
+	std::vector<WTrieNode> V6Trie{ 1 };
+
+	std::vector<WFilterDefinition> Filters{};
+
+	WFilterMask AnyAddressMask{};
+	WFilterMask PortConstrainedMask{};
+	WFilterMask ProtocolConstrainedMask{};
+	WFilterMask AsnConstrainedMask{};
+
+	// Bumped on every compile so counters can tell that their cached mask is outdated, see GetGeneration
+	uint32_t Generation{ 1 };
+
+	static void InsertPrefix(std::vector<WTrieNode>& Trie, WCidr const& Cidr, WFilterMask Bit, bool bExclude);
+
+	[[nodiscard]] WFilterMask LookupAddress(WIPAddress const& Address) const;
+
+public:
+	static std::vector<WFilterDefinition> GetDefaultFilters();
+
+	static std::optional<WFilterDefinition> ParseDefinition(WFilterConfig const& Config);
+
+	// Returns false if there were more filters than bits in WFilterMask, the extra filters are dropped
+	bool Compile(std::vector<WFilterDefinition> const& Definitions);
+
+	[[nodiscard]] WFilterMask Classify(
+		WEndpoint const& Local, WEndpoint const& Remote, EProtocol::Type Protocol) const;
+
+	// Also changes when a new ASN database is loaded, since that changes the result of filters with ASNs
+	[[nodiscard]] uint32_t GetGeneration() const;
+
+	[[nodiscard]] std::vector<WFilterDefinition> const& GetFilters() const { return Filters; }
+
+	[[nodiscard]] std::size_t GetMemoryUsage() const;
+};
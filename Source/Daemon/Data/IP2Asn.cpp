@@ -24,52 +24,110 @@ static stdfs::path GetDataFolder()
 	return { "." };
 }
 
-bool WIP2Asn::ExtractDatabase(std::filesystem::path const& GzPath, std::filesystem::path const& OutPath)
+bool WIP2Asn::DownloadDatabase(std::string const& Url, std::filesystem::path const& OutPath)
 {
-	auto const InputFile = gzopen(GzPath.string().c_str(), "rb");
-	if (!InputFile)
+	FILE* OutputFile = std::fopen(OutPath.string().c_str(), "wb");
+	if (!OutputFile)
 	{
-		spdlog::error("Failed to open gzipped IP2ASN database at {}", GzPath.string());
+		spdlog::error("Failed to open output IP2ASN database file at {}", OutPath.string());
 		return false;
 	}
 
-	FILE* OutputFile = std::fopen(OutPath.string().c_str(), "wb");
-	if (!OutputFile)
+	z_stream Stream{};
+	// 16 + MAX_WBITS makes zlib expect a gzip header
+	if (inflateInit2(&Stream, 16 + MAX_WBITS) != Z_OK)
 	{
-		spdlog::error("Failed to open output IP2ASN database file at {}", OutPath.string());
-		gzclose(InputFile);
+		spdlog::error("Failed to initialize zlib");
+		std::fclose(OutputFile);
 		return false;
 	}
 
 	constexpr std::size_t BufferSize = 128 * 1024;
-	auto const            Buffer = std::make_unique<char[]>(BufferSize);
-	int                   BytesRead;
+	auto const            Buffer = std::make_unique<Bytef[]>(BufferSize);
+	bool                  bStreamEnd = false;
+	float                 LastProgress = 0.f;
 
-	while ((BytesRead = gzread(InputFile, static_cast<void*>(Buffer.get()), 128 * 1024)) > 0)
-	{
-		if (std::fwrite(static_cast<void*>(Buffer.get()), 1, static_cast<size_t>(BytesRead), OutputFile)
-			!= static_cast<size_t>(BytesRead))
+	auto const OnData = [&](char const* Data, std::size_t Size) {
+		Stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(Data));
+		Stream.avail_in = static_cast<uInt>(Size);
+		while (Stream.avail_in > 0)
 		{
-			spdlog::error("Failed to write to output file {}", OutPath.string());
-			break;
+			if (bStreamEnd)
+			{
+				// The file might consist of multiple concatenated gzip members
+				inflateReset(&Stream);
+				bStreamEnd = false;
+			}
+
+			Stream.next_out = Buffer.get();
+			Stream.avail_out = static_cast<uInt>(BufferSize);
+			auto const Result = inflate(&Stream, Z_NO_FLUSH);
+			if (Result != Z_OK && Result != Z_STREAM_END)
+			{
+				spdlog::error("Failed to inflate IP2ASN database: {}", Stream.msg ? Stream.msg : zError(Result));
+				return false;
+			}
+			bStreamEnd = Result == Z_STREAM_END;
+
+			auto const Produced = BufferSize - Stream.avail_out;
+			if (std::fwrite(Buffer.get(), 1, Produced, OutputFile) != Produced)
+			{
+				spdlog::error("Failed to write to output file {}", OutPath.string());
+				return false;
+			}
 		}
+		return true;
+	};
+
+	auto const bDownloaded = WLibCurl::DownloadStream(
+		Url, OnData,
+		[&LastProgress](float Progress) {
+			if (Progress - LastProgress >= 0.1f)
+			{
+				LastProgress = Progress;
+				spdlog::info("Downloading IP2ASN database: {:.2f}%", static_cast<double>(Progress) * 100);
+			}
+		},
+		[](std::string const& Error) { spdlog::error("Failed to download IP2ASN database: {}", Error); });
+
+	inflateEnd(&Stream);
+	auto const bWritten = std::fclose(OutputFile) == 0;
+
+	if (bDownloaded && !bStreamEnd)
+	{
+		spdlog::error("IP2ASN database download is truncated");
 	}
+	return bDownloaded && bStreamEnd && bWritten;
+}
 
-	if (BytesRead < 0)
+std::shared_ptr<WIP2AsnDB const> WIP2Asn::LoadDatabase(std::filesystem::path const& Path)
+{
+	auto NewDatabase = std::make_shared<WIP2AsnDB>(Path);
+	if (!NewDatabase->Init())
 	{
-		int         ErrNum;
-		char const* ErrMsg = gzerror(InputFile, &ErrNum);
-		spdlog::error("Failed to read from gzip file {}: {}", GzPath.string(), ErrMsg);
+		spdlog::error("Failed to parse IP2ASN database at {}", Path.string());
+		return nullptr;
 	}
+	spdlog::info("Loaded IP2ASN database with {} entries (memory usage: {})", NewDatabase->GetSize(),
+		WStorageFormat::AutoFormat(NewDatabase->MemoryUsage()));
+	return NewDatabase;
+}
 
-	gzclose(InputFile);
-	std::fclose(OutputFile);
-	return true;
+void WIP2Asn::SwapDatabase(std::shared_ptr<WIP2AsnDB const> NewDatabase)
+{
+	Database.store(std::move(NewDatabase));
+	bHaveDatabaseDownloaded = true;
+	++DatabaseGeneration;
+
+	// Cached results (including failed lookups) came from the old database
+	std::scoped_lock Lock(CacheMutex);
+	Cache.clear();
 }
 
 void WIP2Asn::LookupAddress(WQueuedRequest const& Request)
 {
-	if (!Database || bUpdateInProgress)
+	auto const Db = Database.load();
+	if (!Db)
 	{
 		Request.Promise.Finish(std::nullopt);
 		return;
@@ -88,8 +146,7 @@ void WIP2Asn::LookupAddress(WQueuedRequest const& Request)
 		return;
 	}
 	spdlog::debug("Looking up ASN for {}", Request.AddressToResolve.ToString());
-	std::scoped_lock Lock(DownloadMutex);
-	auto             Result = Database->Lookup(Request.AddressToResolve);
+	auto Result = Db->Lookup(Request.AddressToResolve);
 	if (!Result)
 	{
 		Cache[Request.AddressToResolve] = std::nullopt;
@@ -158,19 +215,11 @@ void WIP2Asn::Init()
 		Stop();
 	}
 	auto DatabasePath = GetDataFolder() / "ip2asn_db.tsv";
-	Database = nullptr;
 	if (std::filesystem::exists(DatabasePath))
 	{
-		Database = std::make_unique<WIP2AsnDB>(DatabasePath);
-		if (Database->Init())
-		{
-			spdlog::info("Loaded IP2ASN database with {} entries (memory usage: {})", Database->GetSize(),
-				WStorageFormat::AutoFormat(Database->MemoryUsage()));
-			bHaveDatabaseDownloaded = true;
-		}
-		else
+		if (auto NewDatabase = LoadDatabase(DatabasePath))
 		{
-			spdlog::error("Failed to parse IP2ASN database at {}", DatabasePath.string());
+			SwapDatabase(std::move(NewDatabase));
 		}
 	}
 	else
@@ -205,42 +254,45 @@ void WIP2Asn::UpdateDatabase()
 	}
 	static std::string const URL = "https://waechter.st/ip2asn-combined.tsv.gz";
 
-	auto OldDatabasePath = GetDataFolder() / "ip2asn_db.tsv";
-	if (std::filesystem::exists(OldDatabasePath))
-	{
-		std::filesystem::remove(OldDatabasePath);
-	}
-	OldDatabasePath = GetDataFolder() / "ip2asn_db.tsv.gz";
-	if (std::filesystem::exists(OldDatabasePath))
-	{
-		std::filesystem::remove(OldDatabasePath);
-	}
-	OldDatabasePath = GetDataFolder() / "ip2asn_db.tsv.idx";
-	if (std::filesystem::exists(OldDatabasePath))
-	{
-		std::filesystem::remove(OldDatabasePath);
-	}
-	float LastProgress = 0.f;
+	// Leftover from versions that downloaded the compressed database to disk first
+	std::error_code Error;
+	std::filesystem::remove(GetDataFolder() / "ip2asn_db.tsv.gz", Error);
 
 	bUpdateInProgress = true;
-	DownloadThread = std::thread([this, &LastProgress] {
-		std::scoped_lock lock(DownloadMutex);
-		auto const       DatabasePath = GetDataFolder() / "ip2asn_db.tsv.gz";
-		WLibCurl::DownloadFile(
-			URL, DatabasePath,
-			[&](float Progress) {
-				if (Progress - LastProgress >= 0.1f)
-				{
-					LastProgress = Progress;
-					spdlog::info("Downloading IP2ASN database: {:.2f}%", Progress * 100);
-				}
-			},
-			[](std::string const& Error) { spdlog::error("Failed to download IP2ASN database: {}", Error); });
-		if (ExtractDatabase(DatabasePath, DatabasePath.parent_path() / "ip2asn_db.tsv"))
+	DownloadThread = std::thread([this] {
+		ZoneScopedN("WIP2Asn::UpdateDatabase");
+		// The current database stays in use until the new one is ready, so everything is written
+		// to temporary files first and only moved into place once it was downloaded and indexed
+		auto const DatabasePath = GetDataFolder() / "ip2asn_db.tsv";
+		auto const IndexPath = WIP2AsnDB::GetIndexPath(DatabasePath);
+		auto       TempDatabasePath = DatabasePath;
+		auto       TempIndexPath = IndexPath;
+		TempDatabasePath += ".tmp";
+		TempIndexPath += ".tmp";
+
+		std::error_code FsError;
+		if (DownloadDatabase(URL, TempDatabasePath) && WIP2AsnDB::BuildIndex(TempDatabasePath, TempIndexPath))
 		{
-			spdlog::info("Extracted IP2ASN database successfully");
-			Init();
+			// Mapped instances of the old files stay valid after they were replaced
+			std::filesystem::rename(TempDatabasePath, DatabasePath, FsError);
+			if (!FsError)
+			{
+				std::filesystem::rename(TempIndexPath, IndexPath, FsError);
+			}
+
+			if (FsError)
+			{
+				spdlog::error("Failed to move the new IP2ASN database into place: {}", FsError.message());
+			}
+			else if (auto NewDatabase = LoadDatabase(DatabasePath))
+			{
+				SwapDatabase(std::move(NewDatabase));
+				spdlog::info("Updated IP2ASN database successfully");
+			}
 		}
+
+		std::filesystem::remove(TempDatabasePath, FsError);
+		std::filesystem::remove(TempIndexPath, FsError);
 		bUpdateInProgress = false;
 	});
 }
@@ -264,7 +316,8 @@ std::optional<WIP2AsnLookupResult> WIP2Asn::LookupSync(WIPAddress const& IpAddre
 	{
 		return std::nullopt;
 	}
-	if (!Database || bUpdateInProgress)
+	auto const Db = Database.load();
+	if (!Db)
 	{
 		return std::nullopt;
 	}
@@ -275,12 +328,12 @@ std::optional<WIP2AsnLookupResult> WIP2Asn::LookupSync(WIPAddress const& IpAddre
 		return It->second;
 	}
 	spdlog::debug("Looking up ASN for {}", IpAddress.ToString());
-	std::scoped_lock Lock(DownloadMutex);
-	auto             Result = Database->Lookup(IpAddress);
+	auto Result = Db->Lookup(IpAddress);
 	if (!Result)
 	{
+		// Not every address is announced, the miss is cached so this is only logged once per address
 		Cache[IpAddress] = std::nullopt;
-		spdlog::warn("IP2ASN lookup failed for address: {}", IpAddress.ToString());
+		spdlog::debug("IP2ASN lookup failed for address: {}", IpAddress.ToString());
 		return std::nullopt;
 	}
 	Result->Address = IpAddress;
@@ -290,4 +343,22 @@ std::optional<WIP2AsnLookupResult> WIP2Asn::LookupSync(WIPAddress const& IpAddre
 	Result->Country = CountryLowerCase;
 	Cache[IpAddress] = Result;
 	return Result;
-}
\ No newline at end of file
+}
+
+std::optional<uint32_t> WIP2Asn::LookupAsn(WIPAddress const& IpAddress) const
+{
+	if (IpAddress.IsZero() || IpAddress.IsLocalhost() || IpAddress.IsLANAddress())
+	{
+		return std::nullopt;
+	}
+	auto const Db = Database.load();
+	if (!Db)
+	{
+		return std::nullopt;
+	}
+	if (auto const Result = Db->Lookup(IpAddress))
+	{
+		return Result->ASN;
+	}
+	return std::nullopt;
+}
@@ -8,6 +8,7 @@
 
 #include <memory>
 #include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
@@ -22,12 +23,17 @@ class WIP2Asn : public TSingleton<WIP2Asn>
 	bool bHaveDatabaseDownloaded{ false };
 	std::atomic<bool> bUpdateInProgress{ false };
 	std::thread       DownloadThread{};
-	std::mutex        DownloadMutex{};
 	std::atomic<float> DownloadProgress{ 0.0f };
 
-	std::unique_ptr<WIP2AsnDB> Database{};
+	// Lookups hold their own reference, so an update can swap in a new database while they are running
+	std::atomic<std::shared_ptr<WIP2AsnDB const>> Database{};
+	std::atomic<uint32_t>                         DatabaseGeneration{ 0 };
+
+	// Inflates the gzipped database into OutPath while it is downloaded
+	static bool DownloadDatabase(std::string const& Url, std::filesystem::path const& OutPath);
+	static std::shared_ptr<WIP2AsnDB const> LoadDatabase(std::filesystem::path const& Path);
+	void                                    SwapDatabase(std::shared_ptr<WIP2AsnDB const> NewDatabase);
 
-	static bool ExtractDatabase(std::filesystem::path const& GzPath, std::filesystem::path const& OutPath);
 	std::mutex  CacheMutex;
 	std::unordered_map<WIPAddress, std::optional<WIP2AsnLookupResult>> Cache{};
 
@@ -60,9 +66,15 @@ public:
 	void UpdateDatabase();
 
 	bool IsUpdateInProgress() const noexcept { return bUpdateInProgress.load(); }
-	bool HasDatabase() const noexcept { return Database != nullptr; }
+	bool HasDatabase() const noexcept { return Database.load() != nullptr; }
 
 	TPromise<std::optional<WIP2AsnLookupResult> const&> Lookup(WIPAddress const& IpAddress);
 
 	std::optional<WIP2AsnLookupResult> LookupSync(WIPAddress const& IpAddress);
+
+	// Goes straight to the database without the cache or logging, for callers that hold the system map lock
+	[[nodiscard]] std::optional<uint32_t> LookupAsn(WIPAddress const& IpAddress) const;
+
+	// Bumped whenever a database is loaded, results from an older one are outdated
+	[[nodiscard]] uint32_t GetDatabaseGeneration() const noexcept { return DatabaseGeneration.load(); }
 };
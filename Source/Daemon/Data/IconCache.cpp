@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "IconCache.hpp"
+
+#include <fstream>
+
+#include "spdlog/spdlog.h"
+#include "tracy/Tracy.hpp"
+#include "stb_image.h"
+#include "stb_image_resize2.h"
+
+namespace
+{
+int64_t GetModificationTime(std::string const& Path)
+{
+	struct stat Stat{};
+	if (stat(Path.c_str(), &Stat) != 0)
+	{
+		return -1;
+	}
+	return static_cast<int64_t>(Stat.st_mtim.tv_sec) * 1000000000 + Stat.st_mtim.tv_nsec;
+}
+
+template <typename T>
+bool ReadValue(std::ifstream& File, T& Value)
+{
+	return static_cast<bool>(File.read(reinterpret_cast<char*>(&Value), sizeof(T)));
+}
+
+template <typename T>
+void WriteValue(std::ofstream& File, T const& Value)
+{
+	File.write(reinterpret_cast<char const*>(&Value), sizeof(T));
+}
+} // namespace
+
+WIconCache::WIconCache(uint32_t const IconSize_) : IconSize(IconSize_)
+{
+	// Same place as the IP2ASN database, the cache is only an optimization so we don't fall back to the working dir
+	if (WFilesystem::Writable("/var/lib/waechter"))
+	{
+		CachePath = "/var/lib/waechter/icon-cache.bin";
+	}
+}
+
+std::shared_ptr<WDecodedIcon const> WIconCache::Decode(
+	std::string const& Path, int64_t const ModificationTime, uint32_t const IconSize)
+{
+	ZoneScopedN("WIconCache::Decode");
+	int            IconW, IconH, N;
+	unsigned char* Data = stbi_load(Path.c_str(), &IconW, &IconH, &N, 4); // Force RGBA
+	if (!Data)
+	{
+		spdlog::warn("Failed to load app icon from path '{}'", Path);
+		return nullptr;
+	}
+
+	auto Icon = std::make_shared<WDecodedIcon>();
+	Icon->ModificationTime = ModificationTime;
+	Icon->IconSize = IconSize;
+
+	if (IconW > static_cast<int>(IconSize) || IconH > static_cast<int>(IconSize))
+	{
+		// Resize icon to fit
+		Icon->W = Icon->H = IconSize;
+		Icon->Pixels.resize(std::size_t{ IconSize } * IconSize * 4);
+		stbir_resize_uint8_srgb(Data, IconW, IconH, 0, Icon->Pixels.data(), static_cast<int>(IconSize),
+			static_cast<int>(IconSize), 0, STBIR_RGBA);
+	}
+	else
+	{
+		Icon->W = static_cast<uint32_t>(IconW);
+		Icon->H = static_cast<uint32_t>(IconH);
+		Icon->Pixels.assign(Data, Data + std::size_t{ Icon->W } * Icon->H * 4);
+	}
+	stbi_image_free(Data);
+	return Icon;
+}
+
+std::shared_ptr<WDecodedIcon const> WIconCache::Get(std::string const& Path)
+{
+	std::scoped_lock Lock(Mutex);
+	if (!bLoaded)
+	{
+		Load();
+	}
+
+	auto const ModificationTime = GetModificationTime(Path);
+	if (ModificationTime < 0)
+	{
+		return nullptr;
+	}
+
+	if (auto const It = Icons.find(Path); It != Icons.end() && It->second->ModificationTime == ModificationTime)
+	{
+		return It->second;
+	}
+
+	auto Icon = Decode(Path, ModificationTime, IconSize);
+	if (Icon)
+	{
+		Icons[Path] = Icon;
+		bModified = true;
+	}
+	return Icon;
+}
+
+void WIconCache::Load()
+{
+	ZoneScopedN("WIconCache::Load");
+	bLoaded = true;
+	if (CachePath.empty())
+	{
+		return;
+	}
+
+	std::ifstream File(CachePath, std::ios::binary);
+	if (!File)
+	{
+		return;
+	}
+
+	uint32_t FileMagic{}, FileVersion{}, Count{};
+	if (!ReadValue(File, FileMagic) || !ReadValue(File, FileVersion) || !ReadValue(File, Count) || FileMagic != Magic
+		|| FileVersion != Version)
+	{
+		spdlog::warn("Ignoring icon cache at {} with unknown format", CachePath.string());
+		return;
+	}
+
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		uint32_t PathLength{};
+		auto     Icon = std::make_shared<WDecodedIcon>();
+		if (!ReadValue(File, PathLength) || PathLength > 4096)
+		{
+			break;
+		}
+
+		// The sizes are checked against our own icon size before anything is allocated for the pixels. Entries of
+		// another size would be decoded again anyway, and a broken entry means the rest can't be trusted either
+		std::string Path(PathLength, '\0');
+		if (!File.read(Path.data(), PathLength) || !ReadValue(File, Icon->ModificationTime)
+			|| !ReadValue(File, Icon->IconSize) || !ReadValue(File, Icon->W) || !ReadValue(File, Icon->H)
+			|| Icon->IconSize != IconSize || Icon->W > IconSize || Icon->H > IconSize)
+		{
+			spdlog::warn("Ignoring the rest of the icon cache at {}, entry {} is invalid", CachePath.string(), i);
+			bModified = true;
+			break;
+		}
+
+		Icon->Pixels.resize(std::size_t{ Icon->W } * Icon->H * 4);
+		if (!File.read(reinterpret_cast<char*>(Icon->Pixels.data()), static_cast<std::streamsize>(Icon->Pixels.size())))
+		{
+			break;
+		}
+		Icons[Path] = std::move(Icon);
+	}
+	spdlog::debug("Loaded {} decoded icons from {}", Icons.size(), CachePath.string());
+}
+
+void WIconCache::Save()
+{
+	std::scoped_lock Lock(Mutex);
+	if (!bModified || CachePath.empty())
+	{
+		return;
+	}
+	ZoneScopedN("WIconCache::Save");
+	bModified = false;
+
+	// Apps that were uninstalled would otherwise stay in the cache forever
+	std::erase_if(Icons, [](auto const& Entry) { return GetModificationTime(Entry.first) < 0; });
+
+	// Write to a temporary file first, so a crash doesn't leave a truncated cache behind
+	auto const    TempPath = stdfs::path(CachePath).concat(".tmp");
+	std::ofstream File(TempPath, std::ios::binary | std::ios::trunc);
+	if (!File)
+	{
+		spdlog::warn("Failed to write icon cache to {}", TempPath.string());
+		return;
+	}
+
+	WriteValue(File, Magic);
+	WriteValue(File, Version);
+	WriteValue(File, static_cast<uint32_t>(Icons.size()));
+	for (auto const& [Path, Icon] : Icons)
+	{
+		WriteValue(File, static_cast<uint32_t>(Path.size()));
+		File.write(Path.data(), static_cast<std::streamsize>(Path.size()));
+		WriteValue(File, Icon->ModificationTime);
+		WriteValue(File, Icon->IconSize);
+		WriteValue(File, Icon->W);
+		WriteValue(File, Icon->H);
+		File.write(
+			reinterpret_cast<char const*>(Icon->Pixels.data()), static_cast<std::streamsize>(Icon->Pixels.size()));
+	}
+	File.close();
+
+	std::error_code Error;
+	stdfs::rename(TempPath, CachePath, Error);
+	if (Error)
+	{
+		spdlog::warn("Failed to replace icon cache at {}: {}", CachePath.string(), Error.message());
+	}
+}
+
+WMemoryStat WIconCache::GetMemoryUsage()
+{
+	std::scoped_lock Lock(Mutex);
+	WMemoryStat      Stats{};
+	Stats.Name = "WIconCache";
+
+	WMemoryStatEntry IconsEntry{};
+	IconsEntry.Name = "Decoded icons";
+	for (auto const& [Path, Icon] : Icons)
+	{
+		IconsEntry.Usage += Path.capacity() + sizeof(WDecodedIcon) + Icon->Pixels.capacity();
+	}
+	Stats.ChildEntries.emplace_back(IconsEntry);
+	return Stats;
+}
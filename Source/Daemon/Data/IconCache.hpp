@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MemoryStats.hpp"
+#include "Filesystem.hpp"
+
+struct WDecodedIcon
+{
+	int64_t                    ModificationTime{};
+	uint32_t                   IconSize{}; // the size the icon was scaled down to
+	uint32_t                   W{}, H{};
+	std::vector<unsigned char> Pixels{}; // RGBA
+};
+
+/**
+ * Decoding and resizing icons is by far the most expensive part of building the icon atlas,
+ * so the results are kept per icon file and only redone if the file was modified.
+ * The cache is written to disk so the icons don't have to be decoded again after a restart.
+ */
+class WIconCache : public IMemoryTrackable
+{
+	static constexpr uint32_t Magic = 0x4e434957; // WICN
+	static constexpr uint32_t Version = 1;
+
+	std::mutex Mutex;
+
+	// All icons are scaled down to fit into this, cached entries of another size are dropped
+	uint32_t IconSize{};
+
+	std::unordered_map<std::string, std::shared_ptr<WDecodedIcon const>> Icons{};
+	stdfs::path                                                          CachePath{};
+	bool                                                                 bLoaded{ false };
+	bool                                                                 bModified{ false };
+
+	static std::shared_ptr<WDecodedIcon const> Decode(
+		std::string const& Path, int64_t ModificationTime, uint32_t IconSize);
+
+	void Load();
+
+public:
+	explicit WIconCache(uint32_t IconSize_);
+
+	// Returns nullptr if the icon couldn't be loaded
+	std::shared_ptr<WDecodedIcon const> Get(std::string const& Path);
+
+	// Writes the cache to disk if icons were decoded since the last call, icons that no longer exist are dropped
+	void Save();
+
+	WMemoryStat GetMemoryUsage() override;
+};
@@ -5,68 +5,186 @@
 
 #include "IconResolver.hpp"
 
+#include <array>
 #include <fstream>
 #include <vector>
+#include <sys/inotify.h>
+
+#include "tracy/Tracy.hpp"
 
 #include "Filesystem.hpp"
 
-inline std::string FindDesktopFile(std::string const& BinaryName, std::vector<std::string> const& DesktopDirs)
+namespace
 {
-	auto BinaryNameLowercase = BinaryName;
-	std::ranges::transform(BinaryNameLowercase, BinaryNameLowercase.begin(), ::tolower);
+// Returns the N in a ".../NxN/apps/name.png" path, or 0 if the path doesn't contain a size
+int GetIconDirSize(stdfs::path const& IconPath)
+{
+	for (auto const& Component : IconPath)
+	{
+		auto const Str = Component.string();
+		auto const Pos = Str.find('x');
+		if (Pos == std::string::npos || Pos == 0 || Str.substr(0, Pos) != Str.substr(Pos + 1))
+		{
+			continue;
+		}
+
+		try
+		{
+			return std::stoi(Str.substr(0, Pos));
+		}
+		catch (std::exception const&)
+		{
+		}
+	}
+	return 0;
+}
 
+// Prefer the smallest icon that is at least as big as the icons in the atlas, so they don't have to be upscaled
+bool IsBetterIconSize(int const Candidate, int const Current)
+{
+	constexpr int PreferredSize = 32;
+	if (Current == 0)
+	{
+		return Candidate != 0;
+	}
+	if (Candidate >= PreferredSize && Current >= PreferredSize)
+	{
+		return Candidate < Current;
+	}
+	return Candidate > Current;
+}
+} // namespace
+
+WIconResolver::~WIconResolver()
+{
+	if (InotifyFd >= 0)
+	{
+		close(InotifyFd);
+	}
+}
+
+void WIconResolver::WatchDirectory(std::string const& Path) const
+{
+	if (InotifyFd < 0)
+	{
+		return;
+	}
+
+	constexpr uint32_t Mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE;
+	if (inotify_add_watch(InotifyFd, Path.c_str(), Mask) < 0)
+	{
+		spdlog::debug("Failed to watch '{}' for icon changes: {}", Path, WErrnoUtil::StrError());
+	}
+}
+
+void WIconResolver::BuildIndex()
+{
+	ZoneScopedN("WIconResolver::BuildIndex");
+	DesktopIndex.clear();
+	IconIndex.clear();
+
+	if (InotifyFd >= 0)
+	{
+		// Watches are recreated below, the set of directories might have changed
+		close(InotifyFd);
+	}
+	InotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (InotifyFd < 0)
+	{
+		spdlog::warn("Failed to create inotify instance, icons of new applications won't be picked up: {}",
+			WErrnoUtil::StrError());
+	}
+
+	std::error_code Error;
 	for (auto const& Dir : DesktopDirs)
 	{
-		for (auto const& Entry : stdfs::recursive_directory_iterator(Dir))
+		WatchDirectory(Dir);
+		for (auto It = stdfs::recursive_directory_iterator(Dir, Error); !Error && It != stdfs::end(It);
+			It.increment(Error))
 		{
-			if (Entry.path().extension() == ".desktop")
+			if (It->is_directory(Error))
+			{
+				WatchDirectory(It->path().string());
+				continue;
+			}
+			if (It->path().extension() != ".desktop")
+			{
+				continue;
+			}
+
+			WDesktopEntry Entry{};
+			Entry.Path = It->path().string();
+
+			std::ifstream File(It->path());
+			std::string   Line;
+			while (std::getline(File, Line))
 			{
-				std::ifstream File(Entry.path());
-				std::string   Line;
-				while (std::getline(File, Line))
+				if (Line.rfind("Icon=", 0) == 0 && Entry.IconName.empty())
+				{
+					Entry.IconName = Line.substr(5);
+				}
+
+				auto LineLowercase = Line;
+				std::ranges::transform(LineLowercase, LineLowercase.begin(), ::tolower);
+				if (LineLowercase.rfind("exec=", 0) == 0)
 				{
-					auto LineLowercase = Line;
-					std::ranges::transform(LineLowercase, LineLowercase.begin(), ::tolower);
-					if (LineLowercase.rfind("exec=", 0) == 0
-						&& LineLowercase.find(BinaryNameLowercase) != std::string::npos)
-					{
-						spdlog::debug(
-							"Found desktop file for binary '{}' at path '{}'", BinaryName, Entry.path().string());
-						return Entry.path();
-					}
+					Entry.ExecLines.emplace_back(std::move(LineLowercase));
 				}
 			}
+
+			if (!Entry.ExecLines.empty())
+			{
+				DesktopIndex.emplace_back(std::move(Entry));
+			}
 		}
+		Error.clear();
 	}
-	return "";
-}
 
-inline std::string GetIconName(std::string const& DesktopFilePath)
-{
-	std::ifstream File(DesktopFilePath);
-	std::string   Line;
-	while (std::getline(File, Line))
+	WatchDirectory(IconThemeDir);
+	for (auto It = stdfs::recursive_directory_iterator(IconThemeDir, Error); !Error && It != stdfs::end(It);
+		It.increment(Error))
 	{
-		if (Line.rfind("Icon=", 0) == 0)
+		if (It->is_directory(Error))
 		{
-			return Line.substr(5);
+			WatchDirectory(It->path().string());
+		}
+		else if (It->path().extension() == ".png")
+		{
+			IconIndex[It->path().stem().string()].emplace_back(It->path().string());
 		}
 	}
-	return "";
+
+	bIndexValid = true;
+	spdlog::debug("Indexed {} desktop files and {} icon names", DesktopIndex.size(), IconIndex.size());
 }
 
-inline std::string FindIconPathByName(std::string const& Name)
+std::string WIconResolver::FindIconPathByName(std::string const& Name) const
 {
-	// Iterate through all icon directories and look for {name}.png
-	// If found, return the path to the icon
-	for (auto const& Dir : stdfs::recursive_directory_iterator("/usr/share/icons/hicolor"))
+	auto Candidates = IconIndex.find(Name);
+	if (Candidates == IconIndex.end())
+	{
+		// Look for {name}.png in any form, some desktop files only reference part of the file name
+		Candidates = std::ranges::find_if(
+			IconIndex, [&Name](auto const& Entry) { return Entry.first.find(Name) != std::string::npos; });
+	}
+
+	if (Candidates == IconIndex.end())
+	{
+		return "";
+	}
+
+	std::string const* BestPath{};
+	int                BestSize{};
+	for (auto const& Path : Candidates->second)
 	{
-		if (Dir.path().extension() == ".png" && Dir.path().filename().string().find(Name) != std::string::npos)
+		auto const Size = GetIconDirSize(Path);
+		if (!BestPath || IsBetterIconSize(Size, BestSize))
 		{
-			return Dir.path();
+			BestPath = &Path;
+			BestSize = Size;
 		}
 	}
-	return "";
+	return *BestPath;
 }
 
 std::string WIconResolver::GetIconFromBinaryName(std::string const& Binary) const
@@ -76,25 +194,84 @@ std::string WIconResolver::GetIconFromBinaryName(std::string const& Binary) cons
 		return "";
 	}
 
-	auto const DesktopFile = FindDesktopFile(Binary, DesktopDirs);
-	if (DesktopFile.empty())
+	auto BinaryNameLowercase = Binary;
+	std::ranges::transform(BinaryNameLowercase, BinaryNameLowercase.begin(), ::tolower);
+
+	auto const DesktopEntry = std::ranges::find_if(DesktopIndex, [&BinaryNameLowercase](WDesktopEntry const& Entry) {
+		return std::ranges::any_of(Entry.ExecLines,
+			[&](std::string const& Line) { return Line.find(BinaryNameLowercase) != std::string::npos; });
+	});
+
+	if (DesktopEntry == DesktopIndex.end())
 	{
 		spdlog::debug("No desktop file found for binary '{}'", Binary);
 		return "";
 	}
+	spdlog::debug("Found desktop file for binary '{}' at path '{}'", Binary, DesktopEntry->Path);
 
-	auto const Name = GetIconName(DesktopFile);
-	if (Name.empty())
+	if (DesktopEntry->IconName.empty())
 	{
-		spdlog::debug("No icon name found in desktop file '{}'", DesktopFile);
+		spdlog::debug("No icon name found in desktop file '{}'", DesktopEntry->Path);
 		return "";
 	}
-	return FindIconPathByName(Name);
+	return FindIconPathByName(DesktopEntry->IconName);
+}
+
+std::string WIconResolver::ResolveIcon(std::string const& Binary, bool* bCached)
+{
+	std::scoped_lock Lock(Mutex);
+	if (auto const Iter = IconMap.find(Binary); Iter != IconMap.end())
+	{
+		if (bCached)
+		{
+			*bCached = true;
+		}
+		return Iter->second;
+	}
+
+	if (bCached)
+	{
+		*bCached = false;
+	}
+
+	if (!bIndexValid)
+	{
+		BuildIndex();
+	}
+
+	auto const& Icon = IconMap[Binary] = GetIconFromBinaryName(Binary);
+	return Icon;
+}
+
+bool WIconResolver::CheckForChanges()
+{
+	std::scoped_lock Lock(Mutex);
+	if (InotifyFd < 0)
+	{
+		return false;
+	}
+
+	bool                                          bChanged{ false };
+	alignas(inotify_event) std::array<char, 4096> Buffer{};
+	while (read(InotifyFd, Buffer.data(), Buffer.size()) > 0)
+	{
+		// We don't care what exactly changed, package installs touch many files at once anyway
+		bChanged = true;
+	}
+
+	if (bChanged)
+	{
+		spdlog::debug("Desktop files or icons changed, rebuilding icon index");
+		bIndexValid = false;
+		IconMap.clear();
+	}
+	return bChanged;
 }
 
 WMemoryStat WIconResolver::GetMemoryUsage()
 {
-	WMemoryStat Stats{};
+	std::scoped_lock Lock(Mutex);
+	WMemoryStat      Stats{};
 	Stats.Name = "WIconResolver";
 	WMemoryStatEntry IconsEntry{};
 	for (auto const& [Key, Value] : IconMap)
@@ -103,5 +280,25 @@ WMemoryStat WIconResolver::GetMemoryUsage()
 	}
 	IconsEntry.Name = "IconMap";
 	Stats.ChildEntries.emplace_back(IconsEntry);
+
+	WMemoryStatEntry IndexEntry{};
+	IndexEntry.Name = "Desktop/icon index";
+	for (auto const& Entry : DesktopIndex)
+	{
+		IndexEntry.Usage += sizeof(WDesktopEntry) + Entry.Path.capacity() + Entry.IconName.capacity();
+		for (auto const& Line : Entry.ExecLines)
+		{
+			IndexEntry.Usage += sizeof(std::string) + Line.capacity();
+		}
+	}
+	for (auto const& [Name, Paths] : IconIndex)
+	{
+		IndexEntry.Usage += Name.capacity() + sizeof(Paths);
+		for (auto const& Path : Paths)
+		{
+			IndexEntry.Usage += sizeof(std::string) + Path.capacity();
+		}
+	}
+	Stats.ChildEntries.emplace_back(IndexEntry);
 	return Stats;
-}
\ No newline at end of file
+}
@@ -4,6 +4,7 @@
  */
 
 #pragma once
+#include <mutex>
 #include <unordered_map>
 #include <string>
 #include <vector>
@@ -11,35 +12,48 @@
 #include "MemoryStats.hpp"
 #include "spdlog/spdlog.h"
 
+/**
+ * Maps binary names to icon files via the desktop entries of installed applications.
+ * The desktop entries and icon files are indexed once, the index is rebuilt
+ * when inotify reports changes in one of the indexed directories.
+ */
 class WIconResolver : public IMemoryTrackable
 {
+	struct WDesktopEntry
+	{
+		std::string              Path{};
+		std::string              IconName{};
+		std::vector<std::string> ExecLines{}; // lowercase
+	};
+
+	std::mutex Mutex;
+
 	std::unordered_map<std::string, std::string> IconMap{};
 
-	std::string              GetIconFromBinaryName(std::string const& Binary) const;
+	std::vector<WDesktopEntry>                                DesktopIndex{};
+	std::unordered_map<std::string, std::vector<std::string>> IconIndex{}; // icon name -> png files
+	bool                                                      bIndexValid{ false };
+	int                                                       InotifyFd{ -1 };
+
 	std::vector<std::string> DesktopDirs = {
 		"/usr/share/applications",
 	};
+	std::string IconThemeDir{ "/usr/share/icons/hicolor" };
+
+	void BuildIndex();
+	void WatchDirectory(std::string const& Path) const;
+
+	[[nodiscard]] std::string FindIconPathByName(std::string const& Name) const;
+	[[nodiscard]] std::string GetIconFromBinaryName(std::string const& Binary) const;
 
 public:
-	std::string const& ResolveIcon(std::string const& Binary, bool* bCached = nullptr)
-	{
-		if (auto const Iter = IconMap.find(Binary); Iter != IconMap.end())
-		{
-			if (bCached)
-			{
-				*bCached = true;
-			}
-			return Iter->second;
-		}
-
-		if (bCached)
-		{
-			*bCached = false;
-		}
-
-		IconMap[Binary] = GetIconFromBinaryName(Binary);
-		return IconMap[Binary];
-	}
+	~WIconResolver() override;
+
+	std::string ResolveIcon(std::string const& Binary, bool* bCached = nullptr);
+
+	// Returns true if applications or icons were installed or removed since the last call,
+	// previously resolved icons are forgotten in that case
+	bool CheckForChanges();
 
 	WMemoryStat GetMemoryUsage() override;
 };
@@ -22,9 +22,11 @@ namespace
 		return Size * NMemB;
 	}
 
-	size_t WriteFileCallback(char* ptr, size_t size, size_t nmemb, void* userdata)
+	size_t WriteStreamCallback(char* Ptr, size_t Size, size_t NMemB, void* UserData)
 	{
-		return std::fwrite(ptr, size, nmemb, static_cast<FILE*>(userdata));
+		auto* OnData = static_cast<std::function<bool(char const*, std::size_t)>*>(UserData);
+		// Returning less than we were given makes curl abort with CURLE_WRITE_ERROR
+		return (*OnData)(Ptr, Size * NMemB) ? Size * NMemB : 0;
 	}
 
 	int ProgressCallback(void* Client, long long DlTotal, long long DlNow, long long, long long)
@@ -152,26 +154,41 @@ WJson WLibCurl::GetJson(std::string const& Url, std::string& OutError)
 void WLibCurl::DownloadFile(std::string const& Url, std::filesystem::path const& DestinationPath,
 	std::function<void(float)> OnProgress, std::function<void(std::string const&)> const& OnError)
 {
-	CURL* Curl = curl_easy_init();
-	if (!Curl)
-	{
-		OnError("curl_easy_init failed");
-		return;
-	}
-
 	auto File = std::fopen(DestinationPath.string().c_str(), "wb");
 	if (!File)
 	{
 		OnError("fopen failed");
-		curl_easy_cleanup(Curl);
 		return;
 	}
 
-	bool bOk = SetOpt(Curl, CURLOPT_URL, Url.c_str()) && SetOpt(Curl, CURLOPT_WRITEFUNCTION, WriteFileCallback)
-		&& SetOpt(Curl, CURLOPT_WRITEDATA, File)
+	auto const bOk = DownloadStream(
+		Url,
+		[File](char const* Data, std::size_t Size) { return std::fwrite(Data, 1, Size, File) == Size; },
+		std::move(OnProgress), OnError);
+	std::fclose(File);
+
+	if (!bOk)
+	{
+		std::remove(DestinationPath.string().c_str());
+	}
+}
+
+bool WLibCurl::DownloadStream(std::string const& Url, std::function<bool(char const*, std::size_t)> OnData,
+	std::function<void(float)> OnProgress, std::function<void(std::string const&)> const& OnError)
+{
+	CURL* Curl = curl_easy_init();
+	if (!Curl)
+	{
+		OnError("curl_easy_init failed");
+		return false;
+	}
+
+	bool bOk = SetOpt(Curl, CURLOPT_URL, Url.c_str()) && SetOpt(Curl, CURLOPT_WRITEFUNCTION, WriteStreamCallback)
+		&& SetOpt(Curl, CURLOPT_WRITEDATA, &OnData)
 		&& SetOpt(Curl, CURLOPT_USERAGENT, "waechter/1.0 (+https://github.com/)")
 		&& SetOpt(Curl, CURLOPT_FOLLOWLOCATION, 1L) && SetOpt(Curl, CURLOPT_MAXREDIRS, 5L)
-		&& SetOpt(Curl, CURLOPT_TIMEOUT, 30L) && SetOpt(Curl, CURLOPT_CONNECTTIMEOUT, 10L);
+		&& SetOpt(Curl, CURLOPT_TIMEOUT, 30L) && SetOpt(Curl, CURLOPT_CONNECTTIMEOUT, 10L)
+		&& SetOpt(Curl, CURLOPT_FAILONERROR, 1L);
 
 	if (bOk && OnProgress)
 	{
@@ -182,22 +199,19 @@ void WLibCurl::DownloadFile(std::string const& Url, std::filesystem::path const&
 	if (!bOk)
 	{
 		OnError("curl_easy_setopt failed");
-		std::fclose(File);
-		std::remove(DestinationPath.string().c_str());
 		curl_easy_cleanup(Curl);
-		return;
+		return false;
 	}
 
 	CURLcode ReturnCode = curl_easy_perform(Curl);
-	std::fclose(File);
 
 	long HttpCode = 0;
 	GetHttpResponseCode(Curl, HttpCode);
 
-	if (ReturnCode != CURLE_OK)
+	bool bSuccess = false;
+	if (ReturnCode != CURLE_OK && HttpCode < 400)
 	{
 		OnError(curl_easy_strerror(ReturnCode));
-		std::remove(DestinationPath.string().c_str());
 	}
 	else if (HttpCode != 200)
 	{
@@ -211,8 +225,12 @@ void WLibCurl::DownloadFile(std::string const& Url, std::filesystem::path const&
 			OnError(EffectiveUrl.empty() ? fmt::format("HTTP {}", HttpCode)
 										 : fmt::format("HTTP {} ({})", HttpCode, EffectiveUrl));
 		}
-		std::remove(DestinationPath.string().c_str());
+	}
+	else
+	{
+		bSuccess = true;
 	}
 
 	curl_easy_cleanup(Curl);
+	return bSuccess;
 }
@@ -25,4 +25,9 @@ public:
 
 	static void DownloadFile(std::string const& Url, std::filesystem::path const& DestinationPath,
 		std::function<void(float)> OnProgress, std::function<void(std::string const&)> const& OnError);
+
+	// Passes the response body to OnData as it arrives, returning false from OnData aborts the transfer.
+	// Returns true if the whole body was received with HTTP 200
+	static bool DownloadStream(std::string const& Url, std::function<bool(char const*, std::size_t)> OnData,
+		std::function<void(float)> OnProgress, std::function<void(std::string const&)> const& OnError);
 };
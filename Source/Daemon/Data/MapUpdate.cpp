@@ -14,8 +14,8 @@
 bool WMapUpdate::TrackUpdates()
 {
 	// When there are no clients there is no point in tracking updates
-	// as the first client that connects gets the entire tree sent anyway
-	if (auto const Sock = WDaemon::GetInstance().GetDaemonSocket(); Sock && Sock->HasClients())
+	// as the first client that connects gets the entire tree sent anyway, unless it resumes an earlier session
+	if (auto const Sock = WDaemon::GetInstance().GetDaemonSocket(); Sock && Sock->IsTrackingUpdates())
 	{
 		return true;
 	}
@@ -60,6 +60,7 @@ WTrafficTreeUpdates const& WMapUpdate::GetUpdates()
 	Updates.RemovedItems = RemovedItems;
 	Updates.MarkedForRemovalItems = MarkedForRemovalItems;
 	Updates.SocketStateChange = SocketStateChanges;
+	Updates.AddedCgroups = AddedCgroups;
 
 	if (SM.TrafficCounter.IsActive())
 	{
@@ -68,6 +69,7 @@ WTrafficTreeUpdates const& WMapUpdate::GetUpdates()
 
 	FetchActiveCounters(SM.Applications, Updates.UpdatedItems);
 	FetchActiveCounters(SM.Processes, Updates.UpdatedItems);
+	FetchActiveCounters(SM.Cgroups, Updates.UpdatedItems);
 
 	for (auto const& Filter : SM.FilterCounters)
 	{
@@ -98,46 +100,47 @@ WTrafficTreeUpdates const& WMapUpdate::GetUpdates()
 		}
 	}
 
-	for (auto const& Socket : AddedSockets)
+	auto const& Slab = WCounterSlab::GetInstance();
+	for (auto const SocketId : AddedSockets)
 	{
-		if (Socket->GetState() == CS_PendingRemoval)
+		// No point in sending additions for sockets that are gone or being removed
+		auto const Socket = Slab.GetItem<WSocketItem>(SocketId);
+		if (!Socket || Slab.GetState(SocketId) == CS_PendingRemoval)
 		{
-			// No point in sending additions for sockets that are being removed
 			continue;
 		}
 
-		WTrafficTreeSocketAddition Addition{};
-
-		auto const PPTI = Socket->ParentProcess->TrafficItem;
-		auto const PATI = Socket->ParentProcess->ParentApp->TrafficItem;
+		auto const ProcessId = Slab.GetParent(SocketId);
+		auto const PPTI = Slab.GetItem<WProcessItem>(ProcessId);
+		auto const PATI = Slab.GetItem<WApplicationItem>(Slab.GetParent(ProcessId));
+		if (!PPTI || !PATI)
+		{
+			continue;
+		}
 
-		Addition.ItemId = Socket->TrafficItem->ItemId;
+		WTrafficTreeSocketAddition Addition{};
+		Addition.ItemId = SocketId;
 		Addition.ProcessItemId = PPTI->ItemId;
 		Addition.ApplicationItemId = PATI->ItemId;
 		Addition.ProcessId = PPTI->ProcessId;
 		Addition.ApplicationPath = PATI->ApplicationPath;
 		Addition.ApplicationName = PATI->ApplicationName;
 		Addition.ApplicationCommandLine = PATI->ApplicationCommandLine;
-		Addition.SocketTuple = Socket->TrafficItem->SocketTuple;
-		Addition.ConnectionState = Socket->TrafficItem->ConnectionState;
-		Addition.SocketType = Socket->TrafficItem->SocketType;
-		Addition.SocketCookie = Socket->TrafficItem->Cookie;
+		Addition.SocketTuple = Socket->SocketTuple;
+		Addition.ConnectionState = Socket->ConnectionState;
+		Addition.SocketType = Socket->SocketType;
+		Addition.SocketCookie = Socket->Cookie;
 		Updates.AddedSockets.emplace_back(Addition);
 	}
 
-	for (auto const& TupleCounter : AddedTuples)
+	for (auto const& Addition : AddedTuples)
 	{
-		if (TupleCounter.second->ParentSocket->GetState() == CS_PendingRemoval)
+		if (!Slab.IsValid(Addition.SocketItemId) || Slab.GetState(Addition.SocketItemId) == CS_PendingRemoval)
 		{
-			// No point in sending additions for tuples whose parent socket is being removed
+			// No point in sending additions for tuples whose parent socket is gone or being removed
 			continue;
 		}
-
-		WTrafficTreeTupleAddition Addition{};
-
-		Addition.ItemId = TupleCounter.second->TrafficItem->ItemId;
-		Addition.SocketItemId = TupleCounter.second->ParentSocket->TrafficItem->ItemId;
-		Addition.Endpoint = TupleCounter.first;
+		Updates.AddedTuples.emplace_back(Addition);
 	}
 
 	Clear();
@@ -156,10 +159,12 @@ WMemoryStat WMapUpdate::GetMemoryUsage()
 		WMemoryStatEntry{ .Name = "RemovedItems", .Usage = sizeof(WTrafficItemId) * RemovedItems.capacity() });
 	Stats.ChildEntries.emplace_back(WMemoryStatEntry{
 		.Name = "SocketStateChanges", .Usage = sizeof(WTrafficTreeSocketStateChange) * SocketStateChanges.capacity() });
+	Stats.ChildEntries.emplace_back(
+		WMemoryStatEntry{ .Name = "AddedSockets", .Usage = sizeof(WTrafficItemId) * AddedSockets.capacity() });
+	Stats.ChildEntries.emplace_back(WMemoryStatEntry{
+		.Name = "AddedTuples", .Usage = sizeof(WTrafficTreeTupleAddition) * AddedTuples.capacity() });
 	Stats.ChildEntries.emplace_back(WMemoryStatEntry{
-		.Name = "AddedSockets", .Usage = sizeof(std::shared_ptr<WSocketCounter>) * AddedSockets.capacity() });
-	Stats.ChildEntries.emplace_back(WMemoryStatEntry{ .Name = "AddedTuples",
-		.Usage = sizeof(std::pair<WEndpoint, std::shared_ptr<WTupleCounter>>) * AddedTuples.capacity() });
+		.Name = "AddedCgroups", .Usage = sizeof(WTrafficTreeCgroupAddition) * AddedCgroups.capacity() });
 
 	Stats.ChildEntries.emplace_back(WMemoryStatEntry{
 		.Name = "Updates.UpdatedItems", .Usage = sizeof(WTrafficTreeTrafficUpdate) * Updates.UpdatedItems.capacity() });
@@ -14,11 +14,12 @@
 
 class WMapUpdate : public IMemoryTrackable
 {
-	std::vector<WTrafficItemId>                                       MarkedForRemovalItems{};
-	std::vector<WTrafficItemId>                                       RemovedItems{};
-	std::vector<WTrafficTreeSocketStateChange>                        SocketStateChanges{};
-	std::vector<std::shared_ptr<WSocketCounter>>                      AddedSockets{};
-	std::vector<std::pair<WEndpoint, std::shared_ptr<WTupleCounter>>> AddedTuples{};
+	std::vector<WTrafficItemId>                MarkedForRemovalItems{};
+	std::vector<WTrafficItemId>                RemovedItems{};
+	std::vector<WTrafficTreeSocketStateChange> SocketStateChanges{};
+	std::vector<WTrafficItemId>                AddedSockets{}; // resolved through the counter slab when sent
+	std::vector<WTrafficTreeTupleAddition>     AddedTuples{};
+	std::vector<WTrafficTreeCgroupAddition>    AddedCgroups{};
 
 	std::mutex Mutex;
 
@@ -31,12 +32,14 @@ class WMapUpdate : public IMemoryTrackable
 		SocketStateChanges.clear();
 		AddedSockets.clear();
 		AddedTuples.clear();
+		AddedCgroups.clear();
 
 		MarkedForRemovalItems.shrink_to_fit();
 		RemovedItems.shrink_to_fit();
 		SocketStateChanges.shrink_to_fit();
 		AddedSockets.shrink_to_fit();
 		AddedTuples.shrink_to_fit();
+		AddedCgroups.shrink_to_fit();
 	}
 
 	static bool TrackUpdates();
@@ -57,29 +60,41 @@ public:
 	bool HasUpdates() const
 	{
 		return !RemovedItems.empty() || !MarkedForRemovalItems.empty() || !SocketStateChanges.empty()
-			|| !AddedSockets.empty() || !AddedTuples.empty();
+			|| !AddedSockets.empty() || !AddedTuples.empty() || !AddedCgroups.empty();
 	}
 
 	void AddStateChange(WTrafficItemId Id, ESocketConnectionState NewState, uint8_t SocketType,
 		std::shared_ptr<WSocketTuple> const& SocketTuple = nullptr);
 
-	void AddTupleAddition(WEndpoint const& Endpoint, std::shared_ptr<WTupleCounter> const& Tuple)
+	void AddTupleAddition(WEndpoint const& Endpoint, WTupleCounter const& Tuple)
 	{
 		if (!TrackUpdates())
 		{
 			return;
 		}
 		std::scoped_lock Lock(Mutex);
-		AddedTuples.emplace_back(Endpoint, Tuple);
+		AddedTuples.emplace_back(
+			WTrafficTreeTupleAddition{ .ItemId = Tuple.GetId(), .SocketItemId = Tuple.SocketId, .Endpoint = Endpoint });
 	}
 
-	void AddSocketAddition(std::shared_ptr<WSocketCounter> const& Socket)
+	void AddSocketAddition(WSocketCounter const& Socket)
 	{
 		if (!TrackUpdates())
 		{
 			return;
 		}
-		AddedSockets.emplace_back(Socket);
+		AddedSockets.emplace_back(Socket.GetId());
+	}
+
+	void AddCgroupAddition(WCgroupItem const& Cgroup)
+	{
+		if (!TrackUpdates())
+		{
+			return;
+		}
+		std::scoped_lock Lock(Mutex);
+		AddedCgroups.emplace_back(
+			WTrafficTreeCgroupAddition{ .ItemId = Cgroup.ItemId, .CgroupId = Cgroup.CgroupId, .Name = Cgroup.Name });
 	}
 
 	void AddItemRemoval(WTrafficItemId ItemId)
@@ -0,0 +1,397 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "ProcessInfoCache.hpp"
+
+#include <array>
+#include <ranges>
+#include <regex>
+#include <utility>
+
+#include "spdlog/spdlog.h"
+#include "tracy/Tracy.hpp"
+
+#include "Filesystem.hpp"
+#include "Format.hpp"
+#include "Time.hpp"
+
+namespace
+{
+std::string CanonicalizePath(stdfs::path const& Path)
+{
+	std::error_code Error;
+	auto            Canonical = stdfs::weakly_canonical(Path, Error);
+	if (!Error)
+	{
+		return Canonical.string();
+	}
+
+	return Path.lexically_normal().string();
+}
+
+bool ProcessVisiblePathExists(stdfs::path const& LogicalPath, std::string const& ProcessRoot)
+{
+	if (LogicalPath.empty())
+	{
+		return false;
+	}
+
+	std::error_code Error;
+	if (stdfs::exists(LogicalPath, Error))
+	{
+		return true;
+	}
+
+	if (!ProcessRoot.empty() && LogicalPath.is_absolute())
+	{
+		Error.clear();
+		return stdfs::exists(stdfs::path(ProcessRoot) / LogicalPath.relative_path(), Error);
+	}
+
+	return false;
+}
+
+void AddUniqueEntry(std::vector<std::string>& Entries, std::string Entry)
+{
+	Entry = WStringFormat::Trim(Entry);
+	if (Entry.empty())
+	{
+		return;
+	}
+
+	if (std::ranges::find(Entries, Entry) == Entries.end())
+	{
+		Entries.emplace_back(std::move(Entry));
+	}
+}
+
+std::vector<std::string> GetExecutableSearchPaths(WProcessId PID)
+{
+	std::vector<std::string> Paths{};
+	for (auto const& EnvVar : WFilesystem::ReadProcNulSeparated("/proc/" + std::to_string(PID) + "/environ"))
+	{
+		if (!WStringFormat::StartsWith(EnvVar, "PATH="))
+		{
+			continue;
+		}
+
+		for (auto const& PathEntry : WStringFormat::SplitString(EnvVar.substr(5), ':'))
+		{
+			AddUniqueEntry(Paths, PathEntry);
+		}
+		break;
+	}
+
+	for (auto const& PathEntry : std::array<std::string, 7>{
+			 "/usr/local/sbin", "/usr/local/bin", "/usr/sbin", "/usr/bin", "/sbin", "/bin", "/snap/bin" })
+	{
+		AddUniqueEntry(Paths, PathEntry);
+	}
+
+	return Paths;
+}
+
+std::string ResolveProcessBinaryPath(WProcessId PID, std::vector<std::string> const& Argv, std::string const& Comm)
+{
+	std::string const ProcessRoot = WFilesystem::ReadLink("/proc/" + std::to_string(PID) + "/root");
+	std::string const Cwd = WFilesystem::GetProcessCwd(PID);
+	auto const        SearchPaths = GetExecutableSearchPaths(PID);
+
+	std::vector<std::string> Candidates{};
+	if (!Argv.empty())
+	{
+		AddUniqueEntry(Candidates, Argv[0]);
+	}
+	AddUniqueEntry(Candidates, Comm);
+
+	for (auto const& RawCandidate : Candidates)
+	{
+		auto const Candidate = WProcessInfoCache::SanitizeProcessBinaryCandidate(RawCandidate);
+		if (Candidate.empty())
+		{
+			continue;
+		}
+
+		if (Candidate.front() == '/')
+		{
+			if (ProcessVisiblePathExists(Candidate, ProcessRoot))
+			{
+				return WProcessInfoCache::NormalizeAppImagePath(CanonicalizePath(Candidate));
+			}
+			continue;
+		}
+
+		if (Candidate.find('/') != std::string::npos && !Cwd.empty())
+		{
+			auto const ResolvedPath = stdfs::path(Cwd) / Candidate;
+			if (ProcessVisiblePathExists(ResolvedPath, ProcessRoot))
+			{
+				return WProcessInfoCache::NormalizeAppImagePath(CanonicalizePath(ResolvedPath));
+			}
+		}
+
+		for (auto const& SearchPath : SearchPaths)
+		{
+			stdfs::path BasePath = SearchPath;
+			if (!BasePath.is_absolute())
+			{
+				if (Cwd.empty())
+				{
+					continue;
+				}
+				BasePath = stdfs::path(Cwd) / BasePath;
+			}
+
+			auto const ResolvedPath = BasePath / Candidate;
+			if (ProcessVisiblePathExists(ResolvedPath, ProcessRoot))
+			{
+				return WProcessInfoCache::NormalizeAppImagePath(CanonicalizePath(ResolvedPath));
+			}
+		}
+	}
+
+	return {};
+}
+} // namespace
+
+std::string WProcessInfoCache::GetBasename(std::string const& Path)
+{
+	auto const Pos = Path.find_last_of('/');
+	return WStringFormat::Trim((Pos == std::string::npos) ? Path : Path.substr(Pos + 1));
+}
+
+std::string WProcessInfoCache::SanitizeProcessBinaryCandidate(std::string Value)
+{
+	Value = WStringFormat::Trim(Value);
+	if (Value.empty())
+	{
+		return {};
+	}
+
+	if (auto const SpacePos = Value.find(' '); SpacePos != std::string::npos)
+	{
+		Value = Value.substr(0, SpacePos);
+	}
+
+	Value = WStringFormat::Trim(Value);
+	while (!Value.empty() && Value.back() == ':')
+	{
+		Value.pop_back();
+	}
+
+	Value = WStringFormat::Trim(Value);
+	if (Value.empty() || Value == "main" || Value == "Main")
+	{
+		return {};
+	}
+
+	if (Value.front() == '[' && Value.back() == ']')
+	{
+		return {};
+	}
+
+	return Value;
+}
+
+
+std::string WProcessInfoCache::NormalizeAppImagePath(std::string const& Path)
+{
+	static std::regex const RE(R"(^/tmp/[^/]+/usr/bin/(.*)$)");
+	return std::regex_replace(Path, RE, "/tmp/appimage/bin/$1");
+}
+
+WProcessInfo WProcFsProcessInfoBackend::Resolve(WProcessId const PID)
+{
+	ZoneScopedN("WProcFsProcessInfoBackend::Resolve");
+
+	// Build robust process info
+	std::string              ExePath = WProcessInfoCache::NormalizeAppImagePath(WFilesystem::GetProcessExePath(PID));
+	std::vector<std::string> Argv = WFilesystem::GetProcessCmdlineArgs(PID);
+	std::string              Comm = WFilesystem::ReadProc("/proc/" + std::to_string(PID) + "/comm");
+	if (!Comm.empty() && Comm.back() == '\n')
+	{
+		Comm.pop_back();
+	}
+
+	// Fallbacks if cmdline is empty (kernel threads) or trimmed
+	if (Argv.empty())
+	{
+		if (!ExePath.empty())
+		{
+			Argv.push_back(ExePath);
+		}
+		else if (!Comm.empty())
+		{
+			Argv.push_back(Comm);
+		}
+	}
+
+	// If /proc/[pid]/exe is inaccessible (common for setproctitle()-style daemons such as nginx/php-fpm),
+	// fall back to argv[0], comm, PATH, cwd, and the process root.
+	if (ExePath.empty())
+	{
+		ExePath = ResolveProcessBinaryPath(PID, Argv, Comm);
+	}
+
+	// Reconstruct human-readable command line preserving argv boundaries with spaces
+	std::string CmdlIne;
+	for (size_t i = 0; i < Argv.size(); ++i)
+	{
+		CmdlIne += Argv[i];
+		if (i + 1 < Argv.size())
+			CmdlIne += ' ';
+	}
+
+	Comm = WStringFormat::Trim(Comm);
+
+	if ((Comm.empty() || Comm == "main" || Comm == "Main") && !ExePath.empty())
+	{
+		Comm = WProcessInfoCache::GetBasename(ExePath);
+		if (Comm.empty())
+		{
+			Comm = ExePath.empty() ? "unknown" : ExePath;
+		}
+	}
+
+	return { ExePath, CmdlIne, Comm };
+}
+
+bool WProcessInfoCache::StartExitNotifications()
+{
+	if (bKernelProcessEvents)
+	{
+		spdlog::info("Using eBPF process events for exit notifications");
+		return true;
+	}
+
+	Connector.OnProcessExit = [this](WProcessId const PID) { HandleProcessExit(PID); };
+	Connector.OnProcessExec = [this](WProcessId const PID) { HandleProcessExec(PID); };
+	Connector.OnProcessFork = [this](WProcessId const PID) { HandleProcessFork(PID); };
+	Connector.OnEventsLost = [this] { bResyncRequested = true; };
+
+	if (!Connector.Start())
+	{
+		spdlog::warn("Process exit notifications are not available, falling back to polling /proc/");
+		return false;
+	}
+	return true;
+}
+
+void WProcessInfoCache::Stop()
+{
+	Connector.Stop();
+}
+
+void WProcessInfoCache::HandleProcessExit(WProcessId const PID)
+{
+	std::scoped_lock Lock(Mutex);
+	Cache.erase(PID);
+
+	if (ExitedProcesses.size() >= MaxPendingExits)
+	{
+		// Nobody is consuming the notifications, drop them and let the next cleanup check everything
+		ExitedProcesses.clear();
+		bResyncRequested = true;
+	}
+	ExitedProcesses.push_back(PID);
+	RecentExits[PID] = WTime::GetEpochMs();
+}
+
+void WProcessInfoCache::HandleProcessExec(WProcessId const PID)
+{
+	// The process now runs a different binary, so the cached metadata is outdated. It's also clearly alive, an exit
+	// recorded for the PID belonged to an earlier process
+	std::scoped_lock Lock(Mutex);
+	Cache.erase(PID);
+	RecentExits.erase(PID);
+}
+
+void WProcessInfoCache::HandleProcessFork(WProcessId const PID)
+{
+	// The PID was reused, otherwise the new process would be marked for removal as soon as it shows up
+	std::scoped_lock Lock(Mutex);
+	Cache.erase(PID);
+	RecentExits.erase(PID);
+}
+
+bool WProcessInfoCache::TakeResyncRequest()
+{
+	auto const Now = WTime::GetEpochMs();
+	if (Now - LastFullCheck >= FullCheckInterval)
+	{
+		bResyncRequested = true;
+	}
+	if (!bResyncRequested.exchange(false))
+	{
+		return false;
+	}
+	LastFullCheck = Now;
+	return true;
+}
+
+std::shared_ptr<WProcessInfo const> WProcessInfoCache::GetProcessInfo(WProcessId const PID)
+{
+	{
+		std::scoped_lock Lock(Mutex);
+		if (auto const It = Cache.find(PID); It != Cache.end())
+		{
+			return It->second;
+		}
+	}
+
+	// Resolve without holding the lock, this can take a while
+	auto Info = std::make_shared<WProcessInfo const>(Backend->Resolve(PID));
+
+	std::scoped_lock Lock(Mutex);
+	if (!RecentExits.contains(PID))
+	{
+		Cache[PID] = Info;
+	}
+	return Info;
+}
+
+void WProcessInfoCache::Forget(WProcessId const PID)
+{
+	std::scoped_lock Lock(Mutex);
+	Cache.erase(PID);
+}
+
+std::vector<WProcessId> WProcessInfoCache::TakeExitedProcesses()
+{
+	std::scoped_lock Lock(Mutex);
+	auto const       Now = WTime::GetEpochMs();
+	std::erase_if(RecentExits, [Now](auto const& Entry) { return Now - Entry.second > RecentExitTimeout; });
+	return std::exchange(ExitedProcesses, {});
+}
+
+bool WProcessInfoCache::HasRecentlyExited(WProcessId const PID)
+{
+	std::scoped_lock Lock(Mutex);
+	return RecentExits.contains(PID);
+}
+
+WMemoryStat WProcessInfoCache::GetMemoryUsage()
+{
+	std::scoped_lock Lock(Mutex);
+	WMemoryStat      Stats{};
+	Stats.Name = "WProcessInfoCache";
+
+	WMemoryStatEntry CacheEntry{};
+	CacheEntry.Name = "Process info";
+	CacheEntry.Usage = sizeof(Cache);
+	for (auto const& Info : Cache | std::views::values)
+	{
+		CacheEntry.Usage += sizeof(WProcessId) + sizeof(std::shared_ptr<WProcessInfo const>) + sizeof(WProcessInfo);
+		CacheEntry.Usage += Info->ExePath.capacity() + Info->CommandLine.capacity() + Info->Name.capacity();
+	}
+
+	WMemoryStatEntry ExitsEntry{};
+	ExitsEntry.Name = "Exit notifications";
+	ExitsEntry.Usage = ExitedProcesses.capacity() * sizeof(WProcessId) + CALC_MAP_USAGE(RecentExits, WProcessId, WMsec);
+
+	Stats.ChildEntries.emplace_back(CacheEntry);
+	Stats.ChildEntries.emplace_back(ExitsEntry);
+	return Stats;
+}
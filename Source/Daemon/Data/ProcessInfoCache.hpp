@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MemoryStats.hpp"
+#include "Singleton.hpp"
+#include "Types.hpp"
+#include "Net/ProcConnector.hpp"
+
+struct WProcessInfo
+{
+	std::string ExePath{};
+	std::string CommandLine{};
+	std::string Name{};
+};
+
+/**
+ * Resolves the metadata of a single process, called without holding the cache lock.
+ */
+class IProcessInfoBackend
+{
+public:
+	virtual ~IProcessInfoBackend() = default;
+
+	virtual WProcessInfo Resolve(WProcessId PID) = 0;
+};
+
+class WProcFsProcessInfoBackend final : public IProcessInfoBackend
+{
+public:
+	WProcessInfo Resolve(WProcessId PID) override;
+};
+
+/**
+ * Caches the metadata of processes that own sockets, resolving it requires reading a number of files
+ * in /proc/ which shouldn't happen more than once per process or while the system map is locked.
+ *
+ * The cache also collects process exit notifications, so WSystemMap doesn't have to check every known
+ * process for whether it is still running. They come from the eBPF program if it could attach to the
+ * scheduler tracepoints, otherwise from the kernel process connector.
+ */
+class WProcessInfoCache : public TSingleton<WProcessInfoCache>, public IMemoryTrackable
+{
+	// Processes can exit before the daemon processed the events of their sockets,
+	// so exits are remembered for a while to catch processes that are mapped after they exited
+	static constexpr WMsec       RecentExitTimeout = 5000;
+	static constexpr std::size_t MaxPendingExits = 1 << 16;
+
+	// Notifications can also get lost in ways we don't notice, so every process is checked once in a while anyway
+	static constexpr WMsec FullCheckInterval = 60000;
+
+	std::mutex Mutex;
+
+	std::unordered_map<WProcessId, std::shared_ptr<WProcessInfo const>> Cache{};
+	std::vector<WProcessId>                                             ExitedProcesses{};
+	std::unordered_map<WProcessId, WMsec>                               RecentExits{};
+	std::atomic<bool>                                                   bResyncRequested{ false };
+	std::atomic<bool>                                                   bKernelProcessEvents{ false };
+	WMsec                                                               LastFullCheck{};
+
+	WProcConnector Connector{};
+
+	std::unique_ptr<IProcessInfoBackend> Backend{ std::make_unique<WProcFsProcessInfoBackend>() };
+
+public:
+	// Has to be called while the daemon still runs as root
+	bool StartExitNotifications();
+	void Stop();
+
+	// Has to be called before the first process is mapped
+	void SetBackend(std::unique_ptr<IProcessInfoBackend> NewBackend) { Backend = std::move(NewBackend); }
+
+	// The eBPF program reports process events, the process connector isn't needed
+	void UseKernelProcessEvents() { bKernelProcessEvents = true; }
+
+	[[nodiscard]] bool HasExitNotifications() const { return bKernelProcessEvents || Connector.IsRunning(); }
+
+	void HandleProcessExit(WProcessId PID);
+	void HandleProcessExec(WProcessId PID);
+	void HandleProcessFork(WProcessId PID);
+
+	std::shared_ptr<WProcessInfo const> GetProcessInfo(WProcessId PID);
+
+	void Forget(WProcessId PID);
+
+	// Processes that exited since the last call
+	std::vector<WProcessId> TakeExitedProcesses();
+
+	bool HasRecentlyExited(WProcessId PID);
+
+	// Called when process events from the kernel were lost
+	void RequestResync() { bResyncRequested = true; }
+
+	// True if exit notifications were lost and all processes have to be checked manually
+	bool TakeResyncRequest();
+
+	static std::string GetBasename(std::string const& Path);
+	static std::string SanitizeProcessBinaryCandidate(std::string Value);
+	static std::string NormalizeAppImagePath(std::string const& Path);
+
+	WMemoryStat GetMemoryUsage() override;
+};
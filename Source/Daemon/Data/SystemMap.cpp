@@ -5,405 +5,308 @@
 
 #include "SystemMap.hpp"
 
-#include <array>
+#include <algorithm>
+#include <bit>
 #include <ranges>
-#include <regex>
 #include <utility>
 
 #include "spdlog/spdlog.h"
 #include "tracy/Tracy.hpp"
 
 #include "AppIconAtlasBuilder.hpp"
+#include "DaemonConfig.hpp"
 #include "Filesystem.hpp"
 #include "Format.hpp"
 #include "IPLinkMsg.hpp"
 #include "NetworkEvents.hpp"
+#include "ProcessInfoCache.hpp"
 #include "Db/StatsManager.hpp"
 #include "Net/IPLink.hpp"
 #include "Net/PacketParser.hpp"
 
-static std::string NormalizeAppImagePaths(std::string const& path);
-
-namespace
-{
-std::string CanonicalizePath(stdfs::path const& Path)
-{
-	std::error_code Error;
-	auto            Canonical = stdfs::weakly_canonical(Path, Error);
-	if (!Error)
-	{
-		return Canonical.string();
-	}
-
-	return Path.lexically_normal().string();
-}
-
-std::string GetBasename(std::string const& Path)
+void WSystemMap::DoPacketParsing(WSocketEvent const& Event, std::shared_ptr<WSocketCounter> const& SockCounter)
 {
-	auto const Pos = Path.find_last_of('/');
-	return WStringFormat::Trim((Pos == std::string::npos) ? Path : Path.substr(Pos + 1));
-}
+	auto const Item = SockCounter->TrafficItem;
+	// if this socket doesn't already have a local/remote endpoint, try to infer from traffic
+	bool const bHaveLocalEndpoint = !Item->SocketTuple.LocalEndpoint.Address.IsZero();
+	bool const bHaveRemoteEndpoint = !Item->SocketTuple.RemoteEndpoint.Address.IsZero();
+	bool const bIsTcp = Item->SocketTuple.Protocol == EProtocol::TCP;
 
-std::string SanitizeProcessBinaryCandidate(std::string Value)
-{
-	Value = WStringFormat::Trim(Value);
-	if (Value.empty())
+	if (bHaveLocalEndpoint && bHaveRemoteEndpoint && bIsTcp)
 	{
-		return {};
+		// both endpoints are already known
+		// so in the case of TCP there's nothing to do
+		// udp has to always be parsed because it can send/receive from/to multiple endpoints
+		return;
 	}
 
-	if (auto const SpacePos = Value.find(' '); SpacePos != std::string::npos)
-	{
-		Value = Value.substr(0, SpacePos);
-	}
+	WPacketHeaderParser PacketHeader{};
 
-	Value = WStringFormat::Trim(Value);
-	while (!Value.empty() && Value.back() == ':')
+	if (!PacketHeader.ParsePacket(Event.Data.TrafficEventData.RawData, PACKET_HEADER_SIZE))
 	{
-		Value.pop_back();
+		spdlog::warn("Packet header parsing failed");
+		return;
 	}
 
-	Value = WStringFormat::Trim(Value);
-	if (Value.empty() || Value == "main" || Value == "Main")
-	{
-		return {};
-	}
+	auto const& TrafficData = Event.Data.TrafficEventData;
+	auto const  bOutgoing = TrafficData.Direction == PD_Outgoing;
+	auto const& LocalEndpoint = bOutgoing ? PacketHeader.Src : PacketHeader.Dst;
+	auto const& RemoteEndpoint = bOutgoing ? PacketHeader.Dst : PacketHeader.Src;
+	UpdateSocketTuple(*SockCounter, PacketHeader.L4Proto, LocalEndpoint, RemoteEndpoint);
 
-	if (Value.front() == '[' && Value.back() == ']')
+	// Add a new UDP per-connection tuple if the remote endpoint is different from the socket's main one
+	if (Item->SocketTuple.Protocol == EProtocol::UDP && !RemoteEndpoint.Address.IsZero())
 	{
-		return {};
+		PushTupleTraffic(SockCounter, RemoteEndpoint, TrafficData.Direction, TrafficData.Bytes);
 	}
-
-	return Value;
 }
 
-bool ProcessVisiblePathExists(stdfs::path const& LogicalPath, std::string const& ProcessRoot)
+void WSystemMap::UpdateSocketTuple(WSocketCounter& SockCounter, EProtocol::Type const Protocol,
+	WEndpoint const& LocalEndpoint, WEndpoint const& RemoteEndpoint)
 {
-	if (LogicalPath.empty())
+	auto const Item = SockCounter.TrafficItem;
+	bool const bHaveLocalEndpoint = !Item->SocketTuple.LocalEndpoint.Address.IsZero();
+	bool const bHaveRemoteEndpoint = !Item->SocketTuple.RemoteEndpoint.Address.IsZero();
+	bool       bItemModified = false;
+	Item->SocketTuple.Protocol = Protocol;
+
+	if (!bHaveLocalEndpoint)
 	{
-		return false;
+		if (Item->SocketTuple.LocalEndpoint != LocalEndpoint)
+		{
+			bItemModified = true;
+		}
+		Item->SocketTuple.LocalEndpoint = LocalEndpoint;
 	}
 
-	std::error_code Error;
-	if (stdfs::exists(LogicalPath, Error))
+	// Don't assign a remote endpoint to UDP sockets, the only time we do that
+	// is if they explicitly connect() to an address
+	if (!bHaveRemoteEndpoint && Item->SocketTuple.Protocol != EProtocol::UDP)
 	{
-		return true;
+		if (Item->SocketTuple.RemoteEndpoint != RemoteEndpoint)
+		{
+			bItemModified = true;
+		}
+		Item->SocketTuple.RemoteEndpoint = RemoteEndpoint;
 	}
 
-	if (!ProcessRoot.empty() && LogicalPath.is_absolute())
+	if (Item->SocketType == ESocketType::Unknown)
 	{
-		Error.clear();
-		return stdfs::exists(stdfs::path(ProcessRoot) / LogicalPath.relative_path(), Error);
+		if (Item->SocketTuple.Protocol == EProtocol::ICMP || Item->SocketTuple.Protocol == EProtocol::ICMPv6)
+		{
+			if (Item->SocketType != ESocketType::Connect)
+			{
+				bItemModified = true;
+			}
+			Item->SocketType = ESocketType::Connect;
+		}
+		else
+		{
+			ZoneScopedN("DetermineSocketType");
+			auto const DeterminedType = SocketStateParser.DetermineSocketType(
+				Item->SocketTuple.LocalEndpoint, Item->SocketTuple.Protocol, &RemoteEndpoint);
+
+			if (Item->SocketType != DeterminedType)
+			{
+				bItemModified = true;
+			}
+
+			Item->SocketType = DeterminedType;
+		}
 	}
 
-	return false;
+	if (bItemModified)
+	{
+		MapUpdate.AddStateChange(Item->ItemId, Item->ConnectionState, Item->SocketType,
+			std::make_shared<WSocketTuple>(Item->SocketTuple));
+	}
 }
 
-void AddUniqueEntry(std::vector<std::string>& Entries, std::string Entry)
+void WSystemMap::PushTupleTraffic(std::shared_ptr<WSocketCounter> const& SockCounter, WEndpoint const& RemoteEndpoint,
+	uint8_t const Direction, WBytes const Bytes)
 {
-	Entry = WStringFormat::Trim(Entry);
-	if (Entry.empty())
+	auto const TupleCounter = GetOrCreateUDPTupleCounter(SockCounter, RemoteEndpoint);
+	if (Direction == PD_Outgoing)
 	{
-		return;
+		ZoneScopedN("PushOutgoingTraffic");
+		TupleCounter->PushOutgoingTraffic(Bytes);
 	}
-
-	if (std::ranges::find(Entries, Entry) == Entries.end())
+	else
 	{
-		Entries.emplace_back(std::move(Entry));
+		ZoneScopedN("PushIncomingTraffic");
+		TupleCounter->PushIncomingTraffic(Bytes);
 	}
+	// The remote endpoint of the other peers tuple is different for every packet
+	auto const& SocketTuple = SockCounter->TrafficItem->SocketTuple;
+	auto const  FilterMask = TupleCounter->IsOtherPeers()
+		 ? FilterEngine.Classify(SocketTuple.LocalEndpoint, RemoteEndpoint, SocketTuple.Protocol)
+		 : GetTupleFilterMask(*TupleCounter);
+	PushFilterTraffic(FilterMask, Direction, Bytes);
 }
 
-std::vector<std::string> GetExecutableSearchPaths(WProcessId PID)
+std::shared_ptr<WTupleCounter> WSystemMap::CreateUDPTupleCounter(
+	std::shared_ptr<WSocketCounter> const& SockCounter, WEndpoint const& Endpoint)
 {
-	std::vector<std::string> Paths{};
-	for (auto const& EnvVar : WFilesystem::ReadProcNulSeparated("/proc/" + std::to_string(PID) + "/environ"))
-	{
-		if (!WStringFormat::StartsWith(EnvVar, "PATH="))
-		{
-			continue;
-		}
+	auto NewItem = std::make_shared<WTupleItem>();
+	NewItem->Endpoint = Endpoint;
+	SockCounter->TrafficItem->UDPPerConnectionTraffic.emplace_back(NewItem);
 
-		for (auto const& PathEntry : WStringFormat::SplitString(EnvVar.substr(5), ':'))
-		{
-			AddUniqueEntry(Paths, PathEntry);
-		}
-		break;
-	}
+	auto TupleCounter = std::make_shared<WTupleCounter>(NewItem, *SockCounter);
+	SockCounter->UDPPerConnectionCounters[Endpoint] = TupleCounter;
+	MapUpdate.AddTupleAddition(Endpoint, *TupleCounter);
+	return TupleCounter;
+}
 
-	for (auto const& PathEntry : std::array<std::string, 7>{
-			 "/usr/local/sbin", "/usr/local/bin", "/usr/sbin", "/usr/bin", "/sbin", "/bin", "/snap/bin" })
+std::shared_ptr<WTupleCounter> WSystemMap::GetOtherPeersCounter(std::shared_ptr<WSocketCounter> const& SockCounter)
+{
+	if (auto const It = SockCounter->UDPPerConnectionCounters.find(WEndpoint{});
+		It != SockCounter->UDPPerConnectionCounters.end())
 	{
-		AddUniqueEntry(Paths, PathEntry);
+		return It->second;
 	}
-
-	return Paths;
+	spdlog::debug("UDP socket {} reached the peer limit", SockCounter->TrafficItem->SocketTuple.ToString());
+	return CreateUDPTupleCounter(SockCounter, WEndpoint{});
 }
 
-std::string ResolveProcessBinaryPath(WProcessId PID, std::vector<std::string> const& Argv, std::string const& Comm)
+void WSystemMap::EvictPeer(std::shared_ptr<WSocketCounter> const& SockCounter,
+	WSocketCounter::WPeerIterator const It, std::shared_ptr<WTupleCounter> const& OtherPeers)
 {
-	std::string const ProcessRoot = WFilesystem::ReadLink("/proc/" + std::to_string(PID) + "/root");
-	std::string const Cwd = WFilesystem::GetProcessCwd(PID);
-	auto const        SearchPaths = GetExecutableSearchPaths(PID);
+	auto const& Evicted = It->second;
+	OtherPeers->TrafficItem->TotalDownloadBytes += Evicted->TrafficItem->TotalDownloadBytes;
+	OtherPeers->TrafficItem->TotalUploadBytes += Evicted->TrafficItem->TotalUploadBytes;
+	OtherPeers->PushIncomingTraffic(Evicted->GetRecentDownload());
+	OtherPeers->PushOutgoingTraffic(Evicted->GetRecentUpload());
+
+	WNetworkEvents::GetInstance().OnUDPTupleRemoved(Evicted);
+	MapUpdate.AddItemRemoval(Evicted->TrafficItem->ItemId);
+	SockCounter->TrafficItem->EraseTuple(It->first);
+	SockCounter->ErasePeer(It);
+}
 
-	std::vector<std::string> Candidates{};
-	if (!Argv.empty())
+std::shared_ptr<WTupleCounter> WSystemMap::GetOrCreateUDPTupleCounter(
+	std::shared_ptr<WSocketCounter> const& SockCounter, WEndpoint const& Endpoint)
+{
+	auto& Peers = SockCounter->UDPPerConnectionCounters;
+	auto& PeerLru = SockCounter->PeerLru;
+	if (auto const It = Peers.find(Endpoint); It != Peers.end())
 	{
-		AddUniqueEntry(Candidates, Argv[0]);
+		PeerLru.splice(PeerLru.begin(), PeerLru, It->second->LruPosition);
+		return It->second;
 	}
-	AddUniqueEntry(Candidates, Comm);
 
-	for (auto const& RawCandidate : Candidates)
+	if (PeerLru.size() >= static_cast<std::size_t>(WDaemonConfig::GetInstance().UdpPeerLimit))
 	{
-		auto const Candidate = SanitizeProcessBinaryCandidate(RawCandidate);
-		if (Candidate.empty())
-		{
-			continue;
-		}
-
-		if (Candidate.front() == '/')
+		// Only peers that were idle for a while make room, otherwise a socket talking to
+		// lots of peers at once would replace its tuples on every packet
+		if (Peers.find(PeerLru.back())->second->GetInactiveCounter() == 0)
 		{
-			if (ProcessVisiblePathExists(Candidate, ProcessRoot))
-			{
-				return NormalizeAppImagePaths(CanonicalizePath(Candidate));
-			}
-			continue;
-		}
-
-		if (Candidate.find('/') != std::string::npos && !Cwd.empty())
-		{
-			auto const ResolvedPath = stdfs::path(Cwd) / Candidate;
-			if (ProcessVisiblePathExists(ResolvedPath, ProcessRoot))
-			{
-				return NormalizeAppImagePaths(CanonicalizePath(ResolvedPath));
-			}
-		}
-
-		for (auto const& SearchPath : SearchPaths)
-		{
-			stdfs::path BasePath = SearchPath;
-			if (!BasePath.is_absolute())
-			{
-				if (Cwd.empty())
-				{
-					continue;
-				}
-				BasePath = stdfs::path(Cwd) / BasePath;
-			}
-
-			auto const ResolvedPath = BasePath / Candidate;
-			if (ProcessVisiblePathExists(ResolvedPath, ProcessRoot))
-			{
-				return NormalizeAppImagePaths(CanonicalizePath(ResolvedPath));
-			}
+			return GetOtherPeersCounter(SockCounter);
 		}
+		// Creating the other peers tuple invalidates iterators into Peers
+		auto const OtherPeers = GetOtherPeersCounter(SockCounter);
+		EvictPeer(SockCounter, Peers.find(PeerLru.back()), OtherPeers);
 	}
 
-	return {};
+	auto const TupleCounter = CreateUDPTupleCounter(SockCounter, Endpoint);
+	PeerLru.push_front(Endpoint);
+	TupleCounter->LruPosition = PeerLru.begin();
+	WNetworkEvents::GetInstance().OnUDPTupleCreated(TupleCounter);
+	return TupleCounter;
 }
-} // namespace
 
-void WSystemMap::DoPacketParsing(WSocketEvent const& Event, std::shared_ptr<WSocketCounter> const& SockCounter)
+WPeerPage WSystemMap::GetPeerPage(WPeerPageRequest const& Request)
 {
-	auto const Item = SockCounter->TrafficItem;
-	// if this socket doesn't already have a local/remote endpoint, try to infer from traffic
-	bool const bHaveLocalEndpoint = !Item->SocketTuple.LocalEndpoint.Address.IsZero();
-	bool const bHaveRemoteEndpoint = !Item->SocketTuple.RemoteEndpoint.Address.IsZero();
-	bool const bIsTcp = Item->SocketTuple.Protocol == EProtocol::TCP;
+	std::scoped_lock Lock(DataMutex);
+	WPeerPage        Page{};
+	Page.SocketItemId = Request.SocketItemId;
+	Page.Offset = Request.Offset;
 
-	if (bHaveLocalEndpoint && bHaveRemoteEndpoint && bIsTcp)
+	auto const SocketItem = WCounterSlab::GetInstance().GetItem<WSocketItem>(Request.SocketItemId);
+	if (!SocketItem)
 	{
-		// both endpoints are already known
-		// so in the case of TCP there's nothing to do
-		// udp has to always be parsed because it can send/receive from/to multiple endpoints
-		return;
+		return Page;
 	}
 
-	WPacketHeaderParser PacketHeader{};
-
-	if (PacketHeader.ParsePacket(Event.Data.TrafficEventData.RawData, PACKET_HEADER_SIZE))
+	auto const& Peers = SocketItem->UDPPerConnectionTraffic;
+	auto const  Begin = std::min<std::size_t>(Request.Offset, Peers.size());
+	auto const  End = std::min<std::size_t>(Begin + std::min(Request.Count, WPeerPageRequest::MaxCount), Peers.size());
+	Page.PeerCount = static_cast<uint32_t>(Peers.size());
+	Page.Peers.reserve(End - Begin);
+	for (auto i = Begin; i < End; ++i)
 	{
-		bool bItemModified = false;
-		Item->SocketTuple.Protocol = PacketHeader.L4Proto;
-		WEndpoint LocalEndpoint;
-		WEndpoint RemoteEndpoint;
-
-		if (Event.Data.TrafficEventData.Direction == PD_Outgoing)
-		{
-			LocalEndpoint = PacketHeader.Src;
-			RemoteEndpoint = PacketHeader.Dst;
-		}
-		else
-		{
-			LocalEndpoint = PacketHeader.Dst;
-			RemoteEndpoint = PacketHeader.Src;
-		}
-
-		if (!bHaveLocalEndpoint)
-		{
-			if (Item->SocketTuple.LocalEndpoint != LocalEndpoint)
-			{
-				bItemModified = true;
-			}
-			Item->SocketTuple.LocalEndpoint = LocalEndpoint;
-		}
-
-		// Don't assign a remote endpoint to UDP sockets, the only time we do that
-		// is if they explicitly connect() to an address
-		if (!bHaveRemoteEndpoint && Item->SocketTuple.Protocol != EProtocol::UDP)
-		{
-			if (Item->SocketTuple.RemoteEndpoint != RemoteEndpoint)
-			{
-				bItemModified = true;
-			}
-			Item->SocketTuple.RemoteEndpoint = RemoteEndpoint;
-		}
-
-		if (Item->SocketType == ESocketType::Unknown)
-		{
-			if (Item->SocketTuple.Protocol == EProtocol::ICMP || Item->SocketTuple.Protocol == EProtocol::ICMPv6)
-			{
-				if (Item->SocketType != ESocketType::Connect)
-				{
-					bItemModified = true;
-				}
-				Item->SocketType = ESocketType::Connect;
-			}
-			else
-			{
-				ZoneScopedN("DetermineSocketType");
-				auto const DeterminedType = SocketStateParser.DetermineSocketType(
-					Item->SocketTuple.LocalEndpoint, Item->SocketTuple.Protocol, &RemoteEndpoint);
-
-				if (Item->SocketType != DeterminedType)
-				{
-					bItemModified = true;
-				}
-
-				Item->SocketType = DeterminedType;
-			}
-		}
-
-		if (Item->SocketTuple.Protocol == EProtocol::UDP)
-		{
-			// Add a new UDP per-connection tuple if the remote endpoint is different from the socket's main one
-			if (!RemoteEndpoint.Address.IsZero())
-			{
-				bool const bTupleExists = Item->HaveUDPTuple(RemoteEndpoint);
-				auto const TupleCounter = GetOrCreateUDPTupleCounter(SockCounter, RemoteEndpoint);
-				if (Event.Data.TrafficEventData.Direction == PD_Outgoing)
-				{
-					ZoneScopedN("PushOutgoingTraffic");
-					TupleCounter->PushOutgoingTraffic(Event.Data.TrafficEventData.Bytes);
-
-					for (auto const& Filter : FilterCounters)
-					{
-						if (Filter->FilterFunction(TupleCounter->TrafficItem->ItemId, &LocalEndpoint, &RemoteEndpoint))
-						{
-							Filter->PushOutgoingTraffic(Event.Data.TrafficEventData.Bytes);
-						}
-					}
-				}
-				else
-				{
-					ZoneScopedN("PushIncomingTraffic");
-					TupleCounter->PushIncomingTraffic(Event.Data.TrafficEventData.Bytes);
-
-					for (auto const& Filter : FilterCounters)
-					{
-						if (Filter->FilterFunction(TupleCounter->TrafficItem->ItemId, &LocalEndpoint, &RemoteEndpoint))
-						{
-							Filter->PushIncomingTraffic(Event.Data.TrafficEventData.Bytes);
-						}
-					}
-				}
+		Page.Peers.emplace_back(*Peers[i]);
+	}
+	return Page;
+}
 
-				if (!bTupleExists)
-				{
-					MapUpdate.AddTupleAddition(RemoteEndpoint, TupleCounter);
-				}
-			}
-		}
-		if (bItemModified)
+void WSystemMap::RegisterFilters()
+{
+	auto Definitions = WFilterEngine::GetDefaultFilters();
+	for (auto const& FilterConfig : WDaemonConfig::GetInstance().Filters)
+	{
+		if (auto Definition = WFilterEngine::ParseDefinition(FilterConfig))
 		{
-			MapUpdate.AddStateChange(Item->ItemId, Item->ConnectionState, Item->SocketType,
-				std::make_shared<WSocketTuple>(Item->SocketTuple));
+			Definitions.emplace_back(std::move(*Definition));
 		}
 	}
-	else
+
+	FilterEngine.Compile(Definitions);
+	for (auto const& Definition : FilterEngine.GetFilters())
 	{
-		spdlog::warn("Packet header parsing failed");
+		auto FilterItem = std::make_shared<WFilterItem>();
+		FilterItem->Name = Definition.Name;
+		SystemItem->Filters.emplace_back(FilterItem);
+		FilterCounters.emplace_back(std::make_unique<WFilterCounter>(FilterItem));
 	}
+	spdlog::info("Registered {} traffic filters", FilterCounters.size());
 }
 
-std::shared_ptr<WTupleCounter> WSystemMap::GetOrCreateUDPTupleCounter(
-	std::shared_ptr<WSocketCounter> const& SockCounter, WEndpoint const& Endpoint)
+WFilterMask WSystemMap::GetSocketFilterMask(WSocketCounter& Socket) const
 {
-	auto const Item = SockCounter->TrafficItem;
-	if (auto const It = SockCounter->UDPPerConnectionCounters.find(Endpoint);
-		It != SockCounter->UDPPerConnectionCounters.end())
+	auto const& Tuple = Socket.TrafficItem->SocketTuple;
+	if (Socket.FilterGeneration != FilterEngine.GetGeneration() || !(Socket.ClassifiedTuple == Tuple))
 	{
-		return It->second;
+		ZoneScopedN("ClassifySocket");
+		Socket.FilterMask = FilterEngine.Classify(Tuple.LocalEndpoint, Tuple.RemoteEndpoint, Tuple.Protocol);
+		Socket.ClassifiedTuple = Tuple;
+		Socket.FilterGeneration = FilterEngine.GetGeneration();
 	}
-
-	auto NewItem = std::make_shared<WTupleItem>();
-	NewItem->ItemId = GetNextItemId();
-	NewItem->Endpoint = Endpoint;
-	Item->UDPPerConnectionTraffic.emplace_back(NewItem);
-	TrafficItems[NewItem->ItemId] = NewItem;
-
-	auto TupleCounter = std::make_shared<WTupleCounter>(NewItem, SockCounter);
-	SockCounter->UDPPerConnectionCounters[Endpoint] = TupleCounter;
-	WNetworkEvents::GetInstance().OnUDPTupleCreated(TupleCounter);
-	return TupleCounter;
+	return Socket.FilterMask;
 }
 
-void WSystemMap::RegisterDefaultFilters()
+WFilterMask WSystemMap::GetTupleFilterMask(WTupleCounter& Tuple) const
 {
-	auto AddFilter = [this](std::string const&                                                          Name,
-						 std::function<bool(WTrafficItemId const&, WEndpoint const*, WEndpoint const*)> Func) {
-		auto FilterItem = std::make_shared<WFilterItem>();
-		FilterItem->Name = Name;
-		FilterItem->ItemId = GetNextItemId();
-		auto FilterCounter = new WFilterCounter(FilterItem);
-		FilterCounter->FilterFunction = std::move(Func);
-		SystemItem->Filters.emplace_back(FilterItem);
-		FilterCounters.emplace_back(FilterCounter);
-	};
-
-	// idk if the checks for the local endpoint make sense here...
-	AddFilter("Internet", [](WTrafficItemId const&, WEndpoint const* Local, WEndpoint const* Remote) {
-		if (Remote)
-		{
-			return Remote->Address.IsInternetAddress();
-		}
-		if (Local)
-		{
-			return Local->Address.IsInternetAddress();
-		}
-		return false;
-	});
-	AddFilter("LAN", [](WTrafficItemId const&, WEndpoint const* Local, WEndpoint const* Remote) {
-		if (Remote)
-		{
-			return Remote->Address.IsLANAddress();
-		}
-		if (Local)
+	// The remote endpoint of a tuple never changes, so it only has to be classified once
+	if (Tuple.FilterGeneration != FilterEngine.GetGeneration())
+	{
+		ZoneScopedN("ClassifyTuple");
+		auto const SocketItem = Tuple.GetSocketItem();
+		if (!SocketItem)
 		{
-			return Local->Address.IsLANAddress();
+			return 0;
 		}
-		return false;
-	});
-	AddFilter("Localhost", [](WTrafficItemId const&, WEndpoint const* Local, WEndpoint const* Remote) {
-		if (Remote)
+		auto const& SocketTuple = SocketItem->SocketTuple;
+		Tuple.FilterMask =
+			FilterEngine.Classify(SocketTuple.LocalEndpoint, Tuple.TrafficItem->Endpoint, SocketTuple.Protocol);
+		Tuple.FilterGeneration = FilterEngine.GetGeneration();
+	}
+	return Tuple.FilterMask;
+}
+
+void WSystemMap::PushFilterTraffic(WFilterMask Mask, uint8_t const Direction, WBytes const Bytes) const
+{
+	for (; Mask != 0; Mask &= Mask - 1)
+	{
+		auto const& Filter = FilterCounters[static_cast<std::size_t>(std::countr_zero(Mask))];
+		if (Direction == PD_Incoming)
 		{
-			return Remote->Address.IsLocalhost();
+			Filter->PushIncomingTraffic(Bytes);
 		}
-		if (Local)
+		else
 		{
-			return Local->Address.IsLocalhost();
+			Filter->PushOutgoingTraffic(Bytes);
 		}
-		return false;
-	});
+	}
 }
 
 void WSystemMap::AddExistingSockets()
@@ -440,9 +343,13 @@ void WSystemMap::AddExistingSockets()
 		Socket->TrafficItem->SocketTuple.Protocol = Protocol;
 		Socket->TrafficItem->SocketType = ESocketType::Listen;
 		Socket->TrafficItem->ConnectionState = ESocketConnectionState::Connected;
+		{
+			std::scoped_lock Lock(DataMutex);
+			IndexSocketPort(*Socket);
+		}
 
 		spdlog::debug("Added existing listen socket: {} {} (PID {}, app '{}')", EProtocol::ToString(Protocol),
-			LocalEndpoint.ToString(), PID, Socket->ParentProcess->ParentApp->TrafficItem->ApplicationName);
+			LocalEndpoint.ToString(), PID, Socket->GetAppItem()->ApplicationName);
 	}
 
 	spdlog::info("Added {} existing listen sockets.", ListeningSockets.size());
@@ -459,6 +366,116 @@ void WSystemMap::ProcessInitialApps()
 	{
 		WNetworkEvents::GetInstance().OnAppFirstTimeConnected(App);
 	}
+
+	if (!bRestoredFromSnapshot)
+	{
+		return;
+	}
+
+	// Restored connections are announced like new ones, so their rules apply again and they're part of the history
+	for (auto const& Socket : Sockets | std::views::values)
+	{
+		if (Socket->TrafficItem->ConnectionState == ESocketConnectionState::Connected)
+		{
+			WNetworkEvents::GetInstance().OnSocketConnected(Socket.get());
+		}
+		for (auto const& Tuple : Socket->UDPPerConnectionCounters | std::views::values)
+		{
+			if (!Tuple->IsOtherPeers())
+			{
+				WNetworkEvents::GetInstance().OnUDPTupleCreated(Tuple);
+			}
+		}
+	}
+}
+
+WSystemMapSnapshot WSystemMap::CreateSnapshot()
+{
+	WSystemMapSnapshot Snapshot{};
+	Snapshot.SystemItem = SystemItem;
+	Snapshot.ForkedChildren = ForkedChildren;
+	Snapshot.ForkParents = ForkParents;
+	return Snapshot;
+}
+
+void WSystemMap::RestoreSnapshot(WSystemMapSnapshot const& Snapshot)
+{
+	ZoneScopedN("WSystemMap::RestoreSnapshot");
+	std::scoped_lock Lock(DataMutex);
+	auto const&      Saved = *Snapshot.SystemItem;
+	SystemItem->TotalDownloadBytes = Saved.TotalDownloadBytes;
+	SystemItem->TotalUploadBytes = Saved.TotalUploadBytes;
+
+	// The filters come from the config, which might have changed since. The ones that are still there keep
+	// their traffic. Like every restored item they get a new id, the old ones belong to slots of the previous run
+	for (auto const& Filter : SystemItem->Filters)
+	{
+		auto const It = std::ranges::find_if(
+			Saved.Filters, [&](auto const& SavedFilter) { return SavedFilter->Name == Filter->Name; });
+		if (It == Saved.Filters.end())
+		{
+			continue;
+		}
+		Filter->TotalDownloadBytes = (*It)->TotalDownloadBytes;
+		Filter->TotalUploadBytes = (*It)->TotalUploadBytes;
+	}
+
+	for (auto const& [Key, AppItem] : Saved.Applications)
+	{
+		auto const App = std::make_shared<WAppCounter>(AppItem);
+		SystemItem->Applications[Key] = AppItem;
+		Applications[Key] = App;
+
+		for (auto const& [PID, ProcessItem] : AppItem->Processes)
+		{
+			auto const Process = std::make_shared<WProcessCounter>(ProcessItem, *App);
+			Processes[PID] = Process;
+
+			// Closed sockets were only waiting to be removed
+			std::erase_if(ProcessItem->Sockets, [](auto const& Entry) {
+				return Entry.second->ConnectionState == ESocketConnectionState::Closed;
+			});
+			for (auto const& [Cookie, SocketItem] : ProcessItem->Sockets)
+			{
+				auto const Socket = std::make_shared<WSocketCounter>(SocketItem, *Process);
+				Sockets[Cookie] = Socket;
+				IndexSocketPort(*Socket);
+
+				// Only the peers that are sent with the traffic tree are part of the snapshot
+				for (auto const& TupleItem : SocketItem->UDPPerConnectionTraffic)
+				{
+					auto const Tuple = std::make_shared<WTupleCounter>(TupleItem, *Socket);
+					Socket->UDPPerConnectionCounters[TupleItem->Endpoint] = Tuple;
+					if (!Tuple->IsOtherPeers())
+					{
+						Socket->PeerLru.push_back(TupleItem->Endpoint);
+						Tuple->LruPosition = std::prev(Socket->PeerLru.end());
+					}
+				}
+				// Only set on the copies sent to clients, the daemon's own items go by UDPPerConnectionTraffic
+				SocketItem->PeerCount = 0;
+			}
+
+			// Exits during the restart are still waiting in the ring buffer,
+			// unless it overflowed or the kernel doesn't report process events
+			if (!WFilesystem::IsProcessRunning(PID))
+			{
+				MarkProcessForRemoval(Process);
+			}
+		}
+	}
+
+	for (auto const& CgroupItem : Saved.Cgroups)
+	{
+		SystemItem->Cgroups.emplace_back(CgroupItem);
+		Cgroups[CgroupItem->CgroupId] = std::make_shared<WCgroupCounter>(CgroupItem);
+	}
+
+	ForkedChildren = Snapshot.ForkedChildren;
+	ForkParents = Snapshot.ForkParents;
+	bRestoredFromSnapshot = true;
+	spdlog::info("Restored {} applications, {} processes and {} sockets from the previous run", Applications.size(),
+		Processes.size(), Sockets.size());
 }
 
 void WSystemMap::ReparentOrphanedSocket(WEndpoint const& Endpoint, WProcessId NewParentProcess)
@@ -466,77 +483,209 @@ void WSystemMap::ReparentOrphanedSocket(WEndpoint const& Endpoint, WProcessId Ne
 	std::scoped_lock Lock(DataMutex);
 	if (auto const& It = OrphanedSockets.find(Endpoint); It != OrphanedSockets.end())
 	{
-		if (NewParentProcess == 0)
+		// lookup failed, so we'll just have to get rid of this socket
+		if (NewParentProcess != 0)
 		{
-			// lookup failed, so we'll just have to get rid of this socket
-			OrphanedSockets.erase(It);
-			return;
+			AdoptOrphanedSocket(It->second, NewParentProcess);
+		}
+		OrphanedSockets.erase(It);
+	}
+}
+
+void WSystemMap::AdoptOrphanedSocket(WOrphanedSocket const& Orphan, WProcessId NewParentProcess)
+{
+	auto const& [Socket, App] = Orphan;
+
+	// Re-register the application if it was cleaned up while the socket was orphaned
+	auto const& AppKey = App->TrafficItem->ApplicationPath;
+	if (!Applications.contains(AppKey))
+	{
+		Applications[AppKey] = App;
+		SystemItem->Applications[AppKey] = App->TrafficItem;
+		WNetworkEvents::GetInstance().OnAppFirstTimeConnected(App);
+	}
+
+	auto const bExistingProcess = Processes.contains(NewParentProcess);
+	auto const NewProcess = FindOrMapProcess(NewParentProcess, App);
+	Socket->SetParentProcess(*NewProcess);
+	Socket->bGuessedOwner = false;
+	NewProcess->TrafficItem->Sockets[Socket->TrafficItem->Cookie] = Socket->TrafficItem;
+	Sockets[Socket->TrafficItem->Cookie] = Socket;
+	IndexSocketPort(*Socket);
+	spdlog::debug("Reparented {} (type {}) to {}", Socket->TrafficItem->SocketTuple.ToString(),
+		Socket->TrafficItem->SocketType, App->TrafficItem->ApplicationName);
+
+	if (!bExistingProcess)
+	{
+		spdlog::info("New process {} created as parent for orphaned socket {}, id: {}", NewParentProcess,
+			Socket->TrafficItem->SocketTuple.ToString(), Socket->TrafficItem->ItemId);
+	}
+	// Re-add it to the new process
+	MapUpdate.AddSocketAddition(*Socket);
+}
+
+void WSystemMap::HandleProcessFork(WProcessId const ParentPID, WProcessId const ChildPID)
+{
+	std::scoped_lock Lock(DataMutex);
+	if (ForkParents.size() >= MaxForkRelations)
+	{
+		// Exit events were lost, start over instead of growing forever
+		spdlog::warn("Too many tracked fork relations, dropping all of them");
+		ForkParents.clear();
+		ForkedChildren.clear();
+	}
+	ForkParents[ChildPID] = ParentPID;
+	ForkedChildren[ParentPID].push_back(ChildPID);
+}
+
+void WSystemMap::HandleProcessExit(WProcessId const PID)
+{
+	std::scoped_lock Lock(DataMutex);
+	WProcessId Parent{};
+	if (auto const It = ForkParents.find(PID); It != ForkParents.end())
+	{
+		Parent = It->second;
+		ForkParents.erase(It);
+		if (auto const Siblings = ForkedChildren.find(Parent); Siblings != ForkedChildren.end())
+		{
+			std::erase(Siblings->second, PID);
 		}
+	}
 
-		auto const App = It->second->ParentProcess->ParentApp;
+	auto const ProcessIt = Processes.find(PID);
+	if (auto const ChildrenIt = ForkedChildren.find(PID); ChildrenIt != ForkedChildren.end())
+	{
+		// The children still hold whatever they inherited from the parent of this process
+		if (ForkedChildren.contains(Parent))
+		{
+			for (auto const Child : ChildrenIt->second)
+			{
+				ForkParents[Child] = Parent;
+				ForkedChildren[Parent].push_back(Child);
+			}
+		}
 
-		// Re-register the application if it was cleaned up while the socket was orphaned
-		auto const& AppKey = App->TrafficItem->ApplicationPath;
-		if (!Applications.contains(AppKey))
+		// Keep the children around until the cleanup decided who inherits the sockets of this process
+		if (ProcessIt == Processes.end())
 		{
-			Applications[AppKey] = App;
-			SystemItem->Applications[AppKey] = App->TrafficItem;
-			TrafficItems[App->TrafficItem->ItemId] = App->TrafficItem;
-			WNetworkEvents::GetInstance().OnAppFirstTimeConnected(App);
+			ForkedChildren.erase(ChildrenIt);
 		}
+	}
 
-		auto const bExistingProcess = Processes.contains(NewParentProcess);
-		auto const NewProcess = FindOrMapProcess(NewParentProcess, App);
-		It->second->ParentProcess = NewProcess;
-		NewProcess->TrafficItem->Sockets[It->second->TrafficItem->ItemId] = It->second->TrafficItem;
-		Sockets[It->second->TrafficItem->Cookie] = It->second;
-		spdlog::debug("Reparented {} (type {}) to {}", It->second->TrafficItem->SocketTuple.ToString(),
-			It->second->TrafficItem->SocketType, App->TrafficItem->ApplicationName);
+	if (ProcessIt != Processes.end())
+	{
+		MarkProcessForRemoval(ProcessIt->second);
+	}
+}
 
-		OrphanedSockets.erase(It);
-		if (!bExistingProcess)
+WProcessId WSystemMap::FindForkHeir(WProcessId const PID) const
+{
+	// Children are listed in fork order, so this is the oldest one. Which of them kept the sockets isn't known,
+	// a pre-forked server has all its workers hold the listening socket
+	if (auto const It = ForkedChildren.find(PID); It != ForkedChildren.end())
+	{
+		for (auto const Child : It->second)
 		{
-			spdlog::info("New process {} created as parent for orphaned socket {}, id: {}", NewParentProcess,
-				It->second->TrafficItem->SocketTuple.ToString(), It->second->TrafficItem->ItemId);
+			if (ForkParents.contains(Child))
+			{
+				return Child;
+			}
 		}
-		// Re-add it to the new process
-		MapUpdate.AddSocketAddition(It->second);
 	}
+	return 0;
 }
 
-void WSystemMap::ReparentAcceptedSocket(std::shared_ptr<WSocketCounter> const& Socket)
+std::shared_ptr<WAppCounter> WSystemMap::FindForkedApplication(WProcessId PID) const
 {
-	std::scoped_lock Lock(DataMutex);
+	// Bounded in case the relations ended up with a cycle after PIDs were reused
+	for (std::size_t Depth = 0; Depth < 16; ++Depth)
+	{
+		auto const ParentIt = ForkParents.find(PID);
+		if (ParentIt == ForkParents.end())
+		{
+			break;
+		}
+		PID = ParentIt->second;
+		if (auto const It = Processes.find(PID); It != Processes.end())
+		{
+			return FindApp(It->second->GetAppItem());
+		}
+	}
+	return {};
+}
 
-	auto const& LocalEndpoint = Socket->TrafficItem->SocketTuple.LocalEndpoint;
-	if (LocalEndpoint.Port == 0)
+std::shared_ptr<WAppCounter> WSystemMap::FindApp(std::shared_ptr<WApplicationItem> const& AppItem) const
+{
+	if (!AppItem)
 	{
-		return;
+		return {};
 	}
+	auto const It = Applications.find(AppItem->ApplicationPath);
+	return It != Applications.end() && It->second->GetId() == AppItem->ItemId ? It->second : nullptr;
+}
 
-	// port_to_pid stores the master PID (whoever called bind()), but for a pre-forked
-	// server like nginx the accepted fd is owned by a worker. The daemon doesn't run as
-	// root so it can't read /proc/[pid]/fd to resolve the real owner itself. Delegate
-	// to the IPLink process (which runs as root) using the same orphan-lookup path that
-	// fork() reparenting already uses.
-	spdlog::debug("ReparentAcceptedSocket: queuing IPLink lookup for accepted socket on {}", LocalEndpoint.ToString());
+bool WSystemMap::IsOwnerEvent(uint8_t const EventType)
+{
+	// These run in the context of the process calling connect(), bind(), listen(), send() or recv(). Accepted
+	// sockets get their cookie with the accept event, so there's no need to check those
+	switch (EventType)
+	{
+		case NE_SocketConnect_4:
+		case NE_SocketConnect_6:
+		case NE_SocketBind_4:
+		case NE_SocketBind_6:
+		case NE_TCPSocketListening:
+			return true;
+		default:
+			return false;
+	}
+}
+
+void WSystemMap::MoveSocketToProcess(
+	std::shared_ptr<WSocketCounter> const& Socket, std::shared_ptr<WProcessCounter> const& Process)
+{
+	auto const Cookie = Socket->TrafficItem->Cookie;
+	auto const OldProcess = Socket->GetProcessItem();
+	spdlog::debug("Moving socket {} from process {} to {}", Socket->TrafficItem->SocketTuple.ToString(),
+		OldProcess ? OldProcess->ProcessId : 0, Process->TrafficItem->ProcessId);
+
+	// Same as when a socket is reparented during the cleanup, clients remove it and add it to the new process
+	if (OldProcess)
+	{
+		OldProcess->Sockets.erase(Cookie);
+	}
+	MapUpdate.AddItemRemoval(Socket->TrafficItem->ItemId);
+	for (auto const& Tuple : Socket->UDPPerConnectionCounters | std::views::values)
+	{
+		MapUpdate.AddItemRemoval(Tuple->TrafficItem->ItemId);
+		WNetworkEvents::GetInstance().OnUDPTupleRemoved(Tuple);
+	}
+	Socket->ClearPeers();
+	Socket->TrafficItem->UDPPerConnectionTraffic.clear();
 
-	OrphanedSockets[LocalEndpoint] = Socket;
+	Socket->SetParentProcess(*Process);
+	Socket->bGuessedOwner = false;
+	Process->TrafficItem->Sockets[Cookie] = Socket->TrafficItem;
+	MapUpdate.AddSocketAddition(*Socket);
+}
 
-	WLookupEndpointsMsg LookupMsg{};
-	LookupMsg.Endpoints.emplace_back(LocalEndpoint);
-	WIPLink::GetInstance().SendLookupMessage(LookupMsg);
+void WSystemMap::MarkProcessForRemoval(std::shared_ptr<WProcessCounter> const& Process)
+{
+	if (!Process->IsMarkedForRemoval())
+	{
+		Process->MarkForRemoval();
+		MapUpdate.MarkItemForRemoval(Process->TrafficItem->ItemId);
+	}
 }
 
-WSystemMap::WSystemMap()
+WSystemMap::WSystemMap() : CgroupResolver(WDaemonConfig::GetInstance().CGroupPath)
 {
-	TrafficItems[SystemItem->ItemId] = SystemItem;
 	auto const HostName = WFilesystem::ReadProc("/proc/sys/kernel/hostname");
 	if (!HostName.empty())
 	{
 		SystemItem->HostName = HostName;
 	}
-	RegisterDefaultFilters();
+	RegisterFilters();
 	// Periodically check /proc/ for any socket info (I don't think we need this)
 	// WTimerManager::GetInstance().AddTimer(5, [this] {
 	// 	std::scoped_lock Lock(DataMutex);
@@ -544,15 +693,9 @@ WSystemMap::WSystemMap()
 	// });
 }
 
-static std::string NormalizeAppImagePaths(std::string const& path)
-{
-	static std::regex const RE(R"(^/tmp/[^/]+/usr/bin/(.*)$)");
-	return std::regex_replace(path, RE, "/tmp/appimage/bin/$1");
-}
-
 std::shared_ptr<WSocketCounter> WSystemMap::MapSocket(WSocketEvent const& Event, WProcessId PID, bool const bSilentFail)
 {
-	std::scoped_lock Lock(DataMutex);
+	std::unique_lock Lock(DataMutex);
 
 	ZoneScopedN("WSystemMap::MapSocket");
 	auto SocketCookie = Event.Cookie;
@@ -581,64 +724,57 @@ std::shared_ptr<WSocketCounter> WSystemMap::MapSocket(WSocketEvent const& Event,
 		return {};
 	}
 
-	if (auto const It = Sockets.find(SocketCookie); It != Sockets.end())
+	// Sockets of an exited process were handed to one of its children, the first event of the process that really
+	// uses the socket settles who owns it
+	auto IsSettled = [&](std::shared_ptr<WSocketCounter> const& Socket) {
+		if (!Socket->bGuessedOwner || !IsOwnerEvent(Event.EventType))
+		{
+			return true;
+		}
+		auto const Owner = Socket->GetProcessItem();
+		return Owner && Owner->ProcessId == PID;
+	};
+
+	if (auto const It = Sockets.find(SocketCookie); It != Sockets.end() && IsSettled(It->second))
 	{
 		return It->second;
 	}
 
-	// Build robust process info
-	std::string              ExePath = NormalizeAppImagePaths(WFilesystem::GetProcessExePath(PID));
-	std::vector<std::string> Argv = WFilesystem::GetProcessCmdlineArgs(PID);
-	std::string              Comm = WFilesystem::ReadProc("/proc/" + std::to_string(PID) + "/comm");
-	if (!Comm.empty() && Comm.back() == '\n')
+	// A process we already know about doesn't need any lookups
+	std::shared_ptr<WProcessCounter> Process{};
+	if (auto const It = Processes.find(PID); It != Processes.end())
 	{
-		Comm.pop_back();
+		Process = It->second;
 	}
-
-	// Fallbacks if cmdline is empty (kernel threads) or trimmed
-	if (Argv.empty())
+	else
 	{
-		if (!ExePath.empty())
+		// Resolving the process metadata reads a bunch of files in /proc/, don't block traffic updates while doing so
+		Lock.unlock();
+		auto const Info = WProcessInfoCache::GetInstance().GetProcessInfo(PID);
+		Lock.lock();
+
+		if (auto const SocketIt = Sockets.find(SocketCookie); SocketIt != Sockets.end() && IsSettled(SocketIt->second))
 		{
-			Argv.push_back(ExePath);
+			return SocketIt->second;
 		}
-		else if (!Comm.empty())
+
+		// The daemon can't read the binary of processes that belong to other users. If the kernel told us about the
+		// fork, the child most likely still runs the binary of its parent, like the workers of a pre-forked server
+		auto App = Info->ExePath.empty() ? FindForkedApplication(PID) : nullptr;
+		if (!App)
 		{
-			Argv.push_back(Comm);
+			App = FindOrMapApplication(Info->ExePath, Info->CommandLine, Info->Name);
 		}
+		assert(App);
+		Process = FindOrMapProcess(PID, App);
+		assert(Process);
 	}
 
-	// If /proc/[pid]/exe is inaccessible (common for setproctitle()-style daemons such as nginx/php-fpm),
-	// fall back to argv[0], comm, PATH, cwd, and the process root.
-	if (ExePath.empty())
-	{
-		ExePath = ResolveProcessBinaryPath(PID, Argv, Comm);
-	}
-
-	// Reconstruct human-readable command line preserving argv boundaries with spaces
-	std::string CmdlIne;
-	for (size_t i = 0; i < Argv.size(); ++i)
-	{
-		CmdlIne += Argv[i];
-		if (i + 1 < Argv.size())
-			CmdlIne += ' ';
-	}
-
-	Comm = WStringFormat::Trim(Comm);
-
-	if ((Comm.empty() || Comm == "main" || Comm == "Main") && !ExePath.empty())
+	if (auto const It = Sockets.find(SocketCookie); It != Sockets.end())
 	{
-		Comm = GetBasename(ExePath);
-		if (Comm.empty())
-		{
-			Comm = ExePath.empty() ? "unknown" : ExePath;
-		}
+		MoveSocketToProcess(It->second, Process);
+		return It->second;
 	}
-
-	auto const App = FindOrMapApplication(ExePath, CmdlIne, Comm);
-	assert(App);
-	auto const Process = FindOrMapProcess(PID, App);
-	assert(Process);
 	return FindOrMapSocket(SocketCookie, Process);
 }
 
@@ -655,7 +791,12 @@ std::shared_ptr<WSocketCounter> WSystemMap::MapSocketFromTrafficEvent(WSocketEve
 
 	auto const LocalEndpoint =
 		Event.Data.TrafficEventData.Direction == PD_Outgoing ? PacketHeader.Src : PacketHeader.Dst;
+	return MapSocketFromLocalEndpoint(Event, LocalEndpoint, PacketHeader.L4Proto);
+}
 
+std::shared_ptr<WSocketCounter> WSystemMap::MapSocketFromLocalEndpoint(
+	WSocketEvent const& Event, WEndpoint const& LocalEndpoint, EProtocol::Type const Protocol)
+{
 	auto const PID = SocketStateParser.GetEndpointPID(LocalEndpoint);
 	if (PID <= 0)
 	{
@@ -675,7 +816,7 @@ std::shared_ptr<WSocketCounter> WSystemMap::MapSocketFromTrafficEvent(WSocketEve
 
 		if (Socket->TrafficItem->SocketTuple.Protocol == EProtocol::Unknown)
 		{
-			Socket->TrafficItem->SocketTuple.Protocol = PacketHeader.L4Proto;
+			Socket->TrafficItem->SocketTuple.Protocol = Protocol;
 		}
 
 		spdlog::debug(
@@ -685,41 +826,95 @@ std::shared_ptr<WSocketCounter> WSystemMap::MapSocketFromTrafficEvent(WSocketEve
 	return Socket;
 }
 
+void WSystemMap::IndexSocketPort(WSocketCounter& Socket)
+{
+	auto const Port = Socket.TrafficItem->SocketTuple.LocalEndpoint.Port;
+	if (Port == Socket.IndexedPort)
+	{
+		return;
+	}
+
+	UnindexSocketPort(Socket);
+	if (Port != 0)
+	{
+		PortSockets[Port].push_back(Socket.TrafficItem->Cookie);
+		Socket.IndexedPort = Port;
+	}
+}
+
+void WSystemMap::UnindexSocketPort(WSocketCounter& Socket)
+{
+	if (Socket.IndexedPort == 0)
+	{
+		return;
+	}
+
+	if (auto const It = PortSockets.find(Socket.IndexedPort); It != PortSockets.end())
+	{
+		std::erase(It->second, Socket.TrafficItem->Cookie);
+		if (It->second.empty())
+		{
+			PortSockets.erase(It);
+		}
+	}
+	Socket.IndexedPort = 0;
+}
+
+void WSystemMap::EraseSocket(WSocketCookie const Cookie)
+{
+	if (auto const It = Sockets.find(Cookie); It != Sockets.end())
+	{
+		UnindexSocketPort(*It->second);
+		Sockets.erase(It);
+	}
+}
+
+void WSystemMap::MarkSocketForRemoval(WSocketEvent const& Event)
+{
+	std::scoped_lock Lock(DataMutex);
+	auto const       It = Sockets.find(Event.Cookie);
+	if (It == Sockets.end())
+	{
+		return;
+	}
+
+	auto MarkClosed = [this](WSocketCounter& Socket) {
+		Socket.MarkForRemoval();
+		Socket.TrafficItem->ConnectionState = ESocketConnectionState::Closed;
+		MapUpdate.MarkItemForRemoval(Socket.TrafficItem->ItemId);
+		// Force state update of the process, also counted for the application
+		WCounterSlab::GetInstance().PushIncomingTraffic(Socket.GetParentId(), 0);
+		TrafficCounter.PushIncomingTraffic(0);
+	};
+
+	// Listen sockets that were opened before the daemon started are only known under a
+	// synthetic cookie, so the first socket using the port of the closed one goes as well
+	if (Event.Data.SocketCloseEventData.LocalPort > 0)
+	{
+		auto const Port = static_cast<uint16_t>(Event.Data.SocketCloseEventData.LocalPort);
+		if (auto const Bucket = PortSockets.find(Port); Bucket != PortSockets.end() && !Bucket->second.empty())
+		{
+			MarkClosed(*Sockets[Bucket->second.front()]);
+		}
+	}
+	MarkClosed(*It->second);
+}
+
 void WSystemMap::PushTrafficForSocket(WSocketEvent const& Event, std::shared_ptr<WSocketCounter> const& Socket) const
 {
 	auto const Bytes = Event.Data.TrafficEventData.Bytes;
 	if (Event.Data.TrafficEventData.Direction == PD_Incoming)
 	{
+		// Also counted for the parent process and application
 		ZoneScopedN("WSystemMap::PushIncomingTraffic");
 		Socket->PushIncomingTraffic(Bytes);
-		Socket->ParentProcess->PushIncomingTraffic(Bytes);
-		Socket->ParentProcess->ParentApp->PushIncomingTraffic(Bytes);
-
-		for (auto const& Filter : FilterCounters)
-		{
-			if (Filter->FilterFunction(Socket->TrafficItem->ItemId, &Socket->TrafficItem->SocketTuple.LocalEndpoint,
-					&Socket->TrafficItem->SocketTuple.RemoteEndpoint))
-			{
-				Filter->PushIncomingTraffic(Bytes);
-			}
-		}
 	}
 	else
 	{
 		ZoneScopedN("WSystemMap::PushOutgoingTraffic");
 		Socket->PushOutgoingTraffic(Bytes);
-		Socket->ParentProcess->PushOutgoingTraffic(Bytes);
-		Socket->ParentProcess->ParentApp->PushOutgoingTraffic(Bytes);
-
-		for (auto const& Filter : FilterCounters)
-		{
-			if (Filter->FilterFunction(Socket->TrafficItem->ItemId, &Socket->TrafficItem->SocketTuple.LocalEndpoint,
-					&Socket->TrafficItem->SocketTuple.RemoteEndpoint))
-			{
-				Filter->PushOutgoingTraffic(Bytes);
-			}
-		}
 	}
+	PushFilterTraffic(GetSocketFilterMask(*Socket), Event.Data.TrafficEventData.Direction, Bytes);
 
 	Socket->TrafficItem->ConnectionState = ESocketConnectionState::Connected;
 }
@@ -734,46 +929,56 @@ std::shared_ptr<WSocketCounter> WSystemMap::FindOrMapSocket(
 	}
 
 	auto SocketItem = std::make_shared<WSocketItem>();
-	auto Socket = std::make_shared<WSocketCounter>(SocketItem, ParentProcess);
-	SocketItem->ItemId = NextItemId++;
+	auto Socket = std::make_shared<WSocketCounter>(SocketItem, *ParentProcess);
 	SocketItem->Cookie = SocketCookie;
 	Sockets[SocketCookie] = Socket;
-	TrafficItems[Socket->TrafficItem->ItemId] = SocketItem;
 	ParentProcess->TrafficItem->Sockets[SocketCookie] = SocketItem;
 
-	MapUpdate.AddSocketAddition(Socket);
+	MapUpdate.AddSocketAddition(*Socket);
 
 	return Socket;
 }
 
 void WSystemMap::MergeSyntheticSocket(std::shared_ptr<WSocketCounter> const& Socket)
 {
+	std::scoped_lock Lock(DataMutex);
+	// The socket event that was just processed might have changed the local port
+	IndexSocketPort(*Socket);
+
 	auto const& Cookie = Socket->TrafficItem->Cookie;
 	// Only merge real eBPF cookies (skip synthetic and traffic-mapped cookies)
 	if ((Cookie & kSyntheticCookieBase) != 0)
 	{
 		return;
 	}
-	auto const& ParentProcess = Socket->ParentProcess;
-	auto const  Port = Socket->TrafficItem->SocketTuple.LocalEndpoint.Port;
-	if (Port == 0 || !ParentProcess)
+	auto const Port = Socket->TrafficItem->SocketTuple.LocalEndpoint.Port;
+	if (Port == 0)
+	{
+		return;
+	}
+
+	auto const Bucket = PortSockets.find(Port);
+	if (Bucket == PortSockets.end())
+	{
+		return;
+	}
+
+	auto const ParentId = Socket->GetParentId();
+	auto const ParentProcess = Socket->GetProcessItem();
+	if (!ParentProcess)
 	{
 		return;
 	}
 
-	std::scoped_lock Lock(DataMutex);
 	// Find a synthetic entry (AddExistingSockets) with the same port and parent process
-	for (auto const& [ExistingCookie, ExistingSocket] : Sockets)
+	for (auto const ExistingCookie : Bucket->second)
 	{
 		if ((ExistingCookie & kSyntheticCookieBase) == 0)
 		{
 			continue;
 		}
-		if (ExistingSocket->ParentProcess != ParentProcess)
-		{
-			continue;
-		}
-		if (ExistingSocket->TrafficItem->SocketTuple.LocalEndpoint.Port != Port)
+		auto const ExistingSocket = Sockets[ExistingCookie];
+		if (ExistingSocket->GetParentId() != ParentId)
 		{
 			continue;
 		}
@@ -791,11 +996,10 @@ void WSystemMap::MergeSyntheticSocket(std::shared_ptr<WSocketCounter> const& Soc
 		{
 			Socket->TrafficItem->SocketTuple.Protocol = CorrectProto;
 		}
-		// Remove the now-redundant synthetic entry
+		// Remove the now-redundant synthetic entry, this invalidates the bucket
 		WNetworkEvents::GetInstance().OnSocketRemoved(ExistingSocket);
-		ParentProcess->TrafficItem->Sockets.erase(ExistingCookie);
-		TrafficItems.erase(ExistingSocket->TrafficItem->ItemId);
-		Sockets.erase(ExistingCookie);
+		ParentProcess->Sockets.erase(ExistingCookie);
+		EraseSocket(ExistingCookie);
 		MapUpdate.MarkItemForRemoval(ExistingSocket->TrafficItem->ItemId);
 		break;
 	}
@@ -811,15 +1015,19 @@ std::shared_ptr<WProcessCounter> WSystemMap::FindOrMapProcess(
 	}
 
 	auto ProcessItem = std::make_shared<WProcessItem>();
-	auto Process = std::make_shared<WProcessCounter>(ProcessItem, ParentApp);
-	ProcessItem->ItemId = NextItemId++;
+	auto Process = std::make_shared<WProcessCounter>(ProcessItem, *ParentApp);
 	ProcessItem->ProcessId = PID;
 
 	ParentApp->TrafficItem->Processes[PID] = ProcessItem;
 	Processes[PID] = Process;
-	TrafficItems[Process->TrafficItem->ItemId] = ProcessItem;
 
 	WNetworkEvents::GetInstance().OnProcessCreated(Process);
+
+	// The exit notification might have arrived before the events of this process' sockets were processed
+	if (WProcessInfoCache::GetInstance().HasRecentlyExited(PID))
+	{
+		Process->MarkForRemoval();
+	}
 	return Process;
 }
 
@@ -847,9 +1055,9 @@ std::shared_ptr<WAppCounter> WSystemMap::FindOrMapApplication(
 	Key = WStringFormat::Trim(Key);
 	if (Key.empty() || Key.front() != '/')
 	{
-		Key = SanitizeProcessBinaryCandidate(Key);
+		Key = WProcessInfoCache::SanitizeProcessBinaryCandidate(Key);
 	}
-	Key = NormalizeAppImagePaths(Key);
+	Key = WProcessInfoCache::NormalizeAppImagePath(Key);
 	if (Key.empty())
 	{
 		Key = AppName.empty() ? "unknown" : WStringFormat::Trim(AppName);
@@ -862,8 +1070,8 @@ std::shared_ptr<WAppCounter> WSystemMap::FindOrMapApplication(
 
 	if (!Key.empty() && Key.front() == '/')
 	{
-		auto const KeyBasename = GetBasename(Key);
-		auto const AppAlias = SanitizeProcessBinaryCandidate(AppName);
+		auto const KeyBasename = WProcessInfoCache::GetBasename(Key);
+		auto const AppAlias = WProcessInfoCache::SanitizeProcessBinaryCandidate(AppName);
 		for (auto It = Applications.begin(); It != Applications.end(); ++It)
 		{
 			auto const ExistingKey = It->first;
@@ -880,7 +1088,7 @@ std::shared_ptr<WAppCounter> WSystemMap::FindOrMapApplication(
 				// If the existing entry already has a resolved path, still try to match by
 				// basename so we don't create duplicate entries for the same application
 				// (e.g. steam spawning multiple subprocesses with different ExePaths).
-				auto const ExistingBasename = GetBasename(ExistingPath);
+				auto const ExistingBasename = WProcessInfoCache::GetBasename(ExistingPath);
 				if (!ExistingBasename.empty() && (ExistingBasename == KeyBasename || ExistingBasename == AppAlias))
 				{
 					return ExistingApp;
@@ -888,10 +1096,10 @@ std::shared_ptr<WAppCounter> WSystemMap::FindOrMapApplication(
 				continue;
 			}
 
-			auto ExistingAlias = SanitizeProcessBinaryCandidate(ExistingPath);
+			auto ExistingAlias = WProcessInfoCache::SanitizeProcessBinaryCandidate(ExistingPath);
 			if (ExistingAlias.empty())
 			{
-				ExistingAlias = SanitizeProcessBinaryCandidate(ExistingKey);
+				ExistingAlias = WProcessInfoCache::SanitizeProcessBinaryCandidate(ExistingKey);
 			}
 
 			bool const bMatchesAlias = !ExistingAlias.empty() && (ExistingAlias == KeyBasename || ExistingAlias == AppAlias);
@@ -904,6 +1112,11 @@ std::shared_ptr<WAppCounter> WSystemMap::FindOrMapApplication(
 			spdlog::debug("Upgrading application key '{}' -> '{}'", ExistingKey, Key);
 			SystemItem->Applications.erase(ExistingKey);
 			Applications.erase(It);
+			if (auto Labelled = LabelledApps.extract(ExistingKey))
+			{
+				Labelled.key() = Key;
+				LabelledApps.insert(std::move(Labelled));
+			}
 			ExistingApp->TrafficItem->ApplicationPath = Key;
 			if (!CommandLine.empty())
 			{
@@ -923,7 +1136,6 @@ std::shared_ptr<WAppCounter> WSystemMap::FindOrMapApplication(
 	spdlog::debug("Mapped new application: key='{}', exe='{}', cmd='{}'", Key, ExePath, CommandLine);
 	auto AppItem = std::make_shared<WApplicationItem>();
 	auto App = std::make_shared<WAppCounter>(AppItem);
-	AppItem->ItemId = NextItemId++;
 	AppItem->ApplicationPath = Key; // store the most reliable path we have
 	AppItem->ApplicationCommandLine = CommandLine;
 	// Choose display name: AppName (comm) if provided, else basename of key
@@ -954,7 +1166,6 @@ std::shared_ptr<WAppCounter> WSystemMap::FindOrMapApplication(
 
 	SystemItem->Applications[Key] = AppItem;
 	Applications[Key] = App;
-	TrafficItems[AppItem->ItemId] = AppItem;
 	WNetworkEvents::GetInstance().OnAppFirstTimeConnected(App);
 	return App;
 }
@@ -971,6 +1182,13 @@ void WSystemMap::RefreshAllTrafficCounters()
 			Filter->TrafficItem->Name, Filter->GetRecentDownload(), Filter->GetRecentUpload());
 		Filter->Refresh();
 	}
+
+	for (auto const& Cgroup : Cgroups | std::views::values)
+	{
+		WStatsManager::GetInstance().UpdateCgroupStats(
+			Cgroup->TrafficItem->GetStatsName(), Cgroup->GetRecentDownload(), Cgroup->GetRecentUpload());
+		Cgroup->Refresh();
+	}
 	WStatsManager::GetInstance().GetDataMutex().unlock();
 
 	for (auto const& App : Applications | std::views::values)
@@ -986,12 +1204,10 @@ void WSystemMap::RefreshAllTrafficCounters()
 	WStatsManager::GetInstance().GetDataMutex().lock();
 	for (auto const& Socket : Sockets | std::views::values)
 	{
-		if (Socket->ParentProcess && Socket->ParentProcess->ParentApp)
+		if (auto const AppItem = Socket->GetAppItem())
 		{
-			auto const App = Socket->ParentProcess->ParentApp;
-			WStatsManager::GetInstance().UpdateAppStats(App->TrafficItem->ItemId,
-				App->TrafficItem->ApplicationPath, Socket->TrafficItem->SocketTuple.RemoteEndpoint.Address,
-				Socket->GetRecentDownload(),
+			WStatsManager::GetInstance().UpdateAppStats(AppItem->ItemId, AppItem->ApplicationPath,
+				Socket->TrafficItem->SocketTuple.RemoteEndpoint.Address, Socket->GetRecentDownload(),
 				Socket->GetRecentUpload());
 		}
 
@@ -1025,6 +1241,7 @@ void WSystemMap::PushIncomingTraffic(WSocketEvent const& Event)
 
 	PushTrafficForSocket(Event, Socket);
 	DoPacketParsing(Event, Socket);
+	IndexSocketPort(*Socket);
 }
 
 void WSystemMap::PushOutgoingTraffic(WSocketEvent const& Event)
@@ -1053,6 +1270,173 @@ void WSystemMap::PushOutgoingTraffic(WSocketEvent const& Event)
 
 	PushTrafficForSocket(Event, Socket);
 	DoPacketParsing(Event, Socket);
+	IndexSocketPort(*Socket);
+}
+
+void WSystemMap::HandleUDPPeer(WSocketEvent const& Event)
+{
+	ZoneScopedN("WSystemMap::HandleUDPPeer");
+	auto const& PeerData = Event.Data.UDPPeerEventData;
+	auto const  Family = PeerData.Family == AF_INET6 ? EIPFamily::IPv6 : EIPFamily::IPv4;
+	auto const  AddressSize = Family == EIPFamily::IPv6 ? 16 : 4;
+
+	WEndpoint LocalEndpoint{};
+	WEndpoint RemoteEndpoint{};
+	LocalEndpoint.Address.Family = Family;
+	RemoteEndpoint.Address.Family = Family;
+	std::copy_n(PeerData.LocalAddr, AddressSize, LocalEndpoint.Address.Bytes.begin());
+	std::copy_n(PeerData.RemoteAddr, AddressSize, RemoteEndpoint.Address.Bytes.begin());
+	LocalEndpoint.Port = PeerData.LocalPort;
+	RemoteEndpoint.Port = PeerData.RemotePort;
+
+	std::unique_lock                Lock(DataMutex);
+	std::shared_ptr<WSocketCounter> Socket{};
+	if (auto const It = Sockets.find(Event.Cookie); It != Sockets.end())
+	{
+		Socket = It->second;
+	}
+	else if (PeerData.Direction == PD_Outgoing)
+	{
+		// Same as for traffic events, only sockets that send something can be looked up by their local endpoint
+		Lock.unlock();
+		Socket = MapSocketFromLocalEndpoint(Event, LocalEndpoint, EProtocol::UDP);
+		Lock.lock();
+	}
+
+	if (!Socket)
+	{
+		return;
+	}
+
+	UpdateSocketTuple(*Socket, EProtocol::UDP, LocalEndpoint, RemoteEndpoint);
+	if (!RemoteEndpoint.Address.IsZero())
+	{
+		// Creates the tuple right away, the traffic follows with the next sweep of the flow map
+		PushTupleTraffic(Socket, RemoteEndpoint, PeerData.Direction, 0);
+	}
+	Socket->TrafficItem->ConnectionState = ESocketConnectionState::Connected;
+	IndexSocketPort(*Socket);
+}
+
+void WSystemMap::PushUdpFlowTraffic(std::span<WUdpFlowTraffic const> Flows)
+{
+	ZoneScopedN("WSystemMap::PushUdpFlowTraffic");
+	std::scoped_lock Lock(DataMutex);
+	for (auto const& Flow : Flows)
+	{
+		if (Flow.Direction == PD_Incoming)
+		{
+			TrafficCounter.PushIncomingTraffic(Flow.Bytes);
+		}
+		else
+		{
+			TrafficCounter.PushOutgoingTraffic(Flow.Bytes);
+		}
+
+		auto const It = Sockets.find(Flow.Cookie);
+		if (It == Sockets.end())
+		{
+			continue;
+		}
+
+		auto const& Socket = It->second;
+		if (Flow.Direction == PD_Incoming)
+		{
+			Socket->PushIncomingTraffic(Flow.Bytes);
+		}
+		else
+		{
+			Socket->PushOutgoingTraffic(Flow.Bytes);
+		}
+		PushFilterTraffic(GetSocketFilterMask(*Socket), Flow.Direction, Flow.Bytes);
+		PushTupleTraffic(Socket, Flow.RemoteEndpoint, Flow.Direction, Flow.Bytes);
+		Socket->TrafficItem->ConnectionState = ESocketConnectionState::Connected;
+	}
+}
+
+std::shared_ptr<WCgroupCounter> WSystemMap::FindOrMapCgroup(uint64_t const CgroupId)
+{
+	if (auto const It = Cgroups.find(CgroupId); It != Cgroups.end())
+	{
+		return It->second;
+	}
+
+	auto Item = std::make_shared<WCgroupItem>();
+	Item->CgroupId = CgroupId;
+	Item->Name = CgroupResolver.Resolve(CgroupId);
+	if (Item->Name.empty())
+	{
+		// Either gone already or not in the hierarchy the daemon was pointed at
+		Item->Name = fmt::format("#{}", CgroupId);
+	}
+	spdlog::debug("Mapped new cgroup {} ({})", Item->Name, CgroupId);
+
+	auto Counter = std::make_shared<WCgroupCounter>(Item);
+	SystemItem->Cgroups.emplace_back(Item);
+	Cgroups[CgroupId] = Counter;
+	MapUpdate.AddCgroupAddition(*Item);
+	return Counter;
+}
+
+void WSystemMap::PushCgroupTraffic(std::span<WCgroupTraffic const> Traffic)
+{
+	ZoneScopedN("WSystemMap::PushCgroupTraffic");
+	std::scoped_lock Lock(DataMutex);
+	for (auto const& Entry : Traffic)
+	{
+		auto const Cgroup = FindOrMapCgroup(Entry.CgroupId);
+		Cgroup->PushIncomingTraffic(Entry.Download);
+		Cgroup->PushOutgoingTraffic(Entry.Upload);
+	}
+}
+
+void WSystemMap::CleanupCgroups()
+{
+	static constexpr uint8_t CgroupInactiveTicks = 60;
+	static constexpr WMsec   CgroupCheckInterval = 30000;
+
+	for (auto It = Cgroups.begin(); It != Cgroups.end();)
+	{
+		auto const& Cgroup = It->second;
+		if (Cgroup->DueForRemoval())
+		{
+			spdlog::debug("Removing cgroup {}", Cgroup->TrafficItem->Name);
+			MapUpdate.AddItemRemoval(Cgroup->TrafficItem->ItemId);
+			SystemItem->RemoveChild(Cgroup->TrafficItem->ItemId);
+			It = Cgroups.erase(It);
+			continue;
+		}
+		++It;
+	}
+
+	// Idle cgroups are only dropped once their directory is gone, checking that doesn't have to happen every tick
+	auto const Now = WTime::GetEpochMs();
+	if (Now - LastCgroupCheckTime < CgroupCheckInterval)
+	{
+		return;
+	}
+	LastCgroupCheckTime = Now;
+
+	for (auto const& [CgroupId, Cgroup] : Cgroups)
+	{
+		if (!Cgroup->IsMarkedForRemoval() && Cgroup->GetInactiveCounter() >= CgroupInactiveTicks
+			&& !CgroupResolver.Exists(CgroupId))
+		{
+			Cgroup->MarkForRemoval();
+			MapUpdate.MarkItemForRemoval(Cgroup->TrafficItem->ItemId);
+		}
+	}
+}
+
+void WSystemMap::PushExcludedLoopbackTraffic(WBytes const Download, WBytes const Upload)
+{
+	static WEndpoint const Loopback{ .Address = WIPAddress::FromStringV4("127.0.0.1").value_or(WIPAddress{}) };
+
+	std::scoped_lock Lock(DataMutex);
+	// Neither ports nor protocol are known, so filters constrained by them don't get any of it
+	auto const FilterMask = FilterEngine.Classify(Loopback, Loopback, EProtocol::Unknown);
+	PushFilterTraffic(FilterMask, PD_Incoming, Download);
+	PushFilterTraffic(FilterMask, PD_Outgoing, Upload);
 }
 
 std::vector<std::string> WSystemMap::GetActiveApplicationPaths()
@@ -1071,53 +1455,170 @@ std::vector<std::string> WSystemMap::GetActiveApplicationPaths()
 	return ActiveApps;
 }
 
+WTrafficMetrics WSystemMap::GetTrafficMetrics(std::size_t const MaxApps)
+{
+	ZoneScopedN("GetTrafficMetrics");
+	std::lock_guard Lock(DataMutex);
+	WTrafficMetrics Metrics{};
+	Metrics.System = { SystemItem->HostName, {}, SystemItem->TotalDownloadBytes, SystemItem->TotalUploadBytes };
+
+	std::vector<WTrafficMetricsEntry> Unlabelled{};
+	for (auto const& [Path, App] : Applications)
+	{
+		auto const&          Item = App->TrafficItem;
+		WTrafficMetricsEntry Entry{ Item->ApplicationName, Path, Item->TotalDownloadBytes, Item->TotalUploadBytes };
+		if (auto const It = LabelledApps.find(Path); It != LabelledApps.end())
+		{
+			It->second = std::move(Entry);
+		}
+		else
+		{
+			Unlabelled.push_back(std::move(Entry));
+		}
+	}
+
+	auto const ByTraffic = [](WTrafficMetricsEntry const& A, WTrafficMetricsEntry const& B) {
+		return A.Download + A.Upload > B.Download + B.Upload;
+	};
+
+	// Free labels go to the applications with the most traffic, once they are taken they stay taken
+	auto const FreeLabels = std::min(MaxApps - std::min(MaxApps, LabelledApps.size()), Unlabelled.size());
+	auto const FirstOther = Unlabelled.begin() + static_cast<std::ptrdiff_t>(FreeLabels);
+	std::ranges::partial_sort(Unlabelled, FirstOther, ByTraffic);
+	for (auto It = Unlabelled.begin(); It != FirstOther; ++It)
+	{
+		auto Path = It->Path;
+		LabelledApps.emplace(std::move(Path), std::move(*It));
+	}
+
+	Metrics.OtherApps = RemovedOtherApps;
+	for (auto It = FirstOther; It != Unlabelled.end(); ++It)
+	{
+		Metrics.OtherApps.Download += It->Download;
+		Metrics.OtherApps.Upload += It->Upload;
+	}
+	Metrics.OtherAppCount = static_cast<std::size_t>(Unlabelled.end() - FirstOther);
+
+	Metrics.Apps.reserve(LabelledApps.size());
+	for (auto const& Entry : LabelledApps | std::views::values)
+	{
+		Metrics.Apps.push_back(Entry);
+	}
+	std::ranges::sort(Metrics.Apps, ByTraffic);
+
+	for (auto const& Filter : FilterCounters)
+	{
+		auto const& Item = Filter->TrafficItem;
+		Metrics.Filters.push_back({ Item->Name, {}, Item->TotalDownloadBytes, Item->TotalUploadBytes });
+	}
+	return Metrics;
+}
+
+namespace
+{
+	// make_shared puts the counter and its reference counts into one allocation
+	constexpr WBytes SharedControlBlockSize = sizeof(void*) + sizeof(int) * 2;
+
+	// Size of a counter while it carried its traffic state and a shared pointer to each of its parents, the other
+	// members stayed the same. Parents that became slab ids are part of the new counter and are subtracted again
+	template <typename TCounter, typename TItem>
+	constexpr WBytes GetSharedPtrCounterSize(std::size_t const ParentPointers, std::size_t const ParentIds = 0)
+	{
+		return sizeof(TTrafficCounter<TItem>) + ParentPointers * sizeof(std::shared_ptr<void>) + sizeof(TCounter)
+			- sizeof(TSlabCounter<TItem>) - ParentIds * sizeof(WTrafficItemId);
+	}
+} // namespace
+
 WMemoryStat WSystemMap::GetMemoryUsage()
 {
 	std::scoped_lock Lock(DataMutex);
 	WMemoryStat      Stats;
 	Stats.Name = "WSystemMap";
-	WMemoryStatEntry Apps{}, ProcessesEntry{}, SocketsEntry{}, TrafficItemsEntry{}, UDPPerConnectionCountersEntry{},
-		FiltersEntry{};
+	WMemoryStatEntry Apps{}, ProcessesEntry{}, SocketsEntry{}, UDPPerConnectionCountersEntry{}, FiltersEntry{},
+		CgroupsEntry{};
 
+	// The counters are accounted for below, the entries of the items only cover the items and how they're indexed
 	Apps.Name = "Applications";
 	Apps.Usage += sizeof(decltype(Applications));
 	for (auto const& AppPath : Applications | std::views::keys)
 	{
 		Apps.Usage += AppPath.capacity();
-		Apps.Usage += sizeof(WAppCounter);
 		Apps.Usage += sizeof(WApplicationItem);
 	}
 
 	ProcessesEntry.Name = "Processes";
 	ProcessesEntry.Usage += sizeof(decltype(Processes));
-	ProcessesEntry.Usage += (sizeof(WProcessId) + sizeof(WProcessCounter) + sizeof(WProcessItem)) * Processes.size();
+	ProcessesEntry.Usage += (sizeof(WProcessId) + sizeof(WProcessItem)) * Processes.size();
 
 	SocketsEntry.Name = "Sockets";
 	SocketsEntry.Usage += sizeof(decltype(Sockets));
-	SocketsEntry.Usage += (sizeof(WSocketCookie) + sizeof(WSocketCounter) + sizeof(WSocketItem)) * Sockets.size();
+	SocketsEntry.Usage += (sizeof(WSocketCookie) + sizeof(WSocketItem)) * Sockets.size();
+	SocketsEntry.Usage += sizeof(decltype(PortSockets));
+	for (auto const& Cookies : PortSockets | std::views::values)
+	{
+		SocketsEntry.Usage += sizeof(uint16_t) + sizeof(Cookies) + Cookies.capacity() * sizeof(WSocketCookie);
+	}
 
 	UDPPerConnectionCountersEntry.Name = "UDP connections";
+	std::size_t TupleCount{};
 	for (auto const& Socket : Sockets | std::views::values)
 	{
+		TupleCount += Socket->UDPPerConnectionCounters.size();
 		UDPPerConnectionCountersEntry.Usage +=
-			Socket->UDPPerConnectionCounters.size() * (sizeof(WEndpoint) + sizeof(WTupleCounter) + sizeof(WTupleItem));
+			Socket->UDPPerConnectionCounters.size() * (sizeof(WEndpoint) + sizeof(WTupleItem));
+		UDPPerConnectionCountersEntry.Usage += Socket->PeerLru.size() * (sizeof(WEndpoint) + sizeof(void*) * 2);
 	}
 
 	FiltersEntry.Name = "Filters";
 	FiltersEntry.Usage = sizeof(decltype(FilterCounters));
-	FiltersEntry.Usage += sizeof(WFilterCounter) * FilterCounters.size();
 	FiltersEntry.Usage += sizeof(WFilterItem) * FilterCounters.size();
-
-	TrafficItemsEntry.Name = "All traffic items";
-	TrafficItemsEntry.Usage += sizeof(decltype(TrafficItems));
-	TrafficItemsEntry.Usage += (sizeof(WTrafficItemId) + sizeof(ITrafficItem)) * TrafficItems.size();
+	FiltersEntry.Usage += FilterEngine.GetMemoryUsage();
+
+	CgroupsEntry.Name = "Cgroups";
+	CgroupsEntry.Usage = sizeof(decltype(Cgroups)) + CgroupResolver.GetMemoryUsage();
+	for (auto const& Cgroup : Cgroups | std::views::values)
+	{
+		CgroupsEntry.Usage += sizeof(uint64_t) + sizeof(WCgroupItem);
+		CgroupsEntry.Usage += Cgroup->TrafficItem->Name.capacity();
+	}
+
+	// The counters as they are, with their state, parents and the items for each id in the slab
+	auto const&      CounterSlab = WCounterSlab::GetInstance();
+	WMemoryStatEntry SlabLayoutEntry{};
+	SlabLayoutEntry.Name = fmt::format("Counters in the slab ({} of {} slots used)", CounterSlab.GetLiveCount(),
+		CounterSlab.GetSlotCount());
+	SlabLayoutEntry.Usage = CounterSlab.GetAllocatedBytes() + sizeof(TrafficCounter)
+		+ Applications.size() * (sizeof(WAppCounter) + SharedControlBlockSize)
+		+ Processes.size() * (sizeof(WProcessCounter) + SharedControlBlockSize)
+		+ Sockets.size() * (sizeof(WSocketCounter) + SharedControlBlockSize)
+		+ TupleCount * (sizeof(WTupleCounter) + SharedControlBlockSize)
+		+ FilterCounters.size() * sizeof(WFilterCounter)
+		+ Cgroups.size() * (sizeof(WCgroupCounter) + SharedControlBlockSize);
+
+	// The same counters with the state in each of them, a shared pointer to their parents and a map from id to item
+	constexpr WBytes IdMapNodeSize =
+		sizeof(void*) * 2 + sizeof(WTrafficItemId) + sizeof(std::shared_ptr<ITrafficItem>); // incl. bucket
+	WMemoryStatEntry SharedPtrLayoutEntry{};
+	SharedPtrLayoutEntry.Name = "Counters as a shared_ptr graph (for comparison, not in use)";
+	SharedPtrLayoutEntry.bComparison = true;
+	SharedPtrLayoutEntry.Usage = sizeof(TTrafficCounter<WSystemItem>)
+		+ Applications.size() * (GetSharedPtrCounterSize<WAppCounter, WApplicationItem>(0) + SharedControlBlockSize)
+		+ Processes.size() * (GetSharedPtrCounterSize<WProcessCounter, WProcessItem>(1) + SharedControlBlockSize)
+		+ Sockets.size() * (GetSharedPtrCounterSize<WSocketCounter, WSocketItem>(1) + SharedControlBlockSize)
+		+ TupleCount * (GetSharedPtrCounterSize<WTupleCounter, WTupleItem>(1, 1) + SharedControlBlockSize)
+		+ FilterCounters.size() * GetSharedPtrCounterSize<WFilterCounter, WFilterItem>(0)
+		+ Cgroups.size() * (GetSharedPtrCounterSize<WCgroupCounter, WCgroupItem>(0) + SharedControlBlockSize)
+		+ sizeof(std::unordered_map<WTrafficItemId, std::shared_ptr<ITrafficItem>>)
+		+ CounterSlab.GetLiveCount() * IdMapNodeSize;
 
 	Stats.ChildEntries.emplace_back(Apps);
 	Stats.ChildEntries.emplace_back(ProcessesEntry);
 	Stats.ChildEntries.emplace_back(SocketsEntry);
-	Stats.ChildEntries.emplace_back(TrafficItemsEntry);
 	Stats.ChildEntries.emplace_back(UDPPerConnectionCountersEntry);
 	Stats.ChildEntries.emplace_back(FiltersEntry);
+	Stats.ChildEntries.emplace_back(CgroupsEntry);
+	Stats.ChildEntries.emplace_back(SlabLayoutEntry);
+	Stats.ChildEntries.emplace_back(SharedPtrLayoutEntry);
 	return Stats;
 }
 
@@ -1127,32 +1628,61 @@ void WSystemMap::Cleanup()
 
 	auto OldSocketCount = Sockets.size();
 	auto OldProcessCount = Processes.size();
-	auto OldTrafficItemCount = TrafficItems.size();
+	auto OldTrafficItemCount = WCounterSlab::GetInstance().GetLiveCount();
 
-	for (auto ProcessIt = Processes.begin(); ProcessIt != Processes.end();)
+	auto& ProcessInfoCache = WProcessInfoCache::GetInstance();
+
+	// Without exit notifications from the kernel (or if some were lost) we have to check every process
+	bool const bCheckAllProcesses = !ProcessInfoCache.HasExitNotifications() || ProcessInfoCache.TakeResyncRequest();
+	auto const ExitedProcesses = ProcessInfoCache.TakeExitedProcesses();
+	if (bCheckAllProcesses)
 	{
-		auto const PID = ProcessIt->first;
-		if (!WFilesystem::IsProcessRunning(PID) && !ProcessIt->second->IsMarkedForRemoval())
+		for (auto const& [PID, Process] : Processes)
 		{
-			ProcessIt->second->MarkForRemoval();
-			MapUpdate.MarkItemForRemoval(ProcessIt->second->TrafficItem->ItemId);
+			if (!WFilesystem::IsProcessRunning(PID))
+			{
+				MarkProcessForRemoval(Process);
+			}
+		}
+	}
+	else
+	{
+		for (auto const PID : ExitedProcesses)
+		{
+			if (auto const It = Processes.find(PID); It != Processes.end())
+			{
+				MarkProcessForRemoval(It->second);
+			}
 		}
+	}
 
+	// Sockets inherited by a forked child, they can only be moved once we're done iterating over the processes
+	std::vector<std::pair<WOrphanedSocket, WProcessId>> InheritedSockets{};
+
+	for (auto ProcessIt = Processes.begin(); ProcessIt != Processes.end();)
+	{
 		if (auto const& Process = ProcessIt->second; Process->DueForRemoval())
 		{
 			bRemovedAny = true;
 			spdlog::debug("Removing process {}.", ProcessIt->first);
 			TrafficCounter.PushIncomingTraffic(0); // Force state update
-			Process->ParentApp->PushIncomingTraffic(0);
+			auto const App = FindApp(Process->GetAppItem());
+			if (App)
+			{
+				App->PushIncomingTraffic(0);
+			}
 
 			// If this process exited, but there are still open sockets left,
-			// they most likely now belong to a child process. Since those
-			// processes might be running as root, and we are not running as root
-			// we can't look them up via /proc/. So instead we sent these endpoints
+			// they most likely now belong to a child process. If the kernel told us
+			// about the fork, the oldest child that is still running gets them for now. That's
+			// only a guess, the sockets move to whichever process uses them next (see MapSocket).
+			// Otherwise (the fork happened before the daemon started, or the eBPF process
+			// events aren't available) the child processes might be running as root, and we are not running as root
+			// so we can't look them up via /proc/. So instead we sent these endpoints
 			// to the ip link process which does run as root, which will check
-			// what processes (if any) own these ports now. Not exactly a good
-			// solution but the best I could think of for now.
+			// what processes (if any) own these ports now.
 			WLookupEndpointsMsg LookupMsg{};
+			auto const          Heir = FindForkHeir(ProcessIt->first);
 
 			// When cleaning up a process, we have to
 			//  - Remove all its sockets from the Sockets map
@@ -1162,36 +1692,49 @@ void WSystemMap::Cleanup()
 			//  - Reparent any leftover sockets in case this process forked
 			for (auto const& [SocketCookie, Socket] : Process->TrafficItem->Sockets)
 			{
-				TrafficItems.erase(Socket->ItemId);
 				MapUpdate.AddItemRemoval(Socket->ItemId);
 				if (auto SocketCounter = Sockets.find(SocketCookie); SocketCounter != Sockets.end())
 				{
-					if (Socket->ConnectionState != ESocketConnectionState::Closed)
+					if (Socket->ConnectionState != ESocketConnectionState::Closed && App)
 					{
-						spdlog::info("Forked socket {} for {}", Process->ParentApp->TrafficItem->ApplicationName,
+						spdlog::info("Forked socket {} for {}", App->TrafficItem->ApplicationName,
 							Socket->SocketTuple.ToString());
 						// This process exited, but the socket was not closed via the close event sent from ebppf
 						// that indicates that a forked child process owns the socket now
-						OrphanedSockets[Socket->SocketTuple.LocalEndpoint] = SocketCounter->second;
-						LookupMsg.Endpoints.emplace_back(Socket->SocketTuple.LocalEndpoint);
+						WOrphanedSocket Orphan{ .Socket = SocketCounter->second, .App = App };
+						if (Heir != 0)
+						{
+							InheritedSockets.emplace_back(std::move(Orphan), Heir);
+						}
+						else
+						{
+							OrphanedSockets[Socket->SocketTuple.LocalEndpoint] = std::move(Orphan);
+							LookupMsg.Endpoints.emplace_back(Socket->SocketTuple.LocalEndpoint);
+						}
 					}
 					for (auto const& Tuple : SocketCounter->second->UDPPerConnectionCounters | std::views::values)
 					{
-						TrafficItems.erase(Tuple->TrafficItem->ItemId);
 						MapUpdate.AddItemRemoval(Tuple->TrafficItem->ItemId);
 						WNetworkEvents::GetInstance().OnUDPTupleRemoved(Tuple);
 					}
-					SocketCounter->second->UDPPerConnectionCounters.clear();
+					SocketCounter->second->ClearPeers();
 					WNetworkEvents::GetInstance().OnSocketRemoved(SocketCounter->second);
 				}
 				Socket->UDPPerConnectionTraffic.clear();
-				Sockets.erase(SocketCookie);
+				EraseSocket(SocketCookie);
+			}
+			if (!LookupMsg.Endpoints.empty())
+			{
+				WIPLink::GetInstance().SendLookupMessage(LookupMsg);
 			}
-			WIPLink::GetInstance().SendLookupMessage(LookupMsg);
 			WNetworkEvents::GetInstance().OnProcessRemoved(Process);
-			Process->ParentApp->TrafficItem->Processes.erase(ProcessIt->first);
+			ProcessInfoCache.Forget(ProcessIt->first);
+			ForkedChildren.erase(ProcessIt->first);
+			if (App)
+			{
+				App->TrafficItem->Processes.erase(ProcessIt->first);
+			}
 			MapUpdate.AddItemRemoval(ProcessIt->second->TrafficItem->ItemId);
-			TrafficItems.erase(Process->TrafficItem->ItemId);
 			ProcessIt = Processes.erase(ProcessIt);
 		}
 		else
@@ -1200,6 +1743,12 @@ void WSystemMap::Cleanup()
 		}
 	}
 
+	for (auto const& [Orphan, Heir] : InheritedSockets)
+	{
+		AdoptOrphanedSocket(Orphan, Heir);
+		Orphan.Socket->bGuessedOwner = true;
+	}
+
 	// Re-fetch all currently used sockets from /proc/
 	SocketStateParser.ParseData();
 
@@ -1249,25 +1798,27 @@ void WSystemMap::Cleanup()
 			{
 				WNetworkEvents::GetInstance().OnUDPTupleRemoved(Tuple);
 			}
-			Socket->ParentProcess->TrafficItem->Sockets.erase(SocketIt->first);
-			TrafficItems.erase(Socket->TrafficItem->ItemId);
+			if (auto const ProcessItem = Socket->GetProcessItem())
+			{
+				ProcessItem->Sockets.erase(SocketIt->first);
+			}
 			MapUpdate.AddItemRemoval(Socket->TrafficItem->ItemId);
 			for (auto const& TupleCounter : Socket->UDPPerConnectionCounters | std::views::values)
 			{
-				TrafficItems.erase(TupleCounter->TrafficItem->ItemId);
 				MapUpdate.AddItemRemoval(TupleCounter->TrafficItem->ItemId);
 			}
-			Socket->UDPPerConnectionCounters.clear();
+			Socket->ClearPeers();
 			Socket->TrafficItem->UDPPerConnectionTraffic.clear();
+			UnindexSocketPort(*Socket);
 			SocketIt = Sockets.erase(SocketIt);
 		}
 		// Remove sockets in an unknown state
 		else if (IsStaleSocket(Socket))
 		{
 			// todo: ideally we would never end up here
+			auto const AppItem = Socket->GetAppItem();
 			spdlog::debug("Removing unknown socket with id {}, tuple: {}, app: {}", SocketIt->first,
-				Socket->TrafficItem->SocketTuple.ToString(),
-				Socket->ParentProcess->ParentApp->TrafficItem->ApplicationName);
+				Socket->TrafficItem->SocketTuple.ToString(), AppItem ? AppItem->ApplicationName : "?");
 			Socket->MarkForRemoval();
 		}
 		else
@@ -1282,11 +1833,10 @@ void WSystemMap::Cleanup()
 						TupleIt->first.ToString());
 					bRemovedAny = true;
 					WNetworkEvents::GetInstance().OnUDPTupleRemoved(TupleCounter);
-					TrafficItems.erase(TupleCounter->TrafficItem->ItemId);
 					MapUpdate.AddItemRemoval(TupleCounter->TrafficItem->ItemId);
 					Socket->TrafficItem->EraseTuple(TupleIt->first);
 
-					TupleIt = Socket->UDPPerConnectionCounters.erase(TupleIt);
+					TupleIt = Socket->ErasePeer(TupleIt);
 				}
 				else
 				{
@@ -1305,9 +1855,14 @@ void WSystemMap::Cleanup()
 			bRemovedAny = true;
 			spdlog::debug("Removing application '{}' ({}).", AppIt->second->TrafficItem->ApplicationName, AppIt->first);
 			MapUpdate.AddItemRemoval(AppIt->second->TrafficItem->ItemId);
-			TrafficItems.erase(AppIt->second->TrafficItem->ItemId);
+			if (!LabelledApps.contains(AppIt->first))
+			{
+				RemovedOtherApps.Download += AppIt->second->TrafficItem->TotalDownloadBytes;
+				RemovedOtherApps.Upload += AppIt->second->TrafficItem->TotalUploadBytes;
+			}
 			SystemItem->Applications.erase(AppIt->first);
 			AppIt = Applications.erase(AppIt);
+			WAppIconAtlasBuilder::GetInstance().MarkDirty(); // so the icon slot is freed
 		}
 		else
 		{
@@ -1315,6 +1870,12 @@ void WSystemMap::Cleanup()
 		}
 	}
 
+	CleanupCgroups();
+
+	// Counters that were removed above might still be referenced elsewhere, their slots are
+	// only free once the last reference is gone
+	WCounterSlab::GetInstance().Reclaim();
+
 	if (bRemovedAny)
 	{
 		auto NodeCount = Applications.size() + Processes.size() + Sockets.size();
@@ -1325,10 +1886,11 @@ void WSystemMap::Cleanup()
 		LastCleanupMessageTime = WTime::GetEpochSeconds();
 		auto DiffSocketCount = OldSocketCount - Sockets.size();
 		auto DiffProcessCount = OldProcessCount - Processes.size();
-		auto DiffTrafficItemCount = OldTrafficItemCount - TrafficItems.size();
+		auto NewTrafficItemCount = WCounterSlab::GetInstance().GetLiveCount();
+		auto DiffTrafficItemCount = OldTrafficItemCount - NewTrafficItemCount;
 
 		spdlog::debug("Cleanup removed {} sockets({} -> {}), {} processes ({} -> {}), and {} traffic items ({} -> {}).",
 			DiffSocketCount, OldSocketCount, Sockets.size(), DiffProcessCount, OldProcessCount, Processes.size(),
-			DiffTrafficItemCount, OldTrafficItemCount, TrafficItems.size());
+			DiffTrafficItemCount, OldTrafficItemCount, NewTrafficItemCount);
 	}
 }
\ No newline at end of file
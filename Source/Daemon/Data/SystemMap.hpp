@@ -7,20 +7,41 @@
 #include <memory>
 #include <unordered_map>
 #include <mutex>
-#include <atomic>
+#include <span>
+#include <vector>
 
 #include "EBPFCommon.h"
 #include "Types.hpp"
 #include "Singleton.hpp"
-#include "TrafficCounter.hpp"
 #include "MemoryStats.hpp"
 #include "Data/SystemItem.hpp"
 #include "Data/TrafficTreeUpdate.hpp"
+#include "Data/CounterSlab.hpp"
 #include "Data/Counters.hpp"
 #include "Data/MapUpdate.hpp"
 #include "Data/SocketStateParser.hpp"
+#include "Data/CgroupResolver.hpp"
+#include "Data/TrafficMetrics.hpp"
+#include "EBPF/CgroupTrafficMap.hpp"
+#include "EBPF/UdpFlowMap.hpp"
 
 static constexpr WSocketCookie kSyntheticCookieBase = static_cast<WSocketCookie>(1) << 63;
+
+// What the system map keeps across a hot restart, see WHotRestart.
+// The totals are part of the items, the traffic of the current time window is lost. The items get new ids.
+struct WSystemMapSnapshot
+{
+	std::shared_ptr<WSystemItem>                            SystemItem{};
+	std::unordered_map<WProcessId, std::vector<WProcessId>> ForkedChildren{};
+	std::unordered_map<WProcessId, WProcessId>              ForkParents{};
+
+	template <class Archive>
+	void serialize(Archive& archive)
+	{
+		archive(SystemItem, ForkedChildren, ForkParents);
+	}
+};
+
 /**
  * Both the client and the daemon need a tree of applications, processes, and sockets,
  * but the daemon also needs to maintain global traffic counters and mappings.
@@ -30,6 +51,8 @@ static constexpr WSocketCookie kSyntheticCookieBase = static_cast<WSocketCookie>
  *
  * The Other tree is built using the maps defined in this class each node containing
  * a traffic counter and a shared pointer to the corresponding node in the SystemItem tree.
+ * The state of the traffic counters and how they relate to each other lives in the counter slab, the id of an
+ * item is its handle into the slab, see WCounterSlab.
  */
 class WSystemMap : public TSingleton<WSystemMap>, public IMemoryTrackable
 {
@@ -38,17 +61,50 @@ class WSystemMap : public TSingleton<WSystemMap>, public IMemoryTrackable
 	WMapUpdate         MapUpdate{};
 	WSec               LastCleanupMessageTime{};
 
-	std::atomic<WTrafficItemId>  NextItemId{ 1 }; // 0 is the root item
 	std::shared_ptr<WSystemItem> SystemItem = std::make_shared<WSystemItem>();
-	TTrafficCounter<WSystemItem> TrafficCounter{ SystemItem };
+	TSlabCounter<WSystemItem>    TrafficCounter{ SystemItem };
 
+	// Indexed by the bit of the filter in WFilterMask
 	std::vector<std::unique_ptr<WFilterCounter>> FilterCounters{};
+	WFilterEngine                                FilterEngine{};
 
 	std::unordered_map<std::string, std::shared_ptr<WAppCounter>>      Applications{};
 	std::unordered_map<WProcessId, std::shared_ptr<WProcessCounter>>   Processes{};
 	std::unordered_map<WSocketCookie, std::shared_ptr<WSocketCounter>> Sockets{};
-	std::unordered_map<WTrafficItemId, std::shared_ptr<ITrafficItem>>  TrafficItems{};
-	std::unordered_map<WEndpoint, std::shared_ptr<WSocketCounter>>     OrphanedSockets{};
+
+	// Sockets of an exited process, waiting for the IP link process to tell who owns their local endpoint now.
+	// The process might be gone for good by then, so they hold on to the application
+	struct WOrphanedSocket
+	{
+		std::shared_ptr<WSocketCounter> Socket;
+		std::shared_ptr<WAppCounter>    App;
+	};
+	std::unordered_map<WEndpoint, WOrphanedSocket> OrphanedSockets{};
+
+	// Only filled if the eBPF program counts traffic per cgroup, independent of the application tree
+	std::unordered_map<uint64_t, std::shared_ptr<WCgroupCounter>> Cgroups{};
+	WCgroupResolver                                               CgroupResolver;
+	WMsec                                                         LastCgroupCheckTime{};
+
+	// Cookies of the sockets in Sockets by local port, so close events and merging synthetic
+	// sockets don't have to look at every socket. Processes already list their sockets by cookie.
+	std::unordered_map<uint16_t, std::vector<WSocketCookie>> PortSockets{};
+
+	// Set if the tree was restored from a snapshot instead of being built from /proc/
+	bool bRestoredFromSnapshot{};
+
+	// Applications that got a label in the metrics keep it (and their last totals once they are removed) until the
+	// daemon restarts. Otherwise their traffic would move in and out of waechter_other_apps_bytes whenever the top
+	// applications change, and neither counter would be monotonic
+	std::unordered_map<std::string, WTrafficMetricsEntry> LabelledApps{};
+	WTrafficMetricsEntry                                  RemovedOtherApps{};
+
+	// Fork relations of processes that own sockets (or descend from one that did), reported by the kernel.
+	// Used to hand the sockets of an exited process to the child that inherited them.
+	// Children are listed in fork order and are only alive while they're in ForkParents.
+	static constexpr std::size_t                            MaxForkRelations = 1 << 16;
+	std::unordered_map<WProcessId, std::vector<WProcessId>> ForkedChildren{};
+	std::unordered_map<WProcessId, WProcessId>              ForkParents{};
 
 	std::shared_ptr<WSocketCounter> FindOrMapSocket(
 		WSocketCookie SocketCookie, std::shared_ptr<WProcessCounter> const& ParentProcess);
@@ -57,17 +113,67 @@ class WSystemMap : public TSingleton<WSystemMap>, public IMemoryTrackable
 			std::string const& ExePath, std::string const& CommandLine, std::string const& AppName);
 
 	void Cleanup();
+	void CleanupCgroups();
+
+	std::shared_ptr<WCgroupCounter> FindOrMapCgroup(uint64_t CgroupId);
+
+	void MarkProcessForRemoval(std::shared_ptr<WProcessCounter> const& Process);
+
+	// Returns the first forked child of the process that is still running, or 0 if there is none. Only a guess of who
+	// inherited the sockets, see WSocketCounter::bGuessedOwner
+	[[nodiscard]] WProcessId FindForkHeir(WProcessId PID) const;
+
+	// The application of the closest known ancestor, for children whose binary can't be read from /proc/
+	[[nodiscard]] std::shared_ptr<WAppCounter> FindForkedApplication(WProcessId PID) const;
+
+	// Whether the PID of the event is the process that used the socket, and not whoever the kernel was running
+	[[nodiscard]] static bool IsOwnerEvent(uint8_t EventType);
+
+	void MoveSocketToProcess(
+		std::shared_ptr<WSocketCounter> const& Socket, std::shared_ptr<WProcessCounter> const& Process);
+
+	// Null if the app was removed in the meantime
+	[[nodiscard]] std::shared_ptr<WAppCounter> FindApp(std::shared_ptr<WApplicationItem> const& AppItem) const;
+
+	void AdoptOrphanedSocket(WOrphanedSocket const& Orphan, WProcessId NewParentProcess);
 
 	void DoPacketParsing(WSocketEvent const& Event, std::shared_ptr<WSocketCounter> const& SockCounter);
 
+	// Fills in what's still missing of the socket tuple from the endpoints of a packet
+	void UpdateSocketTuple(WSocketCounter& SockCounter, EProtocol::Type Protocol, WEndpoint const& LocalEndpoint,
+		WEndpoint const& RemoteEndpoint);
+
 	std::shared_ptr<WSocketCounter> MapSocketFromTrafficEvent(WSocketEvent const& Event);
+	std::shared_ptr<WSocketCounter> MapSocketFromLocalEndpoint(
+		WSocketEvent const& Event, WEndpoint const& LocalEndpoint, EProtocol::Type Protocol);
 
 	void PushTrafficForSocket(WSocketEvent const& Event, std::shared_ptr<WSocketCounter> const& Socket) const;
 
+	// Counts the traffic for the UDP tuple of the remote endpoint (and its filters), not for the socket itself
+	void PushTupleTraffic(std::shared_ptr<WSocketCounter> const& SockCounter, WEndpoint const& RemoteEndpoint,
+		uint8_t Direction, WBytes Bytes);
+
+	void PushFilterTraffic(WFilterMask Mask, uint8_t Direction, WBytes Bytes) const;
+
+	WFilterMask GetSocketFilterMask(WSocketCounter& Socket) const;
+	WFilterMask GetTupleFilterMask(WTupleCounter& Tuple) const;
+
+	std::shared_ptr<WTupleCounter> CreateUDPTupleCounter(
+		std::shared_ptr<WSocketCounter> const& SockCounter, WEndpoint const& Endpoint);
+	std::shared_ptr<WTupleCounter> GetOtherPeersCounter(std::shared_ptr<WSocketCounter> const& SockCounter);
 	std::shared_ptr<WTupleCounter> GetOrCreateUDPTupleCounter(
 		std::shared_ptr<WSocketCounter> const& SockCounter, WEndpoint const& Endpoint);
 
-	void RegisterDefaultFilters();
+	// Merges the traffic of a peer into the other peers tuple and removes it
+	void EvictPeer(std::shared_ptr<WSocketCounter> const& SockCounter, WSocketCounter::WPeerIterator It,
+		std::shared_ptr<WTupleCounter> const& OtherPeers);
+
+	void RegisterFilters();
+
+	// Moves the socket to the bucket of its current local port, cheap if the port didn't change
+	void IndexSocketPort(WSocketCounter& Socket);
+	void UnindexSocketPort(WSocketCounter& Socket);
+	void EraseSocket(WSocketCookie Cookie);
 
 public:
 	WSystemMap();
@@ -75,21 +181,24 @@ public:
 
 	std::mutex DataMutex;
 
-	WTrafficItemId GetNextItemId() { return NextItemId.fetch_add(1); }
-
 	std::shared_ptr<WSocketCounter> MapSocket(WSocketEvent const& Event, WProcessId PID, bool bSilentFail = false);
 
 	void AddExistingSockets();
 	void ProcessInitialApps();
 
+	// The snapshot shares the items with the system map, so it has to be written while DataMutex is held
+	WSystemMapSnapshot CreateSnapshot();
+
+	// Used instead of AddExistingSockets after a hot restart
+	void RestoreSnapshot(WSystemMapSnapshot const& Snapshot);
+
 	void ReparentOrphanedSocket(WEndpoint const& Endpoint, WProcessId NewParentProcess);
 
-	void MergeSyntheticSocket(std::shared_ptr<WSocketCounter> const& Socket);
+	// Process lifecycle events from the eBPF program
+	void HandleProcessFork(WProcessId ParentPID, WProcessId ChildPID);
+	void HandleProcessExit(WProcessId PID);
 
-	// After an accept event, re-check /proc to find the worker that actually owns the
-	// accepted socket's fd, and move the socket to that process if it differs from the
-	// master PID that was stored in port_to_pid at bind() time.
-	void ReparentAcceptedSocket(std::shared_ptr<WSocketCounter> const& Socket);
+	void MergeSyntheticSocket(std::shared_ptr<WSocketCounter> const& Socket);
 
 	void RefreshAllTrafficCounters();
 
@@ -97,37 +206,17 @@ public:
 
 	void PushOutgoingTraffic(WSocketEvent const& Event);
 
-	void MarkSocketForRemoval(WSocketEvent const& Event)
-	{
-		if (auto const It = Sockets.find(Event.Cookie); It != Sockets.end())
-		{
-			if (Event.Data.SocketCloseEventData.LocalPort > 0)
-			{
-				// todo: iterating over all sockets is a bit dumb since this really
-				//       only affects listen sockets that were opened before the daemon started
-				//       but it's probably not too much of an issue
-				for (auto const& Sock : Sockets | std::views::values)
-				{
-					if (Sock->TrafficItem->SocketTuple.LocalEndpoint.Port == Event.Data.SocketCloseEventData.LocalPort)
-					{
-						Sock->MarkForRemoval();
-						Sock->TrafficItem->ConnectionState = ESocketConnectionState::Closed;
-						MapUpdate.MarkItemForRemoval(Sock->TrafficItem->ItemId);
-						Sock->ParentProcess->PushIncomingTraffic(0); // Force state update
-						Sock->ParentProcess->ParentApp->PushOutgoingTraffic(0);
-						TrafficCounter.PushIncomingTraffic(0);
-						break;
-					}
-				}
-			}
-			It->second->MarkForRemoval();
-			It->second->TrafficItem->ConnectionState = ESocketConnectionState::Closed;
-			MapUpdate.MarkItemForRemoval(It->second->TrafficItem->ItemId);
-			It->second->ParentProcess->PushIncomingTraffic(0); // Force state update
-			It->second->ParentProcess->ParentApp->PushOutgoingTraffic(0);
-			TrafficCounter.PushIncomingTraffic(0);
-		}
-	}
+	void MarkSocketForRemoval(WSocketEvent const& Event);
+
+	// UDP traffic counted by the eBPF program, see WUdpFlowMap
+	void HandleUDPPeer(WSocketEvent const& Event);
+	void PushUdpFlowTraffic(std::span<WUdpFlowTraffic const> Flows);
+
+	// Traffic per cgroup counted by the eBPF program, see WCgroupTrafficMap
+	void PushCgroupTraffic(std::span<WCgroupTraffic const> Traffic);
+
+	// Loopback traffic the eBPF program was told to skip, only counted for the filters that match loopback addresses
+	void PushExcludedLoopbackTraffic(WBytes Download, WBytes Upload);
 
 	double GetDownloadSpeed() const { return SystemItem->DownloadSpeed; }
 
@@ -139,18 +228,19 @@ public:
 
 	std::vector<std::string> GetActiveApplicationPaths();
 
+	// Totals of the system, the (at most MaxApps) labelled applications and the filters
+	WTrafficMetrics GetTrafficMetrics(std::size_t MaxApps);
+
 	WTrafficTreeUpdates const& GetUpdates() { return MapUpdate.GetUpdates(); }
 
 	WMapUpdate& GetMapUpdate() { return MapUpdate; }
 
-	std::shared_ptr<ITrafficItem> GetTrafficItemById(WTrafficItemId const ItemId)
+	// Peers of a socket that weren't sent with the traffic tree
+	WPeerPage GetPeerPage(WPeerPageRequest const& Request);
+
+	static std::shared_ptr<ITrafficItem> GetTrafficItemById(WTrafficItemId const ItemId)
 	{
-		auto const It = TrafficItems.find(ItemId);
-		if (It != TrafficItems.end())
-		{
-			return It->second;
-		}
-		return {};
+		return WCounterSlab::GetInstance().GetItem(ItemId);
 	}
 
 	WMemoryStat GetMemoryUsage() override;
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+
+#include "Types.hpp"
+
+struct WTrafficMetricsEntry
+{
+	std::string Name{};
+	std::string Path{}; // Only set for applications
+	WBytes      Download{};
+	WBytes      Upload{};
+};
+
+// Copy of the byte counters for the metrics endpoint, taken once per refresh so scrapes don't need WSystemMap
+struct WTrafficMetrics
+{
+	WTrafficMetricsEntry              System{};
+	std::vector<WTrafficMetricsEntry> Apps{}; // The ones that got a label, sorted by traffic
+	WTrafficMetricsEntry              OtherApps{};
+	std::size_t                       OtherAppCount{};
+	std::vector<WTrafficMetricsEntry> Filters{};
+};
@@ -392,6 +392,93 @@ namespace Schema
       };
     };
   };
+  namespace ResolvedHost_
+  {
+    struct Family
+    {
+      struct _alias_t
+      {
+        static constexpr const char _literal[] =  "Family";
+        using _name_t = sqlpp::make_char_sequence<sizeof(_literal), _literal>;
+        template<typename T>
+        struct _member_t
+          {
+            T Family;
+            T& operator()() { return Family; }
+            const T& operator()() const { return Family; }
+          };
+      };
+      using _traits = sqlpp::make_traits<sqlpp::integer, sqlpp::tag::require_insert>;
+    };
+    struct IPAddress
+    {
+      struct _alias_t
+      {
+        static constexpr const char _literal[] =  "IPAddress";
+        using _name_t = sqlpp::make_char_sequence<sizeof(_literal), _literal>;
+        template<typename T>
+        struct _member_t
+          {
+            T IPAddress;
+            T& operator()() { return IPAddress; }
+            const T& operator()() const { return IPAddress; }
+          };
+      };
+      using _traits = sqlpp::make_traits<sqlpp::blob, sqlpp::tag::require_insert>;
+    };
+    struct Hostname
+    {
+      struct _alias_t
+      {
+        static constexpr const char _literal[] =  "Hostname";
+        using _name_t = sqlpp::make_char_sequence<sizeof(_literal), _literal>;
+        template<typename T>
+        struct _member_t
+          {
+            T Hostname;
+            T& operator()() { return Hostname; }
+            const T& operator()() const { return Hostname; }
+          };
+      };
+      using _traits = sqlpp::make_traits<sqlpp::text, sqlpp::tag::require_insert>;
+    };
+    struct ExpiresAt
+    {
+      struct _alias_t
+      {
+        static constexpr const char _literal[] =  "ExpiresAt";
+        using _name_t = sqlpp::make_char_sequence<sizeof(_literal), _literal>;
+        template<typename T>
+        struct _member_t
+          {
+            T ExpiresAt;
+            T& operator()() { return ExpiresAt; }
+            const T& operator()() const { return ExpiresAt; }
+          };
+      };
+      using _traits = sqlpp::make_traits<sqlpp::integer, sqlpp::tag::require_insert>;
+    };
+  } // namespace ResolvedHost_
+
+  struct ResolvedHost: sqlpp::table_t<ResolvedHost,
+               ResolvedHost_::Family,
+               ResolvedHost_::IPAddress,
+               ResolvedHost_::Hostname,
+               ResolvedHost_::ExpiresAt>
+  {
+    struct _alias_t
+    {
+      static constexpr const char _literal[] =  "ResolvedHost";
+      using _name_t = sqlpp::make_char_sequence<sizeof(_literal), _literal>;
+      template<typename T>
+      struct _member_t
+      {
+        T ResolvedHost;
+        T& operator()() { return ResolvedHost; }
+        const T& operator()() const { return ResolvedHost; }
+      };
+    };
+  };
   namespace Rule_
   {
     struct ID
@@ -18,6 +18,7 @@
 #include "Buffer.hpp"
 #include "Format.hpp"
 #include "Messages.hpp"
+#include "PipelineMetricsCollector.hpp"
 #include "Data/IP2Asn.hpp"
 #include "Data/SystemMap.hpp"
 #include "Data/Stats.hpp"
@@ -114,6 +115,7 @@ void WStatsManager::MakeSnapshot()
 		spdlog::debug("Making snapshot of local snapshot: {} apps", LocalSnapshot.Apps.size());
 	}
 
+	WStageTimer const DbWriteTimer(EPipelineStage::DbWrite);
 	WDbManager::GetInstance().Run([&](auto& DbConn) {
 		ZoneScopedN("MakeSnapshot - DB write");
 		constexpr Db::Schema::Asn             Asn;
@@ -236,8 +238,8 @@ TPromise<std::string> WStatsManager::RequestStats(WBuffer const& Request, EMessa
 	return Data.Response;
 }
 
-static void ProcessHostHistoryRequest(WConnectionHistoryRequest const& Request, WConnectionHistoryResponse& Response,
-	TPromise<std::string> const& Promise, auto& DbConn)
+static void ProcessHostHistoryRequest(
+	WConnectionHistoryRequest const& Request, WConnectionHistoryResponse& Response, auto& DbConn)
 {
 	constexpr Db::Schema::TrafficItem            TrafficItem;
 	constexpr Db::Schema::Host                   Host;
@@ -249,7 +251,6 @@ static void ProcessHostHistoryRequest(WConnectionHistoryRequest const& Request,
 	if (Result.empty())
 	{
 		spdlog::info("No connection history data for {}", Request.HostTarget->ToString());
-		Promise.Finish("");
 		return;
 	}
 	HostID = static_cast<uint64_t>(Result.front().ID.value());
@@ -330,14 +331,13 @@ static void AppendEndpointHistoryEntries(TRows& Rows, WConnectionHistoryResponse
 }
 
 template <typename TQuery>
-static bool ResolveHistoryTargetId(TQuery const& Query, std::string const& TargetName,
-	TPromise<std::string> const& Promise, auto& DbConn, uint64_t& TargetID)
+static bool ResolveHistoryTargetId(
+	TQuery const& Query, std::string const& TargetName, auto& DbConn, uint64_t& TargetID)
 {
 	auto Result = DbConn(Query);
 	if (Result.empty())
 	{
 		spdlog::info("No connection history data for {}", TargetName);
-		Promise.Finish("");
 		return false;
 	}
 
@@ -345,8 +345,8 @@ static bool ResolveHistoryTargetId(TQuery const& Query, std::string const& Targe
 	return true;
 }
 
-static void ProcessAppHistoryRequest(WConnectionHistoryRequest const& Request, WConnectionHistoryResponse& Response,
-	TPromise<std::string> const& Promise, auto& DbConn)
+static void ProcessAppHistoryRequest(
+	WConnectionHistoryRequest const& Request, WConnectionHistoryResponse& Response, auto& DbConn)
 {
 	constexpr Db::Schema::Host                   Host;
 	constexpr Db::Schema::ConnectionHistoryEntry CE;
@@ -355,7 +355,7 @@ static void ProcessAppHistoryRequest(WConnectionHistoryRequest const& Request, W
 
 	if (!ResolveHistoryTargetId(
 			sqlpp::select(TrafficItem.ID).from(TrafficItem).where(TrafficItem.Name == Request.TargetName),
-			Request.TargetName, Promise, DbConn, ItemID))
+			Request.TargetName, DbConn, ItemID))
 	{
 		return;
 	}
@@ -419,15 +419,14 @@ static void ProcessOrgHistoryRequest(
 	AppendEndpointHistoryEntries(Rows, Response);
 }
 
-static void ProcessAsnHistoryRequest(WConnectionHistoryRequest const& Request, WConnectionHistoryResponse& Response,
-	TPromise<std::string> const& Promise, auto& DbConn)
+static void ProcessAsnHistoryRequest(
+	WConnectionHistoryRequest const& Request, WConnectionHistoryResponse& Response, auto& DbConn)
 {
 	auto const AsnInt = WStringFormat::ParseInt(Request.TargetName.substr(4));
 
 	if (AsnInt == 0)
 	{
 		spdlog::error("Invalid ASN in history request: {}", Request.TargetName);
-		Promise.Finish("");
 		return;
 	}
 	constexpr Db::Schema::Asn                    Asn;
@@ -457,14 +456,15 @@ void WStatsManager::ProcessHistoryRequest(
 	Response.RequestId = Request.RequestId;
 	spdlog::info("Received stats request for {}", Request.TargetName);
 
+	// Targets without history are answered with an empty response
 	WDbManager::GetInstance().Run([&](auto& DbConn) {
 		if (Request.HostTarget)
 		{
-			ProcessHostHistoryRequest(Request, Response, Promise, DbConn);
+			ProcessHostHistoryRequest(Request, Response, DbConn);
 		}
 		else if (WStringFormat::StartsWith(Request.TargetName, "asn:"))
 		{
-			ProcessAsnHistoryRequest(Request, Response, Promise, DbConn);
+			ProcessAsnHistoryRequest(Request, Response, DbConn);
 		}
 		else if (WStringFormat::StartsWith(Request.TargetName, "org:"))
 		{
@@ -476,7 +476,7 @@ void WStatsManager::ProcessHistoryRequest(
 		}
 		else
 		{
-			ProcessAppHistoryRequest(Request, Response, Promise, DbConn);
+			ProcessAppHistoryRequest(Request, Response, DbConn);
 		}
 		Promise.Finish(SerializeMessage(MT_HistoryResponse, Response));
 	});
@@ -70,6 +70,12 @@ public:
 
 	void UpdateFilterStats(std::string const& FilterName, WBytes In, WBytes Out);
 
+	// Stored like filters, see WCgroupItem::GetStatsName
+	void UpdateCgroupStats(std::string const& StatsName, WBytes In, WBytes Out)
+	{
+		UpdateFilterStats(StatsName, In, Out);
+	}
+
 	void UpdateAppStats(
 		WTrafficItemId AppId, std::string const& ApplicationPath, WIPAddress const& RemoteHost, WBytes In, WBytes Out);
 
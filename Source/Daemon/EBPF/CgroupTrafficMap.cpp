@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "CgroupTrafficMap.hpp"
+
+#include <bpf/bpf.h>
+#include <bpf/libbpf.h>
+
+#include "spdlog/spdlog.h"
+#include "tracy/Tracy.hpp"
+
+WCgroupTrafficMap::WCgroupTrafficMap(bpf_map const* Map)
+{
+	if (!Map)
+	{
+		return;
+	}
+
+	auto const PossibleCpus = libbpf_num_possible_cpus();
+	if (PossibleCpus <= 0)
+	{
+		spdlog::error("Failed to get the number of CPUs: {}", PossibleCpus);
+		return;
+	}
+
+	MapFd = bpf_map__fd(Map);
+	CpuCount = static_cast<std::size_t>(PossibleCpus);
+	ValueBuffer.resize(CpuCount);
+}
+
+std::vector<WCgroupTraffic> WCgroupTrafficMap::Sweep()
+{
+	ZoneScopedN("WCgroupTrafficMap::Sweep");
+	std::vector<WCgroupTraffic> Traffic{};
+	std::vector<uint64_t>       IdleCgroups{};
+
+	std::scoped_lock Lock(Mutex);
+	++SweepGeneration;
+
+	// There are only a few hundred cgroups at most, no need for batched lookups
+	uint64_t CgroupId{};
+	int      Result = bpf_map_get_next_key(MapFd, nullptr, &CgroupId);
+	while (Result == 0)
+	{
+		if (bpf_map_lookup_elem(MapFd, &CgroupId, ValueBuffer.data()) == 0)
+		{
+			WBytes Download{};
+			WBytes Upload{};
+			for (auto const& Value : ValueBuffer)
+			{
+				Download += Value.DownloadBytes;
+				Upload += Value.UploadBytes;
+			}
+
+			auto& State = Cgroups[CgroupId];
+			// The entry was evicted or deleted and added again, the kernel started counting from zero
+			WCgroupTraffic Delta{};
+			Delta.CgroupId = CgroupId;
+			Delta.Download = Download >= State.Download ? Download - State.Download : Download;
+			Delta.Upload = Upload >= State.Upload ? Upload - State.Upload : Upload;
+			State.Download = Download;
+			State.Upload = Upload;
+			State.SweepGeneration = SweepGeneration;
+
+			if (Delta.Download != 0 || Delta.Upload != 0)
+			{
+				State.IdleSweeps = 0;
+				Traffic.push_back(Delta);
+			}
+			else if (++State.IdleSweeps >= MaxIdleSweeps)
+			{
+				IdleCgroups.push_back(CgroupId);
+			}
+		}
+
+		auto const Previous = CgroupId;
+		Result = bpf_map_get_next_key(MapFd, &Previous, &CgroupId);
+	}
+
+	// Deleting while iterating would restart the iteration
+	for (auto const Id : IdleCgroups)
+	{
+		bpf_map_delete_elem(MapFd, &Id);
+		Cgroups.erase(Id);
+	}
+
+	// Cgroups the kernel evicted from the LRU
+	std::erase_if(Cgroups, [this](auto const& Cgroup) { return Cgroup.second.SweepGeneration != SweepGeneration; });
+	return Traffic;
+}
+
+std::unordered_map<uint64_t, std::pair<WBytes, WBytes>> WCgroupTrafficMap::GetBaselines()
+{
+	std::scoped_lock                                        Lock(Mutex);
+	std::unordered_map<uint64_t, std::pair<WBytes, WBytes>> Baselines{};
+	for (auto const& [CgroupId, State] : Cgroups)
+	{
+		Baselines[CgroupId] = { State.Download, State.Upload };
+	}
+	return Baselines;
+}
+
+void WCgroupTrafficMap::RestoreBaselines(std::unordered_map<uint64_t, std::pair<WBytes, WBytes>> const& Baselines)
+{
+	std::scoped_lock Lock(Mutex);
+	for (auto const& [CgroupId, Totals] : Baselines)
+	{
+		auto& State = Cgroups[CgroupId];
+		State.Download = Totals.first;
+		State.Upload = Totals.second;
+		State.SweepGeneration = SweepGeneration;
+	}
+}
+
+WBytes WCgroupTrafficMap::GetMemoryUsage()
+{
+	std::scoped_lock Lock(Mutex);
+	return Cgroups.size() * (sizeof(uint64_t) + sizeof(WCgroupState) + sizeof(void*) * 2)
+		+ ValueBuffer.capacity() * sizeof(WCgroupTrafficValue);
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "EBPFCommon.h"
+#include "Types.hpp"
+
+struct bpf_map;
+
+// Traffic of a cgroup since the last sweep
+struct WCgroupTraffic
+{
+	uint64_t CgroupId{};
+	WBytes   Download{};
+	WBytes   Upload{};
+};
+
+/**
+ * Reads the per cgroup counters of the eBPF program. Like WUdpFlowMap the kernel only keeps running totals
+ * per CPU, so the last total of every cgroup is remembered. Cgroups without traffic for a while are deleted
+ * from the kernel map, which keeps it small on hosts where containers come and go.
+ */
+class WCgroupTrafficMap
+{
+	struct WCgroupState
+	{
+		WBytes   Download{};
+		WBytes   Upload{};
+		uint32_t IdleSweeps{};
+		uint32_t SweepGeneration{};
+	};
+
+	// One sweep per second
+	static constexpr uint32_t MaxIdleSweeps = 5 * 60;
+
+	int         MapFd{ -1 };
+	std::size_t CpuCount{ 1 };
+
+	std::mutex                                 Mutex;
+	std::unordered_map<uint64_t, WCgroupState> Cgroups{};
+	uint32_t                                   SweepGeneration{};
+
+	std::vector<WCgroupTrafficValue> ValueBuffer{}; // one value per possible CPU
+
+public:
+	explicit WCgroupTrafficMap(bpf_map const* Map);
+
+	[[nodiscard]] bool IsValid() const { return MapFd >= 0; }
+
+	std::vector<WCgroupTraffic> Sweep();
+
+	// Kernel totals (download, upload) of every cgroup at the last sweep, see WUdpFlowMap::GetBaselines
+	std::unordered_map<uint64_t, std::pair<WBytes, WBytes>> GetBaselines();
+	void RestoreBaselines(std::unordered_map<uint64_t, std::pair<WBytes, WBytes>> const& Baselines);
+
+	WBytes GetMemoryUsage();
+};
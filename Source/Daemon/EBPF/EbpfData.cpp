@@ -8,8 +8,67 @@
 WEbpfData::WEbpfData(WWaechterEbpf const& EbpfObj)
 {
 	SocketEvents = std::make_unique<TEbpfRingBuffer<WSocketEvent>>(EbpfObj.Skeleton->maps.socket_event_ring);
+	if (EbpfObj.Skeleton->rodata->DnsSnoopingEnabled)
+	{
+		DnsAnswers = std::make_unique<TEbpfRingBuffer<WDnsAnswerEvent>>(EbpfObj.Skeleton->maps.dns_answer_ring);
+	}
 	SocketRules = std::make_unique<TEbpfMap<WSocketCookie, WTrafficItemRulesBase>>(EbpfObj.Skeleton->maps.socket_rules);
+	SystemRules = std::make_unique<TEbpfMap<uint32_t, WTrafficItemRulesBase>>(EbpfObj.Skeleton->maps.system_rules);
+	if (EbpfObj.Skeleton->bss)
+	{
+		SocketRulesGeneration = const_cast<uint32_t*>(&EbpfObj.Skeleton->bss->SocketRulesGeneration);
+		SocketEventRingDrops = const_cast<__u64*>(&EbpfObj.Skeleton->bss->SocketEventRingDrops);
+	}
 	SocketMarks = std::make_unique<TEbpfMap<uint16_t, uint16_t>>(EbpfObj.Skeleton->maps.ingress_port_marks);
 	PidDownloadMarks = std::make_unique<TEbpfMap<uint32_t, uint32_t>>(EbpfObj.Skeleton->maps.pid_download_marks);
 	PortToPid = std::make_unique<TEbpfMap<uint16_t, uint32_t>>(EbpfObj.Skeleton->maps.port_to_pid);
-}
\ No newline at end of file
+	TrackedPids = std::make_unique<TEbpfMap<uint32_t, uint8_t>>(EbpfObj.Skeleton->maps.tracked_pids);
+	if (EbpfObj.Skeleton->rodata->UdpFlowAccountingEnabled)
+	{
+		UdpFlows = std::make_unique<WUdpFlowMap>(EbpfObj.Skeleton->maps.udp_flows);
+	}
+	if (EbpfObj.Skeleton->rodata->CgroupAccountingEnabled)
+	{
+		CgroupTraffic = std::make_unique<WCgroupTrafficMap>(EbpfObj.Skeleton->maps.cgroup_traffic);
+	}
+	auto const* Rodata = EbpfObj.Skeleton->rodata;
+	if (Rodata->ExcludeLoopback || Rodata->ExcludeInterfaces || Rodata->ExcludePorts || Rodata->ExcludeCgroups)
+	{
+		Exclusions = std::make_unique<WExclusionMap>(EbpfObj.Skeleton->maps.excluded_interfaces,
+			EbpfObj.Skeleton->maps.excluded_ports, EbpfObj.Skeleton->maps.excluded_cgroups,
+			EbpfObj.Skeleton->maps.excluded_traffic);
+	}
+}
+WKernelCounterBaselines WEbpfData::GetKernelCounterBaselines() const
+{
+	WKernelCounterBaselines Baselines{};
+	if (UdpFlows && UdpFlows->IsValid())
+	{
+		Baselines.UdpFlows = UdpFlows->GetBaselines();
+	}
+	if (CgroupTraffic && CgroupTraffic->IsValid())
+	{
+		Baselines.Cgroups = CgroupTraffic->GetBaselines();
+	}
+	if (Exclusions && Exclusions->IsValid())
+	{
+		Baselines.Loopback = Exclusions->GetLoopbackBaseline();
+	}
+	return Baselines;
+}
+
+void WEbpfData::RestoreKernelCounterBaselines(WKernelCounterBaselines const& Baselines) const
+{
+	if (UdpFlows && UdpFlows->IsValid())
+	{
+		UdpFlows->RestoreBaselines(Baselines.UdpFlows);
+	}
+	if (CgroupTraffic && CgroupTraffic->IsValid())
+	{
+		CgroupTraffic->RestoreBaselines(Baselines.Cgroups);
+	}
+	if (Exclusions && Exclusions->IsValid())
+	{
+		Exclusions->RestoreLoopbackBaseline(Baselines.Loopback);
+	}
+}
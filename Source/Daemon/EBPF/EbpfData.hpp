@@ -4,32 +4,108 @@
  */
 
 #pragma once
+#include <array>
+#include <atomic>
 #include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "EbpfRingBuffer.hpp"
 #include "WaechterEbpf.hpp"
 #include "EBPFCommon.h"
 #include "EbpfMap.hpp"
+#include "CgroupTrafficMap.hpp"
+#include "ExclusionMap.hpp"
+#include "UdpFlowMap.hpp"
+
+template <class Archive>
+void serialize(Archive& archive, WUdpFlowKey& Key)
+{
+	archive(Key.Cookie, Key.RemoteAddr, Key.RemotePort, Key.Family, Key.Direction);
+}
+
+/**
+ * The maps that are swept instead of sending events keep their running totals across a hot restart,
+ * the totals of the last sweep are saved with them so the traffic isn't counted a second time.
+ */
+struct WKernelCounterBaselines
+{
+	std::vector<std::pair<WUdpFlowKey, WBytes>>             UdpFlows{};
+	std::unordered_map<uint64_t, std::pair<WBytes, WBytes>> Cgroups{};
+	std::array<WBytes, 2>                                   Loopback{};
+
+	template <class Archive>
+	void serialize(Archive& archive)
+	{
+		archive(UdpFlows, Cgroups, Loopback);
+	}
+};
 
 class WEbpfData
 {
 
 public:
 	std::unique_ptr<TEbpfRingBuffer<WSocketEvent>>                  SocketEvents;
+	std::unique_ptr<TEbpfRingBuffer<WDnsAnswerEvent>>               DnsAnswers;
 	std::unique_ptr<TEbpfMap<WSocketCookie, WTrafficItemRulesBase>> SocketRules;
+	std::unique_ptr<TEbpfMap<uint32_t, WTrafficItemRulesBase>>      SystemRules; // single element
 	std::unique_ptr<TEbpfMap<uint16_t, uint16_t>>                   SocketMarks;
 	std::unique_ptr<TEbpfMap<uint32_t, uint32_t>>                   PidDownloadMarks;
 	std::unique_ptr<TEbpfMap<uint16_t, uint32_t>>                   PortToPid;
+	std::unique_ptr<TEbpfMap<uint32_t, uint8_t>>                    TrackedPids;
+	std::unique_ptr<WUdpFlowMap>                                    UdpFlows; // null if UDP is counted in userspace
+	std::unique_ptr<WExclusionMap>                                  Exclusions; // null if nothing is excluded
+	std::unique_ptr<WCgroupTrafficMap>                              CgroupTraffic; // null if disabled
+
+	// Points into the mapped .bss section of the eBPF object
+	uint32_t* SocketRulesGeneration{};
+	__u64*    SocketEventRingDrops{};
 
 	[[nodiscard]] bool IsValid() const { return SocketEvents && SocketEvents->IsValid(); }
 
+	// Has to be called after changing SocketRules, the eBPF programs only read the rules
+	// of a socket again if the generation changed since they cached them
+	void InvalidateSocketRules() const
+	{
+		if (SocketRulesGeneration)
+		{
+			std::atomic_ref(*SocketRulesGeneration).fetch_add(1);
+		}
+	}
+
+	// Events the eBPF programs couldn't put into the ring since they were loaded
+	[[nodiscard]] uint64_t GetSocketEventRingDrops() const
+	{
+		return SocketEventRingDrops ? std::atomic_ref(*SocketEventRingDrops).load(std::memory_order_relaxed) : 0;
+	}
+
 	void UpdateData() const
 	{
 		if (SocketEvents && SocketEvents->IsValid())
 		{
 			SocketEvents->Poll(500);
 		}
+		if (DnsAnswers && DnsAnswers->IsValid())
+		{
+			DnsAnswers->Poll(0);
+		}
+	}
+
+	void ConsumeData() const
+	{
+		if (SocketEvents && SocketEvents->IsValid())
+		{
+			SocketEvents->Consume();
+		}
+		if (DnsAnswers && DnsAnswers->IsValid())
+		{
+			DnsAnswers->Consume();
+		}
 	}
 
+	[[nodiscard]] WKernelCounterBaselines GetKernelCounterBaselines() const;
+	void                                  RestoreKernelCounterBaselines(WKernelCounterBaselines const& Baselines) const;
+
 	explicit WEbpfData(WWaechterEbpf const& EbpfObj);
 };
@@ -5,7 +5,10 @@
 
 #include "EbpfObj.hpp"
 
+#include <algorithm>
 #include <fcntl.h>
+#include <filesystem>
+#include <string_view>
 #include <bpf/bpf.h>
 #include <bpf/libbpf.h>
 #include <net/if.h>
@@ -62,17 +65,25 @@ WEbpfObj::WEbpfObj()
 
 WEbpfObj::~WEbpfObj()
 {
-	spdlog::info("Detaching eBPF programs...");
-	for (auto const& Program : Programs)
+	if (bKeepAttached)
 	{
-		int  ProgFd = bpf_program__fd(std::get<0>(Program));
-		auto Type = std::get<1>(Program);
-		if (ProgFd >= 0 && CGroupFd)
+		spdlog::info("Keeping eBPF programs attached for the restart");
+	}
+	else
+	{
+		spdlog::info("Detaching eBPF programs...");
+		for (auto const& Program : Programs)
 		{
-			bpf_prog_detach2(ProgFd, *CGroupFd, Type);
+			int  ProgFd = bpf_program__fd(std::get<0>(Program));
+			auto Type = std::get<1>(Program);
+			if (ProgFd >= 0 && CGroupFd)
+			{
+				bpf_prog_detach2(ProgFd, *CGroupFd, Type);
+			}
 		}
 	}
 
+	// Pinned links stay attached when their fd is closed
 	for (auto const& Link : Links)
 	{
 		if (bpf_link* BpfLink = std::get<0>(Link))
@@ -123,6 +134,13 @@ bool WEbpfObj::FindAndAttachProgram(std::string const& ProgName, bpf_attach_type
 		return false;
 	}
 
+	// Only a single program can be attached, attaching another one replaces the program of the previous run
+	if (bReplaceAttached && bpf_prog_attach(ProgFd, *CGroupFd, AttachType, Flags) == 0)
+	{
+		Programs.emplace_back(Prog, AttachType);
+		return true;
+	}
+
 	bpf_prog_detach2(ProgFd, *CGroupFd, AttachType);
 	auto Result = bpf_prog_attach(bpf_program__fd(Prog), *CGroupFd, AttachType, Flags) == 0;
 	if (Result)
@@ -149,6 +167,10 @@ bool WEbpfObj::CreateAndAttachTcxProgram(bpf_program* Program, int ifboverride)
 	Opts.sz = sizeof(Opts);
 
 	int If = ifboverride > 0 ? ifboverride : static_cast<int>(IfIndex);
+	if (bReplaceAttached && ReplacePinnedTcxProgram(Program, If))
+	{
+		return true;
+	}
 
 	auto* Link = bpf_program__attach_tcx(Program, If, &Opts);
 	if (int const Err = libbpf_get_error(Link); Err != 0)
@@ -159,4 +181,100 @@ bool WEbpfObj::CreateAndAttachTcxProgram(bpf_program* Program, int ifboverride)
 	}
 	Links.emplace_back(Link, Program);
 	return true;
-}
\ No newline at end of file
+}
+
+std::string WEbpfObj::GetLinkPinPath(bpf_program const* Program) const
+{
+	return fmt::format("{}/link_{}", PinDirectory, bpf_program__name(Program));
+}
+
+bool WEbpfObj::PinLink(bpf_link* Link, bpf_program const* Program) const
+{
+	auto const PinPath = GetLinkPinPath(Program);
+	if (int const Err = bpf_link__pin(Link, PinPath.c_str()); Err != 0)
+	{
+		spdlog::error("Failed to pin link of eBPF program '{}' to {}: {}", bpf_program__name(Program), PinPath,
+			WErrnoUtil::StrError(-Err));
+		return false;
+	}
+	return true;
+}
+
+bool WEbpfObj::PinLinks()
+{
+	if (PinDirectory.empty())
+	{
+		return false;
+	}
+
+	for (auto const& [Link, Program] : Links)
+	{
+		if (!PinLink(Link, Program))
+		{
+			return false;
+		}
+	}
+	bKeepAttached = true;
+	return true;
+}
+
+bool WEbpfObj::ReplacePinnedTcxProgram(bpf_program* Program, int const If)
+{
+	auto* Link = bpf_link__open(GetLinkPinPath(Program).c_str());
+	if (libbpf_get_error(Link) != 0)
+	{
+		return false;
+	}
+
+	// The interface might have changed in the meantime, or be gone if it was recreated (like the ifb device)
+	bpf_link_info Info{};
+	uint32_t      InfoSize = sizeof(Info);
+	if (bpf_link_get_info_by_fd(bpf_link__fd(Link), &Info, &InfoSize) != 0 || Info.type != BPF_LINK_TYPE_TCX
+		|| static_cast<int>(Info.tcx.ifindex) != If || bpf_link__update_program(Link, Program) != 0)
+	{
+		spdlog::info("Can't reuse the tcx link of eBPF program '{}', attaching it again", bpf_program__name(Program));
+
+		// This was the last reference, so the old program is detached
+		bpf_link__unpin(Link);
+		bpf_link__destroy(Link);
+		return false;
+	}
+
+	// Pinned again by the next hot restart
+	bpf_link__unpin(Link);
+	Links.emplace_back(Link, Program);
+	return true;
+}
+
+void WEbpfObj::PinMaps(std::span<char const* const> const ExcludedMaps) const
+{
+	bpf_map* Map{};
+	bpf_object__for_each_map(Map, Obj)
+	{
+		std::string_view const Name = bpf_map__name(Map);
+		if (bpf_map__is_internal(Map)
+			|| std::ranges::any_of(ExcludedMaps, [Name](char const* Excluded) { return Name == Excluded; }))
+		{
+			continue;
+		}
+
+		auto const PinPath = fmt::format("{}/{}", PinDirectory, Name);
+		if (int const Err = bpf_map__set_pin_path(Map, PinPath.c_str()); Err != 0)
+		{
+			spdlog::warn("Failed to set pin path of eBPF map '{}': {}", Name, WErrnoUtil::StrError(-Err));
+		}
+	}
+}
+
+void WEbpfObj::RemoveStaleLinkPins() const
+{
+	std::error_code Error{};
+	for (auto const& Entry : std::filesystem::directory_iterator(PinDirectory, Error))
+	{
+		if (Entry.path().filename().string().starts_with("link_"))
+		{
+			spdlog::debug("Removing link {} of the previous run", Entry.path().string());
+			std::filesystem::remove(Entry.path(), Error);
+		}
+	}
+}
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <span>
 #include <string>
 #include <vector>
 #include <memory>
@@ -34,6 +35,28 @@ protected:
 	std::unique_ptr<int, WFdCloser>                        CGroupFd{};
 	unsigned int                                           IfIndex{};
 
+	// Directory under bpffs for maps and links that outlive the daemon, empty unless hot restarts are enabled
+	std::string PinDirectory{};
+
+	// The programs of the previous run are still attached and get replaced in place
+	bool bReplaceAttached{};
+
+	// Set once the links are pinned for a hot restart, nothing is detached on destruction then
+	bool bKeepAttached{};
+
+	[[nodiscard]] std::string GetLinkPinPath(bpf_program const* Program) const;
+
+	bool PinLink(bpf_link* Link, bpf_program const* Program) const;
+
+	// Swaps the program of a tcx link pinned by the previous run, so there's no moment without one
+	bool ReplacePinnedTcxProgram(bpf_program* Program, int If);
+
+	// Has to be called before the object is loaded, libbpf reuses compatible maps that are pinned already
+	void PinMaps(std::span<char const* const> ExcludedMaps) const;
+
+	// Drops the links the previous run left behind that weren't replaced, which detaches their programs
+	void RemoveStaleLinkPins() const;
+
 public:
 	explicit WEbpfObj();
 
@@ -48,4 +71,7 @@ public:
 	operator bpf_object*() const { return Obj; }
 
 	bool CreateAndAttachTcxProgram(bpf_program* Program, int ifboverride = -1);
+
+	// Keeps the programs attached after the daemon exited, the cgroup programs stay attached anyway
+	bool PinLinks();
 };
@@ -67,5 +67,18 @@ public:
 		}
 	}
 
+	// Reads whatever was submitted so far without waiting, for when the epoll fd reported new data
+	void Consume()
+	{
+		auto Return = ring_buffer__consume(RingBufferPtr);
+		if (Return < 0)
+		{
+			spdlog::error("ring_buffer__consume failed: {}", Return);
+		}
+	}
+
+	// Becomes readable once the eBPF programs submitted data
+	[[nodiscard]] int GetEpollFd() const { return ring_buffer__epoll_fd(RingBufferPtr); }
+
 	[[nodiscard]] bool IsValid() const { return RingBufferPtr != nullptr; }
 };
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "ExclusionMap.hpp"
+
+#include <charconv>
+#include <bpf/bpf.h>
+#include <bpf/libbpf.h>
+#include <sys/stat.h>
+
+#include "spdlog/spdlog.h"
+
+#include "DaemonConfig.hpp"
+#include "ErrnoUtil.hpp"
+#include "Format.hpp"
+#include "NetworkInterface.hpp"
+
+namespace
+{
+std::vector<std::string> SplitList(std::string const& Str)
+{
+	std::vector<std::string> Result{};
+	for (auto const& Entry : WStringFormat::SplitString(Str, ';'))
+	{
+		if (auto Trimmed = WStringFormat::Trim(Entry); !Trimmed.empty())
+		{
+			Result.emplace_back(std::move(Trimmed));
+		}
+	}
+	return Result;
+}
+
+int GetMapFd(bpf_map const* Map)
+{
+	return Map ? bpf_map__fd(Map) : -1;
+}
+} // namespace
+
+WKernelExclusions WKernelExclusions::FromConfig(WExclusionConfig const& Config, std::string const& CgroupRoot)
+{
+	WKernelExclusions Exclusions{};
+	Exclusions.bLoopback = Config.bLoopback;
+
+	for (auto const& Name : SplitList(Config.Interfaces))
+	{
+		if (auto const IfIndex = WNetworkInterface::GetIfIndex(Name); IfIndex != 0)
+		{
+			Exclusions.IfIndexes.emplace_back(IfIndex);
+		}
+		else
+		{
+			spdlog::error("Excluded interface '{}' does not exist", Name);
+		}
+	}
+
+	for (auto const& Entry : SplitList(Config.Ports))
+	{
+		if (auto const Range = WPortRange::FromString(Entry))
+		{
+			Exclusions.Ports.emplace_back(*Range);
+		}
+		else
+		{
+			spdlog::error("Invalid excluded port range '{}'", Entry);
+		}
+	}
+
+	for (auto const& Entry : SplitList(Config.Cgroups))
+	{
+		uint64_t   Id{};
+		auto const [End, Error] = std::from_chars(Entry.data(), Entry.data() + Entry.size(), Id);
+		if (Error == std::errc{} && End == Entry.data() + Entry.size())
+		{
+			Exclusions.CgroupIds.emplace_back(Id);
+			continue;
+		}
+
+		// On cgroup v2 the id of a cgroup is the inode number of its directory
+		auto const  Path = Entry.starts_with('/') ? Entry : CgroupRoot + "/" + Entry;
+		struct stat Stat{};
+		if (stat(Path.c_str(), &Stat) == 0 && S_ISDIR(Stat.st_mode))
+		{
+			Exclusions.CgroupIds.emplace_back(static_cast<uint64_t>(Stat.st_ino));
+		}
+		else
+		{
+			spdlog::error("Excluded cgroup '{}' not found at {}", Entry, Path);
+		}
+	}
+	return Exclusions;
+}
+
+WExclusionMap::WExclusionMap(
+	bpf_map const* Interfaces, bpf_map const* Ports, bpf_map const* Cgroups, bpf_map const* Traffic)
+	: InterfacesFd(GetMapFd(Interfaces)), PortsFd(GetMapFd(Ports)), CgroupsFd(GetMapFd(Cgroups))
+{
+	auto const PossibleCpus = libbpf_num_possible_cpus();
+	if (PossibleCpus <= 0)
+	{
+		spdlog::error("Failed to get the number of CPUs: {}", PossibleCpus);
+		return;
+	}
+
+	TrafficFd = GetMapFd(Traffic);
+	ValueBuffer.resize(static_cast<std::size_t>(PossibleCpus));
+}
+
+void WExclusionMap::Populate(WKernelExclusions const& Exclusions) const
+{
+	uint8_t const One = 1;
+	for (auto const IfIndex : Exclusions.IfIndexes)
+	{
+		if (bpf_map_update_elem(InterfacesFd, &IfIndex, &One, BPF_ANY) != 0)
+		{
+			spdlog::error("Failed to exclude interface {}: {}", IfIndex, WErrnoUtil::StrError());
+		}
+	}
+
+	for (auto const CgroupId : Exclusions.CgroupIds)
+	{
+		if (bpf_map_update_elem(CgroupsFd, &CgroupId, &One, BPF_ANY) != 0)
+		{
+			spdlog::error("Failed to exclude cgroup {}: {}", CgroupId, WErrnoUtil::StrError());
+		}
+	}
+
+	std::array<uint64_t, 65536 / 64> PortBits{};
+	for (auto const& Range : Exclusions.Ports)
+	{
+		for (uint32_t Port = Range.Low; Port <= Range.High; ++Port)
+		{
+			PortBits[Port / 64] |= uint64_t{ 1 } << (Port % 64);
+		}
+	}
+
+	for (uint32_t Index = 0; Index < PortBits.size(); ++Index)
+	{
+		if (PortBits[Index] != 0 && bpf_map_update_elem(PortsFd, &Index, &PortBits[Index], BPF_ANY) != 0)
+		{
+			spdlog::error("Failed to exclude ports {}-{}: {}", Index * 64, Index * 64 + 63, WErrnoUtil::StrError());
+		}
+	}
+
+	spdlog::info("Excluding {}{} interfaces, {} port ranges and {} cgroups from accounting",
+		Exclusions.bLoopback ? "loopback, " : "", Exclusions.IfIndexes.size(), Exclusions.Ports.size(),
+		Exclusions.CgroupIds.size());
+}
+
+std::array<WBytes, 2> WExclusionMap::SweepLoopbackTraffic()
+{
+	std::array<WBytes, 2> Traffic{};
+	for (uint32_t Direction = 0; Direction < Traffic.size(); ++Direction)
+	{
+		if (bpf_map_lookup_elem(TrafficFd, &Direction, ValueBuffer.data()) != 0)
+		{
+			continue;
+		}
+
+		WBytes Total{};
+		for (auto const& Value : ValueBuffer)
+		{
+			Total += Value.Bytes;
+		}
+
+		// The kernel only ever adds to the counters, so anything below the last total can't happen
+		Traffic[Direction] = Total >= LastLoopbackBytes[Direction] ? Total - LastLoopbackBytes[Direction] : 0;
+		LastLoopbackBytes[Direction] = Total;
+	}
+	return Traffic;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Data/FilterEngine.hpp"
+#include "EBPFCommon.h"
+#include "Types.hpp"
+
+struct bpf_map;
+struct WExclusionConfig;
+
+// The [exclusions] config section resolved to what the eBPF program can match against
+struct WKernelExclusions
+{
+	bool                    bLoopback{};
+	std::vector<uint32_t>   IfIndexes{};
+	std::vector<WPortRange> Ports{};
+	std::vector<uint64_t>   CgroupIds{};
+
+	// Entries that can't be resolved are logged and skipped, cgroup paths are relative to CgroupRoot
+	static WKernelExclusions FromConfig(WExclusionConfig const& Config, std::string const& CgroupRoot);
+};
+
+/**
+ * Fills the exclusion maps of the eBPF program and reads back the loopback traffic it skipped.
+ * Only the sum per direction is kept in the kernel, which is enough to keep filters that match
+ * loopback addresses (like the built-in Localhost filter) accurate.
+ */
+class WExclusionMap
+{
+	int InterfacesFd{ -1 };
+	int PortsFd{ -1 };
+	int CgroupsFd{ -1 };
+	int TrafficFd{ -1 };
+
+	std::vector<WExcludedTrafficValue> ValueBuffer{}; // one value per possible CPU
+	std::array<WBytes, 2>              LastLoopbackBytes{};
+
+public:
+	WExclusionMap(bpf_map const* Interfaces, bpf_map const* Ports, bpf_map const* Cgroups, bpf_map const* Traffic);
+
+	[[nodiscard]] bool IsValid() const { return TrafficFd >= 0; }
+
+	void Populate(WKernelExclusions const& Exclusions) const;
+
+	// Loopback traffic skipped since the last call, indexed by EPacketDirection
+	std::array<WBytes, 2> SweepLoopbackTraffic();
+
+	// Kernel totals at the last sweep, see WUdpFlowMap::GetBaselines
+	[[nodiscard]] std::array<WBytes, 2> GetLoopbackBaseline() const { return LastLoopbackBytes; }
+	void RestoreLoopbackBaseline(std::array<WBytes, 2> const& Baseline) { LastLoopbackBytes = Baseline; }
+};
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "SocketEventLog.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "spdlog/spdlog.h"
+
+#include "ErrnoUtil.hpp"
+#include "Time.hpp"
+
+WSocketEventRecorder::WSocketEventRecorder(std::string const& Path)
+{
+	Fd = open(Path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (Fd < 0)
+	{
+		spdlog::error("Failed to open socket event log {}: {}", Path, WErrnoUtil::StrError());
+		return;
+	}
+
+	if (!Grow())
+	{
+		close(Fd);
+		Fd = -1;
+		return;
+	}
+
+	*GetHeader() = WSocketEventLogHeader{};
+	GetHeader()->StartTime = WTime::GetEpochMs();
+	StartTime = std::chrono::steady_clock::now();
+	spdlog::info("Recording socket events to {}", Path);
+}
+
+WSocketEventRecorder::~WSocketEventRecorder()
+{
+	std::scoped_lock Lock(Mutex);
+	if (Mapping)
+	{
+		auto const UsedSize = sizeof(WSocketEventLogHeader) + GetHeader()->EventCount * sizeof(WRecordedSocketEvent);
+		spdlog::info("Recorded {} socket events", GetHeader()->EventCount);
+		munmap(Mapping, MappingSize);
+		// Drop the unused rest of the last chunk
+		if (ftruncate(Fd, static_cast<off_t>(UsedSize)) != 0)
+		{
+			spdlog::warn("Failed to truncate socket event log: {}", WErrnoUtil::StrError());
+		}
+	}
+
+	if (Fd >= 0)
+	{
+		close(Fd);
+	}
+}
+
+bool WSocketEventRecorder::Grow()
+{
+	auto const NewSize = MappingSize + GrowSize;
+	if (ftruncate(Fd, static_cast<off_t>(NewSize)) != 0)
+	{
+		spdlog::error("Failed to grow socket event log to {} bytes: {}", NewSize, WErrnoUtil::StrError());
+		return false;
+	}
+
+	void* NewMapping{};
+	if (Mapping)
+	{
+		NewMapping = mremap(Mapping, MappingSize, NewSize, MREMAP_MAYMOVE);
+	}
+	else
+	{
+		NewMapping = mmap(nullptr, NewSize, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+	}
+
+	if (NewMapping == MAP_FAILED)
+	{
+		spdlog::error("Failed to map socket event log: {}", WErrnoUtil::StrError());
+		return false;
+	}
+	Mapping = NewMapping;
+	MappingSize = NewSize;
+	return true;
+}
+
+void WSocketEventRecorder::Append(WSocketEvent const& Event)
+{
+	std::scoped_lock Lock(Mutex);
+	if (!Mapping)
+	{
+		return;
+	}
+
+	auto const Count = GetHeader()->EventCount;
+	auto const Offset = sizeof(WSocketEventLogHeader) + Count * sizeof(WRecordedSocketEvent);
+	if (Offset + sizeof(WRecordedSocketEvent) > MappingSize && !Grow())
+	{
+		// Keep what was recorded so far
+		munmap(Mapping, MappingSize);
+		Mapping = nullptr;
+		spdlog::error("Stopped recording socket events after {} events", Count);
+		return;
+	}
+
+	auto* Record = reinterpret_cast<WRecordedSocketEvent*>(static_cast<char*>(Mapping) + Offset);
+	Record->TimeOffset = static_cast<uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - StartTime).count());
+	Record->Event = Event;
+	GetHeader()->EventCount = Count + 1;
+}
+
+WSocketEventLog::WSocketEventLog(std::string const& Path)
+{
+	int const Fd = open(Path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (Fd < 0)
+	{
+		spdlog::error("Failed to open socket event log {}: {}", Path, WErrnoUtil::StrError());
+		return;
+	}
+
+	struct stat st{};
+	if (fstat(Fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(WSocketEventLogHeader))
+	{
+		spdlog::error("Socket event log {} is too small", Path);
+		close(Fd);
+		return;
+	}
+
+	MappingSize = static_cast<std::size_t>(st.st_size);
+	Mapping = mmap(nullptr, MappingSize, PROT_READ, MAP_PRIVATE, Fd, 0);
+	close(Fd);
+	if (Mapping == MAP_FAILED)
+	{
+		spdlog::error("Failed to mmap socket event log {}", Path);
+		Mapping = nullptr;
+		MappingSize = 0;
+		return;
+	}
+	madvise(Mapping, MappingSize, MADV_SEQUENTIAL);
+
+	auto const& Header = GetHeader();
+	if (Header.Magic != SocketEventLogMagic || Header.Version != SocketEventLogVersion)
+	{
+		spdlog::error("{} is not a socket event log", Path);
+	}
+	else if (Header.EventSize != sizeof(WSocketEvent))
+	{
+		spdlog::error("Socket event log {} was recorded by a different build (event size {}, expected {})", Path,
+			Header.EventSize, sizeof(WSocketEvent));
+	}
+	else if (sizeof(WSocketEventLogHeader) + Header.EventCount * sizeof(WRecordedSocketEvent) > MappingSize)
+	{
+		spdlog::error("Socket event log {} is truncated", Path);
+	}
+	else
+	{
+		return;
+	}
+
+	munmap(Mapping, MappingSize);
+	Mapping = nullptr;
+	MappingSize = 0;
+}
+
+WSocketEventLog::~WSocketEventLog()
+{
+	if (Mapping)
+	{
+		munmap(Mapping, MappingSize);
+	}
+}
+
+std::span<WRecordedSocketEvent const> WSocketEventLog::GetEvents() const
+{
+	if (!Mapping)
+	{
+		return {};
+	}
+
+	auto const* First = reinterpret_cast<WRecordedSocketEvent const*>(
+		static_cast<char const*>(Mapping) + sizeof(WSocketEventLogHeader));
+	return { First, static_cast<std::size_t>(GetHeader().EventCount) };
+}
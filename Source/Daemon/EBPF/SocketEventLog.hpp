@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <span>
+#include <string>
+#include <type_traits>
+
+#include "Types.hpp"
+#include "EBPFCommon.h"
+#include "CgroupTrafficMap.hpp"
+#include "UdpFlowMap.hpp"
+
+constexpr uint32_t SocketEventLogMagic = 0x4C455357; // "WSEL"
+constexpr uint32_t SocketEventLogVersion = 2;
+
+// Traffic the eBPF program only counts in maps never shows up as a socket event. Each swept delta is logged as an
+// event of one of these types instead, with the delta in place of the event data
+enum ERecordedSweepType : uint8_t
+{
+	RS_UdpFlowTraffic = 0xF0, // WUdpFlowTraffic
+	RS_CgroupTraffic,         // WCgroupTraffic
+	RS_LoopbackTraffic,       // WLoopbackTraffic
+};
+
+struct WLoopbackTraffic
+{
+	WBytes Download{};
+	WBytes Upload{};
+};
+
+struct WSocketEventLogHeader
+{
+	uint32_t Magic{ SocketEventLogMagic };
+	uint32_t Version{ SocketEventLogVersion };
+	uint32_t EventSize{ sizeof(WSocketEvent) }; // The events are stored as is, so logs only work with the same build
+	uint32_t Reserved{};
+	uint64_t EventCount{};
+	int64_t  StartTime{}; // Epoch milliseconds
+};
+
+struct WRecordedSocketEvent
+{
+	uint64_t     TimeOffset; // Nanoseconds since the recording started
+	WSocketEvent Event;
+};
+
+/**
+ * Appends the socket events read from the ring buffer to a file, so the userspace side of the daemon
+ * can later be run against them without root, eBPF or live traffic (see WSocketEventReplay).
+ * The file is written through a shared mapping that grows in chunks, the event count in the header
+ * is updated with every event, so a log is still readable if the daemon didn't shut down cleanly.
+ */
+class WSocketEventRecorder
+{
+	static constexpr std::size_t GrowSize = 16 WMiB;
+
+	// Events are appended by the ring buffer consumer, sweeps by the timer thread
+	std::mutex                            Mutex;
+	int                                   Fd{ -1 };
+	void*                                 Mapping{ nullptr };
+	std::size_t                           MappingSize{ 0 };
+	std::chrono::steady_clock::time_point StartTime{};
+
+	bool Grow();
+
+	[[nodiscard]] WSocketEventLogHeader* GetHeader() const { return static_cast<WSocketEventLogHeader*>(Mapping); }
+
+public:
+	explicit WSocketEventRecorder(std::string const& Path);
+	~WSocketEventRecorder();
+
+	WSocketEventRecorder(WSocketEventRecorder const&) = delete;
+	WSocketEventRecorder& operator=(WSocketEventRecorder const&) = delete;
+
+	[[nodiscard]] bool IsValid() const { return Mapping != nullptr; }
+
+	void Append(WSocketEvent const& Event);
+
+	template <class T>
+	void AppendSweep(ERecordedSweepType Type, T const& Delta)
+	{
+		static_assert(std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(WSocketEventData));
+		WSocketEvent Event{};
+		Event.EventType = Type;
+		std::memcpy(&Event.Data, &Delta, sizeof(T));
+		Append(Event);
+	}
+
+	[[nodiscard]] uint64_t GetEventCount() const { return IsValid() ? GetHeader()->EventCount : 0; }
+};
+
+// Read only view of a recorded log
+class WSocketEventLog
+{
+	void*       Mapping{ nullptr };
+	std::size_t MappingSize{ 0 };
+
+public:
+	explicit WSocketEventLog(std::string const& Path);
+	~WSocketEventLog();
+
+	WSocketEventLog(WSocketEventLog const&) = delete;
+	WSocketEventLog& operator=(WSocketEventLog const&) = delete;
+
+	[[nodiscard]] bool IsValid() const { return Mapping != nullptr; }
+
+	[[nodiscard]] WSocketEventLogHeader const& GetHeader() const
+	{
+		return *static_cast<WSocketEventLogHeader const*>(Mapping);
+	}
+
+	[[nodiscard]] std::span<WRecordedSocketEvent const> GetEvents() const;
+
+	template <class T>
+	[[nodiscard]] static T GetSweep(WSocketEvent const& Event)
+	{
+		static_assert(std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(WSocketEventData));
+		T Delta{};
+		std::memcpy(static_cast<void*>(&Delta), &Event.Data, sizeof(T));
+		return Delta;
+	}
+};
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "SocketEventReplay.hpp"
+
+#include <thread>
+
+#include "spdlog/spdlog.h"
+#include "tracy/Tracy.hpp"
+
+WProcessInfo WReplayProcessInfoBackend::Resolve(WProcessId const PID)
+{
+	auto Name = fmt::format("replay-{}", PID);
+	return { "/replay/" + Name, Name, Name };
+}
+
+WSocketEventReplay::WSocketEventReplay(std::string const& Path, double const Speed_) : Log(Path), Speed(Speed_)
+{
+	if (Log.IsValid())
+	{
+		spdlog::info("Replaying {} socket events from {} at {}", Log.GetEvents().size(), Path,
+			Speed > 0 ? fmt::format("{}x speed", Speed) : "maximum speed");
+	}
+}
+
+WReplayResult WSocketEventReplay::Run(
+	std::function<void(WSocketEvent const&)> const& Handler, std::atomic<bool> const& bStop) const
+{
+	using namespace std::chrono;
+	WReplayResult Result{};
+	auto const    StartTime = steady_clock::now();
+
+	for (auto const& Record : Log.GetEvents())
+	{
+		if (bStop)
+		{
+			break;
+		}
+
+		if (Speed > 0)
+		{
+			auto const Offset = duration<double, std::nano>(static_cast<double>(Record.TimeOffset) / Speed);
+			auto const Due = StartTime + duration_cast<nanoseconds>(Offset);
+			// Sleeping for every event would cost more than the events themselves
+			if (Due - steady_clock::now() > milliseconds(1))
+			{
+				std::this_thread::sleep_until(Due);
+			}
+		}
+
+		{
+			ZoneScopedN("ReplaySocketEvent");
+			Handler(Record.Event);
+		}
+		++Result.Events;
+	}
+
+	Result.Duration = duration_cast<milliseconds>(steady_clock::now() - StartTime).count();
+	return Result;
+}
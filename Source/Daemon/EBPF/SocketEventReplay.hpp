@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <atomic>
+#include <functional>
+#include <string>
+
+#include "SocketEventLog.hpp"
+#include "Data/ProcessInfoCache.hpp"
+
+struct WReplayResult
+{
+	uint64_t Events{};
+	WMsec    Duration{};
+
+	[[nodiscard]] double GetEventsPerSecond() const
+	{
+		if (Duration <= 0)
+		{
+			return static_cast<double>(Events);
+		}
+		return static_cast<double>(Events) * 1000.0 / static_cast<double>(Duration);
+	}
+};
+
+// The processes of a recording don't exist on the replaying machine, each PID becomes its own application
+class WReplayProcessInfoBackend final : public IProcessInfoBackend
+{
+public:
+	WProcessInfo Resolve(WProcessId PID) override;
+};
+
+/**
+ * Feeds a recorded socket event log into the same handler the ring buffer events go through.
+ * Events are either replayed at the recorded pace scaled by Speed, or as fast as possible if Speed is 0.
+ */
+class WSocketEventReplay
+{
+	WSocketEventLog Log;
+	double          Speed{ 1.0 };
+
+public:
+	WSocketEventReplay(std::string const& Path, double Speed_);
+
+	[[nodiscard]] bool IsValid() const { return Log.IsValid(); }
+
+	[[nodiscard]] uint64_t GetEventCount() const { return Log.GetEvents().size(); }
+
+	// Returns early if bStop is set
+	WReplayResult Run(std::function<void(WSocketEvent const&)> const& Handler, std::atomic<bool> const& bStop) const;
+};
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "UdpFlowMap.hpp"
+
+#include <algorithm>
+#include <bpf/bpf.h>
+#include <bpf/libbpf.h>
+#include <cerrno>
+#include <sys/socket.h>
+
+#include "spdlog/spdlog.h"
+#include "tracy/Tracy.hpp"
+
+WUdpFlowMap::WUdpFlowMap(bpf_map const* Map)
+{
+	if (!Map)
+	{
+		return;
+	}
+
+	auto const PossibleCpus = libbpf_num_possible_cpus();
+	if (PossibleCpus <= 0)
+	{
+		spdlog::error("Failed to get the number of CPUs: {}", PossibleCpus);
+		return;
+	}
+
+	MapFd = bpf_map__fd(Map);
+	CpuCount = static_cast<std::size_t>(PossibleCpus);
+	KeyBuffer.resize(BatchSize);
+	ValueBuffer.resize(BatchSize * CpuCount);
+}
+
+bool WUdpFlowMap::ReadBatched(WFlowVisitor const& Visit)
+{
+	WUdpFlowKey InBatch{};
+	WUdpFlowKey OutBatch{};
+	bool        bFirst = true;
+	while (true)
+	{
+		auto       Count = BatchSize;
+		auto const Result = bpf_map_lookup_batch(
+			MapFd, bFirst ? nullptr : &InBatch, &OutBatch, KeyBuffer.data(), ValueBuffer.data(), &Count, nullptr);
+		auto const Error = Result < 0 ? errno : 0;
+		if (Result < 0 && Error != ENOENT)
+		{
+			if (bFirst)
+			{
+				spdlog::info("Batched map lookups are not available ({}), reading UDP flows one by one",
+					std::strerror(Error));
+				bBatchLookup = false;
+				return false;
+			}
+			spdlog::warn("Failed to read UDP flows: {}", std::strerror(Error));
+			return true;
+		}
+
+		for (uint32_t i = 0; i < Count; ++i)
+		{
+			Visit(KeyBuffer[i], &ValueBuffer[i * CpuCount]);
+		}
+
+		// ENOENT means that this was the last batch
+		if (Result < 0)
+		{
+			return true;
+		}
+		InBatch = OutBatch;
+		bFirst = false;
+	}
+}
+
+void WUdpFlowMap::ReadByKey(WFlowVisitor const& Visit)
+{
+	WUdpFlowKey Key{};
+	int         Result = bpf_map_get_next_key(MapFd, nullptr, &Key);
+	while (Result == 0)
+	{
+		if (bpf_map_lookup_elem(MapFd, &Key, ValueBuffer.data()) == 0)
+		{
+			Visit(Key, ValueBuffer.data());
+		}
+		auto const Previous = Key;
+		Result = bpf_map_get_next_key(MapFd, &Previous, &Key);
+	}
+}
+
+std::vector<WUdpFlowTraffic> WUdpFlowMap::Sweep()
+{
+	ZoneScopedN("WUdpFlowMap::Sweep");
+	std::vector<WUdpFlowTraffic> Traffic{};
+	std::vector<WUdpFlowKey>     FinishedFlows{};
+
+	std::scoped_lock Lock(Mutex);
+	++SweepGeneration;
+	auto const Visit = [&](WUdpFlowKey const& Key, WUdpFlowValue const* PerCpuValues) {
+		WBytes Total = 0;
+		for (std::size_t Cpu = 0; Cpu < CpuCount; ++Cpu)
+		{
+			Total += PerCpuValues[Cpu].Bytes;
+		}
+
+		auto& State = Flows[Key];
+		// The flow was evicted and added again in the meantime, the kernel started counting from zero
+		auto const Bytes = Total >= State.Bytes ? Total - State.Bytes : Total;
+		State.Bytes = Total;
+		State.SweepGeneration = SweepGeneration;
+
+		if (RemovedSockets.contains(Key.Cookie))
+		{
+			FinishedFlows.push_back(Key);
+		}
+
+		if (Bytes == 0)
+		{
+			return;
+		}
+
+		WUdpFlowTraffic Flow{};
+		Flow.Cookie = Key.Cookie;
+		Flow.Direction = Key.Direction;
+		Flow.Bytes = Bytes;
+		Flow.RemoteEndpoint.Address.Family = Key.Family == AF_INET6 ? EIPFamily::IPv6 : EIPFamily::IPv4;
+		std::copy_n(Key.RemoteAddr, Key.Family == AF_INET6 ? 16 : 4, Flow.RemoteEndpoint.Address.Bytes.begin());
+		Flow.RemoteEndpoint.Port = Key.RemotePort;
+		Traffic.push_back(Flow);
+	};
+
+	if (!bBatchLookup || !ReadBatched(Visit))
+	{
+		ReadByKey(Visit);
+	}
+
+	// The last bytes of a removed socket are still reported, after that its flows are gone for good
+	for (auto const& Key : FinishedFlows)
+	{
+		bpf_map_delete_elem(MapFd, &Key);
+		Flows.erase(Key);
+	}
+	RemovedSockets.clear();
+
+	// Flows the kernel evicted from the LRU
+	std::erase_if(Flows, [this](auto const& Flow) { return Flow.second.SweepGeneration != SweepGeneration; });
+	return Traffic;
+}
+
+std::vector<std::pair<WUdpFlowKey, WBytes>> WUdpFlowMap::GetBaselines()
+{
+	std::scoped_lock                            Lock(Mutex);
+	std::vector<std::pair<WUdpFlowKey, WBytes>> Baselines{};
+	Baselines.reserve(Flows.size());
+	for (auto const& [Key, State] : Flows)
+	{
+		Baselines.emplace_back(Key, State.Bytes);
+	}
+	return Baselines;
+}
+
+void WUdpFlowMap::RestoreBaselines(std::vector<std::pair<WUdpFlowKey, WBytes>> const& Baselines)
+{
+	std::scoped_lock Lock(Mutex);
+	for (auto const& [Key, Bytes] : Baselines)
+	{
+		// Flows that were evicted in the meantime are dropped by the next sweep
+		Flows[Key] = WFlowState{ Bytes, SweepGeneration };
+	}
+}
+
+void WUdpFlowMap::ForgetSocket(WSocketCookie const Cookie)
+{
+	std::scoped_lock Lock(Mutex);
+	RemovedSockets.insert(Cookie);
+}
+
+WBytes WUdpFlowMap::GetMemoryUsage()
+{
+	std::scoped_lock Lock(Mutex);
+	return Flows.size() * (sizeof(WUdpFlowKey) + sizeof(WFlowState) + sizeof(void*) * 2)
+		+ RemovedSockets.size() * (sizeof(WSocketCookie) + sizeof(void*) * 2)
+		+ KeyBuffer.capacity() * sizeof(WUdpFlowKey) + ValueBuffer.capacity() * sizeof(WUdpFlowValue);
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "EBPFCommon.h"
+#include "IPAddress.hpp"
+#include "Types.hpp"
+
+struct bpf_map;
+
+// Traffic between a socket and one of its UDP peers since the last sweep
+struct WUdpFlowTraffic
+{
+	WSocketCookie Cookie{};
+	WEndpoint     RemoteEndpoint{};
+	uint8_t       Direction{}; // EPacketDirection
+	WBytes        Bytes{};
+};
+
+/**
+ * Reads the per peer UDP counters of the eBPF program. The kernel only keeps running totals per CPU,
+ * so the last total of every flow is remembered to get the traffic since the previous sweep.
+ * Flows of removed sockets are deleted from the kernel map on the next sweep, the LRU takes care of the rest.
+ */
+class WUdpFlowMap
+{
+	struct WFlowKeyHash
+	{
+		std::size_t operator()(WUdpFlowKey const& Key) const
+		{
+			return std::hash<std::string_view>{}(std::string_view(reinterpret_cast<char const*>(&Key), sizeof(Key)));
+		}
+	};
+
+	struct WFlowKeyEqual
+	{
+		bool operator()(WUdpFlowKey const& A, WUdpFlowKey const& B) const
+		{
+			return std::memcmp(&A, &B, sizeof(WUdpFlowKey)) == 0;
+		}
+	};
+
+	struct WFlowState
+	{
+		WBytes   Bytes{};
+		uint32_t SweepGeneration{};
+	};
+
+	using WFlowVisitor = std::function<void(WUdpFlowKey const&, WUdpFlowValue const*)>;
+
+	static constexpr uint32_t BatchSize = 1024;
+
+	int         MapFd{ -1 };
+	std::size_t CpuCount{ 1 };
+	bool        bBatchLookup{ true };
+
+	std::mutex                                                               Mutex;
+	std::unordered_map<WUdpFlowKey, WFlowState, WFlowKeyHash, WFlowKeyEqual> Flows{};
+	std::unordered_set<WSocketCookie>                                        RemovedSockets{};
+	uint32_t                                                                 SweepGeneration{};
+
+	std::vector<WUdpFlowKey>   KeyBuffer{};
+	std::vector<WUdpFlowValue> ValueBuffer{}; // one value per possible CPU for every key
+
+	// Returns false if the kernel doesn't support batched lookups
+	bool ReadBatched(WFlowVisitor const& Visit);
+	void ReadByKey(WFlowVisitor const& Visit);
+
+public:
+	explicit WUdpFlowMap(bpf_map const* Map);
+
+	[[nodiscard]] bool IsValid() const { return MapFd >= 0; }
+
+	std::vector<WUdpFlowTraffic> Sweep();
+
+	// Kernel totals of every flow at the last sweep, so a hot restart continues where the last run stopped
+	std::vector<std::pair<WUdpFlowKey, WBytes>> GetBaselines();
+	void RestoreBaselines(std::vector<std::pair<WUdpFlowKey, WBytes>> const& Baselines);
+
+	void ForgetSocket(WSocketCookie Cookie);
+
+	WBytes GetMemoryUsage();
+};
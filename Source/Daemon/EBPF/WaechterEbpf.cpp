@@ -5,7 +5,9 @@
 
 #include "WaechterEbpf.hpp"
 
+#include <array>
 #include <bpf/bpf.h>
+#include <ctime>
 #include <dirent.h>
 #include <fstream>
 #include <sstream>
@@ -14,12 +16,19 @@
 #include "spdlog/spdlog.h"
 #include "tracy/Tracy.hpp"
 
+#include "DaemonConfig.hpp"
 #include "EbpfData.hpp"
 #include "EBPFCommon.h"
+#include "SocketEventLog.hpp"
 #include "Types.hpp"
 #include "Format.hpp"
+#include "HotRestart.hpp"
 #include "NetworkInterface.hpp"
+#include "PipelineMetricsCollector.hpp"
+#include "Data/NetworkEvents.hpp"
+#include "Data/ProcessInfoCache.hpp"
 #include "Data/SystemMap.hpp"
+#include "Net/DnsCache.hpp"
 #include "Net/IPLink.hpp"
 
 WWaechterEbpf::WWaechterEbpf() = default;
@@ -29,7 +38,23 @@ WWaechterEbpf::~WWaechterEbpf()
 	waechter_ebpf__destroy(Skeleton);
 }
 
-EEbpfInitResult WWaechterEbpf::Init()
+namespace
+{
+	// Filled from the config on every start, or only valid for the programs that created them.
+	// The rules and marks are set up again by the rule manager, which drops process and socket rules on a restart
+	constexpr std::array<char const*, 8> UnpinnedMaps{
+		"excluded_interfaces",
+		"excluded_ports",
+		"excluded_cgroups",
+		"socket_rule_cache",
+		"socket_rules",
+		"system_rules",
+		"ingress_port_marks",
+		"pid_download_marks",
+	};
+} // namespace
+
+EEbpfInitResult WWaechterEbpf::OpenAndLoad(WKernelExclusions const& Exclusions)
 {
 	Skeleton = waechter_ebpf__open();
 	if (!Skeleton)
@@ -39,25 +64,70 @@ EEbpfInitResult WWaechterEbpf::Init()
 	}
 
 	Skeleton->rodata->IngressInterfaceId = static_cast<int>(WIPLink::GetInstance().WaechterIngressIfIndex);
+	Skeleton->rodata->DnsSnoopingEnabled = WDaemonConfig::GetInstance().bSnoopDns ? 1 : 0;
+	Skeleton->rodata->UdpFlowAccountingEnabled = WDaemonConfig::GetInstance().bKernelUdpAccounting ? 1 : 0;
+	Skeleton->rodata->CgroupAccountingEnabled = WDaemonConfig::GetInstance().bCgroupAccounting ? 1 : 0;
+	Skeleton->rodata->ExcludeLoopback = Exclusions.bLoopback ? 1 : 0;
+	Skeleton->rodata->ExcludeInterfaces = Exclusions.IfIndexes.empty() ? 0 : 1;
+	Skeleton->rodata->ExcludePorts = Exclusions.Ports.empty() ? 0 : 1;
+	Skeleton->rodata->ExcludeCgroups = Exclusions.CgroupIds.empty() ? 0 : 1;
 	Obj = Skeleton->obj;
 
-	auto Result = waechter_ebpf__load(Skeleton);
+	if (!PinDirectory.empty())
+	{
+		PinMaps(UnpinnedMaps);
+	}
 
-	if (Result != 0)
+	if (auto const Result = waechter_ebpf__load(Skeleton); Result != 0)
 	{
 		spdlog::error("Failed to load eBPF object: {}", Result);
 		return EEbpfInitResult::Load_Failed;
 	}
+	return EEbpfInitResult::Success;
+}
 
-	Result = waechter_ebpf__attach(Skeleton);
+EEbpfInitResult WWaechterEbpf::Init()
+{
+	auto& HotRestart = WHotRestart::GetInstance();
+	if (HotRestart.IsEnabled())
+	{
+		PinDirectory = HotRestart.GetPinDirectory();
+	}
+	bReplaceAttached = HotRestart.IsHotStart();
 
-	if (Result != 0)
+	auto const Exclusions = WKernelExclusions::FromConfig(
+		WDaemonConfig::GetInstance().Exclusions, WDaemonConfig::GetInstance().CGroupPath);
+	auto InitResult = OpenAndLoad(Exclusions);
+	if (InitResult == EEbpfInitResult::Load_Failed && bReplaceAttached)
+	{
+		spdlog::warn("Couldn't reuse the eBPF maps of the previous run, starting over");
+		waechter_ebpf__destroy(Skeleton);
+		Skeleton = nullptr;
+		Obj = nullptr;
+		bReplaceAttached = false;
+		HotRestart.Discard();
+		InitResult = OpenAndLoad(Exclusions);
+	}
+
+	if (InitResult != EEbpfInitResult::Success)
+	{
+		return InitResult;
+	}
+
+	// After a hot restart the programs of the previous run keep running next to these until their links are removed
+	if (auto const Result = waechter_ebpf__attach(Skeleton); Result != 0)
 	{
 		spdlog::error("Failed to attach eBPF programs: {}", Result);
 		return EEbpfInitResult::Attach_Failed;
 	}
 
 	Data = std::make_shared<WEbpfData>(*this);
+	SetupExclusions(Exclusions);
+	if (auto const* Baselines = HotRestart.GetKernelCounters(); bReplaceAttached && Baselines)
+	{
+		// The pinned maps kept counting, only what came after the last sweep of the previous run is new
+		Data->RestoreKernelCounterBaselines(*Baselines);
+	}
 
 	if (!FindAndAttachProgram("cgskb_ingress", BPF_CGROUP_INET_INGRESS))
 	{
@@ -102,11 +172,52 @@ EEbpfInitResult WWaechterEbpf::Init()
 		return EEbpfInitResult::Attach_Failed;
 	}
 
-	PrePopulatePortToPid();
+	if (bReplaceAttached)
+	{
+		RemoveStaleLinkPins();
+	}
+	else
+	{
+		// After a hot restart port_to_pid is still filled
+		PrePopulatePortToPid();
+	}
+	SetupProcessEvents();
+	SetupUdpFlows();
 
 	return EEbpfInitResult::Success;
 }
 
+bool WWaechterEbpf::KeepAttached()
+{
+	if (PinDirectory.empty())
+	{
+		return false;
+	}
+
+	// The programs the skeleton attached by itself, the others are in Links
+	auto const* ObjSkeleton = Skeleton->skeleton;
+	for (int i = 0; i < ObjSkeleton->prog_cnt; ++i)
+	{
+		auto const& Program = ObjSkeleton->progs[i];
+		if (*Program.link && !PinLink(*Program.link, *Program.prog))
+		{
+			return false;
+		}
+	}
+	return PinLinks();
+}
+
+bool WWaechterEbpf::StartRecording(std::string const& Path)
+{
+	Recorder = std::make_unique<WSocketEventRecorder>(Path);
+	if (!Recorder->IsValid())
+	{
+		Recorder.reset();
+		return false;
+	}
+	return true;
+}
+
 void WWaechterEbpf::PrintStats()
 {
 	spdlog::info("System Traffic: Download Speed: {}, Upload Speed: {}",
@@ -117,8 +228,30 @@ void WWaechterEbpf::PrintStats()
 void WWaechterEbpf::UpdateData()
 {
 	Data->UpdateData();
+	HandleQueuedEvents();
+}
+
+void WWaechterEbpf::ConsumeData()
+{
+	Data->ConsumeData();
+	HandleQueuedEvents();
+}
+
+void WWaechterEbpf::HandleQueuedEvents()
+{
+	HandleDnsAnswers();
 	std::lock_guard Lock(Data->SocketEvents->GetDataMutex());
 	auto&           SocketEventQueue = Data->SocketEvents->GetData();
+	auto&           Metrics = WPipelineMetricsCollector::GetInstance();
+	Metrics.RecordQueueDepth(SocketEventQueue.size());
+	auto const RingDrops = Data->GetSocketEventRingDrops();
+	Metrics.SetRingDrops(RingDrops);
+	if (RingDrops > LastRingDrops)
+	{
+		// Process exits might have been among the dropped events
+		WProcessInfoCache::GetInstance().RequestResync();
+		LastRingDrops = RingDrops;
+	}
 
 	if (SocketEventQueue.size() > 100)
 	{
@@ -141,101 +274,295 @@ void WWaechterEbpf::UpdateData()
 
 	while (!SocketEventQueue.empty())
 	{
-		auto& SocketEvent = SocketEventQueue.front();
-
-		// extract the PID
-		uint64_t Raw = SocketEvent.PidTgId;
-		auto     Tgid = static_cast<WProcessId>(Raw >> 32);
-
-#if WDEBUG
-
-		static constexpr char const* EventNames[] = { "SocketCreate", "SocketConnect_4", "SocketConnect_6",
-			"SocketBind_4", "SocketBind_6", "TCPSocketEstablished_4", "TCPSocketEstablished_6", "TCPSocketListening",
-			"SocketAccept_4", "SocketAccept_6", "SocketClosed", "Traffic" };
-		auto const  EventTypeIdx = static_cast<unsigned>(SocketEvent.EventType);
-		auto const* EventName = EventTypeIdx < std::size(EventNames) ? EventNames[EventTypeIdx] : "Unknown";
-		if (SocketEvent.EventType != NE_Traffic)
+		auto const& SocketEvent = SocketEventQueue.front();
+		if (Recorder)
 		{
-			spdlog::trace("[eBPF event] type={} cookie={} pid={}", EventName, SocketEvent.Cookie, Tgid);
+			Recorder->Append(SocketEvent);
 		}
-
-		if (SocketEvent.EventType == NE_TCPSocketEstablished_4 || SocketEvent.EventType == NE_TCPSocketEstablished_6)
+		HandleSocketEvent(SocketEvent);
+		if (SocketEvent.EventType == NE_Traffic)
 		{
-			spdlog::trace("[eBPF TCP_ESTABLISHED] cookie={} pid={} localPort={} remotePort={} isAccept={}",
-				SocketEvent.Cookie, Tgid, SocketEvent.Data.TCPSocketEstablishedEventData.UserPort,
-				SocketEvent.Data.TCPSocketEstablishedEventData.RemotePort,
-				SocketEvent.Data.TCPSocketEstablishedEventData.bIsAccept);
+			// Same clock as bpf_ktime_get_ns(). Measured here rather than in HandleSocketEvent because replayed
+			// events go through that too and their timestamps are from the recording
+			timespec Now{};
+			clock_gettime(CLOCK_MONOTONIC, &Now);
+			auto const NowNs = static_cast<uint64_t>(Now.tv_sec) * 1000000000ull + static_cast<uint64_t>(Now.tv_nsec);
+			auto const Timestamp = SocketEvent.Data.TrafficEventData.Timestamp;
+			Metrics.RecordLatency(EPipelineStage::KernelToCounter, NowNs > Timestamp ? NowNs - Timestamp : 0);
 		}
+		SocketEventQueue.pop_front();
+	}
+}
 
-		if (SocketEvent.EventType == NE_SocketAccept_4 || SocketEvent.EventType == NE_SocketAccept_6)
+void WWaechterEbpf::HandleRecordedEvent(WSocketEvent const& RecordedEvent)
+{
+	auto& SystemMap = WSystemMap::GetInstance();
+	switch (RecordedEvent.EventType)
+	{
+		case RS_UdpFlowTraffic:
+		{
+			auto const Flow = WSocketEventLog::GetSweep<WUdpFlowTraffic>(RecordedEvent);
+			SystemMap.PushUdpFlowTraffic(std::span(&Flow, 1));
+			break;
+		}
+		case RS_CgroupTraffic:
+		{
+			auto const Cgroup = WSocketEventLog::GetSweep<WCgroupTraffic>(RecordedEvent);
+			SystemMap.PushCgroupTraffic(std::span(&Cgroup, 1));
+			break;
+		}
+		case RS_LoopbackTraffic:
 		{
-			spdlog::trace("[eBPF SocketAccept] cookie={} pid={} srcPort={} dstPort={}", SocketEvent.Cookie, Tgid,
-				SocketEvent.Data.SocketAcceptEventData.SourcePort,
-				SocketEvent.Data.SocketAcceptEventData.DestinationPort);
+			auto const Loopback = WSocketEventLog::GetSweep<WLoopbackTraffic>(RecordedEvent);
+			SystemMap.PushExcludedLoopbackTraffic(Loopback.Download, Loopback.Upload);
+			break;
 		}
+		default:
+			HandleSocketEvent(RecordedEvent);
+			break;
+	}
+}
+
+void WWaechterEbpf::HandleSocketEvent(WSocketEvent const& SocketEvent)
+{
+	// extract the PID
+	uint64_t Raw = SocketEvent.PidTgId;
+	auto     Tgid = static_cast<WProcessId>(Raw >> 32);
+
+	WPipelineMetricsCollector::GetInstance().CountEvent(SocketEvent.EventType);
+
+#if WDEBUG
+	auto const* EventName = WPipelineMetricsCollector::GetEventTypeName(SocketEvent.EventType);
+	if (SocketEvent.EventType != NE_Traffic)
+	{
+		spdlog::trace("[eBPF event] type={} cookie={} pid={}", EventName, SocketEvent.Cookie, Tgid);
+	}
+
+	if (SocketEvent.EventType == NE_TCPSocketEstablished_4 || SocketEvent.EventType == NE_TCPSocketEstablished_6)
+	{
+		spdlog::trace("[eBPF TCP_ESTABLISHED] cookie={} pid={} localPort={} remotePort={} isAccept={}",
+			SocketEvent.Cookie, Tgid, SocketEvent.Data.TCPSocketEstablishedEventData.UserPort,
+			SocketEvent.Data.TCPSocketEstablishedEventData.RemotePort,
+			SocketEvent.Data.TCPSocketEstablishedEventData.bIsAccept);
+	}
+
+	if (SocketEvent.EventType == NE_SocketAccept_4 || SocketEvent.EventType == NE_SocketAccept_6)
+	{
+		spdlog::trace("[eBPF SocketAccept] cookie={} pid={} srcPort={} dstPort={}", SocketEvent.Cookie, Tgid,
+			SocketEvent.Data.SocketAcceptEventData.SourcePort,
+			SocketEvent.Data.SocketAcceptEventData.DestinationPort);
+	}
 #endif
 
-		/*
-		 This will also create the application/process/socket entries as needed
-		 NE_Traffic and NE_SocketClose usually have PID set to 0, so for those to be properly associated with a process,
-		 the daemon has to first capture the socket creation and connection events for that socket cookie.
-		 So for traffic events we fail silently if no matching socket is found because it usually just means
-		 we weren't around to capture the socket creation/connection.
-		*/
-		auto const bSilentFail = SocketEvent.EventType == NE_Traffic || SocketEvent.EventType == NE_SocketClosed
-			|| SocketEvent.EventType == NE_TCPSocketEstablished_4 || SocketEvent.EventType == NE_TCPSocketEstablished_6;
-		auto SocketInfo = WSystemMap::GetInstance().MapSocket(SocketEvent, Tgid, bSilentFail);
-
-		switch (SocketEvent.EventType)
-		{
-			case NE_SocketAccept_4:
-			case NE_SocketAccept_6:
-			case NE_TCPSocketListening:
-			case NE_SocketBind_4:
-			case NE_SocketBind_6:
-			case NE_SocketCreate:
-			case NE_SocketConnect_4:
-			case NE_SocketConnect_6:
-			case NE_TCPSocketEstablished_4:
-			case NE_TCPSocketEstablished_6:
-				if (SocketInfo)
+	// Process events aren't tied to a socket
+	if (SocketEvent.EventType == NE_ProcessFork || SocketEvent.EventType == NE_ProcessExec
+		|| SocketEvent.EventType == NE_ProcessExit)
+	{
+		HandleProcessEvent(SocketEvent);
+		return;
+	}
+
+	// Maps the socket itself if needed, the PID isn't known in the cgroup_skb programs
+	if (SocketEvent.EventType == NE_UDPPeer)
+	{
+		WSystemMap::GetInstance().HandleUDPPeer(SocketEvent);
+		return;
+	}
+
+	/*
+	 This will also create the application/process/socket entries as needed
+	 NE_Traffic and NE_SocketClose usually have PID set to 0, so for those to be properly associated with a process,
+	 the daemon has to first capture the socket creation and connection events for that socket cookie.
+	 So for traffic events we fail silently if no matching socket is found because it usually just means
+	 we weren't around to capture the socket creation/connection.
+	*/
+	auto const bSilentFail = SocketEvent.EventType == NE_Traffic || SocketEvent.EventType == NE_SocketClosed
+		|| SocketEvent.EventType == NE_TCPSocketEstablished_4 || SocketEvent.EventType == NE_TCPSocketEstablished_6;
+	auto SocketInfo = WSystemMap::GetInstance().MapSocket(SocketEvent, Tgid, bSilentFail);
+
+	switch (SocketEvent.EventType)
+	{
+		case NE_SocketAccept_4:
+		case NE_SocketAccept_6:
+		case NE_TCPSocketListening:
+		case NE_SocketBind_4:
+		case NE_SocketBind_6:
+		case NE_SocketCreate:
+		case NE_SocketConnect_4:
+		case NE_SocketConnect_6:
+		case NE_TCPSocketEstablished_4:
+		case NE_TCPSocketEstablished_6:
+			if (SocketInfo)
+			{
+				ZoneScopedN("ProcessSocketEvent");
 				{
-					ZoneScopedN("ProcessSocketEvent");
+					// The connection handlers resolve the process and app through the counter slab
+					std::scoped_lock Lock(WSystemMap::GetInstance().DataMutex);
 					SocketInfo->ProcessSocketEvent(SocketEvent);
-
-					// If a synthetic-cookie socket entry (from AddExistingSockets) already
-					// exists for the same port and process, merge its correct /proc/net/
-					// endpoint into this real-cookie socket and remove the duplicate.
-					WSystemMap::GetInstance().MergeSyntheticSocket(SocketInfo);
-
-					// port_to_pid holds the master PID (from bind()), but the accepted socket
-					// fd is owned by a worker process. Delegate PID resolution to the IPLink
-					// process (which runs as root) via the same orphan-lookup path used for
-					// fork() reparenting.
-					if (SocketEvent.EventType == NE_SocketAccept_4 || SocketEvent.EventType == NE_SocketAccept_6)
-					{
-						WSystemMap::GetInstance().ReparentAcceptedSocket(SocketInfo);
-					}
 				}
-				break;
-			case NE_Traffic:
-				if (SocketEvent.Data.TrafficEventData.Direction == PD_Incoming)
+
+				// If a synthetic-cookie socket entry (from AddExistingSockets) already
+				// exists for the same port and process, merge its correct /proc/net/
+				// endpoint into this real-cookie socket and remove the duplicate.
+				WSystemMap::GetInstance().MergeSyntheticSocket(SocketInfo);
+			}
+			break;
+		case NE_Traffic:
+			if (SocketEvent.Data.TrafficEventData.Direction == PD_Incoming)
+			{
+				ZoneScopedN("PushIncomingTraffic");
+				WSystemMap::GetInstance().PushIncomingTraffic(SocketEvent);
+			}
+			else if (SocketEvent.Data.TrafficEventData.Direction == PD_Outgoing)
+			{
+				ZoneScopedN("PushOutgoingTraffic");
+				WSystemMap::GetInstance().PushOutgoingTraffic(SocketEvent);
+			}
+			break;
+		case NE_SocketClosed:
+			WSystemMap::GetInstance().MarkSocketForRemoval(SocketEvent);
+			break;
+		default:;
+	}
+}
+
+void WWaechterEbpf::HandleDnsAnswers() const
+{
+	if (!Data->DnsAnswers)
+	{
+		return;
+	}
+
+	ZoneScopedN("HandleDnsAnswers");
+	std::lock_guard Lock(Data->DnsAnswers->GetDataMutex());
+	auto&           AnswerQueue = Data->DnsAnswers->GetData();
+	for (auto const& Answer : AnswerQueue)
+	{
+		auto const Size = std::min<std::size_t>(Answer.Size, sizeof(Answer.Payload));
+		WDnsCache::GetInstance().HandleResponse(std::span(Answer.Payload, Size));
+	}
+	AnswerQueue.clear();
+}
+
+void WWaechterEbpf::HandleProcessEvent(WSocketEvent const& Event)
+{
+	ZoneScopedN("HandleProcessEvent");
+	auto const PID = static_cast<WProcessId>(Event.Data.ProcessEventData.Pid);
+	switch (Event.EventType)
+	{
+		case NE_ProcessFork:
+			WProcessInfoCache::GetInstance().HandleProcessFork(PID);
+			WSystemMap::GetInstance().HandleProcessFork(
+				static_cast<WProcessId>(Event.Data.ProcessEventData.ParentPid), PID);
+			break;
+		case NE_ProcessExec:
+			WProcessInfoCache::GetInstance().HandleProcessExec(PID);
+			break;
+		case NE_ProcessExit:
+			WProcessInfoCache::GetInstance().HandleProcessExit(PID);
+			WSystemMap::GetInstance().HandleProcessExit(PID);
+			break;
+		default:;
+	}
+}
+
+// The process tracepoints are only compiled in with BTF support, without them
+// the daemon falls back to the netlink process connector for exit notifications
+void WWaechterEbpf::SetupProcessEvents() const
+{
+	if (!bpf_object__find_program_by_name(Obj, "on_sched_process_exit"))
+	{
+		spdlog::info("eBPF process events are not available");
+		return;
+	}
+
+	WProcessInfoCache::GetInstance().UseKernelProcessEvents();
+
+	// Processes that created their sockets before the daemon started have to be tracked manually
+	if (Data->TrackedPids && Data->TrackedPids->IsValid())
+	{
+		WNetworkEvents::GetInstance().OnProcessCreated.connect(
+			[EbpfData = Data](std::shared_ptr<WProcessCounter> const& Process) {
+				auto const PID = static_cast<uint32_t>(Process->TrafficItem->ProcessId);
+				EbpfData->TrackedPids->Update(PID, 1, BPF_NOEXIST);
+			});
+	}
+}
+
+void WWaechterEbpf::SetupUdpFlows() const
+{
+	if (!Data->UdpFlows || !Data->UdpFlows->IsValid())
+	{
+		spdlog::info("UDP traffic is counted in userspace");
+		return;
+	}
+
+	WNetworkEvents::GetInstance().OnSocketRemoved.connect(
+		[EbpfData = Data](std::shared_ptr<WSocketCounter> const& Socket) {
+			EbpfData->UdpFlows->ForgetSocket(Socket->TrafficItem->Cookie);
+		});
+	spdlog::info("UDP traffic is counted per peer in the kernel");
+}
+
+void WWaechterEbpf::SetupExclusions(WKernelExclusions const& Exclusions) const
+{
+	if (!Data->Exclusions)
+	{
+		return;
+	}
+
+	// Runs before the cgroup programs are attached, so no excluded traffic slips through
+	Data->Exclusions->Populate(Exclusions);
+}
+
+void WWaechterEbpf::SweepKernelCounters() const
+{
+	if (!Data)
+	{
+		return;
+	}
+
+	if (Data->UdpFlows && Data->UdpFlows->IsValid())
+	{
+		if (auto const Flows = Data->UdpFlows->Sweep(); !Flows.empty())
+		{
+			WSystemMap::GetInstance().PushUdpFlowTraffic(Flows);
+			if (Recorder)
+			{
+				for (auto const& Flow : Flows)
 				{
-					ZoneScopedN("PushIncomingTraffic");
-					WSystemMap::GetInstance().PushIncomingTraffic(SocketEvent);
+					Recorder->AppendSweep(RS_UdpFlowTraffic, Flow);
 				}
-				else if (SocketEvent.Data.TrafficEventData.Direction == PD_Outgoing)
+			}
+		}
+	}
+
+	if (Data->CgroupTraffic && Data->CgroupTraffic->IsValid())
+	{
+		if (auto const Traffic = Data->CgroupTraffic->Sweep(); !Traffic.empty())
+		{
+			WSystemMap::GetInstance().PushCgroupTraffic(Traffic);
+			if (Recorder)
+			{
+				for (auto const& Cgroup : Traffic)
 				{
-					ZoneScopedN("PushOutgoingTraffic");
-					WSystemMap::GetInstance().PushOutgoingTraffic(SocketEvent);
+					Recorder->AppendSweep(RS_CgroupTraffic, Cgroup);
 				}
-				break;
-			case NE_SocketClosed:
-				WSystemMap::GetInstance().MarkSocketForRemoval(SocketEvent);
-				break;
-			default:;
+			}
+		}
+	}
+
+	if (Data->Exclusions && Data->Exclusions->IsValid())
+	{
+		auto const [Upload, Download] = Data->Exclusions->SweepLoopbackTraffic();
+		if (Upload != 0 || Download != 0)
+		{
+			WSystemMap::GetInstance().PushExcludedLoopbackTraffic(Download, Upload);
+			if (Recorder)
+			{
+				Recorder->AppendSweep(RS_LoopbackTraffic, WLoopbackTraffic{ Download, Upload });
+			}
 		}
-		SocketEventQueue.pop_front();
 	}
 }
 
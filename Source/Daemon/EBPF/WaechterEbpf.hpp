@@ -5,12 +5,17 @@
 
 #pragma once
 #include <memory>
+#include <string>
 
 #include "WaechterEBPF.skel.h"
 #include "EbpfObj.hpp"
 #include "Types.hpp"
+#include "EBPFCommon.h"
+
+struct WKernelExclusions;
 
 class WEbpfData;
+class WSocketEventRecorder;
 
 enum class EEbpfInitResult
 {
@@ -22,10 +27,21 @@ enum class EEbpfInitResult
 
 class WWaechterEbpf : public WEbpfObj
 {
-	std::shared_ptr<WEbpfData> Data{};
-	WMsec                      QueuePileupStartTime{};
+	std::shared_ptr<WEbpfData>            Data{};
+	WMsec                                 QueuePileupStartTime{};
+	uint64_t                              LastRingDrops{};
+	std::unique_ptr<WSocketEventRecorder> Recorder{};
+
+	EEbpfInitResult OpenAndLoad(WKernelExclusions const& Exclusions);
 
 	void PrePopulatePortToPid() const;
+	void SetupProcessEvents() const;
+	void SetupUdpFlows() const;
+	void SetupExclusions(WKernelExclusions const& Exclusions) const;
+
+	static void HandleProcessEvent(WSocketEvent const& Event);
+	void        HandleDnsAnswers() const;
+	void        HandleQueuedEvents();
 
 public:
 	waechter_ebpf* Skeleton{};
@@ -38,5 +54,27 @@ public:
 	std::shared_ptr<WEbpfData> GetData() { return Data; }
 
 	static void PrintStats();
-	void        UpdateData();
+
+	// Waits up to 500 ms for new events and handles them
+	void UpdateData();
+
+	// Handles the events that are already in the ring buffers, for the event loop
+	void ConsumeData();
+
+	// Processes a single event from the ring buffer, replayed events go through here as well
+	static void HandleSocketEvent(WSocketEvent const& SocketEvent);
+
+	// Processes a single event from a recorded log, which also contains the swept kernel counters
+	static void HandleRecordedEvent(WSocketEvent const& RecordedEvent);
+
+	// Appends all socket events and swept kernel counters to a log that can be replayed without eBPF,
+	// has to be called before polling starts
+	bool StartRecording(std::string const& Path);
+
+	// Pins all links so the programs keep running into the pinned maps after the daemon exits, see WHotRestart
+	bool KeepAttached();
+
+	// Counts the traffic the eBPF program summed up since the last call (UDP flows, cgroups and excluded loopback),
+	// has to run before the counters refresh
+	void SweepKernelCounters() const;
 };
@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "EventLoop.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <ctime>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "spdlog/spdlog.h"
+#include "tracy/Tracy.hpp"
+
+#include "ErrnoUtil.hpp"
+#include "Socket.hpp"
+
+namespace
+{
+	// Watch id of the eventfd that interrupts epoll_wait, regular ids start at 1
+	constexpr uint64_t WakeWatchId = 0;
+
+	timespec ToTimespec(double const Seconds)
+	{
+		double     Whole{};
+		auto const Fraction = std::modf(Seconds, &Whole);
+		return { static_cast<time_t>(Whole), static_cast<long>(Fraction * 1e9) };
+	}
+} // namespace
+
+WEventLoop::~WEventLoop()
+{
+	for (auto const& Timer : Timers)
+	{
+		close(Timer->Fd);
+	}
+	if (WakeFd >= 0)
+	{
+		close(WakeFd);
+	}
+	if (EpollFd >= 0)
+	{
+		close(EpollFd);
+	}
+}
+
+bool WEventLoop::Init(std::size_t const WorkerThreads)
+{
+	EpollFd = epoll_create1(EPOLL_CLOEXEC);
+	WakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	epoll_event WakeEvent{};
+	WakeEvent.events = EPOLLIN;
+	WakeEvent.data.u64 = WakeWatchId;
+	if (EpollFd < 0 || WakeFd < 0 || epoll_ctl(EpollFd, EPOLL_CTL_ADD, WakeFd, &WakeEvent) != 0)
+	{
+		spdlog::error("Failed to set up the event loop: {}", WErrnoUtil::StrError());
+		if (WakeFd >= 0)
+		{
+			close(WakeFd);
+			WakeFd = -1;
+		}
+		if (EpollFd >= 0)
+		{
+			close(EpollFd);
+			EpollFd = -1;
+		}
+		return false;
+	}
+
+	bRunning = true;
+	Workers.Start(WorkerThreads);
+	TimerWorker.Start(1);
+	spdlog::info("Using the epoll event loop with {} worker threads", WorkerThreads);
+	return true;
+}
+
+void WEventLoop::Run()
+{
+	tracy::SetThreadName("event-loop");
+	pthread_setname_np(pthread_self(), "event-loop");
+
+	std::array<epoll_event, 32> Events{};
+	while (bRunning)
+	{
+		int const Count = epoll_wait(EpollFd, Events.data(), static_cast<int>(Events.size()), -1);
+		if (Count < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			spdlog::error("epoll_wait failed: {}", WErrnoUtil::StrError());
+			break;
+		}
+
+		for (std::size_t i = 0; i < static_cast<std::size_t>(Count); ++i)
+		{
+			auto const& Event = Events[i];
+			if (Event.data.u64 == WakeWatchId)
+			{
+				uint64_t Value{};
+				[[maybe_unused]] auto const Unused = read(WakeFd, &Value, sizeof(Value));
+				continue;
+			}
+
+			// A handler can remove its own watch (or one later in this batch), so it's looked up for every event
+			std::shared_ptr<WHandler const> Handler{};
+			{
+				std::scoped_lock Lock(WatchesMutex);
+				if (auto const It = Watches.find(Event.data.u64); It != Watches.end())
+				{
+					Handler = It->second.Handler;
+				}
+			}
+			if (Handler)
+			{
+				(*Handler)(Event.events);
+			}
+		}
+	}
+
+	TimerWorker.Stop();
+	Workers.Stop();
+}
+
+void WEventLoop::Stop()
+{
+	bRunning = false;
+	if (WakeFd >= 0)
+	{
+		uint64_t const One = 1;
+		[[maybe_unused]] auto const Unused = write(WakeFd, &One, sizeof(One));
+	}
+}
+
+uint64_t WEventLoop::Add(int const Fd, uint32_t const Events, WHandler Handler)
+{
+	std::scoped_lock Lock(WatchesMutex);
+	auto const       Id = NextWatchId++;
+	epoll_event      Event{};
+	Event.events = Events;
+	Event.data.u64 = Id;
+	if (epoll_ctl(EpollFd, EPOLL_CTL_ADD, Fd, &Event) != 0)
+	{
+		spdlog::error("Failed to add fd {} to the event loop: {}", Fd, WErrnoUtil::StrError());
+		return 0;
+	}
+	Watches.emplace(Id, WWatch{ Fd, std::make_shared<WHandler const>(std::move(Handler)) });
+	return Id;
+}
+
+void WEventLoop::Remove(uint64_t const WatchId)
+{
+	std::scoped_lock Lock(WatchesMutex);
+	auto const       It = Watches.find(WatchId);
+	if (It == Watches.end())
+	{
+		return;
+	}
+	int const Fd = It->second.Fd;
+	Watches.erase(It);
+
+	// If the fd was closed already epoll dropped it by itself, and its number might belong to a newer watch by now
+	if (std::ranges::none_of(Watches, [Fd](auto const& Watch) { return Watch.second.Fd == Fd; }))
+	{
+		epoll_ctl(EpollFd, EPOLL_CTL_DEL, Fd, nullptr);
+	}
+}
+
+bool WEventLoop::AddSocket(std::shared_ptr<WClientSocket> const& Socket)
+{
+	auto const Id = Add(Socket->GetFd(), EPOLLIN, [Socket](uint32_t) { Socket->ReceiveAvailable(); });
+	if (Id == 0)
+	{
+		return false;
+	}
+	Socket->OnClosed.connect([this, Id] { Remove(Id); });
+
+	// Closed before the slot was connected
+	if (!Socket->IsConnected())
+	{
+		Remove(Id);
+	}
+	return true;
+}
+
+bool WEventLoop::ArmTimer(WLoopTimer const& Timer)
+{
+	itimerspec Spec{};
+	Spec.it_interval = ToTimespec(Timer.Interval);
+	if (!Timer.bAlignToWallClock)
+	{
+		// The kernel keeps the period, so the ticks don't drift no matter how long the callbacks take
+		Spec.it_value = Spec.it_interval;
+		return timerfd_settime(Timer.Fd, 0, &Spec, nullptr) == 0;
+	}
+
+	timespec Now{};
+	clock_gettime(CLOCK_REALTIME, &Now);
+	auto const Interval = std::max<time_t>(1, static_cast<time_t>(Timer.Interval));
+	Spec.it_value.tv_sec = (Now.tv_sec / Interval + 1) * Interval;
+
+	// Setting the clock cancels the timer, it's aligned again in OnTimerExpired
+	return timerfd_settime(Timer.Fd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &Spec, nullptr) == 0;
+}
+
+void WEventLoop::OnTimerExpired(std::shared_ptr<WLoopTimer> const& Timer)
+{
+	uint64_t Expirations{};
+	if (read(Timer->Fd, &Expirations, sizeof(Expirations)) < 0)
+	{
+		if (errno == ECANCELED)
+		{
+			spdlog::debug("System clock changed, aligning timer again");
+			ArmTimer(*Timer);
+		}
+		return;
+	}
+
+	if (Timer->bQueued.exchange(true))
+	{
+		return;
+	}
+	TimerWorker.Post([Timer] {
+		Timer->Callback();
+		Timer->bQueued = false;
+	});
+}
+
+bool WEventLoop::AddLoopTimer(
+	double const IntervalSeconds, std::function<void()> Callback, bool const bAlignToWallClock)
+{
+	auto Timer = std::make_shared<WLoopTimer>();
+	Timer->Interval = IntervalSeconds;
+	Timer->bAlignToWallClock = bAlignToWallClock;
+	Timer->Callback = std::move(Callback);
+	Timer->Fd = timerfd_create(bAlignToWallClock ? CLOCK_REALTIME : CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (Timer->Fd < 0 || !ArmTimer(*Timer))
+	{
+		spdlog::error("Failed to create a timer: {}", WErrnoUtil::StrError());
+		if (Timer->Fd >= 0)
+		{
+			close(Timer->Fd);
+		}
+		return false;
+	}
+
+	if (Add(Timer->Fd, EPOLLIN, [this, Timer](uint32_t) { OnTimerExpired(Timer); }) == 0)
+	{
+		close(Timer->Fd);
+		return false;
+	}
+	std::scoped_lock Lock(WatchesMutex);
+	Timers.push_back(Timer);
+	return true;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <sys/epoll.h>
+
+#include "Singleton.hpp"
+#include "WorkerPool.hpp"
+
+class WClientSocket;
+
+/**
+ * Optional replacement for the daemon's polling threads, see [daemon] event_loop.
+ * A single thread waits on an epoll instance for the eBPF ring buffers, the unix sockets and timerfds
+ * and only wakes up if one of them is ready. Handlers run on that thread and mustn't block,
+ * anything that might is posted to the worker pool instead.
+ */
+class WEventLoop : public TSingleton<WEventLoop>
+{
+public:
+	using WHandler = std::function<void(uint32_t Events)>;
+
+private:
+	struct WWatch
+	{
+		int                             Fd{ -1 };
+		std::shared_ptr<WHandler const> Handler{};
+	};
+
+	struct WLoopTimer
+	{
+		int                   Fd{ -1 };
+		double                Interval{};
+		bool                  bAlignToWallClock{};
+		std::function<void()> Callback{};
+		std::atomic<bool>     bQueued{};
+	};
+
+	int               EpollFd{ -1 };
+	int               WakeFd{ -1 };
+	std::atomic<bool> bRunning{ false };
+
+	// Watches are identified by an id instead of their fd, an fd number can be reused as soon as it was closed
+	std::mutex                               WatchesMutex;
+	std::unordered_map<uint64_t, WWatch>     Watches{};
+	uint64_t                                 NextWatchId{ 1 };
+	std::vector<std::shared_ptr<WLoopTimer>> Timers{};
+
+	WWorkerPool Workers{ "worker" };
+
+	// Timer callbacks run one after another, like they did on the periodic update thread
+	WWorkerPool TimerWorker{ "timers" };
+
+	static bool ArmTimer(WLoopTimer const& Timer);
+	void        OnTimerExpired(std::shared_ptr<WLoopTimer> const& Timer);
+	bool        AddLoopTimer(double IntervalSeconds, std::function<void()> Callback, bool bAlignToWallClock);
+
+public:
+	~WEventLoop() override;
+
+	bool Init(std::size_t WorkerThreads);
+
+	[[nodiscard]] bool IsEnabled() const { return EpollFd >= 0; }
+
+	// Blocks until Stop is called, queued tasks and timer callbacks are finished before it returns
+	void Run();
+	void Stop();
+
+	// Level triggered, returns 0 on failure
+	uint64_t Add(int Fd, uint32_t Events, WHandler Handler);
+
+	// Safe to call for fds that were already closed and from within the watch's own handler
+	void Remove(uint64_t WatchId);
+
+	// Reads the socket on the loop thread instead of its listen thread, the watch is removed once it closes
+	bool AddSocket(std::shared_ptr<WClientSocket> const& Socket);
+
+	// The callback runs on the timer thread, ticks are dropped while the previous run is still busy.
+	// Aligned timers fire on multiples of the interval since the epoch (e.g. every full hour)
+	bool AddTimer(double IntervalSeconds, std::function<void()> Callback)
+	{
+		return AddLoopTimer(IntervalSeconds, std::move(Callback), false);
+	}
+
+	bool AddAlignedTimer(double IntervalSeconds, std::function<void()> Callback)
+	{
+		return AddLoopTimer(IntervalSeconds, std::move(Callback), true);
+	}
+
+	void Post(std::function<void()> Task) { Workers.Post(std::move(Task)); }
+
+	// Runs tasks right away on the posting thread if the event loop isn't used
+	[[nodiscard]] WWorkerPool& GetWorkers() { return Workers; }
+};
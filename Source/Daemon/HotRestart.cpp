@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "HotRestart.hpp"
+
+#include <csignal>
+#include <fstream>
+#include <sys/stat.h>
+
+#include "spdlog/spdlog.h"
+#include "cereal/types/array.hpp"
+#include "cereal/types/vector.hpp"
+#include "cereal/types/optional.hpp"
+#include "cereal/types/unordered_map.hpp"
+#include "cereal/types/memory.hpp"
+#include "cereal/types/string.hpp"
+#include "cereal/types/utility.hpp"
+#include "cereal/archives/binary.hpp"
+
+#include "DaemonConfig.hpp"
+#include "Filesystem.hpp"
+#include "SignalHandler.hpp"
+#include "Data/SystemMap.hpp"
+#include "EBPF/EbpfData.hpp"
+#include "EBPF/WaechterEbpf.hpp"
+
+namespace
+{
+	void OnSigusr2(int)
+	{
+		spdlog::info("Received restart signal");
+		WHotRestart::GetInstance().RequestRestart();
+		auto& Handler = WSignalHandler::GetInstance();
+		Handler.bStop = true;
+		Handler.SignalCondition.notify_all();
+	}
+} // namespace
+
+WHotRestart::WHotRestart() = default;
+
+WHotRestart::~WHotRestart() = default;
+
+std::string WHotRestart::GetBootId()
+{
+	return WFilesystem::ReadProc("/proc/sys/kernel/random/boot_id");
+}
+
+void WHotRestart::Prepare()
+{
+	auto const& Config = WDaemonConfig::GetInstance();
+	bEnabled = Config.bHotRestart;
+	if (!bEnabled)
+	{
+		// Left behind by an earlier run that had it enabled
+		RemovePins();
+		return;
+	}
+
+	// The daemon doesn't have root anymore when it pins its links on exit
+	std::error_code Error{};
+	stdfs::create_directories(PinDirectory, Error);
+	if (Error || !WFilesystem::SetSocketOwnerAndPermsByName(PinDirectory, Config.DaemonUser, Config.DaemonGroup, 0700))
+	{
+		spdlog::warn("Failed to prepare {}, hot restart is disabled", PinDirectory);
+		bEnabled = false;
+		return;
+	}
+
+	LoadState();
+	if (!bHotStart)
+	{
+		RemovePins();
+	}
+}
+
+void WHotRestart::LoadState()
+{
+	std::ifstream File(StatePath, std::ios::binary);
+	if (!File)
+	{
+		return;
+	}
+
+	std::error_code Error{};
+	auto            Loaded = std::make_unique<WSystemMapSnapshot>();
+	auto            LoadedCounters = std::make_unique<WKernelCounterBaselines>();
+	try
+	{
+		uint32_t                   Magic{}, Version{};
+		std::string                BootId{};
+		cereal::BinaryInputArchive Archive(File);
+		Archive(Magic, Version);
+		if (Magic != StateMagic || Version != StateVersion)
+		{
+			spdlog::warn("Ignoring hot restart state at {} with unknown format", StatePath);
+			File.close();
+			stdfs::remove(StatePath, Error);
+			return;
+		}
+
+		// Pinned objects don't survive a reboot
+		Archive(BootId);
+		if (BootId != GetBootId())
+		{
+			spdlog::info("Ignoring hot restart state from before the last reboot");
+			File.close();
+			stdfs::remove(StatePath, Error);
+			return;
+		}
+		Archive(*Loaded, *LoadedCounters);
+	}
+	catch (std::exception const& Ex)
+	{
+		spdlog::warn("Failed to read hot restart state from {}: {}", StatePath, Ex.what());
+		File.close();
+		stdfs::remove(StatePath, Error);
+		return;
+	}
+	File.close();
+
+	// Only used once, a crash after this starts over
+	stdfs::remove(StatePath, Error);
+	Snapshot = std::move(Loaded);
+	KernelCounters = std::move(LoadedCounters);
+	bHotStart = true;
+	spdlog::info("Resuming from the previous run");
+}
+
+bool WHotRestart::SaveState(WWaechterEbpf& Ebpf) const
+{
+	auto const    TempPath = stdfs::path(StatePath).concat(".tmp");
+	std::ofstream File(TempPath, std::ios::binary | std::ios::trunc);
+	if (!File)
+	{
+		spdlog::error("Failed to write hot restart state to {}: {}", TempPath.string(), WErrnoUtil::StrError());
+		return false;
+	}
+
+	try
+	{
+		auto&            SystemMap = WSystemMap::GetInstance();
+		std::scoped_lock Lock(SystemMap.DataMutex);
+		auto const       Snap = SystemMap.CreateSnapshot();
+
+		// The counters were last swept right before the last refresh, so the snapshot includes their traffic
+		// and everything the kernel counts after that is picked up by the next run
+		auto const                  Baselines = Ebpf.GetData()->GetKernelCounterBaselines();
+		cereal::BinaryOutputArchive Archive(File);
+		Archive(StateMagic, StateVersion, GetBootId(), Snap, Baselines);
+	}
+	catch (std::exception const& Ex)
+	{
+		spdlog::error("Failed to write hot restart state: {}", Ex.what());
+		return false;
+	}
+	File.close();
+
+	// The state is only written once the programs keep running, otherwise the next start would miss their traffic
+	std::error_code Error{};
+	if (!File || !Ebpf.KeepAttached())
+	{
+		stdfs::remove(TempPath, Error);
+		return false;
+	}
+
+	stdfs::rename(TempPath, StatePath, Error);
+	if (Error)
+	{
+		spdlog::error("Failed to write hot restart state to {}: {}", StatePath, Error.message());
+		stdfs::remove(TempPath, Error);
+		return false;
+	}
+	return true;
+}
+
+void WHotRestart::RemovePins() const
+{
+	std::error_code Error{};
+	for (auto const& Entry : stdfs::directory_iterator(PinDirectory, Error))
+	{
+		stdfs::remove(Entry.path(), Error);
+	}
+}
+
+void WHotRestart::Discard()
+{
+	Snapshot.reset();
+	KernelCounters.reset();
+	bHotStart = false;
+	RemovePins();
+}
+
+bool WHotRestart::RestoreSystemMap()
+{
+	if (!Snapshot)
+	{
+		return false;
+	}
+	WSystemMap::GetInstance().RestoreSnapshot(*Snapshot);
+	Snapshot.reset();
+	return true;
+}
+
+void WHotRestart::RegisterSignalHandler()
+{
+	signal(SIGUSR2, OnSigusr2);
+}
+
+int WHotRestart::Shutdown(WWaechterEbpf& Ebpf)
+{
+	if (!bRestartRequested)
+	{
+		if (bEnabled)
+		{
+			RemovePins();
+		}
+		return 0;
+	}
+
+	if (bEnabled && SaveState(Ebpf))
+	{
+		spdlog::info("Saved state for the restart");
+	}
+	else if (bEnabled)
+	{
+		spdlog::warn("Failed to save state, the daemon starts over after the restart");
+		RemovePins();
+	}
+	return RestartExitCode;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Singleton.hpp"
+
+struct WSystemMapSnapshot;
+struct WKernelCounterBaselines;
+class WWaechterEbpf;
+
+/**
+ * Restarts the daemon without losing what it saw, see [daemon] hot_restart.
+ * On SIGUSR2 the daemon pins its eBPF links under /sys/fs/bpf/waechter (the maps are pinned there on load),
+ * writes the system map to /var/lib/waechter and exits with RestartExitCode so systemd starts it again.
+ * The programs keep counting into the pinned maps in the meantime, the next start loads its programs
+ * into the same maps and swaps them in. Any other kind of stop and any state that doesn't fit starts over.
+ */
+class WHotRestart : public TSingleton<WHotRestart>
+{
+	static constexpr uint32_t StateMagic{ 0x57485253 }; // WHRS
+	static constexpr uint32_t StateVersion{ 3 };
+
+	std::string PinDirectory{ "/sys/fs/bpf/waechter" };
+	std::string StatePath{ "/var/lib/waechter/hot-restart.bin" };
+
+	bool              bEnabled{};
+	bool              bHotStart{};
+	std::atomic<bool> bRestartRequested{ false };
+
+	std::unique_ptr<WSystemMapSnapshot>      Snapshot;
+	std::unique_ptr<WKernelCounterBaselines> KernelCounters;
+
+	void               LoadState();
+	bool               SaveState(WWaechterEbpf& Ebpf) const;
+	void               RemovePins() const;
+	static std::string GetBootId();
+
+public:
+	static constexpr int RestartExitCode{ 75 };
+
+	WHotRestart();
+	~WHotRestart() override;
+
+	// Has to run as root before the eBPF object is loaded
+	void Prepare();
+
+	[[nodiscard]] bool IsEnabled() const { return bEnabled; }
+
+	// The maps and links of the previous run are still pinned and the system map can be restored
+	[[nodiscard]] bool IsHotStart() const { return bHotStart; }
+
+	[[nodiscard]] std::string const& GetPinDirectory() const { return PinDirectory; }
+
+	// The pinned state couldn't be reused, the daemon starts over
+	void Discard();
+
+	// Returns false if there is nothing to restore
+	bool RestoreSystemMap();
+
+	// Totals of the swept kernel counters the restored system map already includes, null on a cold start
+	[[nodiscard]] WKernelCounterBaselines const* GetKernelCounters() const { return KernelCounters.get(); }
+
+	void RegisterSignalHandler();
+
+	[[nodiscard]] bool IsRestartRequested() const { return bRestartRequested; }
+	void               RequestRestart() { bRestartRequested = true; }
+
+	// Called after the main loop stopped, returns the exit code of the daemon
+	int Shutdown(WWaechterEbpf& Ebpf);
+};
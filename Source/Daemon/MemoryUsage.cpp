@@ -8,8 +8,10 @@
 #include "Daemon.hpp"
 #include "Data/AppIconAtlasBuilder.hpp"
 #include "Data/ConnectionHistory.hpp"
+#include "Data/ProcessInfoCache.hpp"
 #include "Data/SystemMap.hpp"
 #include "Db/StatsManager.hpp"
+#include "Net/DnsCache.hpp"
 #include "Net/IPLink.hpp"
 #include "Net/Resolver.hpp"
 #include "Rules/RuleManager.hpp"
@@ -18,6 +20,7 @@ WMemoryStats WMemoryUsage::GetMemoryStats()
 {
 	auto const RuleManagerStats = WRuleManager::GetInstance().GetMemoryUsage();
 	auto const ResolverStats = WResolver::GetInstance().GetMemoryUsage();
+	auto const DnsCacheStats = WDnsCache::GetInstance().GetMemoryUsage();
 	auto const IPLinkStats = WIPLink::GetInstance().GetMemoryUsage();
 
 	auto&      SysMap = WSystemMap::GetInstance();
@@ -29,18 +32,23 @@ WMemoryStats WMemoryUsage::GetMemoryStats()
 
 	auto const ConnectionHistoryStats = WConnectionHistory::GetInstance().GetMemoryUsage();
 	auto const IconResolverStats = WAppIconAtlasBuilder::GetInstance().GetResolver().GetMemoryUsage();
+	auto const IconCacheStats = WAppIconAtlasBuilder::GetInstance().GetCache().GetMemoryUsage();
 	auto const DaemonStats = WDaemon::GetInstance().GetMemoryUsage();
 	auto const StatsManagerStats = WStatsManager::GetInstance().GetMemoryUsage();
+	auto const ProcessInfoCacheStats = WProcessInfoCache::GetInstance().GetMemoryUsage();
 
 	WMemoryStats Stats{};
 	Stats.Stats.push_back(RuleManagerStats);
 	Stats.Stats.push_back(ResolverStats);
+	Stats.Stats.push_back(DnsCacheStats);
 	Stats.Stats.push_back(IPLinkStats);
 	Stats.Stats.push_back(SystemMapUsage);
 	Stats.Stats.push_back(MapUpdateUsage);
 	Stats.Stats.push_back(ConnectionHistoryStats);
 	Stats.Stats.push_back(IconResolverStats);
+	Stats.Stats.push_back(IconCacheStats);
 	Stats.Stats.push_back(DaemonStats);
 	Stats.Stats.push_back(StatsManagerStats);
+	Stats.Stats.push_back(ProcessInfoCacheStats);
 	return Stats;
 }
\ No newline at end of file
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "MetricsExporter.hpp"
+
+#include <array>
+#include <iterator>
+#include <string_view>
+
+#include "spdlog/spdlog.h"
+#include "tracy/Tracy.hpp"
+
+#include "DaemonConfig.hpp"
+#include "PipelineMetricsCollector.hpp"
+#include "Data/SystemMap.hpp"
+
+namespace
+{
+	struct WLatencyBound
+	{
+		uint64_t    Nanoseconds;
+		char const* Label;
+	};
+
+	// The histograms are recorded with much finer buckets, scrapers get these instead
+	constexpr std::array<WLatencyBound, 15> LatencyBounds{ {
+		{ 1000, "0.000001" },
+		{ 5000, "0.000005" },
+		{ 10000, "0.00001" },
+		{ 50000, "0.00005" },
+		{ 100000, "0.0001" },
+		{ 500000, "0.0005" },
+		{ 1000000, "0.001" },
+		{ 5000000, "0.005" },
+		{ 10000000, "0.01" },
+		{ 50000000, "0.05" },
+		{ 100000000, "0.1" },
+		{ 500000000, "0.5" },
+		{ 1000000000, "1" },
+		{ 5000000000, "5" },
+		{ 10000000000, "10" },
+	} };
+
+	// Label values of the pipeline stages, in the order of EPipelineStage
+	constexpr std::array<char const*, static_cast<std::size_t>(EPipelineStage::Count)> StageLabels{
+		"kernel_to_counter", "refresh_counters", "collect_updates", "serialize_updates", "db_write"
+	};
+
+	std::string EscapeLabelValue(std::string_view const Value)
+	{
+		std::string Escaped{};
+		Escaped.reserve(Value.size());
+		for (char const C : Value)
+		{
+			if (C == '\\' || C == '"')
+			{
+				Escaped += '\\';
+				Escaped += C;
+			}
+			else if (C == '\n')
+			{
+				Escaped += "\\n";
+			}
+			else
+			{
+				Escaped += C;
+			}
+		}
+		return Escaped;
+	}
+
+	void AppendFamily(std::string& Out, std::string_view const Name, std::string_view const Type,
+		std::string_view const Unit, std::string_view const Help)
+	{
+		fmt::format_to(std::back_inserter(Out), "# TYPE {} {}\n", Name, Type);
+		if (!Unit.empty())
+		{
+			fmt::format_to(std::back_inserter(Out), "# UNIT {} {}\n", Name, Unit);
+		}
+		fmt::format_to(std::back_inserter(Out), "# HELP {} {}\n", Name, Help);
+	}
+
+	// Labels are either empty or a comma terminated list like 'app="ssh",'
+	void AppendTraffic(
+		std::string& Out, std::string_view const Name, std::string const& Labels, WTrafficMetricsEntry const& Entry)
+	{
+		fmt::format_to(std::back_inserter(Out), "{}_total{{{}direction=\"download\"}} {}\n", Name, Labels,
+			Entry.Download);
+		fmt::format_to(std::back_inserter(Out), "{}_total{{{}direction=\"upload\"}} {}\n", Name, Labels, Entry.Upload);
+	}
+
+	void AppendTrafficMetrics(std::string& Out, WTrafficMetrics const& Traffic)
+	{
+		AppendFamily(Out, "waechter_system_bytes", "counter", "bytes", "Traffic of the whole system.");
+		AppendTraffic(Out, "waechter_system_bytes", "", Traffic.System);
+
+		AppendFamily(Out, "waechter_app_bytes", "counter", "bytes",
+			"Traffic of the applications that got their own label, see [metrics] max_apps.");
+		for (auto const& App : Traffic.Apps)
+		{
+			AppendTraffic(Out, "waechter_app_bytes",
+				fmt::format("app=\"{}\",path=\"{}\",", EscapeLabelValue(App.Name), EscapeLabelValue(App.Path)), App);
+		}
+
+		AppendFamily(Out, "waechter_other_apps_bytes", "counter", "bytes",
+			"Traffic of the applications that didn't make it into waechter_app_bytes.");
+		AppendTraffic(Out, "waechter_other_apps_bytes", "", Traffic.OtherApps);
+		AppendFamily(Out, "waechter_other_apps", "gauge", "", "Applications counted in waechter_other_apps_bytes.");
+		fmt::format_to(std::back_inserter(Out), "waechter_other_apps {}\n", Traffic.OtherAppCount);
+
+		AppendFamily(Out, "waechter_filter_bytes", "counter", "bytes", "Traffic matched by each filter.");
+		for (auto const& Filter : Traffic.Filters)
+		{
+			AppendTraffic(Out, "waechter_filter_bytes", fmt::format("filter=\"{}\",", EscapeLabelValue(Filter.Name)),
+				Filter);
+		}
+	}
+
+	void AppendPipelineMetrics(std::string& Out, WPipelineMetrics const& Pipeline)
+	{
+		AppendFamily(Out, "waechter_socket_events", "counter", "", "Events received from the eBPF programs.");
+		for (auto const& Event : Pipeline.Events)
+		{
+			fmt::format_to(std::back_inserter(Out), "waechter_socket_events_total{{type=\"{}\"}} {}\n",
+				EscapeLabelValue(Event.Name), Event.Total);
+		}
+
+		AppendFamily(Out, "waechter_socket_event_ring_drops", "counter", "",
+			"Events the eBPF programs dropped because the ring buffer was full.");
+		fmt::format_to(std::back_inserter(Out), "waechter_socket_event_ring_drops_total {}\n", Pipeline.RingDrops);
+
+		AppendFamily(Out, "waechter_socket_event_queue_depth", "gauge", "",
+			"Events that were read from the ring buffer but not processed yet.");
+		fmt::format_to(std::back_inserter(Out), "waechter_socket_event_queue_depth {}\n", Pipeline.QueueDepth);
+
+		AppendFamily(Out, "waechter_pipeline_latency_seconds", "histogram", "seconds",
+			"Duration of the daemon's pipeline stages.");
+		for (std::size_t i = 0; i < Pipeline.Histograms.size() && i < StageLabels.size(); ++i)
+		{
+			auto const& Histogram = Pipeline.Histograms[i];
+			auto const* Stage = StageLabels[i];
+
+			// A fine bucket only counts towards a bound if all of it is below, so the counts are never too high
+			std::size_t Bucket = 0;
+			uint64_t    Cumulative = 0;
+			for (auto const& Bound : LatencyBounds)
+			{
+				while (Bucket < Histogram.Buckets.size()
+					&& WHistogramBuckets::GetUpperBound(Bucket) <= Bound.Nanoseconds)
+				{
+					Cumulative += Histogram.Buckets[Bucket++];
+				}
+				fmt::format_to(std::back_inserter(Out),
+					"waechter_pipeline_latency_seconds_bucket{{stage=\"{}\",le=\"{}\"}} {}\n", Stage, Bound.Label,
+					Cumulative);
+			}
+			fmt::format_to(std::back_inserter(Out),
+				"waechter_pipeline_latency_seconds_bucket{{stage=\"{}\",le=\"+Inf\"}} {}\n", Stage, Histogram.Count);
+			fmt::format_to(std::back_inserter(Out), "waechter_pipeline_latency_seconds_count{{stage=\"{}\"}} {}\n",
+				Stage, Histogram.Count);
+			fmt::format_to(std::back_inserter(Out), "waechter_pipeline_latency_seconds_sum{{stage=\"{}\"}} {}\n", Stage,
+				static_cast<double>(Histogram.Sum) / 1e9);
+		}
+	}
+} // namespace
+
+bool WMetricsExporter::Start()
+{
+	auto const& Address = WDaemonConfig::GetInstance().MetricsListenAddress;
+	if (Address.empty())
+	{
+		return true;
+	}
+
+	Endpoint = std::make_unique<WMetricsEndpoint>(Address, [this] { return Render(); });
+	if (!Endpoint->Start())
+	{
+		Endpoint.reset();
+		return false;
+	}
+	return true;
+}
+
+void WMetricsExporter::Stop()
+{
+	if (Endpoint)
+	{
+		Endpoint->Stop();
+	}
+}
+
+void WMetricsExporter::UpdateSnapshot()
+{
+	auto const MaxApps = static_cast<std::size_t>(WDaemonConfig::GetInstance().MetricsMaxApps);
+	Traffic.store(std::make_shared<WTrafficMetrics const>(WSystemMap::GetInstance().GetTrafficMetrics(MaxApps)));
+}
+
+std::string WMetricsExporter::Render() const
+{
+	ZoneScopedN("WMetricsExporter::Render");
+	std::string Out{};
+	if (auto const Snapshot = Traffic.load())
+	{
+		AppendTrafficMetrics(Out, *Snapshot);
+	}
+	AppendPipelineMetrics(Out, WPipelineMetricsCollector::GetInstance().Collect(false));
+	Out += "# EOF\n";
+	return Out;
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "Singleton.hpp"
+#include "Communication/MetricsEndpoint.hpp"
+#include "Data/TrafficMetrics.hpp"
+
+// Serves the traffic counters and the pipeline metrics in the OpenMetrics text format if [metrics] listen is set.
+// Scrapes only read the last snapshot of the counters, which is replaced on every refresh, so they never wait
+// for WSystemMap::DataMutex.
+class WMetricsExporter : public TSingleton<WMetricsExporter>
+{
+	std::atomic<std::shared_ptr<WTrafficMetrics const>> Traffic{};
+	std::unique_ptr<WMetricsEndpoint>                   Endpoint{};
+
+public:
+	bool Start();
+	void Stop();
+
+	[[nodiscard]] bool IsEnabled() const { return Endpoint != nullptr; }
+
+	// Called after the counters were refreshed
+	void UpdateSnapshot();
+
+	[[nodiscard]] std::string Render() const;
+};
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "DnsCache.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <optional>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+#include "tracy/Tracy.hpp"
+
+#include "Time.hpp"
+
+namespace
+{
+	constexpr uint16_t DnsTypeA = 1;
+	constexpr uint16_t DnsTypeCNAME = 5;
+	constexpr uint16_t DnsTypeAAAA = 28;
+	constexpr uint16_t DnsClassIN = 1;
+	constexpr int      MaxCompressionJumps = 16;
+	constexpr size_t   MaxNameLength = 255;
+	constexpr size_t   MaxCnameChain = 8;
+
+	// Names are case insensitive, and resolvers randomize the case of the names they ask for
+	bool IsSameName(std::string const& A, std::string const& B)
+	{
+		return std::ranges::equal(A, B, [](char const X, char const Y) {
+			return std::tolower(static_cast<unsigned char>(X)) == std::tolower(static_cast<unsigned char>(Y));
+		});
+	}
+
+	class WDnsReader
+	{
+		std::span<uint8_t const> Message;
+		std::size_t              Offset{ 0 };
+
+	public:
+		explicit WDnsReader(std::span<uint8_t const> InMessage) : Message(InMessage) {}
+
+		[[nodiscard]] std::size_t GetOffset() const { return Offset; }
+
+		bool Skip(std::size_t Count)
+		{
+			if (Offset + Count > Message.size())
+			{
+				return false;
+			}
+			Offset += Count;
+			return true;
+		}
+
+		std::optional<uint16_t> ReadU16()
+		{
+			if (Offset + 2 > Message.size())
+			{
+				return std::nullopt;
+			}
+			auto const Value = static_cast<uint16_t>(Message[Offset] << 8 | Message[Offset + 1]);
+			Offset += 2;
+			return Value;
+		}
+
+		std::optional<uint32_t> ReadU32()
+		{
+			auto const High = ReadU16();
+			auto const Low = ReadU16();
+			if (!High || !Low)
+			{
+				return std::nullopt;
+			}
+			return static_cast<uint32_t>(*High) << 16 | *Low;
+		}
+
+		// Reads a possibly compressed name, OutName is null if the caller only wants to skip it
+		bool ReadName(std::string* OutName)
+		{
+			auto Position = Offset;
+			bool bJumped = false;
+			for (int Jumps = 0; Jumps <= MaxCompressionJumps;)
+			{
+				if (Position >= Message.size())
+				{
+					return false;
+				}
+
+				auto const Length = Message[Position];
+				if (Length == 0)
+				{
+					if (!bJumped)
+					{
+						Offset = Position + 1;
+					}
+					return true;
+				}
+
+				if ((Length & 0xC0) == 0xC0)
+				{
+					if (Position + 1 >= Message.size())
+					{
+						return false;
+					}
+					if (!bJumped)
+					{
+						Offset = Position + 2;
+					}
+					Position = static_cast<std::size_t>((Length & 0x3F) << 8 | Message[Position + 1]);
+					bJumped = true;
+					++Jumps;
+					continue;
+				}
+
+				if ((Length & 0xC0) != 0 || Position + 1 + Length > Message.size())
+				{
+					return false;
+				}
+
+				if (OutName)
+				{
+					if (!OutName->empty())
+					{
+						OutName->push_back('.');
+					}
+					OutName->append(reinterpret_cast<char const*>(Message.data() + Position + 1), Length);
+					if (OutName->size() > MaxNameLength)
+					{
+						return false;
+					}
+				}
+				Position += 1 + Length;
+			}
+			return false;
+		}
+	};
+} // namespace
+
+void WDnsCache::HandleResponse(std::span<uint8_t const> Payload)
+{
+	ZoneScopedN("WDnsCache::HandleResponse");
+	WDnsReader Reader(Payload);
+
+	auto const Id = Reader.ReadU16();
+	auto const Flags = Reader.ReadU16();
+	auto const QuestionCount = Reader.ReadU16();
+	auto const AnswerCount = Reader.ReadU16();
+	// Authority and additional records are of no interest
+	if (!Id || !Flags || !QuestionCount || !AnswerCount || !Reader.Skip(4))
+	{
+		return;
+	}
+
+	// Has to be a response (QR) to a standard query (OPCODE) without error (RCODE). The eBPF program already
+	// checked that it answers a query the socket sent for this name
+	if ((*Flags & 0x8000) == 0 || (*Flags & 0x7800) != 0 || (*Flags & 0x000F) != 0 || *QuestionCount != 1
+		|| *AnswerCount == 0)
+	{
+		return;
+	}
+
+	// Answers are attributed to the name that was asked for, not the end of a CNAME chain
+	std::string QueryName{};
+	if (!Reader.ReadName(&QueryName) || QueryName.empty() || !Reader.Skip(4))
+	{
+		return;
+	}
+
+	// Only records for the name that was asked for, or the names it is an alias of, are used. Anything else in
+	// the response can't be trusted to be what the application connects to
+	std::vector<std::string> Names{ QueryName };
+	for (uint16_t i = 0; i < *AnswerCount; ++i)
+	{
+		std::string Owner{};
+		if (!Reader.ReadName(&Owner))
+		{
+			return;
+		}
+
+		auto const Type = Reader.ReadU16();
+		auto const Class = Reader.ReadU16();
+		auto const Ttl = Reader.ReadU32();
+		auto const DataLength = Reader.ReadU16();
+		if (!Type || !Class || !Ttl || !DataLength)
+		{
+			return;
+		}
+
+		auto const DataOffset = Reader.GetOffset();
+		auto       DataReader = Reader;
+		if (!Reader.Skip(*DataLength))
+		{
+			// Truncated by the eBPF program, the answers before this one are still valid
+			return;
+		}
+
+		if (*Class != DnsClassIN
+			|| std::ranges::none_of(Names, [&Owner](auto const& Name) { return IsSameName(Name, Owner); }))
+		{
+			continue;
+		}
+
+		if (*Type == DnsTypeCNAME)
+		{
+			if (std::string Target{}; Names.size() < MaxCnameChain && DataReader.ReadName(&Target) && !Target.empty())
+			{
+				Names.push_back(std::move(Target));
+			}
+			continue;
+		}
+
+		WIPAddress Address{};
+		if (*Type == DnsTypeA && *DataLength == 4)
+		{
+			Address.Family = EIPFamily::IPv4;
+		}
+		else if (*Type == DnsTypeAAAA && *DataLength == 16)
+		{
+			Address.Family = EIPFamily::IPv6;
+		}
+		else
+		{
+			continue;
+		}
+
+		std::copy_n(Payload.begin() + static_cast<std::ptrdiff_t>(DataOffset), *DataLength, Address.Bytes.begin());
+		spdlog::trace("DNS answer {} -> {} (ttl {})", QueryName, Address.ToString(), *Ttl);
+		Insert(Address, QueryName, *Ttl);
+	}
+}
+
+void WDnsCache::Insert(WIPAddress const& Address, std::string const& Hostname, uint32_t const Ttl)
+{
+	auto const ExpiresAt = WTime::GetEpochMs() + static_cast<WMsec>(std::clamp(Ttl, MinTtl, MaxTtl)) * 1000;
+
+	std::scoped_lock Lock(Mutex);
+	auto [It, bInserted] = Cache.try_emplace(Address);
+	if (bInserted)
+	{
+		LruList.push_front(Address);
+		It->second.LruPosition = LruList.begin();
+	}
+	else
+	{
+		HostnameUsage -= It->second.Hostname.capacity();
+		LruList.splice(LruList.begin(), LruList, It->second.LruPosition);
+	}
+	It->second.Hostname = Hostname;
+	It->second.ExpiresAt = ExpiresAt;
+	HostnameUsage += It->second.Hostname.capacity();
+
+	while (Cache.size() > MaxEntries)
+	{
+		auto const Oldest = Cache.find(LruList.back());
+		HostnameUsage -= Oldest->second.Hostname.capacity();
+		Cache.erase(Oldest);
+		LruList.pop_back();
+	}
+}
+
+bool WDnsCache::Lookup(WIPAddress const& Address, std::string& OutHostname)
+{
+	std::scoped_lock Lock(Mutex);
+	auto const       It = Cache.find(Address);
+	if (It == Cache.end())
+	{
+		return false;
+	}
+
+	if (It->second.ExpiresAt <= WTime::GetEpochMs())
+	{
+		HostnameUsage -= It->second.Hostname.capacity();
+		LruList.erase(It->second.LruPosition);
+		Cache.erase(It);
+		return false;
+	}
+
+	LruList.splice(LruList.begin(), LruList, It->second.LruPosition);
+	OutHostname = It->second.Hostname;
+	return true;
+}
+
+WMemoryStat WDnsCache::GetMemoryUsage()
+{
+	std::scoped_lock Lock(Mutex);
+	WMemoryStat      Stats{};
+	Stats.Name = "WDnsCache";
+	Stats.ChildEntries.emplace_back(WMemoryStatEntry{ .Name = "Cache",
+		.Usage = Cache.size() * (sizeof(WIPAddress) * 2 + sizeof(WCacheEntry) + sizeof(void*) * 4) + HostnameUsage });
+	return Stats;
+}
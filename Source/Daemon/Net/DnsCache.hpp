@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+#include "IPAddress.hpp"
+#include "MemoryStats.hpp"
+#include "Singleton.hpp"
+#include "Types.hpp"
+
+/**
+ * Maps addresses to the names that were looked up to get them, filled from the DNS responses
+ * the eBPF program copies from ingress traffic. Unlike reverse lookups this gives the name the
+ * application actually connected to, which matters for CDNs and shared hosting.
+ */
+class WDnsCache : public TSingleton<WDnsCache>, public IMemoryTrackable
+{
+	struct WCacheEntry
+	{
+		std::string                     Hostname{};
+		WMsec                           ExpiresAt{};
+		std::list<WIPAddress>::iterator LruPosition{};
+	};
+
+	static constexpr std::size_t MaxEntries = 16384;
+	// Some resolvers hand out TTLs of a few seconds, the name is still useful for a while after that
+	static constexpr uint32_t MinTtl = 5 * 60;
+	static constexpr uint32_t MaxTtl = 24 * 60 * 60;
+
+	std::mutex                                  Mutex;
+	std::unordered_map<WIPAddress, WCacheEntry> Cache{};
+	std::list<WIPAddress>                       LruList{}; // most recently used first
+	WBytes                                      HostnameUsage{ 0 };
+
+	void Insert(WIPAddress const& Address, std::string const& Hostname, uint32_t Ttl);
+
+public:
+	// Payload starts at the DNS header, responses that can't be parsed are ignored
+	void HandleResponse(std::span<uint8_t const> Payload);
+
+	bool Lookup(WIPAddress const& Address, std::string& OutHostname);
+
+	WMemoryStat GetMemoryUsage() override;
+};
@@ -22,6 +22,7 @@
 #include "NetworkInterface.hpp"
 #include "DaemonConfig.hpp"
 #include "ErrnoUtil.hpp"
+#include "EventLoop.hpp"
 #include "Filesystem.hpp"
 #include "IPLinkMsg.hpp"
 #include "Data/Counters.hpp"
@@ -59,7 +60,10 @@ WBandwidthLimit::~WBandwidthLimit()
 	Msg.RemoveHtbClass->Mark = Mark;
 	Msg.RemoveHtbClass->MinorId = MinorId;
 	Msg.RemoveHtbClass->bIsRoot = bIsRoot;
-	WIPLink::GetInstance().IpProcSocket->SendMessage(Msg);
+	if (auto const& Socket = WIPLink::GetInstance().IpProcSocket)
+	{
+		Socket->SendMessage(Msg);
+	}
 }
 
 void WIPLink::SetupHTBLimitClass(
@@ -76,7 +80,11 @@ void WIPLink::SetupHTBLimitClass(
 	Msg.SetupHtbClass->MinorId = Limit->MinorId;
 	Msg.SetupHtbClass->RateLimit = Limit->RateLimit;
 	Msg.SetupHtbClass->bIsRoot = bIsRoot;
-	IpProcSocket->SendMessage(Msg);
+	// Not connected when replaying a socket event log
+	if (IpProcSocket)
+	{
+		IpProcSocket->SendMessage(Msg);
+	}
 }
 
 void WIPLink::OnSocketRemoved(std::shared_ptr<WSocketCounter> const& Socket)
@@ -168,7 +176,7 @@ bool WIPLink::Init()
 		return false;
 	}
 
-	IpProcSocket = std::make_unique<WClientSocket>(WDaemonConfig::GetInstance().IpLinkProcSocketPath);
+	IpProcSocket = std::make_shared<WClientSocket>(WDaemonConfig::GetInstance().IpLinkProcSocketPath);
 
 	for (int i = 0; i < 10; ++i)
 	{
@@ -185,7 +193,14 @@ bool WIPLink::Init()
 	}
 
 	IpProcSocket->OnData.connect([](WBuffer const& Data) { OnDataReceived(Data); });
-	IpProcSocket->StartListenThread();
+	if (auto& Loop = WEventLoop::GetInstance(); Loop.IsEnabled())
+	{
+		Loop.AddSocket(IpProcSocket);
+	}
+	else
+	{
+		IpProcSocket->StartListenThread();
+	}
 
 	spdlog::debug("IP link process socket connected");
 
@@ -214,6 +229,10 @@ void WIPLink::SetupIngressHTBClass(std::shared_ptr<WBandwidthLimit> const& Limit
 void WIPLink::SetupIngressPortRouting(WTrafficItemId, uint32_t const DownloadMark, uint16_t const DestPort)
 {
 	auto const& Data = WDaemon::GetInstance().GetEbpfObj().GetData();
+	if (!Data)
+	{
+		return;
+	}
 
 	if (!Data->SocketMarks->Update(DestPort, static_cast<uint16_t>(DownloadMark)))
 	{
@@ -224,6 +243,10 @@ void WIPLink::SetupIngressPortRouting(WTrafficItemId, uint32_t const DownloadMar
 void WIPLink::RemoveIngressPortRouting(uint16_t const DestPort)
 {
 	auto const& Data = WDaemon::GetInstance().GetEbpfObj().GetData();
+	if (!Data)
+	{
+		return;
+	}
 
 	if (!Data->SocketMarks->Update(DestPort, 0))
 	{
@@ -234,6 +257,10 @@ void WIPLink::RemoveIngressPortRouting(uint16_t const DestPort)
 void WIPLink::SetPidDownloadMark(uint32_t Pid, uint32_t Mark)
 {
 	auto const& Data = WDaemon::GetInstance().GetEbpfObj().GetData();
+	if (!Data)
+	{
+		return;
+	}
 
 	if (!Data->PidDownloadMarks->Update(Pid, Mark))
 	{
@@ -248,6 +275,10 @@ void WIPLink::SetPidDownloadMark(uint32_t Pid, uint32_t Mark)
 void WIPLink::RemovePidDownloadMark(uint32_t Pid)
 {
 	auto const& Data = WDaemon::GetInstance().GetEbpfObj().GetData();
+	if (!Data)
+	{
+		return;
+	}
 
 	if (!Data->PidDownloadMarks->Delete(Pid))
 	{
@@ -52,7 +52,7 @@ class WIPLink : public TSingleton<WIPLink>, public IMemoryTrackable
 	std::unordered_map<WTrafficItemId, std::shared_ptr<WBandwidthLimit>> ActiveUploadLimits;
 	std::unordered_map<WTrafficItemId, std::shared_ptr<WBandwidthLimit>> ActiveDownloadLimits;
 
-	std::unique_ptr<WClientSocket> IpProcSocket;
+	std::shared_ptr<WClientSocket> IpProcSocket;
 
 	void SetupHTBLimitClass(
 		std::shared_ptr<WBandwidthLimit> const& Limit, std::string const& IfName, bool bIsRoot) const;
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "ProcConnector.hpp"
+
+#include <array>
+#include <cstring>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "spdlog/spdlog.h"
+#include "tracy/Tracy.hpp"
+
+#include "ErrnoUtil.hpp"
+
+bool WProcConnector::Subscribe(bool const bListen) const
+{
+	alignas(nlmsghdr) std::array<char, NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))> Buffer{};
+
+	auto* Header = reinterpret_cast<nlmsghdr*>(Buffer.data());
+	Header->nlmsg_len = static_cast<__u32>(NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op)));
+	Header->nlmsg_type = NLMSG_DONE;
+	Header->nlmsg_pid = static_cast<__u32>(getpid());
+
+	auto* Message = static_cast<cn_msg*>(NLMSG_DATA(Header));
+	Message->id.idx = CN_IDX_PROC;
+	Message->id.val = CN_VAL_PROC;
+	Message->len = sizeof(proc_cn_mcast_op);
+
+	proc_cn_mcast_op const Op = bListen ? PROC_CN_MCAST_LISTEN : PROC_CN_MCAST_IGNORE;
+	std::memcpy(Message->data, &Op, sizeof(Op));
+
+	return send(Socket, Buffer.data(), Header->nlmsg_len, 0) >= 0;
+}
+
+bool WProcConnector::Start()
+{
+	Socket = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+	if (Socket < 0)
+	{
+		spdlog::warn("Failed to create proc connector socket: {}", WErrnoUtil::StrError());
+		return false;
+	}
+
+	sockaddr_nl Address{};
+	Address.nl_family = AF_NETLINK;
+	Address.nl_groups = CN_IDX_PROC;
+	Address.nl_pid = static_cast<__u32>(getpid());
+
+	if (bind(Socket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) < 0 || !Subscribe(true))
+	{
+		spdlog::warn("Failed to subscribe to process events: {}", WErrnoUtil::StrError());
+		close(Socket);
+		Socket = -1;
+		return false;
+	}
+
+	bRunning = true;
+	ListenThread = std::thread(&WProcConnector::ListenThreadFunc, this);
+	spdlog::info("Subscribed to kernel process events");
+	return true;
+}
+
+void WProcConnector::Stop()
+{
+	bRunning = false;
+	if (ListenThread.joinable())
+	{
+		ListenThread.join();
+	}
+
+	if (Socket >= 0)
+	{
+		Subscribe(false);
+		close(Socket);
+		Socket = -1;
+	}
+}
+
+void WProcConnector::ListenThreadFunc() const
+{
+	pthread_setname_np(pthread_self(), "proc-events");
+	tracy::SetThreadName("proc-events");
+
+	alignas(nlmsghdr) std::array<char, 8192> Buffer{};
+	while (bRunning)
+	{
+		pollfd Pfd{ Socket, POLLIN, 0 };
+		if (poll(&Pfd, 1, 500) <= 0)
+		{
+			continue;
+		}
+
+		sockaddr_nl Sender{};
+		socklen_t   SenderLength = sizeof(Sender);
+		auto const  Received =
+			recvfrom(Socket, Buffer.data(), Buffer.size(), 0, reinterpret_cast<sockaddr*>(&Sender), &SenderLength);
+		if (Received < 0)
+		{
+			if (errno == ENOBUFS)
+			{
+				spdlog::warn("Process event buffer overran, some process events were lost");
+				if (OnEventsLost)
+				{
+					OnEventsLost();
+				}
+			}
+			continue;
+		}
+
+		// Only the kernel is allowed to send us process events
+		if (Sender.nl_pid != 0)
+		{
+			continue;
+		}
+
+		ZoneScopedN("WProcConnector::HandleEvents");
+		auto const  Length = static_cast<std::size_t>(Received);
+		std::size_t Offset = 0;
+		while (Offset + sizeof(nlmsghdr) <= Length)
+		{
+			auto const* Header = reinterpret_cast<nlmsghdr const*>(Buffer.data() + Offset);
+			if (Header->nlmsg_len < sizeof(nlmsghdr) || Offset + Header->nlmsg_len > Length)
+			{
+				break;
+			}
+			Offset += NLMSG_ALIGN(Header->nlmsg_len);
+
+			if (Header->nlmsg_type == NLMSG_ERROR || Header->nlmsg_type == NLMSG_NOOP)
+			{
+				continue;
+			}
+
+			auto const* Message = static_cast<cn_msg const*>(NLMSG_DATA(Header));
+			if (Message->id.idx != CN_IDX_PROC || Message->id.val != CN_VAL_PROC)
+			{
+				continue;
+			}
+
+			auto const* Event = reinterpret_cast<proc_event const*>(Message->data);
+			switch (Event->what)
+			{
+				case proc_event::PROC_EVENT_EXIT:
+					// Thread exits are reported as well, we only care about the whole process
+					if (Event->event_data.exit.process_pid == Event->event_data.exit.process_tgid && OnProcessExit)
+					{
+						OnProcessExit(static_cast<WProcessId>(Event->event_data.exit.process_tgid));
+					}
+					break;
+				case proc_event::PROC_EVENT_FORK:
+					// Same as with exits, new threads are reported as forks too
+					if (Event->event_data.fork.child_pid == Event->event_data.fork.child_tgid && OnProcessFork)
+					{
+						OnProcessFork(static_cast<WProcessId>(Event->event_data.fork.child_tgid));
+					}
+					break;
+				case proc_event::PROC_EVENT_EXEC:
+					if (OnProcessExec)
+					{
+						OnProcessExec(static_cast<WProcessId>(Event->event_data.exec.process_tgid));
+					}
+					break;
+				default:;
+			}
+		}
+	}
+}
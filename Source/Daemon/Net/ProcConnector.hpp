@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "Types.hpp"
+
+/**
+ * Listens to process events from the kernel via the netlink process connector.
+ * Subscribing requires CAP_NET_ADMIN, so this has to be started before the daemon drops its privileges,
+ * the subscription stays valid afterward.
+ */
+class WProcConnector
+{
+	int               Socket{ -1 };
+	std::thread       ListenThread{};
+	std::atomic<bool> bRunning{ false };
+
+	void ListenThreadFunc() const;
+
+	bool Subscribe(bool bListen) const;
+
+public:
+	// Called from the listen thread with the thread group id of the process
+	std::function<void(WProcessId)> OnProcessExit{};
+	std::function<void(WProcessId)> OnProcessExec{};
+	std::function<void(WProcessId)> OnProcessFork{};
+
+	// Called when the socket buffer overran and events were lost
+	std::function<void()> OnEventsLost{};
+
+	~WProcConnector() { Stop(); }
+
+	bool Start();
+	void Stop();
+
+	[[nodiscard]] bool IsRunning() const { return bRunning; }
+};
@@ -7,18 +7,24 @@
 
 #include "Format.hpp"
 
+#include <algorithm>
 #include <netdb.h>
 
 #include "tracy/Tracy.hpp"
 #include "spdlog/spdlog.h"
+#include "sqlpp11/sqlpp11.h"
 
-void WResolver::ResolveAddress(WQueuedRequest const& Request)
+#include "DaemonConfig.hpp"
+#include "PipelineMetricsCollector.hpp"
+#include "Time.hpp"
+#include "Db/DbManager.hpp"
+#include "Db/Schema.hpp"
+
+int WGetNameInfoBackend::Resolve(WIPAddress const& Address, std::string& OutHostname)
 {
 	int  Result = 0;
 	char Host[NI_MAXHOST]{};
 
-	auto const& Address = Request.AddressToResolve;
-
 	if (Address.Family == EIPFamily::IPv6)
 	{
 		in6_addr Addr6{};
@@ -28,8 +34,8 @@ void WResolver::ResolveAddress(WQueuedRequest const& Request)
 		SockAddr6.sin6_addr = Addr6;
 		SockAddr6.sin6_port = 0;
 
-		Result =
-			getnameinfo(reinterpret_cast<sockaddr*>(&SockAddr6), sizeof(SockAddr6), Host, sizeof(Host), nullptr, 0, 0);
+		Result = getnameinfo(reinterpret_cast<sockaddr*>(&SockAddr6), sizeof(SockAddr6), Host, sizeof(Host), nullptr,
+			0, NI_NAMEREQD);
 	}
 	else if (Address.Family == EIPFamily::IPv4)
 	{
@@ -42,8 +48,8 @@ void WResolver::ResolveAddress(WQueuedRequest const& Request)
 		SockAddr4.sin_addr = Addr4;
 		SockAddr4.sin_port = 0;
 
-		Result =
-			getnameinfo(reinterpret_cast<sockaddr*>(&SockAddr4), sizeof(SockAddr4), Host, sizeof(Host), nullptr, 0, 0);
+		Result = getnameinfo(reinterpret_cast<sockaddr*>(&SockAddr4), sizeof(SockAddr4), Host, sizeof(Host), nullptr,
+			0, NI_NAMEREQD);
 	}
 	else
 	{
@@ -53,106 +59,287 @@ void WResolver::ResolveAddress(WQueuedRequest const& Request)
 		V6.Family = EIPFamily::IPv6;
 		spdlog::info(
 			"Unknown address family {} ({}/{})", static_cast<int>(Address.Family), V4.ToString(), V6.ToString());
+		return EAI_FAMILY;
+	}
+
+	if (Result == 0)
+	{
+		OutHostname = Host;
+	}
+	return Result;
+}
+
+bool WResolver::FindCached(WIPAddress const& Address, std::string& OutHostname)
+{
+	std::scoped_lock Lock(CacheMutex);
+	auto const       It = Cache.find(Address);
+	if (It == Cache.end())
+	{
+		return false;
+	}
+
+	if (It->second.ExpiresAt <= WTime::GetEpochMs())
+	{
+		CurrentCacheRamUsage -= GetEntryUsage(It->second.Hostname);
+		LruList.erase(It->second.LruPosition);
+		Cache.erase(It);
+		return false;
+	}
+
+	LruList.splice(LruList.begin(), LruList, It->second.LruPosition);
+	OutHostname = It->second.Hostname;
+	return true;
+}
+
+void WResolver::AddToCache(WIPAddress const& Address, std::string const& Hostname, WMsec const ExpiresAt)
+{
+	std::scoped_lock Lock(CacheMutex);
+	auto [It, bInserted] = Cache.try_emplace(Address);
+	if (bInserted)
+	{
+		LruList.push_front(Address);
+		It->second.LruPosition = LruList.begin();
+	}
+	else
+	{
+		CurrentCacheRamUsage -= GetEntryUsage(It->second.Hostname);
+		LruList.splice(LruList.begin(), LruList, It->second.LruPosition);
+	}
+	It->second.Hostname = Hostname;
+	It->second.ExpiresAt = ExpiresAt;
+	CurrentCacheRamUsage += GetEntryUsage(It->second.Hostname);
+
+	int DroppedEntries = 0;
+	while (CurrentCacheRamUsage > MaxCacheRamUsage && LruList.size() > 1)
+	{
+		auto const Oldest = Cache.find(LruList.back());
+		CurrentCacheRamUsage -= GetEntryUsage(Oldest->second.Hostname);
+		Cache.erase(Oldest);
+		LruList.pop_back();
+		++DroppedEntries;
 	}
 
+	if (DroppedEntries > 0)
+	{
+		spdlog::debug("Dropped {} least recently used entries from resolver cache, RAM usage {}", DroppedEntries,
+			WStorageFormat::AutoFormat(CurrentCacheRamUsage));
+	}
+}
+
+void WResolver::ResolveAddress(WIPAddress const& Address, std::string& OutHostname)
+{
+	ZoneScopedN("WResolver::ResolveAddress");
+	auto const Result = Backend->Resolve(Address, OutHostname);
+
+	WMsec Ttl = PositiveTtl;
 	if (Result != 0)
 	{
 		// getnameinfo returns GAI error codes, not errno
 		if (Result == EAI_AGAIN)
 		{
 			spdlog::debug("Resolver failed for {}: {} ({})", Address.ToString(), gai_strerror(Result), Result);
+			Ttl = TemporaryFailureTtl;
+		}
+		else if (Result == EAI_NONAME)
+		{
+			spdlog::debug("No hostname for {}", Address.ToString());
+			Ttl = NegativeTtl;
 		}
 		else
 		{
 			spdlog::warn("Resolver failed for {}: {} ({})", Address.ToString(), gai_strerror(Result), Result);
+			Ttl = NegativeTtl;
 		}
+		OutHostname.clear();
+	}
+	else
+	{
+		spdlog::debug("Resolved {} to {}", Address.ToString(), OutHostname);
 	}
 
-	std::lock_guard Lock(ResolvedAddressesMutex);
-	CurrentCacheRamUsage += sizeof(WIPAddress) + strlen(Host) + 1 + sizeof(std::string);
-	spdlog::debug("Current resolver cache RAM usage: {}", WStorageFormat::AutoFormat(CurrentCacheRamUsage));
+	auto const ExpiresAt = WTime::GetEpochMs() + Ttl;
+	AddToCache(Address, OutHostname, ExpiresAt);
 
-	if (CurrentCacheRamUsage > MaxCacheRamUsage)
+	// Temporary failures are retried after a restart anyway
+	if (bPersist && Ttl != TemporaryFailureTtl)
 	{
-		spdlog::info("Resolver cache exceeded max RAM of usage of {}, dropping some entries...",
-			WStorageFormat::AutoFormat(MaxCacheRamUsage));
-		int DroppedEntries = 0;
-		while (CurrentCacheRamUsage > MaxCacheRamUsage / 2 && !ResolvedAddresses.empty())
-		{
-			auto const It = ResolvedAddresses.begin();
-			CurrentCacheRamUsage -= sizeof(WIPAddress) + It->second.size() + 1 + sizeof(std::string);
-			ResolvedAddresses.erase(It);
-			++DroppedEntries;
-		}
-		if (DroppedEntries > 0)
-		{
-			spdlog::info("Dropped {} entries from resolver cache. New RAM usage {}", DroppedEntries,
-				WStorageFormat::AutoFormat(CurrentCacheRamUsage));
-		}
+		std::scoped_lock Lock(PersistMutex);
+		PendingWrites.emplace_back(WPersistedHost{ Address, OutHostname, ExpiresAt });
 	}
+}
+
+void WResolver::LoadPersistedHosts()
+{
+	ZoneScopedN("WResolver::LoadPersistedHosts");
+	std::vector<WPersistedHost> Hosts{};
+	try
+	{
+		WDbManager::GetInstance().Run([&](auto& DbConn) {
+			constexpr Db::Schema::ResolvedHost ResolvedHost;
+			auto const                         Now = WTime::GetEpochMs();
+			DbConn(sqlpp::remove_from(ResolvedHost).where(ResolvedHost.ExpiresAt <= Now));
 
-	if (Host == Address.ToString())
+			// Most of these will be evicted again if they don't fit into the cache
+			for (auto const& Row : DbConn(
+					 sqlpp::select(ResolvedHost.Family, ResolvedHost.IPAddress, ResolvedHost.Hostname,
+						 ResolvedHost.ExpiresAt)
+						 .from(ResolvedHost)
+						 .unconditionally()
+						 .order_by(ResolvedHost.ExpiresAt.asc())))
+			{
+				WPersistedHost Host{};
+				auto const&    Bytes = Row.IPAddress.value();
+				Host.Address.Family = Row.Family.value() == 6 ? EIPFamily::IPv6 : EIPFamily::IPv4;
+				std::copy_n(Bytes.begin(), std::min(Bytes.size(), Host.Address.Bytes.size()),
+					Host.Address.Bytes.begin());
+				Host.Hostname = Row.Hostname.value();
+				Host.ExpiresAt = Row.ExpiresAt;
+				Hosts.emplace_back(std::move(Host));
+			}
+		});
+	}
+	catch (std::exception const& E)
 	{
-		ResolvedAddresses[Address] = {};
-		Request.Promise.Finish({});
+		spdlog::error("Failed to load resolved hostnames from database: {}", E.what());
 		return;
 	}
 
-	spdlog::debug("Resolved {} to {}", Address.ToString(), Host);
-	ResolvedAddresses[Address] = Host;
-	Request.Promise.Finish(Host);
+	for (auto const& Host : Hosts)
+	{
+		AddToCache(Host.Address, Host.Hostname, Host.ExpiresAt);
+	}
+	spdlog::info("Loaded {} resolved hostnames from database", Hosts.size());
 }
 
-void WResolver::ResolverThreadFunc()
+void WResolver::PersistHosts(bool const bForce)
+{
+	std::vector<WPersistedHost> Hosts{};
+	{
+		std::scoped_lock Lock(PersistMutex);
+		auto const       Now = WTime::GetEpochMs();
+		if (PendingWrites.empty()
+			|| (!bForce && PendingWrites.size() < PersistBatchSize && Now - LastPersistTime < PersistInterval))
+		{
+			return;
+		}
+		LastPersistTime = Now;
+		Hosts.swap(PendingWrites);
+	}
+
+	ZoneScopedN("WResolver::PersistHosts");
+	WStageTimer const DbWriteTimer(EPipelineStage::DbWrite);
+	try
+	{
+		WDbManager::GetInstance().Run([&](auto& DbConn) {
+			constexpr Db::Schema::ResolvedHost ResolvedHost;
+			DbConn.start_transaction();
+			try
+			{
+				for (auto const& Host : Hosts)
+				{
+					DbConn(sqlpp::sqlite3::insert_or_replace_into(ResolvedHost)
+							.set(ResolvedHost.Family = static_cast<int64_t>(Host.Address.Family),
+								ResolvedHost.IPAddress = Host.Address.GetBytesVector(),
+								ResolvedHost.Hostname = Host.Hostname, ResolvedHost.ExpiresAt = Host.ExpiresAt));
+				}
+				DbConn.commit_transaction();
+			}
+			catch (...)
+			{
+				DbConn.rollback_transaction(false);
+				throw;
+			}
+		});
+	}
+	catch (std::exception const& E)
+	{
+		spdlog::error("Failed to store {} resolved hostnames in database: {}", Hosts.size(), E.what());
+	}
+}
+
+void WResolver::WorkerThreadFunc()
 {
-	static std::string Empty = {};
 	pthread_setname_np(pthread_self(), "resolver");
 	tracy::SetThreadName("ResolverThread");
 	while (bRunning)
 	{
-		std::unique_lock Lock(QueueMutex);
-		QueueCondition.wait(Lock, [this] { return !PendingAddresses.empty() || !bRunning; });
-
-		if (!bRunning)
+		WIPAddress Address{};
 		{
-			break;
+			std::unique_lock Lock(QueueMutex);
+			QueueCondition.wait(Lock, [this] { return !PendingAddresses.empty() || !bRunning; });
+
+			if (!bRunning)
+			{
+				break;
+			}
+			Address = PendingAddresses.front();
+			PendingAddresses.pop_front();
 		}
 
-		if (!PendingAddresses.empty())
+		std::string Hostname{};
+		if (!Address.IsZero() && !FindCached(Address, Hostname))
 		{
-			auto Request = PendingAddresses.front(); // copy before pop to keep TPromise's WSharedState alive
-			PendingAddresses.pop();
+			ResolveAddress(Address, Hostname);
+		}
 
-			if (Request.AddressToResolve.IsZero())
-			{
-				Request.Promise.Finish(Empty);
-			}
-			else if (auto It = ResolvedAddresses.find(Request.AddressToResolve); It != ResolvedAddresses.end())
-			{
-				Request.Promise.Finish(It->second);
-			}
-			else
+		std::vector<TPromise<std::string const&>> Waiting{};
+		{
+			std::scoped_lock Lock(QueueMutex);
+			if (auto const It = InFlight.find(Address); It != InFlight.end())
 			{
-				Lock.unlock();
-				ResolveAddress(Request);
+				Waiting = std::move(It->second);
+				InFlight.erase(It);
 			}
 		}
+
+		for (auto const& Promise : Waiting)
+		{
+			Promise.Finish(Hostname);
+		}
+
+		if (bPersist)
+		{
+			PersistHosts(false);
+		}
 	}
 }
 
 void WResolver::Start()
 {
+	auto const& Config = WDaemonConfig::GetInstance();
+	bPersist = Config.bPersistResolvedHosts;
+	if (bPersist)
+	{
+		LoadPersistedHosts();
+	}
+
 	bRunning = true;
-	ResolverThread = std::thread(&WResolver::ResolverThreadFunc, this);
+	for (int i = 0; i < Config.ResolverThreads; ++i)
+	{
+		Workers.emplace_back(&WResolver::WorkerThreadFunc, this);
+	}
+	spdlog::info("Started resolver with {} threads", Workers.size());
 }
 
 void WResolver::Stop()
 {
-	bRunning = false;
-	QueueCondition.notify_one();
-	if (ResolverThread.joinable())
 	{
-		ResolverThread.join();
+		std::scoped_lock Lock(QueueMutex);
+		bRunning = false;
+	}
+	QueueCondition.notify_all();
+	for (auto& Worker : Workers)
+	{
+		if (Worker.joinable())
+		{
+			Worker.join();
+		}
+	}
+	Workers.clear();
+
+	if (bPersist)
+	{
+		PersistHosts(true);
 	}
 }
 
@@ -161,10 +348,15 @@ TPromise<std::string const&> WResolver::Resolve(WIPAddress const& Address)
 	TPromise<std::string const&> Promise{};
 
 	{
-		WQueuedRequest  Request{ Address, Promise };
 		std::lock_guard Lock(QueueMutex);
-		PendingAddresses.push(Request);
-		QueueCondition.notify_one();
+		auto& Waiting = InFlight[Address];
+		Waiting.push_back(Promise);
+		// Only the first request for an address has to be queued, the others are answered with its result
+		if (Waiting.size() == 1)
+		{
+			PendingAddresses.push_back(Address);
+			QueueCondition.notify_one();
+		}
 	}
 
 	return Promise;
@@ -172,9 +364,17 @@ TPromise<std::string const&> WResolver::Resolve(WIPAddress const& Address)
 
 WMemoryStat WResolver::GetMemoryUsage()
 {
-	std::scoped_lock Lock(QueueMutex);
-	WMemoryStat      Stats;
+	WMemoryStat Stats;
 	Stats.Name = "WResolver";
-	Stats.ChildEntries.emplace_back(WMemoryStatEntry{ .Name = "Cache", .Usage = CurrentCacheRamUsage });
+	{
+		std::scoped_lock Lock(CacheMutex);
+		Stats.ChildEntries.emplace_back(WMemoryStatEntry{ .Name = "Cache", .Usage = CurrentCacheRamUsage });
+	}
+	{
+		std::scoped_lock Lock(QueueMutex);
+		Stats.ChildEntries.emplace_back(WMemoryStatEntry{ .Name = "Pending requests",
+			.Usage = PendingAddresses.size() * sizeof(WIPAddress)
+				+ InFlight.size() * (sizeof(WIPAddress) + sizeof(std::vector<TPromise<std::string const&>>)) });
+	}
 	return Stats;
 }
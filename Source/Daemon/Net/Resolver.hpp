@@ -9,7 +9,10 @@
 #include <mutex>
 #include <thread>
 #include <atomic>
-#include <queue>
+#include <deque>
+#include <list>
+#include <memory>
+#include <vector>
 #include <condition_variable>
 
 #include "MemoryStats.hpp"
@@ -18,36 +21,97 @@
 #include "Types.hpp"
 #include "Promise.hpp"
 
+/**
+ * Performs a single blocking reverse lookup on one of the resolver's worker threads.
+ * Returns 0 or a getnameinfo error code, OutHostname stays empty if the address has no name.
+ */
+class IResolverBackend
+{
+public:
+	virtual ~IResolverBackend() = default;
+
+	virtual int Resolve(WIPAddress const& Address, std::string& OutHostname) = 0;
+};
+
+class WGetNameInfoBackend final : public IResolverBackend
+{
+public:
+	int Resolve(WIPAddress const& Address, std::string& OutHostname) override;
+};
+
+/**
+ * Resolves addresses to hostnames on a pool of worker threads.
+ * Concurrent requests for the same address share one lookup, results (including failed lookups)
+ * are kept in an LRU cache until they expire and are optionally stored in the database.
+ */
 class WResolver : public TSingleton<WResolver>, public IMemoryTrackable
 {
-	struct WQueuedRequest
+	struct WCacheEntry
+	{
+		std::string                     Hostname{}; // empty if the address has no name
+		WMsec                           ExpiresAt{};
+		std::list<WIPAddress>::iterator LruPosition{};
+	};
+
+	struct WPersistedHost
 	{
-		WIPAddress                   AddressToResolve;
-		TPromise<std::string const&> Promise;
+		WIPAddress  Address{};
+		std::string Hostname{};
+		WMsec       ExpiresAt{};
 	};
 
-	static constexpr WBytes                     MaxCacheRamUsage = 1 WMiB;
-	std::unordered_map<WIPAddress, std::string> ResolvedAddresses{};
+	static constexpr WBytes      MaxCacheRamUsage = 1 WMiB;
+	static constexpr WMsec       PositiveTtl = 6 * 60 * 60 * 1000;
+	static constexpr WMsec       NegativeTtl = 30 * 60 * 1000;
+	static constexpr WMsec       TemporaryFailureTtl = 30 * 1000;
+	static constexpr std::size_t PersistBatchSize = 64;
+	static constexpr WMsec       PersistInterval = 30 * 1000;
+
+	std::unique_ptr<IResolverBackend> Backend{ std::make_unique<WGetNameInfoBackend>() };
+
+	std::mutex                                  CacheMutex;
+	std::unordered_map<WIPAddress, WCacheEntry> Cache{};
+	std::list<WIPAddress>                       LruList{}; // most recently used first
+	WBytes                                      CurrentCacheRamUsage{ 0 };
 
-	std::thread             ResolverThread;
-	std::atomic<bool>       bRunning{ false };
-	std::mutex              QueueMutex;
-	std::condition_variable QueueCondition;
-	WBytes                  CurrentCacheRamUsage{ 0 };
-	std::queue<WQueuedRequest> PendingAddresses;
+	std::vector<std::thread> Workers{};
+	std::atomic<bool>        bRunning{ false };
+	std::mutex               QueueMutex;
+	std::condition_variable  QueueCondition;
+	std::deque<WIPAddress>   PendingAddresses{};
 
-	void ResolveAddress(WQueuedRequest const& Request);
+	// Requests for an address that is already queued or being resolved wait for the same result
+	std::unordered_map<WIPAddress, std::vector<TPromise<std::string const&>>> InFlight{};
+
+	bool                        bPersist{ false };
+	std::mutex                  PersistMutex;
+	std::vector<WPersistedHost> PendingWrites{};
+	WMsec                       LastPersistTime{ 0 };
+
+	static WBytes GetEntryUsage(std::string const& Hostname)
+	{
+		// Hash map node and LRU list node
+		return sizeof(WIPAddress) * 2 + sizeof(WCacheEntry) + Hostname.capacity() + sizeof(void*) * 4;
+	}
 
-	void ResolverThreadFunc();
+	bool FindCached(WIPAddress const& Address, std::string& OutHostname);
+	void AddToCache(WIPAddress const& Address, std::string const& Hostname, WMsec ExpiresAt);
+
+	void ResolveAddress(WIPAddress const& Address, std::string& OutHostname);
+
+	void LoadPersistedHosts();
+	void PersistHosts(bool bForce);
+
+	void WorkerThreadFunc();
 
 public:
 	void Start();
 	void Stop();
 
-	TPromise<std::string const&> Resolve(WIPAddress const& Address);
+	// Has to be called before Start
+	void SetBackend(std::unique_ptr<IResolverBackend> NewBackend) { Backend = std::move(NewBackend); }
 
-	std::mutex                                  ResolvedAddressesMutex;
-	std::unordered_map<WIPAddress, std::string> GetResolvedAddresses() const { return ResolvedAddresses; }
+	TPromise<std::string const&> Resolve(WIPAddress const& Address);
 
 	WMemoryStat GetMemoryUsage() override;
-};
\ No newline at end of file
+};
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "PipelineMetricsCollector.hpp"
+
+WLatencyHistogram WAtomicHistogram::Snapshot(std::string Name) const
+{
+	WLatencyHistogram Result{};
+	Result.Name = std::move(Name);
+	Result.Buckets.reserve(Buckets.size());
+	for (auto const& Bucket : Buckets)
+	{
+		Result.Buckets.push_back(Bucket.load(std::memory_order_relaxed));
+	}
+	Result.Count = Count.load(std::memory_order_relaxed);
+	Result.Sum = Sum.load(std::memory_order_relaxed);
+	Result.Max = Max.load(std::memory_order_relaxed);
+	return Result;
+}
+
+char const* WPipelineMetricsCollector::GetEventTypeName(uint8_t const EventType)
+{
+	static constexpr char const* EventNames[] = { "SocketCreate", "SocketConnect_4", "SocketConnect_6",
+		"SocketBind_4", "SocketBind_6", "TCPSocketEstablished_4", "TCPSocketEstablished_6", "TCPSocketListening",
+		"SocketAccept_4", "SocketAccept_6", "SocketClosed", "Traffic", "Synthetic", "ProcessFork", "ProcessExec",
+		"ProcessExit", "UDPPeer" };
+	static_assert(std::size(EventNames) == EventTypeCount);
+	return EventType < std::size(EventNames) ? EventNames[EventType] : "Unknown";
+}
+
+char const* WPipelineMetricsCollector::GetStageName(EPipelineStage const Stage)
+{
+	switch (Stage)
+	{
+		case EPipelineStage::KernelToCounter:
+			return "Kernel to counter";
+		case EPipelineStage::RefreshCounters:
+			return "RefreshAllTrafficCounters";
+		case EPipelineStage::CollectUpdates:
+			return "GetUpdates";
+		case EPipelineStage::SerializeUpdates:
+			return "Serialize updates";
+		case EPipelineStage::DbWrite:
+			return "Database write";
+		default:
+			return "Unknown";
+	}
+}
+
+void WPipelineMetricsCollector::RecordQueueDepth(uint64_t const Depth)
+{
+	QueueDepth.store(Depth, std::memory_order_relaxed);
+	auto CurrentPeak = PeakQueueDepth.load(std::memory_order_relaxed);
+	while (Depth > CurrentPeak && !PeakQueueDepth.compare_exchange_weak(CurrentPeak, Depth, std::memory_order_relaxed))
+	{
+	}
+}
+
+WPipelineMetrics WPipelineMetricsCollector::Collect(bool const bResetPeak)
+{
+	WPipelineMetrics Metrics{};
+	Metrics.Timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now().time_since_epoch())
+							.count();
+	for (std::size_t i = 0; i < EventTypeCount; ++i)
+	{
+		Metrics.Events.push_back({ GetEventTypeName(static_cast<uint8_t>(i)),
+			EventCounts[i].load(std::memory_order_relaxed) });
+	}
+	Metrics.RingDrops = RingDrops.load(std::memory_order_relaxed);
+	Metrics.QueueDepth = QueueDepth.load(std::memory_order_relaxed);
+	if (bResetPeak)
+	{
+		Metrics.PeakQueueDepth = PeakQueueDepth.exchange(Metrics.QueueDepth, std::memory_order_relaxed);
+	}
+	else
+	{
+		Metrics.PeakQueueDepth = PeakQueueDepth.load(std::memory_order_relaxed);
+	}
+	for (std::size_t i = 0; i < StageLatencies.size(); ++i)
+	{
+		Metrics.Histograms.push_back(StageLatencies[i].Snapshot(GetStageName(static_cast<EPipelineStage>(i))));
+	}
+	return Metrics;
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+
+#include "EBPFCommon.h"
+#include "PipelineMetrics.hpp"
+#include "Singleton.hpp"
+
+enum class EPipelineStage : uint8_t
+{
+	KernelToCounter, // bpf_ktime_get_ns() of a traffic event until it was added to the counters
+	RefreshCounters,
+	CollectUpdates,
+	SerializeUpdates,
+	DbWrite,
+
+	Count
+};
+
+// Same buckets as WLatencyHistogram, but can be recorded into from any thread without a lock
+class WAtomicHistogram
+{
+	std::array<std::atomic<uint64_t>, WHistogramBuckets::Count> Buckets{};
+	std::atomic<uint64_t>                                        Count{};
+	std::atomic<uint64_t>                                        Sum{};
+	std::atomic<uint64_t>                                        Max{};
+
+public:
+	void Record(uint64_t const Value)
+	{
+		Buckets[WHistogramBuckets::GetIndex(Value)].fetch_add(1, std::memory_order_relaxed);
+		Count.fetch_add(1, std::memory_order_relaxed);
+		Sum.fetch_add(Value, std::memory_order_relaxed);
+		auto CurrentMax = Max.load(std::memory_order_relaxed);
+		while (Value > CurrentMax && !Max.compare_exchange_weak(CurrentMax, Value, std::memory_order_relaxed)) {}
+	}
+
+	[[nodiscard]] WLatencyHistogram Snapshot(std::string Name) const;
+};
+
+class WPipelineMetricsCollector : public TSingleton<WPipelineMetricsCollector>
+{
+	static constexpr std::size_t EventTypeCount = NE_UDPPeer + 1;
+
+	std::array<std::atomic<uint64_t>, EventTypeCount>                             EventCounts{};
+	std::array<WAtomicHistogram, static_cast<std::size_t>(EPipelineStage::Count)> StageLatencies{};
+
+	std::atomic<uint64_t> RingDrops{};
+	std::atomic<uint64_t> QueueDepth{};
+	std::atomic<uint64_t> PeakQueueDepth{};
+
+public:
+	static char const* GetEventTypeName(uint8_t EventType);
+	static char const* GetStageName(EPipelineStage Stage);
+
+	void CountEvent(uint8_t const EventType)
+	{
+		if (EventType < EventTypeCount)
+		{
+			EventCounts[EventType].fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void RecordLatency(EPipelineStage Stage, uint64_t const Nanoseconds)
+	{
+		StageLatencies[static_cast<std::size_t>(Stage)].Record(Nanoseconds);
+	}
+
+	// The eBPF side keeps the total, so this just mirrors it
+	void SetRingDrops(uint64_t const Drops) { RingDrops.store(Drops, std::memory_order_relaxed); }
+
+	void RecordQueueDepth(uint64_t Depth);
+
+	// Starts a new peak queue depth window if bResetPeak is set, which only the periodic broadcast does
+	WPipelineMetrics Collect(bool bResetPeak);
+};
+
+// Records how long the enclosing scope took, or until Stop() was called
+class WStageTimer
+{
+	EPipelineStage                        Stage;
+	std::chrono::steady_clock::time_point Start;
+	bool                                  bStopped{ false };
+
+public:
+	explicit WStageTimer(EPipelineStage const Stage_) : Stage(Stage_), Start(std::chrono::steady_clock::now()) {}
+
+	~WStageTimer() { Stop(); }
+
+	WStageTimer(WStageTimer const&) = delete;
+	WStageTimer& operator=(WStageTimer const&) = delete;
+
+	void Stop()
+	{
+		if (bStopped)
+		{
+			return;
+		}
+		bStopped = true;
+		auto const Elapsed = std::chrono::steady_clock::now() - Start;
+		WPipelineMetricsCollector::GetInstance().RecordLatency(
+			Stage, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Elapsed).count()));
+	}
+};
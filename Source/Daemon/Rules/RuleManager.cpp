@@ -86,12 +86,17 @@ inline bool operator==(WTrafficItemRulesBase const& A, WTrafficItemRules const&
 
 void WRuleManager::OnSocketConnected(WSocketCounter const* Socket)
 {
-	std::lock_guard Lock(Mutex);
-	auto const      ProcessItemId = Socket->ParentProcess->TrafficItem->ItemId;
-	auto const      AppItem = Socket->ParentProcess->ParentApp->TrafficItem->ItemId;
-	auto const      ProcessPid = Socket->ParentProcess->TrafficItem->ProcessId;
+	auto const Process = Socket->GetProcessItem();
+	auto const App = Socket->GetAppItem();
+	if (!Process || !App)
+	{
+		return;
+	}
 
-	auto const App = Socket->ParentProcess->ParentApp;
+	std::lock_guard Lock(Mutex);
+	auto const      ProcessItemId = Process->ItemId;
+	auto const      AppItem = App->ItemId;
+	auto const      ProcessPid = Process->ProcessId;
 
 	auto const AppRules = ApplicationRules.contains(AppItem) ? ApplicationRules[AppItem] : WTrafficItemRules{};
 	auto const EffectiveAppRules = GetEffectiveRules(SystemRules, AppRules);
@@ -105,7 +110,7 @@ void WRuleManager::OnSocketConnected(WSocketCounter const* Socket)
 		//       this ensures that the higher-ranked limit is always enforced but it could technically mean
 		//       that a lower ranked limit is exceeded. Ideally we'd set up a hierarchy of the different HTB limits
 		//       so that both limits are enforced properly.
-		UpdateRuleCache(App->TrafficItem);
+		UpdateRuleCache(App);
 		SyncRules();
 
 		// Ensure the PID mark is set for this process if there's a download limit.
@@ -295,6 +300,7 @@ void WRuleManager::SyncRules()
 		return;
 	}
 
+	bool bUpdatedAny = false;
 	for (auto& [Cookie, SockRules] : SocketCookieRules)
 	{
 		if (!SockRules.bDirty)
@@ -311,6 +317,7 @@ void WRuleManager::SyncRules()
 			spdlog::debug("Updated eBPF rules for socket cookie {}: UploadSwitch={}, DownloadSwitch={}", Cookie,
 				static_cast<int>(SockRules.Rules.UploadSwitch), static_cast<int>(SockRules.Rules.DownloadSwitch));
 			SockRules.bDirty = false;
+			bUpdatedAny = true;
 		}
 		if (auto TrafficItem = WSystemMap::GetInstance().GetTrafficItemById(SockRules.SocketId))
 		{
@@ -328,10 +335,16 @@ void WRuleManager::SyncRules()
 			}
 		}
 	}
+
+	if (bUpdatedAny)
+	{
+		EbpfData->InvalidateSocketRules();
+	}
 }
 
 void WRuleManager::RemoveEmptyRules()
 {
+	auto const EbpfData = WDaemon::GetInstance().GetEbpfObj().GetData();
 	if (SystemRules.IsDefault())
 	{
 		SystemRules = {};
@@ -358,6 +371,11 @@ void WRuleManager::RemoveEmptyRules()
 		if (It->second.Rules.DownloadMark == 0 && It->second.Rules.UploadMark == 0
 			&& It->second.Rules.UploadSwitch == SS_None && It->second.Rules.DownloadSwitch == SS_None)
 		{
+			// The empty rules were already synced, so no cached copy has to be invalidated
+			if (EbpfData && !It->second.bDirty)
+			{
+				EbpfData->SocketRules->Delete(It->first);
+			}
 			It = SocketCookieRules.erase(It);
 		}
 		else
@@ -488,7 +506,7 @@ void WRuleManager::HandleRuleChange(WBuffer const& Buf, WDaemonClient const* Sen
 
 	spdlog::info("Rule Change for {}: {}", Update.TrafficItemId, Update.Rules.ToString());
 
-	std::lock_guard Lock(Mutex);
+	std::unique_lock Lock(Mutex);
 
 	auto const Item = WSystemMap::GetInstance().GetTrafficItemById(Update.TrafficItemId);
 	auto const AppItem = WSystemMap::GetInstance().GetTrafficItemById(Update.ParentAppId);
@@ -502,10 +520,10 @@ void WRuleManager::HandleRuleChange(WBuffer const& Buf, WDaemonClient const* Sen
 
 	if (Item->GetType() == TI_System)
 	{
-		// We also store the system rule with cookie 0 in ebpf.
+		// We also store the system rule in ebpf.
 		// That way we can immediately determine if all traffic should be blocked
 		auto const EbpfData = WDaemon::GetInstance().GetEbpfObj().GetData();
-		if (!EbpfData->SocketRules->Update(0, Update.Rules.AsBase()))
+		if (EbpfData && !EbpfData->SystemRules->Update(0, Update.Rules.AsBase()))
 		{
 			spdlog::error("Failed to update eBPF rules for system rule");
 		}
@@ -596,7 +614,9 @@ void WRuleManager::HandleRuleChange(WBuffer const& Buf, WDaemonClient const* Sen
 		ProcessRules.size(), SocketRules.size(), SocketCookieRules.size());
 	WIPLink::GetInstance().PrintStats();
 
-	WDaemon::GetInstance().GetDaemonSocket()->BroadcastMessage(MT_RuleUpdate, Update, Sender);
+	// The socket takes its own locks, clients that reconnect later get the change from the session log
+	Lock.unlock();
+	WDaemon::GetInstance().GetDaemonSocket()->BroadcastLoggedMessage(MT_RuleUpdate, Update, Sender);
 }
 
 WMemoryStat WRuleManager::GetMemoryUsage()
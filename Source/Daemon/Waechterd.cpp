@@ -3,15 +3,20 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 
+#include <cstdlib>
+#include <string_view>
 #include <unistd.h>
 
 #include "spdlog/spdlog.h"
 
 #include "Daemon.hpp"
 #include "DaemonConfig.hpp"
+#include "EventLoop.hpp"
+#include "HotRestart.hpp"
 #include "Data/ConnectionHistory.hpp"
 #include "Data/IP2Asn.hpp"
 #include "Data/LibCurl.hpp"
+#include "Data/ProcessInfoCache.hpp"
 #include "Data/SystemMap.hpp"
 #include "Db/DbManager.hpp"
 #include "Db/StatsManager.hpp"
@@ -19,6 +24,34 @@
 #include "Net/Resolver.hpp"
 #include "Net/IPLink.hpp"
 
+// Runs everything behind the ring buffer on a recorded socket event log,
+// without root, eBPF programs, waechter-iplink or the processes from /proc/
+static int RunReplay(std::string const& Path, double const Speed)
+{
+	spdlog::info("Waechter daemon starting in replay mode");
+	WDaemonConfig::GetInstance().LogConfig();
+	if (!WDaemon::GetInstance().InitReplay(Path, Speed) || !WDaemon::GetInstance().InitSocket())
+	{
+		return -1;
+	}
+
+	WDbManager::GetInstance().Initialize(EDbBackend::SQLite);
+	WStatsManager::GetInstance().StartRequestProcessThread();
+	WResolver::GetInstance().Start();
+	WLibCurl::Init();
+	WIP2Asn::GetInstance().Init();
+	WDaemon::RegisterSignalHandlers();
+	WConnectionHistory::GetInstance().RegisterSignalHandlers();
+
+	WDaemon::GetInstance().RunLoop();
+	spdlog::info("Waechter daemon stopped");
+	WResolver::GetInstance().Stop();
+	WIP2Asn::GetInstance().Stop();
+	WLibCurl::Deinit();
+	WStatsManager::GetInstance().StopRequestProcessThread();
+	return 0;
+}
+
 int main(int Argc, char* Argv[])
 {
 	if (std::getenv("INVOCATION_ID") != nullptr)
@@ -27,20 +60,60 @@ int main(int Argc, char* Argv[])
 		spdlog::set_pattern("[%^%l%$] %v");
 	}
 
-	if (geteuid() != 0)
+	std::string RecordPath{};
+	std::string ReplayPath{};
+	double      ReplaySpeed{ 1.0 };
+	for (int i = 1; i < Argc; ++i)
 	{
-		spdlog::critical("Waechter daemon requires root");
-		return -1;
+		std::string_view const Arg = Argv[i];
+		if (Arg == "--debug")
+		{
+			spdlog::set_level(spdlog::level::debug);
+		}
+		else if (Arg == "--record" && i + 1 < Argc)
+		{
+			RecordPath = Argv[++i];
+		}
+		else if (Arg == "--replay" && i + 1 < Argc)
+		{
+			ReplayPath = Argv[++i];
+		}
+		else if (Arg == "--replay-speed" && i + 1 < Argc)
+		{
+			// "max" replays the events as fast as possible
+			std::string_view const Speed = Argv[++i];
+			ReplaySpeed = Speed == "max" ? 0.0 : std::strtod(Argv[i], nullptr);
+		}
+		else
+		{
+			spdlog::warn("Ignoring unknown argument {}", Arg);
+		}
 	}
 
-	if (Argc > 1 && Argv[1] == std::string("--debug"))
+	if (!ReplayPath.empty())
 	{
-		spdlog::set_level(spdlog::level::debug);
+		return RunReplay(ReplayPath, ReplaySpeed);
+	}
+
+	if (geteuid() != 0)
+	{
+		spdlog::critical("Waechter daemon requires root");
+		return -1;
 	}
 
 	libbpf_set_strict_mode(LIBBPF_STRICT_ALL);
 	spdlog::info("Waechter daemon starting");
 	WDaemonConfig::GetInstance().LogConfig();
+
+	// Has to exist before anything adds its sockets, the polling threads are used if it fails
+	if (auto const& Cfg = WDaemonConfig::GetInstance(); Cfg.bEpollEventLoop)
+	{
+		WEventLoop::GetInstance().Init(static_cast<std::size_t>(Cfg.WorkerThreads));
+	}
+
+	auto& HotRestart = WHotRestart::GetInstance();
+	HotRestart.Prepare();
+
 	if (!WIPLink::GetInstance().Init())
 	{
 		spdlog::error("Failed to initialize IP link");
@@ -53,9 +126,21 @@ int main(int Argc, char* Argv[])
 		WIPLink::GetInstance().Deinit();
 		return -1;
 	}
+
+	if (!RecordPath.empty() && !WDaemon::GetInstance().GetEbpfObj().StartRecording(RecordPath))
+	{
+		WIPLink::GetInstance().Deinit();
+		return -1;
+	}
+	// Subscribing to process events requires CAP_NET_ADMIN
+	WProcessInfoCache::GetInstance().StartExitNotifications();
+
 	// We need to do this while we still have root
 	// otherwise we can't see the PID for sockets owned by root
-	WSystemMap::GetInstance().AddExistingSockets();
+	if (!HotRestart.RestoreSystemMap())
+	{
+		WSystemMap::GetInstance().AddExistingSockets();
+	}
 
 	if (!WDaemonConfig::GetInstance().DropPrivileges())
 	{
@@ -69,15 +154,18 @@ int main(int Argc, char* Argv[])
 	WIP2Asn::GetInstance().Init();
 	WDaemon::RegisterSignalHandlers();
 	WConnectionHistory::GetInstance().RegisterSignalHandlers();
+	HotRestart.RegisterSignalHandler();
 	WSystemMap::GetInstance().ProcessInitialApps();
 
 	spdlog::info("Ebpf programs loaded and attached");
 	WDaemon::GetInstance().RunLoop();
+	int const ExitCode = HotRestart.Shutdown(WDaemon::GetInstance().GetEbpfObj());
 	spdlog::info("Waechter daemon stopped");
 	WIPLink::GetInstance().Deinit();
 	WResolver::GetInstance().Stop();
 	WIP2Asn::GetInstance().Stop();
+	WProcessInfoCache::GetInstance().Stop();
 	WLibCurl::Deinit();
 	WStatsManager::GetInstance().StopRequestProcessThread();
-	return 0;
+	return ExitCode;
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "WorkerPool.hpp"
+
+#include <pthread.h>
+
+#include "spdlog/spdlog.h"
+#include "tracy/Tracy.hpp"
+
+void WWorkerPool::WorkerThreadFunction(std::string const ThreadName)
+{
+	tracy::SetThreadName(ThreadName.c_str());
+	pthread_setname_np(pthread_self(), ThreadName.c_str());
+
+	while (true)
+	{
+		std::function<void()> Task{};
+		{
+			std::unique_lock Lock(QueueMutex);
+			QueueCondition.wait(Lock, [this] { return !Tasks.empty() || !bRunning; });
+			if (Tasks.empty())
+			{
+				return;
+			}
+			Task = std::move(Tasks.front());
+			Tasks.pop_front();
+		}
+		Task();
+	}
+}
+
+void WWorkerPool::Start(std::size_t const Threads)
+{
+	std::scoped_lock Lock(QueueMutex);
+	if (bRunning)
+	{
+		return;
+	}
+	bRunning = true;
+	Workers.reserve(Threads);
+	for (std::size_t i = 0; i < Threads; ++i)
+	{
+		Workers.emplace_back(
+			&WWorkerPool::WorkerThreadFunction, this, Threads > 1 ? fmt::format("{}-{}", Name, i) : Name);
+	}
+}
+
+void WWorkerPool::Stop()
+{
+	{
+		std::scoped_lock Lock(QueueMutex);
+		bRunning = false;
+	}
+	QueueCondition.notify_all();
+	for (auto& Worker : Workers)
+	{
+		if (Worker.joinable())
+		{
+			Worker.join();
+		}
+	}
+	Workers.clear();
+}
+
+void WWorkerPool::Post(std::function<void()> Task)
+{
+	{
+		std::unique_lock Lock(QueueMutex);
+		if (!bRunning)
+		{
+			Lock.unlock();
+			Task();
+			return;
+		}
+		Tasks.push_back(std::move(Task));
+	}
+	QueueCondition.notify_one();
+}
+
+std::size_t WWorkerPool::GetQueuedTasks()
+{
+	std::scoped_lock Lock(QueueMutex);
+	return Tasks.size();
+}
+
+void WSerialExecutor::Post(std::function<void()> Task)
+{
+	{
+		std::scoped_lock Lock(Mutex);
+		Tasks.push_back(std::move(Task));
+		if (bScheduled)
+		{
+			return;
+		}
+		bScheduled = true;
+	}
+	Target.Post([Self = shared_from_this()] { Self->RunQueued(); });
+}
+
+void WSerialExecutor::RunQueued()
+{
+	// Tasks posted while this runs are picked up here instead of being scheduled again
+	while (true)
+	{
+		std::function<void()> Task{};
+		{
+			std::scoped_lock Lock(Mutex);
+			if (Tasks.empty())
+			{
+				bScheduled = false;
+				return;
+			}
+			Task = std::move(Tasks.front());
+			Tasks.pop_front();
+		}
+		Task();
+	}
+}
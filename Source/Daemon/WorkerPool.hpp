@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Promise.hpp"
+
+// Runs posted tasks on a fixed number of threads in the order they were posted,
+// with a single thread no two tasks ever run at the same time
+class WWorkerPool final : public IExecutor
+{
+	std::string                       Name{};
+	std::vector<std::thread>          Workers{};
+	std::mutex                        QueueMutex;
+	std::condition_variable           QueueCondition;
+	std::deque<std::function<void()>> Tasks{};
+	bool                              bRunning{ false };
+
+	void WorkerThreadFunction(std::string ThreadName);
+
+public:
+	// Also used as the thread name, so at most 12 characters
+	explicit WWorkerPool(std::string Name_) : Name(std::move(Name_)) {}
+	~WWorkerPool() override { Stop(); }
+
+	WWorkerPool(WWorkerPool const&) = delete;
+	WWorkerPool& operator=(WWorkerPool const&) = delete;
+
+	void Start(std::size_t Threads);
+
+	// Tasks that are still queued run before the threads exit
+	void Stop();
+
+	// Runs the task right away on the calling thread if the pool isn't running
+	void Post(std::function<void()> Task) override;
+
+	[[nodiscard]] std::size_t GetQueuedTasks();
+};
+
+// Runs its tasks on another executor one at a time and in order, e.g. everything sent to a single client.
+// Has to be owned by a shared_ptr, queued tasks keep it alive
+class WSerialExecutor final : public IExecutor, public std::enable_shared_from_this<WSerialExecutor>
+{
+	IExecutor&                        Target;
+	std::mutex                        Mutex;
+	std::deque<std::function<void()>> Tasks{};
+	bool                              bScheduled{};
+
+	void RunQueued();
+
+public:
+	explicit WSerialExecutor(IExecutor& Target_) : Target(Target_) {}
+
+	void Post(std::function<void()> Task) override;
+};
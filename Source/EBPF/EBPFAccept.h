@@ -6,6 +6,9 @@
 #pragma once
 #include "EBPFInternal.h"
 
+// PF_KTHREAD from linux/sched.h, defines aren't part of vmlinux.h
+#define WPF_KTHREAD 0x00200000
+
 #ifdef HAVE_VMLINUX
 SEC("lsm/sock_graft")
 int BPF_PROG(sock_graft, struct sock* Sk, struct socket* Parent)
@@ -24,31 +27,32 @@ int BPF_PROG(sock_graft, struct sock* Sk, struct socket* Parent)
 
 	__u64 Cookie = bpf_get_socket_cookie(Sk);
 
-	// sock_graft fires in softirq context during TCP handshake completion,
-	// so bpf_get_current_pid_tgid() returns whatever process was interrupted
-	// by the softirq — NOT the process that called accept(). We must look up
-	// the actual owning PID from the local port via port_to_pid map, which
-	// was populated when the listening socket was bound.
-	__u16  Lport = Sk->__sk_common.skc_num; // host-endian
-	__u32* OwnerPid = bpf_map_lookup_elem(&port_to_pid, &Lport);
-
-	struct WSocketEvent* Event = MakeSocketEvent2(Cookie, NE_SocketAccept_4, false);
-	if (!Event)
+	// sock_graft is called by accept() (inet_accept), so the current task is the process that gets the new socket.
+	// For a pre-forked server that's the worker, not the process that bound the port. Kernel threads accepting
+	// connections on their own fall back to the owner of the listening port
+	__u16               Lport = Sk->__sk_common.skc_num; // host-endian
+	__u64               PidTgid = bpf_get_current_pid_tgid();
+	struct task_struct* Task = bpf_get_current_task_btf();
+	if ((PidTgid >> 32) == 0 || (BPF_CORE_READ(Task, flags) & WPF_KTHREAD))
 	{
-		return WLSM_ALLOW;
+		__u32* OwnerPid = bpf_map_lookup_elem(&port_to_pid, &Lport);
+		PidTgid = OwnerPid ? ((__u64)(*OwnerPid)) << 32 : 0;
 	}
 
-	// Override PidTgId with the actual owner PID from port_to_pid lookup
-	if (OwnerPid && *OwnerPid != 0)
+	__u32 Tgid = (__u32)(PidTgid >> 32);
+	if (Tgid != 0)
 	{
-		Event->PidTgId = ((__u64)(*OwnerPid)) << 32;
+		// The accepted socket doesn't go through cgroup/sock_create, the process has to be tracked from here
+		__u8 const Tracked = 1;
+		bpf_map_update_elem(&tracked_pids, &Tgid, &Tracked, BPF_NOEXIST);
 	}
-	else
+
+	struct WSocketEvent* Event = MakeSocketEvent2(Cookie, NE_SocketAccept_4, false);
+	if (!Event)
 	{
-		// Fallback: use bpf_get_current_pid_tgid() even though it may be wrong
-		// in softirq context. Better than nothing.
-		Event->PidTgId = bpf_get_current_pid_tgid();
+		return WLSM_ALLOW;
 	}
+	Event->PidTgId = PidTgid;
 	Event->CgroupId = bpf_get_current_cgroup_id();
 
 	Event->Data.SocketAcceptEventData.Family = Family;
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// Traffic per cgroup, summed up in the kernel so the daemon can show per container usage
+// without having to resolve the processes behind every packet.
+#pragma once
+#include "EBPFInternal.h"
+#include "EBPFCommon.h"
+
+#ifndef CGROUP_TRAFFIC_MAP_SIZE
+	#define CGROUP_TRAFFIC_MAP_SIZE 4096
+#endif
+
+// Set by the daemon before loading, see [daemon] cgroup_accounting
+__u8 const volatile CgroupAccountingEnabled = 0;
+
+struct
+{
+	__uint(type, BPF_MAP_TYPE_LRU_PERCPU_HASH);
+	__uint(max_entries, CGROUP_TRAFFIC_MAP_SIZE);
+	__type(key, __u64); // cgroup id
+	__type(value, struct WCgroupTrafficValue);
+} cgroup_traffic SEC(".maps");
+
+static __always_inline void AccountCgroup(struct __sk_buff* Skb, __u8 Direction)
+{
+	if (!CgroupAccountingEnabled)
+	{
+		return;
+	}
+
+	// The cgroup of the socket, not of whatever task happens to be running
+	__u64                       CgroupId = bpf_skb_cgroup_id(Skb);
+	struct WCgroupTrafficValue* Value = bpf_map_lookup_elem(&cgroup_traffic, &CgroupId);
+	if (!Value)
+	{
+		struct WCgroupTrafficValue NewValue = { 0, 0 };
+		// Fails if another CPU added it in the meantime, the lookup below then finds that one
+		bpf_map_update_elem(&cgroup_traffic, &CgroupId, &NewValue, BPF_NOEXIST);
+		Value = bpf_map_lookup_elem(&cgroup_traffic, &CgroupId);
+		if (!Value)
+		{
+			return;
+		}
+	}
+
+	// Per CPU value, no atomics needed
+	if (Direction == PD_Incoming)
+	{
+		Value->DownloadBytes += Skb->len;
+	}
+	else
+	{
+		Value->UploadBytes += Skb->len;
+	}
+}
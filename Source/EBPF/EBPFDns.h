@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// Copies DNS responses to a separate ring, so the daemon can map remote addresses
+// to the names that applications looked up instead of doing reverse lookups
+#pragma once
+#include "EBPFInternal.h"
+#include "EBPFCommon.h"
+
+#ifndef DNS_RING_SIZE
+	#define DNS_RING_SIZE (256 * 1024)
+#endif
+
+#define DNS_PORT 53
+#define DNS_HEADER_SIZE 12
+
+// Set by the daemon before loading, see [resolver] snoop_dns
+__u8 const volatile DnsSnoopingEnabled = 0;
+
+// Only this much of the question is compared, longer names are matched by their prefix
+#define DNS_QUESTION_PREFIX 64
+
+struct
+{
+	__uint(type, BPF_MAP_TYPE_RINGBUF);
+	__uint(max_entries, DNS_RING_SIZE);
+} dns_answer_ring SEC(".maps");
+
+struct WDnsQueryKey
+{
+	__u64 Cookie;
+	__u16 Id;
+	__u16 Padding[3];
+};
+
+// Queries sent by local sockets, only answers to them are passed on. Anyone else could send a packet from port 53
+struct
+{
+	__uint(type, BPF_MAP_TYPE_LRU_HASH);
+	__uint(max_entries, 4096);
+	__type(key, struct WDnsQueryKey);
+	__type(value, __u32); // Hash of the question
+} dns_queries SEC(".maps");
+
+struct WDnsMessage
+{
+	__u32 Offset; // Of the DNS header
+	__u32 Length; // Of the whole message, which can be larger than what is in this packet
+	__u8  Protocol;
+};
+
+// Finds the DNS message in a packet from (bResponse) or to port 53, returns false if it doesn't carry one
+static __always_inline bool FindDnsMessage(struct __sk_buff* Skb, bool bResponse, struct WDnsMessage* Out)
+{
+	// Only the first fragment contains the DNS header, packets with extension headers are ignored
+	__u8  IPProto = 0;
+	__u32 TransportOffset = 0;
+	if (!LoadTransportHeader(Skb, &IPProto, &TransportOffset))
+	{
+		return false;
+	}
+
+	if (IPProto != IPPROTO_UDP && IPProto != IPPROTO_TCP)
+	{
+		return false;
+	}
+
+	__u16 Port = 0;
+	if (bpf_skb_load_bytes(Skb, TransportOffset + (bResponse ? 0 : 2), &Port, 2) < 0 || Port != bpf_htons(DNS_PORT))
+	{
+		return false;
+	}
+
+	Out->Protocol = IPProto;
+	if (IPProto == IPPROTO_UDP)
+	{
+		Out->Offset = TransportOffset + 8;
+		if (Out->Offset + DNS_HEADER_SIZE > Skb->len)
+		{
+			return false;
+		}
+		Out->Length = Skb->len - Out->Offset;
+		return true;
+	}
+
+	__u8 DataOffset = 0;
+	if (bpf_skb_load_bytes(Skb, TransportOffset + 12, &DataOffset, 1) < 0)
+	{
+		return false;
+	}
+
+	// Messages start with a two byte length prefix, only segments that start a message are useful. Acks have no
+	// room for a header, a continuation that happens to look like one doesn't match a query that was sent
+	__u32 const PrefixOffset = TransportOffset + (DataOffset >> 4) * 4;
+	__u16       Length = 0;
+	if (PrefixOffset + 2 + DNS_HEADER_SIZE > Skb->len || bpf_skb_load_bytes(Skb, PrefixOffset, &Length, 2) < 0)
+	{
+		return false;
+	}
+	Length = bpf_ntohs(Length);
+	if (Length < DNS_HEADER_SIZE)
+	{
+		return false;
+	}
+	Out->Offset = PrefixOffset + 2;
+	Out->Length = Length;
+	return true;
+}
+
+// Hashes the name in the question section, which responses repeat exactly as it was asked
+static __always_inline __u32 HashDnsQuestion(struct __sk_buff* Skb, struct WDnsMessage const* Message)
+{
+	__u8  Question[DNS_QUESTION_PREFIX] = {};
+	__u32 Size = Skb->len - Message->Offset - DNS_HEADER_SIZE;
+	if (Size > Message->Length - DNS_HEADER_SIZE)
+	{
+		Size = Message->Length - DNS_HEADER_SIZE;
+	}
+	if (Size > DNS_QUESTION_PREFIX)
+	{
+		Size = DNS_QUESTION_PREFIX;
+	}
+	if (Size == 0 || bpf_skb_load_bytes(Skb, Message->Offset + DNS_HEADER_SIZE, Question, Size) < 0)
+	{
+		return 0;
+	}
+
+	// FNV-1a up to the end of the name
+	__u32 Hash = 2166136261;
+	for (__u32 i = 0; i < DNS_QUESTION_PREFIX; ++i)
+	{
+		if (i >= Size || Question[i] == 0)
+		{
+			break;
+		}
+		Hash = (Hash ^ Question[i]) * 16777619;
+	}
+	return Hash;
+}
+
+// Skb starts at the IP header in cgroup_skb programs
+static __always_inline void TrackDnsQuery(struct __sk_buff* Skb, __u64 Cookie)
+{
+	if (!DnsSnoopingEnabled)
+	{
+		return;
+	}
+
+	struct WDnsMessage Message = {};
+	if (!FindDnsMessage(Skb, false, &Message))
+	{
+		return;
+	}
+
+	struct WDnsQueryKey Key = {};
+	Key.Cookie = Cookie;
+	if (bpf_skb_load_bytes(Skb, Message.Offset, &Key.Id, 2) < 0)
+	{
+		return;
+	}
+	__u32 const Hash = HashDnsQuestion(Skb, &Message);
+	bpf_map_update_elem(&dns_queries, &Key, &Hash, BPF_ANY);
+}
+
+// Skb starts at the IP header in cgroup_skb programs
+static __always_inline void SnoopDnsResponse(struct __sk_buff* Skb, __u64 Cookie)
+{
+	if (!DnsSnoopingEnabled)
+	{
+		return;
+	}
+
+	struct WDnsMessage Message = {};
+	if (!FindDnsMessage(Skb, true, &Message))
+	{
+		return;
+	}
+
+	// Has to answer a query this socket sent, for the same name
+	struct WDnsQueryKey Key = {};
+	Key.Cookie = Cookie;
+	if (bpf_skb_load_bytes(Skb, Message.Offset, &Key.Id, 2) < 0)
+	{
+		return;
+	}
+	__u32* QuestionHash = bpf_map_lookup_elem(&dns_queries, &Key);
+	if (!QuestionHash || *QuestionHash != HashDnsQuestion(Skb, &Message))
+	{
+		return;
+	}
+	bpf_map_delete_elem(&dns_queries, &Key);
+
+	__u32 Size = Skb->len - Message.Offset;
+	if (Size > Message.Length)
+	{
+		Size = Message.Length;
+	}
+	if (Size > DNS_PAYLOAD_SIZE)
+	{
+		Size = DNS_PAYLOAD_SIZE;
+	}
+	if (Size < DNS_HEADER_SIZE)
+	{
+		return;
+	}
+
+	struct WDnsAnswerEvent* Event =
+		(struct WDnsAnswerEvent*)bpf_ringbuf_reserve(&dns_answer_ring, sizeof(struct WDnsAnswerEvent), 0);
+	if (!Event)
+	{
+		return;
+	}
+
+	Event->Cookie = Cookie;
+	Event->Size = (__u16)Size;
+	Event->Protocol = Message.Protocol;
+	if (bpf_skb_load_bytes(Skb, Message.Offset, Event->Payload, Size) < 0)
+	{
+		bpf_ringbuf_discard(Event, 0);
+		return;
+	}
+	bpf_ringbuf_submit(Event, 0);
+}
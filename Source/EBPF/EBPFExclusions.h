@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// Traffic that is configured to not be accounted at all, see the [exclusions] section of the daemon config.
+// Checked before anything is reserved on the ring buffer, so excluded packets cost a few map lookups at most.
+#pragma once
+#include "EBPFInternal.h"
+#include "EBPFCommon.h"
+
+#ifndef LOOPBACK_IFINDEX
+	#define LOOPBACK_IFINDEX 1
+#endif
+
+// Set by the daemon before loading, the maps are only looked at if there is something in them
+__u8 const volatile ExcludeLoopback = 0;
+__u8 const volatile ExcludeInterfaces = 0;
+__u8 const volatile ExcludePorts = 0;
+__u8 const volatile ExcludeCgroups = 0;
+
+struct
+{
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, 64);
+	__type(key, __u32); // ifindex
+	__type(value, __u8);
+} excluded_interfaces SEC(".maps");
+
+// One bit per port
+struct
+{
+	__uint(type, BPF_MAP_TYPE_ARRAY);
+	__uint(max_entries, 65536 / 64);
+	__type(key, __u32);
+	__type(value, __u64);
+} excluded_ports SEC(".maps");
+
+struct
+{
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, 256);
+	__type(key, __u64); // cgroup id
+	__type(value, __u8);
+} excluded_cgroups SEC(".maps");
+
+// Excluded loopback traffic per direction, the daemon still counts it for filters matching loopback addresses
+struct
+{
+	__uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+	__uint(max_entries, 2);
+	__type(key, __u32);
+	__type(value, struct WExcludedTrafficValue);
+} excluded_traffic SEC(".maps");
+
+static __always_inline bool IsLoopbackPacket(struct __sk_buff* Skb)
+{
+	if (Skb->ifindex == LOOPBACK_IFINDEX)
+	{
+		return true;
+	}
+
+	// The device isn't always known yet on egress, so check the destination as well
+	if (Skb->protocol == bpf_htons(ETH_P_IP))
+	{
+		__u8 DestinationNet = 0;
+		return bpf_skb_load_bytes(Skb, 16, &DestinationNet, 1) == 0 && DestinationNet == 127;
+	}
+
+	__u64 Destination[2] = { 0, 0 };
+	if (bpf_skb_load_bytes(Skb, 24, Destination, sizeof(Destination)) < 0)
+	{
+		return false;
+	}
+	return Destination[0] == 0 && Destination[1] == bpf_cpu_to_be64(1);
+}
+
+static __always_inline bool IsPortExcluded(__u16 Port)
+{
+	__u32  Index = Port / 64;
+	__u64* Bits = bpf_map_lookup_elem(&excluded_ports, &Index);
+	return Bits && (*Bits >> (Port % 64)) & 1;
+}
+
+static __always_inline bool HasExcludedPort(struct __sk_buff* Skb)
+{
+	__u8  IPProto = 0;
+	__u32 TransportOffset = 0;
+	if (!LoadTransportHeader(Skb, &IPProto, &TransportOffset) || (IPProto != IPPROTO_TCP && IPProto != IPPROTO_UDP))
+	{
+		return false;
+	}
+
+	// Source and destination port are the first four bytes for both protocols
+	__u16 Ports[2] = { 0, 0 };
+	if (bpf_skb_load_bytes(Skb, TransportOffset, Ports, sizeof(Ports)) < 0)
+	{
+		return false;
+	}
+	return IsPortExcluded(bpf_ntohs(Ports[0])) || IsPortExcluded(bpf_ntohs(Ports[1]));
+}
+
+// Returns true if the packet shouldn't be accounted
+static __always_inline bool IsExcluded(struct __sk_buff* Skb, __u8 Direction)
+{
+	if (ExcludeLoopback && IsLoopbackPacket(Skb))
+	{
+		__u32                         Key = Direction;
+		struct WExcludedTrafficValue* Traffic = bpf_map_lookup_elem(&excluded_traffic, &Key);
+		if (Traffic)
+		{
+			// Per CPU value, no atomics needed
+			Traffic->Bytes += Skb->len;
+			Traffic->Packets += 1;
+		}
+		return true;
+	}
+
+	if (ExcludeInterfaces)
+	{
+		__u32 IfIndex = Skb->ifindex;
+		if (bpf_map_lookup_elem(&excluded_interfaces, &IfIndex))
+		{
+			return true;
+		}
+	}
+
+	if (ExcludeCgroups)
+	{
+		__u64 CgroupId = bpf_skb_cgroup_id(Skb);
+		if (bpf_map_lookup_elem(&excluded_cgroups, &CgroupId))
+		{
+			return true;
+		}
+	}
+
+	return ExcludePorts && HasExcludedPort(Skb);
+}
@@ -47,6 +47,15 @@
 	#define ETH_P_IPV6 0x86DD
 #endif
 
+#ifndef IPPROTO_TCP
+	#define IPPROTO_TCP 6
+#endif
+#ifndef IPPROTO_UDP
+	#define IPPROTO_UDP 17
+#endif
+
+// Rules of sockets as written by the daemon, which can only address sockets by their cookie.
+// The programs cache them in socket_rule_cache, entries are deleted when the socket is destroyed.
 struct
 {
 	__uint(type, BPF_MAP_TYPE_HASH);
@@ -56,6 +65,36 @@ struct
 	__uint(pinning, LIBBPF_PIN_BY_NAME); // We need to pin the map so it's both accessible in tcx and cgroup programs
 } socket_rules SEC(".maps");
 
+struct WSocketRuleCache
+{
+	struct WTrafficItemRulesBase Rules; // zeroed if the socket has no rules
+	__u32                        Generation;
+};
+
+// Freed together with the socket, so a lookup per packet is all that's needed once the rules are cached
+struct
+{
+	__uint(type, BPF_MAP_TYPE_SK_STORAGE);
+	__uint(map_flags, BPF_F_NO_PREALLOC);
+	__type(key, int);
+	__type(value, struct WSocketRuleCache);
+} socket_rule_cache SEC(".maps");
+
+// Rules of the whole system
+struct
+{
+	__uint(type, BPF_MAP_TYPE_ARRAY);
+	__type(key, __u32);
+	__type(value, struct WTrafficItemRulesBase);
+	__uint(max_entries, 1);
+} system_rules SEC(".maps");
+
+// Incremented by the daemon after it changed socket_rules, cached rules of an older generation are reloaded
+__u32 volatile SocketRulesGeneration = 0;
+
+// Events that didn't fit into socket_event_ring because the daemon fell behind, only ever read by the daemon
+__u64 volatile SocketEventRingDrops = 0;
+
 struct
 {
 	__uint(type, BPF_MAP_TYPE_RINGBUF);
@@ -105,6 +144,17 @@ struct
 	__type(value, __u32); // PID
 } port_to_pid SEC(".maps");
 
+// Processes that own sockets (and their forked children which inherit them), only those
+// generate process lifecycle events so the ring buffer isn't flooded by every short-lived process.
+// Entries are added by on_sock_create, the fork handler and the daemon for pre-existing processes.
+struct
+{
+	__uint(type, BPF_MAP_TYPE_LRU_HASH);
+	__uint(max_entries, 65536);
+	__type(key, __u32);  // Tgid
+	__type(value, __u8); // Unused
+} tracked_pids SEC(".maps");
+
 static __always_inline struct WSocketEvent* MakeSocketEvent2(__u64 Cookie, __u8 EventType, bool bWithPID)
 {
 	if (Cookie == 0)
@@ -117,6 +167,7 @@ static __always_inline struct WSocketEvent* MakeSocketEvent2(__u64 Cookie, __u8
 		(struct WSocketEvent*)bpf_ringbuf_reserve(&socket_event_ring, sizeof(struct WSocketEvent), 0);
 	if (!SocketEvent)
 	{
+		__sync_fetch_and_add(&SocketEventRingDrops, 1);
 		return NULL;
 	}
 	__builtin_memset(&SocketEvent->Data, 0, sizeof(struct WSocketEventData));
@@ -142,8 +193,99 @@ static __always_inline struct WSocketEvent* MakeSocketEvent(__u64 Cookie, __u8 E
 	return MakeSocketEvent2(Cookie, EventType, true);
 }
 
-static __always_inline struct WTrafficItemRulesBase* GetSocketRules(__u64 Cookie)
+// Process events aren't tied to a socket, so they are reserved without a cookie
+static __always_inline struct WSocketEvent* MakeProcessEvent(__u8 EventType)
 {
+	struct WSocketEvent* SocketEvent =
+		(struct WSocketEvent*)bpf_ringbuf_reserve(&socket_event_ring, sizeof(struct WSocketEvent), 0);
+	if (!SocketEvent)
+	{
+		__sync_fetch_and_add(&SocketEventRingDrops, 1);
+		return NULL;
+	}
+	__builtin_memset(&SocketEvent->Data, 0, sizeof(struct WSocketEventData));
+
+	SocketEvent->Cookie = 0;
+	SocketEvent->CgroupId = bpf_get_current_cgroup_id();
+	SocketEvent->PidTgId = bpf_get_current_pid_tgid();
+	SocketEvent->EventType = EventType;
+
+	return SocketEvent;
+}
+
+// Skb starts at the IP header in cgroup_skb programs. Fails for fragments other than the first one,
+// they don't carry a transport header. IPv6 extension headers aren't supported.
+static __always_inline bool LoadTransportHeader(struct __sk_buff* Skb, __u8* OutProto, __u32* OutOffset)
+{
+	if (Skb->protocol == bpf_htons(ETH_P_IP))
+	{
+		__u8  VersionIhl = 0;
+		__u16 FragmentOffset = 0;
+		if (bpf_skb_load_bytes(Skb, 0, &VersionIhl, 1) < 0 || bpf_skb_load_bytes(Skb, 6, &FragmentOffset, 2) < 0
+			|| bpf_skb_load_bytes(Skb, 9, OutProto, 1) < 0)
+		{
+			return false;
+		}
+
+		if (bpf_ntohs(FragmentOffset) & 0x1FFF)
+		{
+			return false;
+		}
+		*OutOffset = (VersionIhl & 0x0F) * 4;
+		return true;
+	}
+
+	if (bpf_skb_load_bytes(Skb, 6, OutProto, 1) < 0)
+	{
+		return false;
+	}
+	*OutOffset = 40;
+	return true;
+}
+
+static __always_inline struct WTrafficItemRulesBase* GetSocketRules(struct __sk_buff* Skb, __u64 Cookie)
+{
+	struct bpf_sock* Sk = Skb->sk;
+	if (Sk)
+	{
+		Sk = bpf_sk_fullsock(Sk);
+	}
+	if (!Sk)
+	{
+		return bpf_map_lookup_elem(&socket_rules, &Cookie);
+	}
+
+	__u32 const              Generation = SocketRulesGeneration;
+	struct WSocketRuleCache* Cache = bpf_sk_storage_get(&socket_rule_cache, Sk, 0, 0);
+	if (Cache && Cache->Generation == Generation)
+	{
+		return &Cache->Rules;
+	}
+
+	if (!Cache)
+	{
+		Cache = bpf_sk_storage_get(&socket_rule_cache, Sk, 0, BPF_SK_STORAGE_GET_F_CREATE);
+		if (!Cache)
+		{
+			return bpf_map_lookup_elem(&socket_rules, &Cookie);
+		}
+	}
+
 	struct WTrafficItemRulesBase* Rules = bpf_map_lookup_elem(&socket_rules, &Cookie);
-	return Rules;
+	if (Rules)
+	{
+		Cache->Rules = *Rules;
+	}
+	else
+	{
+		__builtin_memset(&Cache->Rules, 0, sizeof(Cache->Rules));
+	}
+	Cache->Generation = Generation;
+	return &Cache->Rules;
+}
+
+static __always_inline struct WTrafficItemRulesBase* GetSystemRules()
+{
+	__u32 const Key = 0;
+	return bpf_map_lookup_elem(&system_rules, &Key);
 }
\ No newline at end of file
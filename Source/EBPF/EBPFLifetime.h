@@ -11,13 +11,17 @@
 SEC("fentry/inet_sock_destruct")
 int BPF_PROG(on_inet_sock_destruct, struct sock* Sk)
 {
-	struct WSocketEvent* Event = MakeSocketEvent(bpf_get_socket_cookie(Sk), NE_SocketClosed);
+	__u64                Cookie = bpf_get_socket_cookie(Sk);
+	struct WSocketEvent* Event = MakeSocketEvent(Cookie, NE_SocketClosed);
 
 	if (Event)
 	{
 		bpf_ringbuf_submit(Event, 0);
 	}
 
+	// The cached copy in socket_rule_cache goes away with the socket
+	bpf_map_delete_elem(&socket_rules, &Cookie);
+
 	// NOTE: We intentionally do NOT clean up port_to_pid here.
 	// TCP cleanup is handled in on_tcp_set_state which correctly only deletes
 	// the mapping when the LISTENING socket closes (not accepted child connections).
@@ -57,6 +61,9 @@ int on_sock_create(struct bpf_sock* Socket)
 
 	bpf_map_update_elem(&shared_socket_data_map, &Key, &Data, BPF_ANY);
 
+	__u8 const Tracked = 1;
+	bpf_map_update_elem(&tracked_pids, &Tgid, &Tracked, BPF_NOEXIST);
+
 	struct WSocketEvent* SocketEvent = MakeSocketEvent(Cookie, NE_SocketCreate);
 	if (SocketEvent)
 	{
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// Tracks the lifecycle of processes that own sockets, so the daemon doesn't have to poll /proc/
+#pragma once
+#include "EBPFInternal.h"
+
+#ifdef HAVE_VMLINUX
+SEC("tp_btf/sched_process_fork")
+int BPF_PROG(on_sched_process_fork, struct task_struct* Parent, struct task_struct* Child)
+{
+	__u32 ParentTgid = BPF_CORE_READ(Parent, tgid);
+	__u32 ChildTgid = BPF_CORE_READ(Child, tgid);
+
+	// New threads share the thread group of the parent
+	if (ParentTgid == ChildTgid || !bpf_map_lookup_elem(&tracked_pids, &ParentTgid))
+	{
+		return 0;
+	}
+
+	// The child inherits the file descriptors, so it could end up owning the sockets of the parent
+	__u8 const Tracked = 1;
+	bpf_map_update_elem(&tracked_pids, &ChildTgid, &Tracked, BPF_ANY);
+
+	struct WSocketEvent* Event = MakeProcessEvent(NE_ProcessFork);
+	if (Event)
+	{
+		Event->Data.ProcessEventData.Pid = ChildTgid;
+		Event->Data.ProcessEventData.ParentPid = ParentTgid;
+		bpf_ringbuf_submit(Event, 0);
+	}
+	return 0;
+}
+
+SEC("tp_btf/sched_process_exec")
+int BPF_PROG(on_sched_process_exec, struct task_struct* Task, pid_t OldPid, struct linux_binprm* Bprm)
+{
+	__u32 Tgid = BPF_CORE_READ(Task, tgid);
+	if (!bpf_map_lookup_elem(&tracked_pids, &Tgid))
+	{
+		return 0;
+	}
+
+	struct WSocketEvent* Event = MakeProcessEvent(NE_ProcessExec);
+	if (Event)
+	{
+		Event->Data.ProcessEventData.Pid = Tgid;
+		bpf_ringbuf_submit(Event, 0);
+	}
+	return 0;
+}
+
+SEC("tp_btf/sched_process_exit")
+int BPF_PROG(on_sched_process_exit, struct task_struct* Task)
+{
+	__u32 Tgid = BPF_CORE_READ(Task, tgid);
+
+	// Thread exits are reported as well, we only care about the whole process. The thread group leader can exit
+	// before its other threads, so the process is gone once the last thread exits, not when the leader does
+	if (BPF_CORE_READ(Task, signal, live.counter) != 0 || !bpf_map_lookup_elem(&tracked_pids, &Tgid))
+	{
+		return 0;
+	}
+
+	struct WSocketEvent* Event = MakeProcessEvent(NE_ProcessExit);
+	if (!Event)
+	{
+		// The process stays tracked, the daemon notices the lost event and checks all processes
+		return 0;
+	}
+	Event->Data.ProcessEventData.Pid = Tgid;
+	bpf_ringbuf_submit(Event, 0);
+	bpf_map_delete_elem(&tracked_pids, &Tgid);
+	return 0;
+}
+#endif
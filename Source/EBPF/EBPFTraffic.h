@@ -7,6 +7,10 @@
 #pragma once
 #include "EBPFInternal.h"
 #include "EBPFCommon.h"
+#include "EBPFDns.h"
+#include "EBPFUdpFlows.h"
+#include "EBPFExclusions.h"
+#include "EBPFCgroups.h"
 
 #ifndef TC_ACT_OK
 	#define TC_ACT_OK 0
@@ -25,8 +29,8 @@ int cgskb_ingress(struct __sk_buff* Skb)
 
 	__u64 Cookie = bpf_get_socket_cookie(Skb);
 
-	struct WTrafficItemRulesBase* Rules = GetSocketRules(Cookie);
-	struct WTrafficItemRulesBase* SystemRules = GetSocketRules(0);
+	struct WTrafficItemRulesBase* Rules = GetSocketRules(Skb, Cookie);
+	struct WTrafficItemRulesBase* SystemRules = GetSystemRules();
 
 	if (SystemRules && SystemRules->DownloadSwitch == SS_Block)
 	{
@@ -37,6 +41,21 @@ int cgskb_ingress(struct __sk_buff* Skb)
 		return SK_DROP;
 	}
 
+	// DNS answers from a local resolver are still of interest if loopback is excluded
+	SnoopDnsResponse(Skb, Cookie);
+
+	if (IsExcluded(Skb, PD_Incoming))
+	{
+		return SK_PASS;
+	}
+
+	AccountCgroup(Skb, PD_Incoming);
+
+	if (AccountUdpFlow(Skb, Cookie, PD_Incoming))
+	{
+		return SK_PASS;
+	}
+
 	struct WSocketEvent* SocketEvent = MakeSocketEvent2(Cookie, NE_Traffic, false);
 
 	if (SocketEvent)
@@ -78,8 +97,8 @@ int cgskb_egress(struct __sk_buff* Skb)
 	}
 	__u64 Cookie = bpf_get_socket_cookie(Skb);
 
-	struct WTrafficItemRulesBase* Rules = GetSocketRules(Cookie);
-	struct WTrafficItemRulesBase* SystemRules = GetSocketRules(0);
+	struct WTrafficItemRulesBase* Rules = GetSocketRules(Skb, Cookie);
+	struct WTrafficItemRulesBase* SystemRules = GetSystemRules();
 
 	if (SystemRules && SystemRules->UploadSwitch == SS_Block)
 	{
@@ -90,6 +109,21 @@ int cgskb_egress(struct __sk_buff* Skb)
 		return SK_DROP;
 	}
 
+	// Queries to a local resolver are still of interest if loopback is excluded
+	TrackDnsQuery(Skb, Cookie);
+
+	if (IsExcluded(Skb, PD_Outgoing))
+	{
+		return SK_PASS;
+	}
+
+	AccountCgroup(Skb, PD_Outgoing);
+
+	if (AccountUdpFlow(Skb, Cookie, PD_Outgoing))
+	{
+		return SK_PASS;
+	}
+
 	struct WSocketEvent* SocketEvent = MakeSocketEvent2(Cookie, NE_Traffic, false);
 	if (SocketEvent)
 	{
@@ -124,7 +158,7 @@ SEC("tcx/egress")
 int cls_egress(struct __sk_buff* skb)
 {
 	__u64                         Cookie = bpf_get_socket_cookie(skb);
-	struct WTrafficItemRulesBase* Rules = GetSocketRules(Cookie);
+	struct WTrafficItemRulesBase* Rules = GetSocketRules(skb, Cookie);
 
 	if (Rules && Rules->UploadMark != 0)
 	{
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// Per peer accounting of UDP traffic. Instead of sending every datagram through the ring buffer,
+// bytes are summed up per (socket, remote endpoint, direction) and the daemon reads the map once per refresh.
+#pragma once
+#include "EBPFInternal.h"
+#include "EBPFCommon.h"
+
+#ifndef UDP_FLOW_MAP_SIZE
+	#define UDP_FLOW_MAP_SIZE 65536
+#endif
+
+// Set by the daemon before loading, see [daemon] kernel_udp_accounting
+__u8 const volatile UdpFlowAccountingEnabled = 0;
+
+struct
+{
+	__uint(type, BPF_MAP_TYPE_LRU_PERCPU_HASH);
+	__uint(max_entries, UDP_FLOW_MAP_SIZE);
+	__type(key, struct WUdpFlowKey);
+	__type(value, struct WUdpFlowValue);
+} udp_flows SEC(".maps");
+
+static __always_inline void EmitUdpPeerEvent(struct __sk_buff* Skb, __u64 Cookie, struct WUdpFlowKey const* Key,
+	__u32 LocalAddrOffset, __u32 LocalPortOffset)
+{
+	struct WSocketEvent* SocketEvent = MakeSocketEvent2(Cookie, NE_UDPPeer, false);
+	if (!SocketEvent)
+	{
+		// The daemon still picks up the flow when it reads the map, it just can't map unknown sockets
+		return;
+	}
+
+	struct WUDPPeerEventData* PeerData = &SocketEvent->Data.UDPPeerEventData;
+	__u16                     LocalPort = 0;
+	// Constant sizes keep the verifier happy
+	int const LoadResult = Key->Family == AF_INET ? bpf_skb_load_bytes(Skb, LocalAddrOffset, PeerData->LocalAddr, 4)
+												  : bpf_skb_load_bytes(Skb, LocalAddrOffset, PeerData->LocalAddr, 16);
+	if (LoadResult < 0 || bpf_skb_load_bytes(Skb, LocalPortOffset, &LocalPort, 2) < 0)
+	{
+		bpf_ringbuf_discard(SocketEvent, 0);
+		return;
+	}
+
+	__builtin_memcpy(PeerData->RemoteAddr, Key->RemoteAddr, sizeof(PeerData->RemoteAddr));
+	PeerData->LocalPort = bpf_ntohs(LocalPort);
+	PeerData->RemotePort = Key->RemotePort;
+	PeerData->Family = Key->Family;
+	PeerData->Direction = Key->Direction;
+	bpf_ringbuf_submit(SocketEvent, 0);
+}
+
+// Returns true if the packet was counted here, the caller then doesn't have to send a traffic event
+static __always_inline bool AccountUdpFlow(struct __sk_buff* Skb, __u64 Cookie, __u8 Direction)
+{
+	if (!UdpFlowAccountingEnabled || Cookie == 0)
+	{
+		return false;
+	}
+
+	__u8  IPProto = 0;
+	__u32 TransportOffset = 0;
+	if (!LoadTransportHeader(Skb, &IPProto, &TransportOffset) || IPProto != IPPROTO_UDP)
+	{
+		return false;
+	}
+
+	struct WUdpFlowKey Key;
+	__builtin_memset(&Key, 0, sizeof(Key));
+	Key.Cookie = Cookie;
+	Key.Direction = Direction;
+
+	// Source address/port for incoming packets, destination for outgoing ones
+	bool const  bIncoming = Direction == PD_Incoming;
+	__u32       RemoteAddrOffset = 0;
+	__u32       LocalAddrOffset = 0;
+	__u32 const RemotePortOffset = TransportOffset + (bIncoming ? 0 : 2);
+	__u32 const LocalPortOffset = TransportOffset + (bIncoming ? 2 : 0);
+	int         LoadResult = 0;
+	if (Skb->protocol == bpf_htons(ETH_P_IP))
+	{
+		Key.Family = AF_INET;
+		RemoteAddrOffset = bIncoming ? 12 : 16;
+		LocalAddrOffset = bIncoming ? 16 : 12;
+		LoadResult = bpf_skb_load_bytes(Skb, RemoteAddrOffset, Key.RemoteAddr, 4);
+	}
+	else
+	{
+		Key.Family = AF_INET6;
+		RemoteAddrOffset = bIncoming ? 8 : 24;
+		LocalAddrOffset = bIncoming ? 24 : 8;
+		LoadResult = bpf_skb_load_bytes(Skb, RemoteAddrOffset, Key.RemoteAddr, 16);
+	}
+
+	__u16 RemotePort = 0;
+	if (LoadResult < 0 || bpf_skb_load_bytes(Skb, RemotePortOffset, &RemotePort, 2) < 0)
+	{
+		return false;
+	}
+	Key.RemotePort = bpf_ntohs(RemotePort);
+
+	struct WUdpFlowValue* Value = bpf_map_lookup_elem(&udp_flows, &Key);
+	if (Value)
+	{
+		// Per CPU value, no atomics needed
+		Value->Bytes += Skb->len;
+		Value->Packets += 1;
+		return true;
+	}
+
+	struct WUdpFlowValue NewValue = { .Bytes = Skb->len, .Packets = 1 };
+	if (bpf_map_update_elem(&udp_flows, &Key, &NewValue, BPF_NOEXIST) == 0)
+	{
+		EmitUdpPeerEvent(Skb, Cookie, &Key, LocalAddrOffset, LocalPortOffset);
+		return true;
+	}
+
+	// Another CPU added the flow first
+	Value = bpf_map_lookup_elem(&udp_flows, &Key);
+	if (Value)
+	{
+		Value->Bytes += Skb->len;
+		Value->Packets += 1;
+		return true;
+	}
+	return false;
+}
@@ -11,5 +11,6 @@
 #include "EBPFLifetime.h"
 #include "EBPFBind.h"
 #include "EBPFUdp.h"
+#include "EBPFProcess.h"
 
 char LICENSE[] SEC("license") = "GPL";
@@ -5,7 +5,8 @@
 
 #include "AppIconAtlas.hpp"
 
-#include "cereal/types/unordered_map.hpp"
+#include <cstring>
+
 #include "cereal/types/string.hpp"
 #include "cereal/types/vector.hpp"
 #include "spdlog/spdlog.h"
@@ -17,22 +18,27 @@
 
 void WAppIconAtlas::DrawIconForApplication(std::string const& BinaryName, ImVec2 Size)
 {
-	if (!UvData.contains(BinaryName) || TextureId == 0)
+	auto const It = Slots.find(BinaryName);
+	if (It == Slots.end() || TextureId == 0)
 	{
 		// Draw no-icon placeholder
 		WIconAtlas::GetInstance().DrawIcon("noicon", Size);
 		return;
 	}
 
-	auto UV = UvData[BinaryName];
+	auto const& Slot = It->second;
+	auto const  X = static_cast<float>((Slot.Index % SlotsPerRow) * SlotSize);
+	auto const  Y = static_cast<float>((Slot.Index / SlotsPerRow) * SlotSize);
+	auto const  W = static_cast<float>(GetTextureWidth());
+	auto const  H = static_cast<float>(GetTextureHeight());
 
-	ImGui::Image(TextureId, Size, ImVec2(UV.U1, UV.V1), ImVec2(UV.U2, UV.V2));
+	ImGui::Image(TextureId, Size, ImVec2(X / W, Y / H), ImVec2((X + Slot.Width) / W, (Y + Slot.Height) / H));
 }
 
-void WAppIconAtlas::FromAtlasData(WBuffer const& Buffer)
+void WAppIconAtlas::FromAtlasDelta(WBuffer const& Buffer)
 {
-	WAppIconAtlasData Data{};
-	if (!DeserializeMessage(Buffer, Data))
+	WAppIconAtlasDelta Delta{};
+	if (!DeserializeMessage(Buffer, Delta))
 	{
 		spdlog::error("Failed to deserialize app icon atlas data");
 		return;
@@ -40,46 +46,121 @@ void WAppIconAtlas::FromAtlasData(WBuffer const& Buffer)
 
 	std::lock_guard Lock(Mutex);
 	// Defer GL uploads to render thread to avoid using a context from network thread
-	PendingData = std::move(Data);
+	if (Delta.bReset)
+	{
+		PendingDeltas.clear();
+	}
+	PendingDeltas.emplace_back(std::move(Delta));
 }
 
-void WAppIconAtlas::UploadPendingIfAny()
+bool WAppIconAtlas::ApplyDelta(WAppIconAtlasDelta const& Delta)
 {
-	std::optional<WAppIconAtlasData> Local;
+	bool bRecreate = TextureId == 0;
+	if (Delta.bReset || Delta.SlotSize != SlotSize || Delta.SlotsPerRow != SlotsPerRow)
 	{
+		SlotSize = Delta.SlotSize;
+		SlotsPerRow = Delta.SlotsPerRow;
+		PageCount = 0;
+		Pixels.clear();
 		std::lock_guard Lock(Mutex);
-		if (!PendingData.has_value())
-			return;
-		Local.swap(PendingData);
+		Slots.clear();
 	}
 
-	// Now we are on the render thread with a current GL context
-	auto& Data = *Local;
+	if (Delta.PageCount != PageCount)
+	{
+		// Pages are appended at the bottom, so the existing rows keep their position
+		PageCount = Delta.PageCount;
+		Pixels.resize(static_cast<std::size_t>(GetTextureWidth()) * static_cast<std::size_t>(GetTextureHeight()) * 4);
+		bRecreate = true;
+	}
 
-	// Update UV map
+	auto const RowPitch = static_cast<std::size_t>(GetTextureWidth()) * 4;
+	for (auto const& Slot : Delta.UpdatedSlots)
 	{
-		std::lock_guard Lock(Mutex);
-		UvData = std::move(Data.UvData);
+		auto const X = (Slot.Slot % SlotsPerRow) * SlotSize;
+		auto const Y = (Slot.Slot / SlotsPerRow) * SlotSize;
+		if (Slot.Width > SlotSize || Slot.Height > SlotSize || static_cast<int>(Y + SlotSize) > GetTextureHeight()
+			|| Slot.Pixels.size() != static_cast<std::size_t>(Slot.Width) * Slot.Height * 4)
+		{
+			spdlog::warn("Ignoring invalid app icon atlas slot {} for {}", Slot.Slot, Slot.BinaryName);
+			continue;
+		}
+
+		// Clear the whole slot, the previous icon in it might have been bigger
+		for (std::size_t Row = 0; Row < SlotSize; ++Row)
+		{
+			auto* Dst = &Pixels[(Y + Row) * RowPitch + X * 4];
+			std::memset(Dst, 0, static_cast<std::size_t>(SlotSize) * 4);
+			if (Row < Slot.Height)
+			{
+				std::memcpy(Dst, &Slot.Pixels[Row * Slot.Width * 4], static_cast<std::size_t>(Slot.Width) * 4);
+			}
+		}
+
+		if (!bRecreate)
+		{
+			glBindTexture(GL_TEXTURE_2D, TextureId);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, GetTextureWidth());
+			glTexSubImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(X), static_cast<GLint>(Y), SlotSize, SlotSize,
+				GL_RGBA, GL_UNSIGNED_BYTE, &Pixels[Y * RowPitch + X * 4]);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		}
+	}
+
+	std::lock_guard Lock(Mutex);
+	for (auto const& Slot : Delta.UpdatedSlots)
+	{
+		Slots[Slot.BinaryName] = WSlot{ Slot.Slot, Slot.Width, Slot.Height };
+	}
+	for (auto const& App : Delta.RemovedApps)
+	{
+		Slots.erase(App);
 	}
+	return bRecreate;
+}
 
-	if (TextureId != 0)
+void WAppIconAtlas::UploadPendingIfAny()
+{
+	std::vector<WAppIconAtlasDelta> Local;
 	{
-		glDeleteTextures(1, &TextureId);
-		TextureId = 0;
+		std::lock_guard Lock(Mutex);
+		if (PendingDeltas.empty())
+			return;
+		Local.swap(PendingDeltas);
 	}
 
-	glGenTextures(1, &TextureId);
-	glBindTexture(GL_TEXTURE_2D, TextureId);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	// Now we are on the render thread with a current GL context
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, Data.AtlasSize, Data.AtlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-		Data.AtlasImageData.data());
+	bool bRecreate = false;
+	for (auto const& Delta : Local)
+	{
+		bRecreate |= ApplyDelta(Delta);
+	}
+
+	if (bRecreate)
+	{
+		if (TextureId != 0)
+		{
+			glDeleteTextures(1, &TextureId);
+			TextureId = 0;
+		}
+
+		glGenTextures(1, &TextureId);
+		glBindTexture(GL_TEXTURE_2D, TextureId);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, GetTextureWidth(), GetTextureHeight(), 0, GL_RGBA, GL_UNSIGNED_BYTE,
+			Pixels.data());
+		spdlog::debug("Created app icon atlas texture: {}x{}, icons={}", GetTextureWidth(), GetTextureHeight(),
+			Slots.size());
+	}
+	else
+	{
+		glBindTexture(GL_TEXTURE_2D, TextureId);
+	}
 
 	glGenerateMipmap(GL_TEXTURE_2D);
 	glBindTexture(GL_TEXTURE_2D, 0);
-
-	spdlog::debug("Uploaded app icon atlas texture: {}x{}, icons={}", Data.AtlasSize, Data.AtlasSize, UvData.size());
-}
\ No newline at end of file
+}
@@ -7,7 +7,7 @@
 #include <mutex>
 #include <string>
 #include <unordered_map>
-#include <optional>
+#include <vector>
 
 #include "imgui.h"
 #ifdef __EMSCRIPTEN__
@@ -22,10 +22,29 @@
 
 class WAppIconAtlas : public TSingleton<WAppIconAtlas>
 {
-	std::mutex                                Mutex;
-	GLuint                                    TextureId{ 0 };
-	std::unordered_map<std::string, WAtlasUv> UvData;
-	std::optional<WAppIconAtlasData>          PendingData; // set by background thread, consumed by render thread
+	struct WSlot
+	{
+		uint32_t Index{};
+		uint16_t Width{};
+		uint16_t Height{};
+	};
+
+	std::mutex                             Mutex;
+	GLuint                                 TextureId{ 0 };
+	std::unordered_map<std::string, WSlot> Slots;
+	std::vector<WAppIconAtlasDelta>        PendingDeltas; // set by background thread, consumed by render thread
+
+	// Layout of the current texture, only touched by the render thread
+	uint16_t                   SlotSize{ 32 };
+	uint16_t                   SlotsPerRow{ 8 };
+	uint32_t                   PageCount{ 0 };
+	std::vector<unsigned char> Pixels; // copy of the texture, needed to recreate it when the atlas grows
+
+	[[nodiscard]] int GetTextureWidth() const { return SlotsPerRow * SlotSize; }
+	[[nodiscard]] int GetTextureHeight() const { return static_cast<int>(PageCount * SlotsPerRow * SlotSize); }
+
+	// Returns true if the texture has to be recreated
+	bool ApplyDelta(WAppIconAtlasDelta const& Delta);
 
 public:
 	WAppIconAtlas() = default;
@@ -43,7 +62,7 @@ public:
 	}
 
 	void DrawIconForApplication(std::string const& BinaryName, ImVec2 Size);
-	void FromAtlasData(WBuffer const& Data);
+	void FromAtlasDelta(WBuffer const& Data);
 	// Call this on the render thread (with a current GL context)
 	void UploadPendingIfAny();
 };
@@ -44,11 +44,16 @@ void WClient::OnDataReceived(WBuffer& Buf)
 		case MT_TrafficTree:
 			TrafficTree->LoadFromBuffer(Buf);
 			break;
+		case MT_TrafficTreeChunk:
+			TrafficTree->LoadChunkFromBuffer(Buf);
+			break;
 		case MT_TrafficTreeUpdate:
 			TrafficTree->UpdateFromBuffer(Buf);
+			++ReceivedSinceSyncVersion;
 			break;
-		case MT_AppIconAtlasData:
-			WAppIconAtlas::GetInstance().FromAtlasData(Buf);
+		case MT_AppIconAtlasDelta:
+			WAppIconAtlas::GetInstance().FromAtlasDelta(Buf);
+			++ReceivedSinceSyncVersion;
 			break;
 		case MT_ResolveResponse:
 			TrafficTree->HandleResolveResponse(Buf);
@@ -58,10 +63,17 @@ void WClient::OnDataReceived(WBuffer& Buf)
 			break;
 		case MT_ConnectionHistoryUpdate:
 			WMainWindow::Get().GetConnectionHistoryWindow().HandleUpdate(Buf);
+			++ReceivedSinceSyncVersion;
+			break;
+		case MT_SyncVersion:
+			HandleSyncVersion(Buf);
 			break;
 		case MT_MemoryStats:
 			WMainWindow::Get().GetMemoryUsageWindow().HandleUpdate(Buf);
 			break;
+		case MT_PipelineMetrics:
+			WMainWindow::Get().GetPipelineMetricsWindow().HandleUpdate(Buf);
+			break;
 		case MT_StatsResponse:
 			WMainWindow::Get().HandleStatsResponse(Buf);
 			break;
@@ -71,6 +83,9 @@ void WClient::OnDataReceived(WBuffer& Buf)
 		case MT_IPLookupResponse:
 			WMainWindow::Get().GetDetailsWindow().HandleLookupResult(Buf);
 			break;
+		case MT_PeerPage:
+			TrafficTree->HandlePeerPage(Buf);
+			break;
 		case MT_RuleUpdate:
 			WClientRuleManager::GetInstance().HandleRuleUpdate(Buf);
 			break;
@@ -126,6 +141,26 @@ void WClient::HandleHandshake(WBuffer const& Buf)
 			"Connected to daemon (protocol version {}, commit {})", Handshake.ProtocolVersion, Handshake.CommitHash);
 		SystemBootTime = Handshake.SystemBootTime;
 	}
+
+	// The daemon doesn't send anything else until it knows what we still have from the last connection
+	WClientHandshake Reply{};
+	Reply.SyncVersion.SessionId = SyncSessionId;
+	Reply.SyncVersion.Version = SyncVersion;
+	Reply.ReceivedSinceVersion = ReceivedSinceSyncVersion;
+	SendMessage(MT_ClientHandshake, Reply);
+}
+
+void WClient::HandleSyncVersion(WBuffer const& Buf)
+{
+	WSyncVersion Version{};
+	if (!DeserializeMessage(Buf, Version))
+	{
+		spdlog::error("Failed to deserialize sync version");
+		return;
+	}
+	SyncSessionId = Version.SessionId;
+	SyncVersion = Version.Version;
+	ReceivedSinceSyncVersion = 0;
 }
 
 void WClient::Start()
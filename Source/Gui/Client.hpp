@@ -42,8 +42,15 @@ class WClient : public TSingleton<WClient>
 
 	void HandleHandshake(WBuffer const& Buf);
 
+	void HandleSyncVersion(WBuffer const& Buf);
+
 	WSec SystemBootTime{};
 
+	// Last version marker from the daemon, sent back on the next handshake so it only sends what we missed
+	std::atomic<uint64_t> SyncSessionId{};
+	std::atomic<uint64_t> SyncVersion{};
+	std::atomic<uint32_t> ReceivedSinceSyncVersion{};
+
 public:
 	std::atomic<WBytesPerSecond> DaemonToClientTrafficRate{ 0 };
 	std::atomic<WBytesPerSecond> ClientToDaemonTrafficRate{ 0 };
@@ -58,13 +65,18 @@ public:
 	}
 
 	void Start();
-	void Stop() const
+	void Stop()
 	{
 		if (DaemonSocket)
 		{
 			DaemonSocket->Stop();
 		}
 		TrafficTree->Clear();
+
+		// Nothing left to resume from
+		SyncSessionId = 0;
+		SyncVersion = 0;
+		ReceivedSinceSyncVersion = 0;
 	}
 
 	WClient();
@@ -103,6 +103,33 @@ void WDetailsWindow::DrawFilterDetails() const
 	}
 }
 
+void WDetailsWindow::DrawCgroupDetails() const
+{
+	auto const Cgroup = Tree->GetSelectedTrafficItem<WCgroupItem>();
+
+	if (Cgroup == nullptr)
+	{
+		return;
+	}
+	WIconAtlas::GetInstance().DrawIcon("computer", WSdlWindow::ScaleSize(ImVec2(16, 16)));
+
+	ImGui::SameLine();
+	ImGui::Text("%s", Cgroup->Name.c_str());
+	ImGui::Separator();
+	ImGui::Text("%s: %llu", TR("cgroup_id"), static_cast<unsigned long long>(Cgroup->CgroupId));
+	ImGui::Text("%s: %s", TR("total_download"), WStorageFormat::AutoFormat(Cgroup->TotalDownloadBytes).c_str());
+	ImGui::Text("%s: %s", TR("total_upload"), WStorageFormat::AutoFormat(Cgroup->TotalUploadBytes).c_str());
+	if (ImGui::Button(TR("show_cgroup_stats")))
+	{
+		WStatsRequest             Request{};
+		WConnectionHistoryRequest HistoryRequest{};
+		Request.Target = Cgroup->GetStatsName();
+		Request.StartTime = WTime::GetEpochHours() - 60 * 60 * 24;
+		Request.EndTime = WTime::GetEpochHours();
+		WSdlWindow::GetInstance().GetMainWindow()->OpenStatsWindow(Request, HistoryRequest);
+	}
+}
+
 void WDetailsWindow::DrawSystemDetails() const
 {
 	auto const System = Tree->GetSelectedTrafficItem<WSystemItem>();
@@ -324,6 +351,9 @@ void WDetailsWindow::Draw()
 			case TI_Filter:
 				DrawFilterDetails();
 				break;
+			case TI_Cgroup:
+				DrawCgroupDetails();
+				break;
 		}
 	}
 
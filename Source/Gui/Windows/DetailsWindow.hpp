@@ -23,6 +23,7 @@ class WDetailsWindow
 	std::shared_ptr<WTrafficTree> Tree{};
 
 	void DrawFilterDetails() const;
+	void DrawCgroupDetails() const;
 	void DrawSystemDetails() const;
 	void DrawApplicationDetails() const;
 	void DrawProcessDetails() const;
@@ -162,6 +162,10 @@ void WMainWindow::Draw()
 			{
 				MemoryUsageWindow.Show();
 			}
+			if (ImGui::MenuItem(TR("pipeline_metrics.title"), nullptr, false))
+			{
+				PipelineMetricsWindow.Show();
+			}
 			ImGui::EndMenu();
 		}
 
@@ -201,6 +205,7 @@ void WMainWindow::Draw()
 		ConnectionHistoryWindow.Draw();
 		SettingsWindow.Draw();
 		MemoryUsageWindow.Draw();
+		PipelineMetricsWindow.Draw();
 
 		for (auto const& StatWindow : StatWindows)
 		{
@@ -5,6 +5,7 @@
 
 #pragma once
 #include "MemoryUsageWindow.hpp"
+#include "PipelineMetricsWindow.hpp"
 #include "SetupWindow.hpp"
 #include "Windows/AboutDialog.hpp"
 #include "Windows/LogWindow.hpp"
@@ -26,6 +27,7 @@ class WMainWindow
 	WRegisterDialog          RegisterDialog{};
 	WSettingsWindow          SettingsWindow{};
 	WMemoryUsageWindow       MemoryUsageWindow{};
+	WPipelineMetricsWindow   PipelineMetricsWindow{};
 	WConnectionHistoryWindow ConnectionHistoryWindow{};
 	WSetupWindow             SetupWindow{};
 
@@ -45,6 +47,7 @@ public:
 	WSetupWindow&             GetSetupWindow() { return SetupWindow; }
 	WConnectionHistoryWindow& GetConnectionHistoryWindow() { return ConnectionHistoryWindow; }
 	WMemoryUsageWindow&       GetMemoryUsageWindow() { return MemoryUsageWindow; }
+	WPipelineMetricsWindow&   GetPipelineMetricsWindow() { return PipelineMetricsWindow; }
 
 	bool IsRegistered() const { return RegisterDialog.IsRegistered(); }
 
@@ -34,7 +34,10 @@ void WMemoryUsageWindow::Draw()
 				WBytes CategoryTotal = 0;
 				for (auto const& Entry : Stat.ChildEntries)
 				{
-					CategoryTotal += Entry.Usage;
+					if (!Entry.bComparison)
+					{
+						CategoryTotal += Entry.Usage;
+					}
 				}
 
 				// Format the tree node header with category name and total
@@ -49,9 +52,17 @@ void WMemoryUsageWindow::Draw()
 					// Draw child entries
 					for (auto const& Entry : Stat.ChildEntries)
 					{
+						if (Entry.bComparison)
+						{
+							ImGui::PushStyleColor(ImGuiCol_Text, ImGui::GetStyleColorVec4(ImGuiCol_TextDisabled));
+						}
 						ImGui::TreeNodeEx(Entry.Name.c_str(),
 							ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen, "%s: %s", Entry.Name.c_str(),
 							WStorageFormat::AutoFormat(Entry.Usage).c_str());
+						if (Entry.bComparison)
+						{
+							ImGui::PopStyleColor();
+						}
 					}
 					ImGui::TreePop();
 				}
@@ -37,7 +37,10 @@ public:
 		{
 			for (auto const& Entry : Stat.ChildEntries)
 			{
-				TotalUsage += Entry.Usage;
+				if (!Entry.bComparison)
+				{
+					TotalUsage += Entry.Usage;
+				}
 			}
 		}
 	}
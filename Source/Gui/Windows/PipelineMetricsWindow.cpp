@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "PipelineMetricsWindow.hpp"
+
+#include <format>
+
+#include "cereal/types/string.hpp"
+#include "cereal/types/vector.hpp"
+
+#include "Client.hpp"
+#include "Format.hpp"
+#include "Util/I18n.hpp"
+
+#include <imgui.h>
+
+namespace
+{
+	std::string FormatDuration(uint64_t const Nanoseconds)
+	{
+		auto const Value = static_cast<double>(Nanoseconds);
+		if (Nanoseconds < 1000)
+		{
+			return std::format("{} ns", Nanoseconds);
+		}
+		if (Nanoseconds < 1000 * 1000)
+		{
+			return std::format("{:.1f} us", Value / 1e3);
+		}
+		if (Nanoseconds < 1000 * 1000 * 1000)
+		{
+			return std::format("{:.1f} ms", Value / 1e6);
+		}
+		return std::format("{:.2f} s", Value / 1e9);
+	}
+
+	WLatencyHistogram const* FindHistogram(std::vector<WLatencyHistogram> const& Histograms, std::string const& Name)
+	{
+		for (auto const& Histogram : Histograms)
+		{
+			if (Histogram.Name == Name)
+			{
+				return &Histogram;
+			}
+		}
+		return nullptr;
+	}
+} // namespace
+
+void WPipelineMetricsWindow::HandleUpdate(WBuffer const& Update)
+{
+	WPipelineMetrics Metrics{};
+	if (!WClient::ReadMessage(Update, Metrics))
+	{
+		spdlog::error("Failed to read pipeline metrics");
+		return;
+	}
+
+	std::lock_guard Lock(Mutex);
+	Previous = std::move(Current);
+	Current = std::move(Metrics);
+}
+
+double WPipelineMetricsWindow::GetIntervalSeconds() const
+{
+	// Also catches a restarted daemon, its monotonic timestamps don't have to continue where the old ones were
+	if (Previous.Events.empty() || Current.Timestamp <= Previous.Timestamp)
+	{
+		return 0.0;
+	}
+	return static_cast<double>(Current.Timestamp - Previous.Timestamp) / 1000.0;
+}
+
+void WPipelineMetricsWindow::Draw()
+{
+	if (!bVisible)
+	{
+		return;
+	}
+	if (ImGui::Begin(TR("pipeline_metrics.title"), &bVisible, ImGuiWindowFlags_NoDocking))
+	{
+		std::scoped_lock Lock(Mutex);
+		if (Current.Events.empty())
+		{
+			ImGui::TextDisabled("No pipeline metrics available");
+		}
+		else
+		{
+			double const Interval = GetIntervalSeconds();
+			ImGui::Text("Socket event queue: %llu (peak %llu)", static_cast<unsigned long long>(Current.QueueDepth),
+				static_cast<unsigned long long>(Current.PeakQueueDepth));
+			if (Interval > 0 && Current.RingDrops >= Previous.RingDrops)
+			{
+				ImGui::Text("Ring buffer drops: %llu (%.1f/s)", static_cast<unsigned long long>(Current.RingDrops),
+					static_cast<double>(Current.RingDrops - Previous.RingDrops) / Interval);
+			}
+			else
+			{
+				ImGui::Text("Ring buffer drops: %llu", static_cast<unsigned long long>(Current.RingDrops));
+			}
+
+			DrawEvents(Interval);
+			DrawLatencies();
+			DrawClients();
+		}
+	}
+	ImGui::End();
+}
+
+void WPipelineMetricsWindow::DrawEvents(double const Interval) const
+{
+	ImGui::SeparatorText("Events");
+	if (!ImGui::BeginTable("PipelineEvents", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable))
+	{
+		return;
+	}
+	ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_WidthStretch);
+	ImGui::TableSetupColumn("Per second", ImGuiTableColumnFlags_WidthFixed, 100.0f);
+	ImGui::TableSetupColumn("Total", ImGuiTableColumnFlags_WidthFixed, 100.0f);
+	ImGui::TableHeadersRow();
+
+	for (std::size_t i = 0; i < Current.Events.size(); ++i)
+	{
+		auto const& Event = Current.Events[i];
+		ImGui::TableNextRow();
+
+		ImGui::TableNextColumn();
+		ImGui::Text("%s", Event.Name.c_str());
+
+		ImGui::TableNextColumn();
+		if (Interval > 0 && i < Previous.Events.size() && Event.Total >= Previous.Events[i].Total)
+		{
+			ImGui::Text("%.1f", static_cast<double>(Event.Total - Previous.Events[i].Total) / Interval);
+		}
+		else
+		{
+			ImGui::TextDisabled("-");
+		}
+
+		ImGui::TableNextColumn();
+		ImGui::Text("%llu", static_cast<unsigned long long>(Event.Total));
+	}
+	ImGui::EndTable();
+}
+
+void WPipelineMetricsWindow::DrawLatencies() const
+{
+	ImGui::SeparatorText("Latencies");
+	if (!ImGui::BeginTable("PipelineLatencies", 7, ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable))
+	{
+		return;
+	}
+	ImGui::TableSetupColumn("Stage", ImGuiTableColumnFlags_WidthStretch);
+	ImGui::TableSetupColumn("Samples", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+	ImGui::TableSetupColumn("p50", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+	ImGui::TableSetupColumn("p90", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+	ImGui::TableSetupColumn("p99", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+	ImGui::TableSetupColumn("p99 (total)", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+	ImGui::TableSetupColumn("Max (total)", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+	ImGui::TableHeadersRow();
+
+	for (auto const& Histogram : Current.Histograms)
+	{
+		// Percentiles of what was recorded since the previous message, the last two columns cover everything
+		WLatencyHistogram Recent = Histogram;
+		if (auto const* Old = FindHistogram(Previous.Histograms, Histogram.Name))
+		{
+			Recent = Histogram.Since(*Old);
+		}
+
+		ImGui::TableNextRow();
+
+		ImGui::TableNextColumn();
+		ImGui::Text("%s", Histogram.Name.c_str());
+
+		ImGui::TableNextColumn();
+		ImGui::Text("%llu", static_cast<unsigned long long>(Recent.Count));
+
+		for (double const Percentile : { 0.5, 0.9, 0.99 })
+		{
+			ImGui::TableNextColumn();
+			if (Recent.Count > 0)
+			{
+				ImGui::Text("%s", FormatDuration(Recent.GetPercentile(Percentile)).c_str());
+			}
+			else
+			{
+				ImGui::TextDisabled("-");
+			}
+		}
+
+		ImGui::TableNextColumn();
+		ImGui::Text("%s", FormatDuration(Histogram.GetPercentile(0.99)).c_str());
+
+		ImGui::TableNextColumn();
+		ImGui::Text("%s", FormatDuration(Histogram.Max).c_str());
+	}
+	ImGui::EndTable();
+}
+
+void WPipelineMetricsWindow::DrawClients() const
+{
+	ImGui::SeparatorText("Client send backlog");
+	if (Current.Clients.empty())
+	{
+		ImGui::TextDisabled("No clients");
+		return;
+	}
+	for (auto const& Client : Current.Clients)
+	{
+		ImGui::Text("%s: %s", Client.Name.c_str(), WStorageFormat::AutoFormat(Client.Backlog).c_str());
+	}
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <mutex>
+
+#include "Buffer.hpp"
+#include "PipelineMetrics.hpp"
+
+class WPipelineMetricsWindow
+{
+	std::mutex Mutex;
+
+	// The daemon only sends running totals, rates and recent latencies are the difference of the last two messages
+	WPipelineMetrics Current{};
+	WPipelineMetrics Previous{};
+	bool             bVisible{};
+
+	[[nodiscard]] double GetIntervalSeconds() const;
+	void                 DrawEvents(double Interval) const;
+	void                 DrawLatencies() const;
+	void                 DrawClients() const;
+
+public:
+	void Draw();
+	void Show() { bVisible = !bVisible; }
+
+	void HandleUpdate(WBuffer const& Update);
+};
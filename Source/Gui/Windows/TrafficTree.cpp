@@ -18,6 +18,7 @@
 // ReSharper disable CppUnusedIncludeDirective
 #include "cereal/types/memory.hpp"
 #include "cereal/types/string.hpp"
+#include "cereal/types/utility.hpp"
 // ReSharper enable CppUnusedIncludeDirective
 
 #include "AppIconAtlas.hpp"
@@ -63,6 +64,14 @@ void WTrafficTree::RemoveTrafficItem(WTrafficItemId const TrafficItemId)
 			{
 				return;
 			}
+
+			for (auto const& Socket : Proc->Sockets | std::views::values)
+			{
+				if (Socket->RemoveChild(TrafficItemId))
+				{
+					return;
+				}
+			}
 		}
 	}
 }
@@ -136,7 +145,7 @@ bool WTrafficTree::RenderItem(WRenderItemArgs const& Args)
 	bool bNodeOpen = false;
 	bool bItemClicked = false;
 
-	if (Args.Item->GetType() <= TI_Process)
+	if (Args.Item->GetType() <= TI_Process || Args.Item->GetType() == TI_Cgroup)
 	{
 		bItemClicked = DrawIcon(bNodeOpen, Args.Name, Args.Item, NodeFlags);
 	}
@@ -210,7 +219,8 @@ bool WTrafficTree::RenderItem(WRenderItemArgs const& Args)
 		ImGui::PopStyleColor();
 	}
 
-	if (Args.Item->GetType() != TI_Filter)
+	// Filters and cgroups only show traffic, rules are set on applications and below
+	if (Args.Item->GetType() != TI_Filter && Args.Item->GetType() != TI_Cgroup)
 	{
 		ImGui::TableSetColumnIndex(3);
 		ImGui::PushID(static_cast<int>(Args.Item->ItemId));
@@ -347,6 +357,11 @@ void WTrafficTree::LoadFromBuffer(WBuffer const& Buffer)
 		TrafficItems[Filter->ItemId] = Filter;
 	}
 
+	for (auto const& Cgroup : Root->Cgroups)
+	{
+		TrafficItems[Cgroup->ItemId] = Cgroup;
+	}
+
 	TrafficItems[0] = Root;
 	if (auto const* Sort = ImGui::TableGetSortSpecs())
 	{
@@ -354,6 +369,60 @@ void WTrafficTree::LoadFromBuffer(WBuffer const& Buffer)
 	}
 }
 
+void WTrafficTree::LoadChunkFromBuffer(WBuffer const& Buffer)
+{
+	std::lock_guard   Lock(DataMutex);
+	WTrafficTreeChunk Chunk{};
+	if (!DeserializeMessage(Buffer, Chunk))
+	{
+		spdlog::error("Failed to deserialize traffic tree chunk");
+		return;
+	}
+
+	for (auto& App : Chunk.Applications)
+	{
+		auto const NewApp = std::make_shared<WApplicationItem>(std::move(App));
+		Root->Applications[NewApp->ApplicationPath] = NewApp;
+		TrafficItems[NewApp->ItemId] = NewApp;
+	}
+
+	for (auto& [AppId, Process] : Chunk.Processes)
+	{
+		auto const App = std::dynamic_pointer_cast<WApplicationItem>(GetItemFromId(AppId));
+		if (!App)
+		{
+			spdlog::warn("Parent application {} for process {} not found", AppId, Process.ItemId);
+			continue;
+		}
+		auto const NewProcess = std::make_shared<WProcessItem>(std::move(Process));
+		App->Processes[NewProcess->ProcessId] = NewProcess;
+		TrafficItems[NewProcess->ItemId] = NewProcess;
+	}
+
+	for (auto& [ProcessId, Socket] : Chunk.Sockets)
+	{
+		auto const Process = std::dynamic_pointer_cast<WProcessItem>(GetItemFromId(ProcessId));
+		if (!Process)
+		{
+			spdlog::warn("Parent process {} for socket {} not found", ProcessId, Socket.ItemId);
+			continue;
+		}
+		auto const NewSocket = std::make_shared<WSocketItem>(std::move(Socket));
+		Process->Sockets[NewSocket->Cookie] = NewSocket;
+		TrafficItems[NewSocket->ItemId] = NewSocket;
+		for (auto const& UDPTuple : NewSocket->UDPPerConnectionTraffic)
+		{
+			TrafficItems[UDPTuple->ItemId] = UDPTuple;
+		}
+	}
+
+	if (Chunk.bLast)
+	{
+		spdlog::debug("Received traffic tree with {} items", TrafficItems.size());
+	}
+	bRequireTreeSorting = true;
+}
+
 void WTrafficTree::UpdateFromBuffer(WBuffer const& Buffer)
 {
 	std::lock_guard     Lock(DataMutex);
@@ -460,11 +529,30 @@ void WTrafficTree::UpdateFromBuffer(WBuffer const& Buffer)
 		{
 			auto NewTuple = std::make_shared<WTupleItem>();
 			NewTuple->ItemId = Addition.ItemId;
+			NewTuple->Endpoint = Addition.Endpoint;
 			SocketItem->UDPPerConnectionTraffic.emplace_back(NewTuple);
+			SocketItem->PeerCount = std::max(SocketItem->PeerCount + 1,
+				static_cast<uint32_t>(SocketItem->UDPPerConnectionTraffic.size()));
 			TrafficItems[Addition.ItemId] = NewTuple;
 		}
 	}
 
+	for (auto const& Addition : Updates.AddedCgroups)
+	{
+		if (TrafficItems.contains(Addition.ItemId))
+		{
+			spdlog::warn("{} already exists in traffic tree, skipping addition", Addition.ItemId);
+			continue;
+		}
+
+		auto NewCgroup = std::make_shared<WCgroupItem>();
+		NewCgroup->ItemId = Addition.ItemId;
+		NewCgroup->CgroupId = Addition.CgroupId;
+		NewCgroup->Name = Addition.Name;
+		Root->Cgroups.emplace_back(NewCgroup);
+		TrafficItems[Addition.ItemId] = NewCgroup;
+	}
+
 	for (auto const& [ItemId, NewState, SocketType, SocketTuple] : Updates.SocketStateChange)
 	{
 		auto It = TrafficItems.find(ItemId);
@@ -538,6 +626,9 @@ static std::string GetSocketName(WSocketItem* Socket)
 
 void WTrafficTree::Draw(ImGuiID MainID)
 {
+	// Whatever the windows asked for during the last frame
+	SendPendingResolves();
+
 	std::lock_guard Lock(DataMutex);
 
 	ImGui::SetNextWindowDockID(MainID, ImGuiCond_FirstUseEver);
@@ -613,6 +704,30 @@ void WTrafficTree::Draw(ImGuiID MainID)
 		ImGui::TreePop();
 	}
 
+	if (!Root->Cgroups.empty())
+	{
+		ImGui::TableNextRow();
+		ImGui::TableSetColumnIndex(0);
+		// Collapsed by default, container hosts can have hundreds of them
+		if (ImGui::TreeNodeEx("##cgroups", ImGuiTreeNodeFlags_SpanFullWidth, "%s", TR("cgroups")))
+		{
+			for (auto const& Cgroup : Root->Cgroups)
+			{
+				ImGui::TableNextRow();
+				ImGui::PushID(static_cast<int>(Cgroup->ItemId));
+				WRenderItemArgs Args;
+				Args.Name = Cgroup->Name;
+				Args.Item = Cgroup;
+				Args.NodeFlags = ImGuiTreeNodeFlags_Leaf;
+				Args.bMarkedForRemoval = MarkedForRemovalItems.contains(Cgroup->ItemId);
+				RenderItem(Args);
+				ImGui::PopID();
+				ImGui::TreePop();
+			}
+			ImGui::TreePop();
+		}
+	}
+
 	for (auto const& AppNode : TreeRoot->Children)
 	{
 		if (!AppNode->Item || AppNode->Item->GetType() != TI_Application)
@@ -726,7 +841,10 @@ void WTrafficTree::Draw(ImGuiID MainID)
 					std::string tupleId = std::string("tuple:") + std::to_string(UDPItem->ItemId);
 					ImGui::PushID(tupleId.c_str());
 					Args = {};
-					Args.Name = std::format("↔ {}", UDPNode->TupleEndpoint.ToString());
+					// An empty endpoint holds the traffic of peers the daemon stopped tracking individually
+					Args.Name = UDPNode->TupleEndpoint.Address.IsZero()
+						? std::string("↔ Other peers")
+						: std::format("↔ {}", UDPNode->TupleEndpoint.ToString());
 					Args.Item = UDPItem;
 					Args.NodeFlags = ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
 					Args.bMarkedForRemoval = bPendingRemoval;
@@ -735,6 +853,22 @@ void WTrafficTree::Draw(ImGuiID MainID)
 
 					ImGui::PopID();
 				}
+
+				auto const KnownPeers = static_cast<uint32_t>(SocketItem->UDPPerConnectionTraffic.size());
+				if (SocketItem->PeerCount > KnownPeers)
+				{
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					auto const Label = std::format("Load more peers ({} of {})", KnownPeers, SocketItem->PeerCount);
+					if (ImGui::SmallButton(Label.c_str()))
+					{
+						WPeerPageRequest Request{};
+						Request.SocketItemId = SocketItem->ItemId;
+						Request.Offset = KnownPeers;
+						Request.Count = WPeerPageRequest::MaxCount;
+						WClient::GetInstance().SendMessage(MT_PeerPageRequest, Request);
+					}
+				}
 				ImGui::PopID();
 
 				if (!SocketItem->UDPPerConnectionTraffic.empty())
@@ -765,10 +899,45 @@ void WTrafficTree::HandleResolveResponse(WBuffer const& Buffer)
 	if (WClient::ReadMessage(Buffer, ResolveResponse))
 	{
 		std::lock_guard Lock(DataMutex);
-		ResolvedAddresses[ResolveResponse.AddressToResolve] = ResolveResponse.ResolveResult;
+		for (auto& Result : ResolveResponse.Results)
+		{
+			ResolvedAddresses[Result.Address] = std::move(Result.Hostname);
+		}
 	}
 }
 
+void WTrafficTree::HandlePeerPage(WBuffer const& Buffer)
+{
+	WPeerPage Page{};
+	if (!WClient::ReadMessage(Buffer, Page))
+	{
+		spdlog::error("Failed to deserialize peer page");
+		return;
+	}
+
+	std::lock_guard Lock(DataMutex);
+	auto const      It = TrafficItems.find(Page.SocketItemId);
+	if (It == TrafficItems.end() || It->second->GetType() != TI_Socket)
+	{
+		return;
+	}
+
+	auto const SocketItem = std::static_pointer_cast<WSocketItem>(It->second);
+	SocketItem->PeerCount = Page.PeerCount;
+	for (auto const& Peer : Page.Peers)
+	{
+		// Peers that were added since the tree was sent are already known
+		if (TrafficItems.contains(Peer.ItemId))
+		{
+			continue;
+		}
+		auto NewTuple = std::make_shared<WTupleItem>(Peer);
+		SocketItem->UDPPerConnectionTraffic.emplace_back(NewTuple);
+		TrafficItems[Peer.ItemId] = NewTuple;
+	}
+	bRequireTreeSorting = true;
+}
+
 std::string const& WTrafficTree::ResolveAddress(WIPAddress const& Address)
 {
 	static std::string Empty{};
@@ -778,10 +947,22 @@ std::string const& WTrafficTree::ResolveAddress(WIPAddress const& Address)
 		return It->second;
 	}
 	ResolvedAddresses[Address] = Empty;
+	PendingResolves.push_back(Address);
+	return Empty;
+}
+
+void WTrafficTree::SendPendingResolves()
+{
 	WResolveRequest Request;
-	Request.AddressToResolve = Address;
+	{
+		std::scoped_lock Lock(DataMutex);
+		if (PendingResolves.empty())
+		{
+			return;
+		}
+		Request.AddressesToResolve = std::exchange(PendingResolves, {});
+	}
 	WClient::GetInstance().SendMessage(MT_ResolveRequest, Request);
-	return Empty;
 }
 
 std::shared_ptr<WApplicationItem> WTrafficTree::FindDaemonItem()
@@ -43,6 +43,7 @@ class WTrafficTree
 	std::shared_ptr<WTreeNode> TreeRoot{};
 
 	std::unordered_map<WIPAddress, std::string> ResolvedAddresses{};
+	std::vector<WIPAddress>                     PendingResolves{}; // sent as one request on the next draw
 
 	std::optional<WEndpoint>    SelectedTupleEndpoint{};
 	WTrafficItemId              SelectedItemId{ std::numeric_limits<WTrafficItemId>::max() };
@@ -56,6 +57,8 @@ class WTrafficTree
 
 	bool RenderItem(WRenderItemArgs const& Args);
 
+	void SendPendingResolves();
+
 	std::recursive_mutex DataMutex;
 
 	void SortTree(ImGuiTableSortSpecs const* Specs);
@@ -65,11 +68,16 @@ public:
 	~WTrafficTree() = default;
 
 	void LoadFromBuffer(WBuffer const& Buffer);
+
+	// Adds a part of the initial traffic tree that's sent after the system item
+	void LoadChunkFromBuffer(WBuffer const& Buffer);
 	void UpdateFromBuffer(WBuffer const& Buffer);
 	void Draw(ImGuiID MainID);
 
 	void HandleResolveResponse(WBuffer const& Buffer);
 
+	void HandlePeerPage(WBuffer const& Buffer);
+
 	std::string const& ResolveAddress(WIPAddress const& Address);
 
 	template <class T>
@@ -104,6 +112,7 @@ public:
 		std::lock_guard Lock(DataMutex);
 		TrafficItems.clear();
 		ResolvedAddresses.clear();
+		PendingResolves.clear();
 		SelectedItemId = std::numeric_limits<WTrafficItemId>::max();
 		SelectedItem = {};
 		Root = std::make_shared<WSystemItem>();
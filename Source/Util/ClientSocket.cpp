@@ -23,6 +23,20 @@ void WClientSocket::ListenThreadFunction()
 	bListenThreadRunning = false;
 }
 
+bool WClientSocket::ReceiveAvailable()
+{
+	WBuffer RecvBuf;
+	if (ReceiveFramed(RecvBuf))
+	{
+		do
+		{
+			OnData(RecvBuf);
+			RecvBuf.Reset();
+		} while (IsConnected() && TryPopBufferedFrame(RecvBuf));
+	}
+	return IsConnected();
+}
+
 WClientSocket::~WClientSocket()
 {
 	Close();
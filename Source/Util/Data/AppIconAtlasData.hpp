@@ -1,35 +1,45 @@
 /*
- * Copyright (c) 2025, Alex <uni@vrsal.cc>
+ * Copyright (c) 2025-2026, Alex <uni@vrsal.cc>
  * SPDX-License-Identifier: BSD-3-Clause
  */
 
 #pragma once
+#include <cstdint>
 #include <vector>
-#include <unordered_map>
 #include <string>
 
-struct WAtlasUv
+// Icons are placed in fixed size slots, which stay assigned to an application for as long as it is active.
+// Slots are laid out row by row, SlotsPerRow slots per row. The atlas grows by one page
+// (SlotsPerRow rows) at a time, so slot positions never change when it grows.
+struct WAppIconAtlasSlot
 {
-	float U1;
-	float V1;
-	float U2;
-	float V2;
+	std::string                BinaryName{};
+	uint32_t                   Slot{};
+	uint16_t                   Width{}; // can be smaller than the slot size
+	uint16_t                   Height{};
+	std::vector<unsigned char> Pixels{}; // RGBA
 
 	template <class Archive>
 	void serialize(Archive& archive)
 	{
-		archive(U1, V1, U2, V2);
+		archive(BinaryName, Slot, Width, Height, Pixels);
 	}
 };
 
-struct WAppIconAtlasData
+struct WAppIconAtlasDelta
 {
-	std::unordered_map<std::string, WAtlasUv> UvData;
-	std::vector<unsigned char>                AtlasImageData;
-	int                                       AtlasSize{ 64 };
+	bool                           bReset{}; // drop all slots before applying this delta
+	uint16_t                       SlotSize{ 32 };
+	uint16_t                       SlotsPerRow{ 8 };
+	uint32_t                       PageCount{ 1 };
+	std::vector<WAppIconAtlasSlot> UpdatedSlots{};
+	std::vector<std::string>       RemovedApps{};
+
+	[[nodiscard]] bool IsEmpty() const { return !bReset && UpdatedSlots.empty() && RemovedApps.empty(); }
+
 	template <class Archive>
 	void serialize(Archive& archive)
 	{
-		archive(UvData, AtlasImageData, AtlasSize);
+		archive(bReset, SlotSize, SlotsPerRow, PageCount, UpdatedSlots, RemovedApps);
 	}
-};
\ No newline at end of file
+};
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "TrafficItem.hpp"
+
+// Traffic of every socket in a cgroup (usually a container or a systemd unit), counted by the eBPF program
+class WCgroupItem : public ITrafficItem
+{
+public:
+	// Stats of cgroups are stored under their name with this prefix
+	static constexpr char const* StatsPrefix = "cgroup:";
+
+	uint64_t    CgroupId{};
+	std::string Name; // path relative to the cgroup root
+
+	template <class Archive>
+	void serialize(Archive& archive)
+	{
+		archive(ItemId, DownloadSpeed, UploadSpeed, TotalDownloadBytes, TotalUploadBytes, CgroupId, Name);
+	}
+
+	[[nodiscard]] ETrafficItemType GetType() const override { return TI_Cgroup; }
+
+	[[nodiscard]] std::string ToString() const override { return Name; }
+
+	[[nodiscard]] std::string GetStatsName() const { return StatsPrefix + Name; }
+};
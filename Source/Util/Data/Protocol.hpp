@@ -5,7 +5,7 @@
 
 #pragma once
 
-#define WAECHTER_PROTOCOL_VERSION 1
+#define WAECHTER_PROTOCOL_VERSION 7
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -29,6 +29,36 @@ struct WProtocolHandshake
 	}
 };
 
+// The daemon sends one after every broadcast that changed what clients know (MT_SyncVersion),
+// a client answers the handshake with the last one it received (MT_ClientHandshake) to resume from there
+struct WSyncVersion
+{
+	uint64_t SessionId{}; // changes whenever the daemon starts, 0 if the client has nothing to resume
+	uint64_t Version{};
+
+	template <class Archive>
+	void serialize(Archive& archive)
+	{
+		archive(SessionId, Version);
+	}
+};
+
+// Sent by the client in response to the handshake
+struct WClientHandshake
+{
+	WSyncVersion SyncVersion{};
+
+	// Traffic, icon atlas and connection history updates that arrived after the last MT_SyncVersion,
+	// the daemon doesn't send them again
+	uint32_t ReceivedSinceVersion{};
+
+	template <class Archive>
+	void serialize(Archive& archive)
+	{
+		archive(SyncVersion, ReceivedSinceVersion);
+	}
+};
+
 struct WDaemonConfigMessage
 {
 	std::vector<std::string> NetworkInterfaces;
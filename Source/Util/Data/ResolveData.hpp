@@ -4,27 +4,45 @@
  */
 
 #pragma once
+#include <string>
+#include <vector>
+
+#include "cereal/types/string.hpp"
+#include "cereal/types/vector.hpp"
+
 #include "IPAddress.hpp"
 
+// The client collects the addresses it needs over a frame and asks for all of them at once
 struct WResolveRequest
 {
-	WIPAddress AddressToResolve;
+	std::vector<WIPAddress> AddressesToResolve;
+
+	template <class Archive>
+	void serialize(Archive& archive)
+	{
+		archive(AddressesToResolve);
+	}
+};
+
+struct WResolvedAddress
+{
+	WIPAddress  Address;
+	std::string Hostname;
 
 	template <class Archive>
 	void serialize(Archive& archive)
 	{
-		archive(AddressToResolve);
+		archive(Address, Hostname);
 	}
 };
 
 struct WResolveResponse
 {
-	WIPAddress  AddressToResolve;
-	std::string ResolveResult;
+	std::vector<WResolvedAddress> Results;
 
 	template <class Archive>
 	void serialize(Archive& archive)
 	{
-		archive(AddressToResolve, ResolveResult);
+		archive(Results);
 	}
 };
@@ -4,6 +4,7 @@
  */
 
 #pragma once
+#include <algorithm>
 #include <memory>
 #include <unordered_map>
 
@@ -50,6 +51,9 @@ struct WTupleItem : ITrafficItem
 
 struct WSocketItem : ITrafficItem
 {
+	// Only this many peers of a socket are sent with the traffic tree, clients request the rest in pages
+	static constexpr std::size_t MaxPeersInTree = 32;
+
 	WSocketTuple SocketTuple{};
 	std::vector<std::shared_ptr<WTupleItem>>
 		UDPPerConnectionTraffic; // Only for UDP sockets, since they can send/receive no many addresses
@@ -58,11 +62,26 @@ struct WSocketItem : ITrafficItem
 	uint8_t                SocketType{};
 	ESocketConnectionState ConnectionState{};
 
+	// Number of peers the daemon knows about, the client might only have received some of them
+	uint32_t PeerCount{};
+
 	template <class Archive>
-	void serialize(Archive& archive)
+	void save(Archive& archive) const
 	{
+		auto const PeersInTree = std::min(UDPPerConnectionTraffic.size(), MaxPeersInTree);
+		auto const PeersEnd = UDPPerConnectionTraffic.begin() + static_cast<std::ptrdiff_t>(PeersInTree);
+		std::vector<std::shared_ptr<WTupleItem>> const Peers(UDPPerConnectionTraffic.begin(), PeersEnd);
+		// A copy for the initial sync only keeps the peers that are sent, but still knows how many there are
+		auto const Count = std::max<std::size_t>(PeerCount, UDPPerConnectionTraffic.size());
 		archive(ItemId, DownloadSpeed, UploadSpeed, TotalDownloadBytes, TotalUploadBytes, ConnectionState, Cookie,
-			SocketTuple, SocketType, UDPPerConnectionTraffic);
+			SocketTuple, SocketType, Peers, static_cast<uint32_t>(Count));
+	}
+
+	template <class Archive>
+	void load(Archive& archive)
+	{
+		archive(ItemId, DownloadSpeed, UploadSpeed, TotalDownloadBytes, TotalUploadBytes, ConnectionState, Cookie,
+			SocketTuple, SocketType, UDPPerConnectionTraffic, PeerCount);
 	}
 
 	[[nodiscard]] ETrafficItemType GetType() const override { return TI_Socket; }
@@ -103,5 +122,17 @@ struct WSocketItem : ITrafficItem
 			[&Endpoint](std::shared_ptr<WTupleItem> const& Tuple) { return Tuple->Endpoint == Endpoint; });
 	}
 
+	bool RemoveChild(WTrafficItemId TrafficItemId) override
+	{
+		if (std::erase_if(UDPPerConnectionTraffic,
+				[TrafficItemId](std::shared_ptr<WTupleItem> const& Tuple) { return Tuple->ItemId == TrafficItemId; })
+			== 0)
+		{
+			return false;
+		}
+		PeerCount = PeerCount > 0 ? PeerCount - 1 : 0;
+		return true;
+	}
+
 	[[nodiscard]] std::string ToString() const override { return SocketTuple.ToString(); }
 };
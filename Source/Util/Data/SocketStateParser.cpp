@@ -162,15 +162,21 @@ void WSocketStateParser::ParseData() const
 		closedir(ProcDir);
 	}
 
+	ParseNetFiles("/proc/net", InodePidMap);
+}
+
+void WSocketStateParser::ParseNetFiles(
+	std::string const& NetPath, std::unordered_map<uint64_t, WProcessId> const& InodePidMap) const
+{
 	std::scoped_lock Lock(Mutex);
 	KnownListeningPorts.clear();
 	KnownUsedPorts.clear();
 	KnownUsedEndpoints.clear();
 	KnownListeningSockets.clear();
-	ParseTcpFile("/proc/net/tcp", InodePidMap);
-	ParseTcpFile("/proc/net/tcp6", InodePidMap);
-	ParseUdpFile("/proc/net/udp", InodePidMap);
-	ParseUdpFile("/proc/net/udp6", InodePidMap);
+	ParseTcpFile(NetPath + "/tcp", InodePidMap);
+	ParseTcpFile(NetPath + "/tcp6", InodePidMap);
+	ParseUdpFile(NetPath + "/udp", InodePidMap);
+	ParseUdpFile(NetPath + "/udp6", InodePidMap);
 }
 
 void WSocketStateParser::ParseTcpFile(
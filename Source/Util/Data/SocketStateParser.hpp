@@ -40,6 +40,10 @@ public:
 
 	void ParseData() const;
 
+	// Parses the tcp, tcp6, udp and udp6 tables in NetPath (usually /proc/net), PIDs are looked up in InodePidMap
+	void ParseNetFiles(
+		std::string const& NetPath, std::unordered_map<uint64_t, WProcessId> const& InodePidMap = {}) const;
+
 	bool IsUsedPort(uint16_t const Port) const
 	{
 		if (Port == 0)
@@ -4,15 +4,19 @@
  */
 
 #pragma once
+#include <algorithm>
 #include <string>
 #include <unordered_map>
 #include <memory>
 #include <ranges>
 #include <cassert>
+#include <utility>
+#include <vector>
 
 #include "TrafficItem.hpp"
 #include "ApplicationItem.hpp"
 #include "FilterItem.hpp"
+#include "CgroupItem.hpp"
 
 struct WSystemItem : ITrafficItem
 {
@@ -20,13 +24,15 @@ struct WSystemItem : ITrafficItem
 
 	std::vector<std::shared_ptr<WFilterItem>> Filters;
 
+	std::vector<std::shared_ptr<WCgroupItem>> Cgroups;
+
 	std::unordered_map<std::string, std::shared_ptr<WApplicationItem>> Applications;
 
 	template <class Archive>
 	void serialize(Archive& archive)
 	{
-		archive(
-			ItemId, DownloadSpeed, UploadSpeed, HostName, TotalDownloadBytes, TotalUploadBytes, Applications, Filters);
+		archive(ItemId, DownloadSpeed, UploadSpeed, HostName, TotalDownloadBytes, TotalUploadBytes, Applications,
+			Filters, Cgroups);
 	}
 
 	[[nodiscard]] ETrafficItemType GetType() const override { return TI_System; }
@@ -44,6 +50,36 @@ struct WSystemItem : ITrafficItem
 				return true;
 			}
 		}
+
+		if (auto const It = std::ranges::find_if(
+				Cgroups, [&](auto const& Cgroup) { return Cgroup->ItemId == TrafficItemId; });
+			It != Cgroups.end())
+		{
+			Cgroups.erase(It);
+			return true;
+		}
 		return false;
 	}
-};
\ No newline at end of file
+};
+
+// Part of the initial traffic tree, MT_TrafficTree only has the system item with its filters and cgroups.
+// Applications are sent first, then processes, then sockets, so an item's parent always arrived before it
+struct WTrafficTreeChunk
+{
+	// Without their processes
+	std::vector<WApplicationItem> Applications{};
+
+	// Without their sockets, along with the item id of their application
+	std::vector<std::pair<WTrafficItemId, WProcessItem>> Processes{};
+
+	// Along with the item id of their process
+	std::vector<std::pair<WTrafficItemId, WSocketItem>> Sockets{};
+
+	bool bLast{};
+
+	template <class Archive>
+	void serialize(Archive& archive)
+	{
+		archive(Applications, Processes, Sockets, bLast);
+	}
+};
@@ -16,6 +16,7 @@ enum ETrafficItemType : uint8_t
 	TI_Process,
 	TI_Socket,
 	TI_Tuple,
+	TI_Cgroup,
 };
 
 struct ITrafficItem
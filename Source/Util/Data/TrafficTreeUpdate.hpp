@@ -71,6 +71,49 @@ struct WTrafficTreeTupleAddition
 	}
 };
 
+struct WTrafficTreeCgroupAddition
+{
+	WTrafficItemId ItemId{};
+	uint64_t       CgroupId{};
+	std::string    Name{};
+
+	template <class Archive>
+	void serialize(Archive& archive)
+	{
+		archive(ItemId, CgroupId, Name);
+	}
+};
+
+// Asks for the peers of a socket that weren't part of the traffic tree
+struct WPeerPageRequest
+{
+	static constexpr uint32_t MaxCount = 256;
+
+	WTrafficItemId SocketItemId{};
+	uint32_t       Offset{};
+	uint32_t       Count{};
+
+	template <class Archive>
+	void serialize(Archive& archive)
+	{
+		archive(SocketItemId, Offset, Count);
+	}
+};
+
+struct WPeerPage
+{
+	WTrafficItemId          SocketItemId{};
+	uint32_t                Offset{};
+	uint32_t                PeerCount{}; // all peers of the socket, not just the ones in this page
+	std::vector<WTupleItem> Peers{};
+
+	template <class Archive>
+	void serialize(Archive& archive)
+	{
+		archive(SocketItemId, Offset, PeerCount, Peers);
+	}
+};
+
 struct WTrafficTreeSocketStateChange
 {
 	WTrafficItemId                ItemId{};
@@ -93,11 +136,13 @@ struct WTrafficTreeUpdates
 	std::vector<WTrafficTreeSocketAddition>    AddedSockets;
 	std::vector<WTrafficTreeTupleAddition>     AddedTuples;
 	std::vector<WTrafficTreeSocketStateChange> SocketStateChange;
+	std::vector<WTrafficTreeCgroupAddition>    AddedCgroups;
 
 	template <class Archive>
 	void serialize(Archive& archive)
 	{
-		archive(RemovedItems, MarkedForRemovalItems, UpdatedItems, AddedSockets, AddedTuples, SocketStateChange);
+		archive(RemovedItems, MarkedForRemovalItems, UpdatedItems, AddedSockets, AddedTuples, SocketStateChange,
+			AddedCgroups);
 	}
 
 	void Reset()
@@ -108,6 +153,7 @@ struct WTrafficTreeUpdates
 		AddedSockets.clear();
 		AddedTuples.clear();
 		SocketStateChange.clear();
+		AddedCgroups.clear();
 
 		MarkedForRemovalItems.shrink_to_fit();
 		RemovedItems.shrink_to_fit();
@@ -115,5 +161,6 @@ struct WTrafficTreeUpdates
 		AddedSockets.shrink_to_fit();
 		AddedTuples.shrink_to_fit();
 		SocketStateChange.shrink_to_fit();
+		AddedCgroups.shrink_to_fit();
 	}
 };
\ No newline at end of file
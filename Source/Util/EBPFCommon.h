@@ -21,6 +21,7 @@ typedef uint64_t __u64;
 #endif
 
 #define PACKET_HEADER_SIZE 128
+#define DNS_PAYLOAD_SIZE 512 // Maximum size of a DNS message over UDP without EDNS
 
 #define WUNUSED(x) (void)(x)
 #define WLSM_ALLOW 0
@@ -49,7 +50,11 @@ enum ENetEventType
 	NE_SocketAccept_6,
 	NE_SocketClosed,
 	NE_Traffic,
-	NE_Synthetic
+	NE_Synthetic,
+	NE_ProcessFork, // Only sent for processes that own sockets, or descend from one that did
+	NE_ProcessExec,
+	NE_ProcessExit,
+	NE_UDPPeer // First packet between a UDP socket and a remote endpoint, the traffic itself is counted in udp_flows
 };
 
 enum ESwitchState : __u8
@@ -147,6 +152,55 @@ struct WSocketCloseEventData
 	__u32 LocalPort;
 };
 
+struct WProcessEventData
+{
+	__u32 Pid;       // Thread group id of the process
+	__u32 ParentPid; // Only set for NE_ProcessFork
+};
+
+// Addresses are copied from the packet as is (network byte order), IPv4 only uses the first four bytes
+struct WUDPPeerEventData
+{
+	__u8  LocalAddr[16];
+	__u8  RemoteAddr[16];
+	__u16 LocalPort; // host byte order
+	__u16 RemotePort;
+	__u8  Family; // AF_INET or AF_INET6
+	__u8  Direction;
+};
+
+// Key of the udp_flows map, has to be zeroed before it is filled in so the padding hashes the same
+struct WUdpFlowKey
+{
+	__u64 Cookie;
+	__u8  RemoteAddr[16];
+	__u16 RemotePort; // host byte order
+	__u8  Family;
+	__u8  Direction;
+	__u32 Padding;
+};
+
+// Per CPU, the daemon sums the values of all CPUs
+struct WUdpFlowValue
+{
+	__u64 Bytes;
+	__u64 Packets;
+};
+
+// Per CPU and keyed by cgroup id, see EBPFCgroups.h
+struct WCgroupTrafficValue
+{
+	__u64 UploadBytes;
+	__u64 DownloadBytes;
+};
+
+// Per CPU and indexed by EPacketDirection, see EBPFExclusions.h
+struct WExcludedTrafficValue
+{
+	__u64 Bytes;
+	__u64 Packets;
+};
+
 struct WSocketEventData
 {
 	union
@@ -158,9 +212,20 @@ struct WSocketEventData
 		struct WSocketBindEventData           SocketBindEventData;
 		struct WSocketAcceptEventData         SocketAcceptEventData;
 		struct WSocketCloseEventData          SocketCloseEventData;
+		struct WProcessEventData              ProcessEventData;
+		struct WUDPPeerEventData              UDPPeerEventData;
 	};
 };
 
+// DNS response received by a local socket, the answers are parsed by the daemon
+struct WDnsAnswerEvent
+{
+	__u64 Cookie;
+	__u16 Size;     // Valid bytes in Payload
+	__u8  Protocol; // IPPROTO_UDP or IPPROTO_TCP
+	__u8  Payload[DNS_PAYLOAD_SIZE]; // Starts at the DNS header, the TCP length prefix is skipped
+};
+
 struct WSocketEvent
 {
 	__u8  EventType; // enum ENetEventType
@@ -7,11 +7,14 @@
 
 #include <algorithm>
 #include <charconv>
+#include <chrono>
 #include <cstring>
 #include <fcntl.h>
 #include <fstream>
 #include <optional>
+#include <string_view>
 #include <sys/stat.h>
+#include <thread>
 #include <vector>
 
 #ifdef _WIN32
@@ -28,74 +31,182 @@ namespace
 {
 	constexpr uint32_t kIndexMagic = 0x41503249; // "IP2A" little endian
 	constexpr uint16_t kIndexVersion = 1;
+	constexpr unsigned kMaxParseThreads = 8;
 
 	int CmpIPv6(std::array<uint8_t, 16> const& A, std::array<uint8_t, 16> const& B)
 	{
 		return std::memcmp(A.data(), B.data(), A.size());
 	}
 
-} // namespace
-
-std::optional<WIP2AsnLookupResult> WIP2AsnDB::ReadEntryAtOffset(uint64_t Offset) const
-{
-	std::ifstream File(DatabasePath);
-	if (!File.is_open())
+	struct WParsedChunk
 	{
-		return std::nullopt;
-	}
-
-	File.seekg(static_cast<std::streamoff>(Offset));
+		std::vector<WIP2AsnIndexEntryV4> V4Entries{};
+		std::vector<WIP2AsnIndexEntryV6> V6Entries{};
+	};
 
-	std::string Line;
-	if (!std::getline(File, Line))
+	// Returns the address in host byte order, like WIPAddress::ToInt
+	bool ParseIPv4(std::string_view const Str, uint32_t& Out)
 	{
-		return std::nullopt;
-	}
+		auto const* Ptr = Str.data();
+		auto const* End = Str.data() + Str.size();
+		uint32_t    Address = 0;
+		for (int Octet = 0; Octet < 4; ++Octet)
+		{
+			if (Octet > 0)
+			{
+				if (Ptr == End || *Ptr != '.')
+				{
+					return false;
+				}
+				++Ptr;
+			}
 
-	std::istringstream  Iss(Line);
-	std::string         StartStr, EndStr, AsnStr;
-	WIP2AsnLookupResult Result{};
+			uint32_t Value = 0;
+			auto const [Next, Ec] = std::from_chars(Ptr, End, Value);
+			if (Ec != std::errc() || Value > 255)
+			{
+				return false;
+			}
+			Address = Address << 8 | Value;
+			Ptr = Next;
+		}
+		Out = Address;
+		return Ptr == End;
+	}
 
-	if (!std::getline(Iss, StartStr, '\t'))
+	bool ParseIPv6(std::string_view const Str, std::array<uint8_t, 16>& Out)
 	{
-		return std::nullopt;
+		// inet_pton needs a null terminated string, copy to the stack instead of allocating a std::string
+		std::array<char, 64> Buffer{};
+		if (Str.size() >= Buffer.size())
+		{
+			return false;
+		}
+		std::memcpy(Buffer.data(), Str.data(), Str.size());
+
+		in6_addr Address{};
+		if (inet_pton(AF_INET6, Buffer.data(), &Address) != 1)
+		{
+			return false;
+		}
+		std::memcpy(Out.data(), &Address, Out.size());
+		return true;
 	}
-	if (!std::getline(Iss, EndStr, '\t'))
+
+	// Parses all lines in Data, BaseOffset is the offset of Data in the TSV
+	void ParseChunk(std::string_view Data, uint64_t const BaseOffset, WParsedChunk& Out)
 	{
-		return std::nullopt;
+		// Roughly 60 bytes per line, most of which are IPv4 ranges
+		Out.V4Entries.reserve(Data.size() / 60);
+
+		uint64_t Offset = BaseOffset;
+		while (!Data.empty())
+		{
+			auto const LineEnd = Data.find('\n');
+			auto const Line = Data.substr(0, LineEnd);
+			auto const LineOffset = Offset;
+			auto const Consumed = LineEnd == std::string_view::npos ? Data.size() : LineEnd + 1;
+			Data.remove_prefix(Consumed);
+			Offset += Consumed;
+
+			auto const FirstTab = Line.find('\t');
+			auto const SecondTab = FirstTab == std::string_view::npos ? FirstTab : Line.find('\t', FirstTab + 1);
+			if (SecondTab == std::string_view::npos)
+			{
+				continue;
+			}
+
+			auto const StartStr = Line.substr(0, FirstTab);
+			auto const EndStr = Line.substr(FirstTab + 1, SecondTab - FirstTab - 1);
+			if (StartStr.find(':') == std::string_view::npos)
+			{
+				WIP2AsnIndexEntryV4 Entry{};
+				Entry.Offset = LineOffset;
+				if (ParseIPv4(StartStr, Entry.Start) && ParseIPv4(EndStr, Entry.End))
+				{
+					Out.V4Entries.push_back(Entry);
+				}
+			}
+			else
+			{
+				WIP2AsnIndexEntryV6 Entry{};
+				Entry.Offset = LineOffset;
+				if (ParseIPv6(StartStr, Entry.Start) && ParseIPv6(EndStr, Entry.End))
+				{
+					Out.V6Entries.push_back(Entry);
+				}
+			}
+		}
 	}
-	if (!std::getline(Iss, AsnStr, '\t'))
+
+	// start \t end \t asn \t country \t organization
+	std::optional<WIP2AsnLookupResult> ParseRecord(std::string_view Line)
 	{
-		return std::nullopt;
+		std::array<std::string_view, 5> Fields{};
+		for (std::size_t i = 0; i < Fields.size() - 1; ++i)
+		{
+			auto const Tab = Line.find('\t');
+			if (Tab == std::string_view::npos)
+			{
+				return std::nullopt;
+			}
+			Fields[i] = Line.substr(0, Tab);
+			Line.remove_prefix(Tab + 1);
+		}
+		Fields.back() = Line;
+
+		WIP2AsnLookupResult Result{};
+		auto [Ptr, Ec] = std::from_chars(Fields[2].data(), Fields[2].data() + Fields[2].size(), Result.ASN);
+		if (Ec != std::errc())
+		{
+			Result.ASN = 0;
+		}
+		Result.Country = std::string(Fields[3]);
+		Result.Organization = std::string(Fields[4]);
+		return Result;
 	}
-	if (!std::getline(Iss, Result.Country, '\t'))
+
+} // namespace
+
+std::optional<WIP2AsnLookupResult> WIP2AsnDB::ReadEntryAtOffset(uint64_t Offset) const
+{
+#ifdef _WIN32
+	std::ifstream File(DatabasePath);
+	if (!File.is_open())
 	{
 		return std::nullopt;
 	}
 
-	if (!std::getline(Iss, Result.Organization))
+	File.seekg(static_cast<std::streamoff>(Offset));
+
+	std::string Line;
+	if (!std::getline(File, Line))
 	{
 		return std::nullopt;
 	}
-
-	auto [Ptr, Ec] = std::from_chars(AsnStr.data(), AsnStr.data() + AsnStr.size(), Result.ASN);
-	if (Ec != std::errc())
+	return ParseRecord(Line);
+#else
+	if (!TSVMapping || Offset >= TSVMappingSize)
 	{
-		Result.ASN = 0;
+		return std::nullopt;
 	}
 
-	return Result;
+	std::string_view const Data(static_cast<char const*>(TSVMapping) + Offset, TSVMappingSize - Offset);
+	return ParseRecord(Data.substr(0, Data.find('\n')));
+#endif
 }
 
 WIP2AsnDB::WIP2AsnDB(std::filesystem::path Path) : DatabasePath(std::move(Path))
 {
-	IndexPath = DatabasePath;
-	IndexPath += ".idx";
+	IndexPath = GetIndexPath(DatabasePath);
 }
 
 WIP2AsnDB::~WIP2AsnDB()
 {
 	UnmapIndex();
+#ifndef _WIN32
+	UnmapTSV();
+#endif
 }
 
 bool WIP2AsnDB::Init()
@@ -106,6 +217,7 @@ bool WIP2AsnDB::Init()
 		return false;
 	}
 
+	bool bIndexValid = false;
 	if (std::filesystem::exists(IndexPath))
 	{
 		if (MapIndex())
@@ -113,80 +225,160 @@ bool WIP2AsnDB::Init()
 			if (IndexView.Header && IndexView.Header->Magic == kIndexMagic && IndexView.Header->Version == kIndexVersion
 				&& IndexView.Header->TSVSize == std::filesystem::file_size(DatabasePath))
 			{
-				return true;
+				bIndexValid = true;
+			}
+			else
+			{
+				spdlog::warn("Existing IP2ASN index is stale or invalid, rebuilding");
 			}
-			spdlog::warn("Existing IP2ASN index is stale or invalid, rebuilding");
 		}
+	}
+
+	if (!bIndexValid)
+	{
 		UnmapIndex();
-		std::filesystem::remove(IndexPath);
+		auto TempIndexPath = IndexPath;
+		TempIndexPath += ".tmp";
+		std::error_code Error;
+		if (!BuildIndex(DatabasePath, TempIndexPath))
+		{
+			std::filesystem::remove(TempIndexPath, Error);
+			return false;
+		}
+		std::filesystem::rename(TempIndexPath, IndexPath, Error);
+		if (Error)
+		{
+			spdlog::error("Failed to move IP2ASN index to {}: {}", IndexPath.string(), Error.message());
+			return false;
+		}
+		if (!MapIndex())
+		{
+			return false;
+		}
 	}
 
-	return BuildIndex() && MapIndex();
+#ifdef _WIN32
+	return true;
+#else
+	return MapTSV();
+#endif
 }
 
-bool WIP2AsnDB::BuildIndex() const
+bool WIP2AsnDB::BuildIndex(std::filesystem::path const& TSVPath, std::filesystem::path const& IndexOutPath)
 {
-	std::ifstream File(DatabasePath);
+	auto const StartTime = std::chrono::steady_clock::now();
+
+#ifdef _WIN32
+	std::ifstream File(TSVPath, std::ios::binary);
 	if (!File.is_open())
 	{
-		spdlog::error("Failed to open IP2ASN TSV at {}", DatabasePath.string());
+		spdlog::error("Failed to open IP2ASN TSV at {}", TSVPath.string());
+		return false;
+	}
+	std::string const Contents((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+	std::string_view const Data(Contents);
+#else
+	int const Fd = open(TSVPath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (Fd < 0)
+	{
+		spdlog::error("Failed to open IP2ASN TSV at {}", TSVPath.string());
 		return false;
 	}
 
-	std::vector<WIP2AsnIndexEntryV4> V4Entries;
-	std::vector<WIP2AsnIndexEntryV6> V6Entries;
-	V4Entries.reserve(650000);
-	V6Entries.reserve(100000);
+	struct stat st{};
+	if (fstat(Fd, &st) != 0)
+	{
+		spdlog::error("Failed to stat IP2ASN TSV at {}", TSVPath.string());
+		close(Fd);
+		return false;
+	}
 
-	std::string Line;
-	while (File)
+	auto const MappingSize = static_cast<size_t>(st.st_size);
+	void*      Mapping = MappingSize > 0 ? mmap(nullptr, MappingSize, PROT_READ, MAP_PRIVATE, Fd, 0) : nullptr;
+	close(Fd);
+	if (Mapping == MAP_FAILED)
 	{
-		// ReSharper disable once CppRedundantCastExpression
-		uint64_t Offset = static_cast<uint64_t>(File.tellg());
-		if (!std::getline(File, Line))
+		spdlog::error("Failed to mmap IP2ASN TSV at {}", TSVPath.string());
+		return false;
+	}
+	if (Mapping)
+	{
+		madvise(Mapping, MappingSize, MADV_SEQUENTIAL);
+	}
+	std::string_view const Data(static_cast<char const*>(Mapping), MappingSize);
+#endif
+
+	// Split the file into one chunk per thread, every chunk starts at the beginning of a line
+	auto const ThreadCount = std::clamp(std::thread::hardware_concurrency(), 1u, kMaxParseThreads);
+	std::vector<std::size_t> ChunkStarts{ 0 };
+	for (unsigned i = 1; i < ThreadCount; ++i)
+	{
+		auto const Start = std::max(Data.size() / ThreadCount * i, ChunkStarts.back());
+		auto const LineEnd = Data.find('\n', Start);
+		if (LineEnd == std::string_view::npos)
 		{
 			break;
 		}
+		ChunkStarts.push_back(LineEnd + 1);
+	}
+	ChunkStarts.push_back(Data.size());
 
-		if (Line.empty())
+	std::vector<WParsedChunk> Chunks(ChunkStarts.size() - 1);
+	{
+		std::vector<std::thread> Workers{};
+		for (std::size_t i = 1; i < Chunks.size(); ++i)
 		{
-			continue;
+			Workers.emplace_back([&, i] {
+				ParseChunk(Data.substr(ChunkStarts[i], ChunkStarts[i + 1] - ChunkStarts[i]), ChunkStarts[i], Chunks[i]);
+			});
 		}
-
-		size_t FirstTab = Line.find('\t');
-		size_t SecondTab = FirstTab == std::string::npos ? std::string::npos : Line.find('\t', FirstTab + 1);
-		if (FirstTab == std::string::npos || SecondTab == std::string::npos)
+		ParseChunk(Data.substr(0, ChunkStarts[1]), 0, Chunks[0]);
+		for (auto& Worker : Workers)
 		{
-			continue;
+			Worker.join();
 		}
+	}
 
-		auto Start = WIPAddress::FromString(Line.substr(0, FirstTab));
-		auto End = WIPAddress::FromString(Line.substr(FirstTab + 1, SecondTab - FirstTab - 1));
-		if (!Start || !End)
-		{
-			continue;
-		}
+#ifndef _WIN32
+	if (Mapping)
+	{
+		munmap(Mapping, MappingSize);
+	}
+#endif
 
-		if (Start->Family == EIPFamily::IPv4)
-		{
-			WIP2AsnIndexEntryV4 Entry{};
-			Entry.Start = Start->ToInt();
-			Entry.End = End->ToInt();
-			Entry.Offset = Offset;
-			V4Entries.push_back(Entry);
-		}
-		else
-		{
-			WIP2AsnIndexEntryV6 Entry{};
-			Entry.Start = Start->Bytes;
-			Entry.End = End->Bytes;
-			Entry.Offset = Offset;
-			V6Entries.push_back(Entry);
-		}
+	std::size_t ParseMemory = 0;
+	std::size_t CountV4 = 0;
+	std::size_t CountV6 = 0;
+	for (auto const& Chunk : Chunks)
+	{
+		ParseMemory += Chunk.V4Entries.capacity() * sizeof(WIP2AsnIndexEntryV4)
+			+ Chunk.V6Entries.capacity() * sizeof(WIP2AsnIndexEntryV6);
+		CountV4 += Chunk.V4Entries.size();
+		CountV6 += Chunk.V6Entries.size();
 	}
 
-	std::ranges::sort(V4Entries, [](auto const& A, auto const& B) { return A.Start < B.Start; });
-	std::ranges::sort(V6Entries, [](auto const& A, auto const& B) { return CmpIPv6(A.Start, B.Start) < 0; });
+	std::vector<WIP2AsnIndexEntryV4> V4Entries;
+	std::vector<WIP2AsnIndexEntryV6> V6Entries;
+	V4Entries.reserve(CountV4);
+	V6Entries.reserve(CountV6);
+	for (auto& Chunk : Chunks)
+	{
+		V4Entries.insert(V4Entries.end(), Chunk.V4Entries.begin(), Chunk.V4Entries.end());
+		V6Entries.insert(V6Entries.end(), Chunk.V6Entries.begin(), Chunk.V6Entries.end());
+		Chunk = {};
+	}
+
+	// The published database is sorted already, so this is usually just a linear check
+	auto const V4Less = [](auto const& A, auto const& B) { return A.Start < B.Start; };
+	auto const V6Less = [](auto const& A, auto const& B) { return CmpIPv6(A.Start, B.Start) < 0; };
+	if (!std::ranges::is_sorted(V4Entries, V4Less))
+	{
+		std::ranges::sort(V4Entries, V4Less);
+	}
+	if (!std::ranges::is_sorted(V6Entries, V6Less))
+	{
+		std::ranges::sort(V6Entries, V6Less);
+	}
 
 	WIP2AsnIndexHeader Header{};
 	Header.Magic = kIndexMagic;
@@ -195,12 +387,12 @@ bool WIP2AsnDB::BuildIndex() const
 	Header.EntrySizeV6 = static_cast<uint16_t>(sizeof(WIP2AsnIndexEntryV6));
 	Header.CountV4 = V4Entries.size();
 	Header.CountV6 = V6Entries.size();
-	Header.TSVSize = std::filesystem::file_size(DatabasePath);
+	Header.TSVSize = Data.size();
 
-	std::ofstream Out(IndexPath, std::ios::binary | std::ios::trunc);
+	std::ofstream Out(IndexOutPath, std::ios::binary | std::ios::trunc);
 	if (!Out.is_open())
 	{
-		spdlog::error("Failed to create IP2ASN index at {}", IndexPath.string());
+		spdlog::error("Failed to create IP2ASN index at {}", IndexOutPath.string());
 		return false;
 	}
 
@@ -215,17 +407,71 @@ bool WIP2AsnDB::BuildIndex() const
 		Out.write(reinterpret_cast<char*>(V6Entries.data()),
 			static_cast<long int>(V6Entries.size() * sizeof(WIP2AsnIndexEntryV6)));
 	}
+	Out.flush();
 
 	if (!Out.good())
 	{
-		spdlog::error("Failed to write IP2ASN index at {}", IndexPath.string());
+		spdlog::error("Failed to write IP2ASN index at {}", IndexOutPath.string());
 		return false;
 	}
 
-	spdlog::info("Built IP2ASN index: {} IPv4 entries, {} IPv6 entries", Header.CountV4, Header.CountV6);
+	auto const Elapsed =
+		std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - StartTime);
+	spdlog::info("Built IP2ASN index: {} IPv4 entries, {} IPv6 entries in {} ms using {} threads "
+				 "(parse buffers: {} KiB, index: {} KiB)",
+		Header.CountV4, Header.CountV6, Elapsed.count(), Chunks.size(), ParseMemory / 1024,
+		(sizeof(Header) + V4Entries.size() * sizeof(WIP2AsnIndexEntryV4)
+			+ V6Entries.size() * sizeof(WIP2AsnIndexEntryV6))
+			/ 1024);
 	return true;
 }
 
+#ifndef _WIN32
+bool WIP2AsnDB::MapTSV()
+{
+	UnmapTSV();
+
+	int const Fd = open(DatabasePath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (Fd < 0)
+	{
+		spdlog::error("Failed to open IP2ASN TSV at {}", DatabasePath.string());
+		return false;
+	}
+
+	struct stat st{};
+	if (fstat(Fd, &st) != 0 || st.st_size <= 0)
+	{
+		spdlog::error("Failed to stat IP2ASN TSV at {}", DatabasePath.string());
+		close(Fd);
+		return false;
+	}
+
+	// The mapping keeps the file alive after the fd is closed, even if it is replaced on disk
+	TSVMappingSize = static_cast<size_t>(st.st_size);
+	TSVMapping = mmap(nullptr, TSVMappingSize, PROT_READ, MAP_PRIVATE, Fd, 0);
+	close(Fd);
+	if (TSVMapping == MAP_FAILED)
+	{
+		spdlog::error("Failed to mmap IP2ASN TSV at {}", DatabasePath.string());
+		TSVMapping = nullptr;
+		TSVMappingSize = 0;
+		return false;
+	}
+	madvise(TSVMapping, TSVMappingSize, MADV_RANDOM);
+	return true;
+}
+
+void WIP2AsnDB::UnmapTSV()
+{
+	if (TSVMapping)
+	{
+		munmap(TSVMapping, TSVMappingSize);
+		TSVMapping = nullptr;
+		TSVMappingSize = 0;
+	}
+}
+#endif
+
 bool WIP2AsnDB::MapIndex()
 {
 	UnmapIndex();
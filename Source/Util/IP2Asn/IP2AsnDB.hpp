@@ -92,11 +92,18 @@ class WIP2AsnDB
 #ifdef _WIN32
 	HANDLE IndexFileHandle = INVALID_HANDLE_VALUE;
 	HANDLE IndexMappingHandle = nullptr;
+#else
+	// Records are read from a mapping of the TSV, so the files can be replaced
+	// by an update while lookups on this instance are still running
+	void*  TSVMapping{ nullptr };
+	size_t TSVMappingSize{ 0 };
+
+	bool MapTSV();
+	void UnmapTSV();
 #endif
 
 	[[nodiscard]] std::optional<WIP2AsnLookupResult> ReadEntryAtOffset(uint64_t offset) const;
 
-	[[nodiscard]] bool BuildIndex() const;
 	bool MapIndex();
 	void UnmapIndex();
 
@@ -107,8 +114,16 @@ public:
 	explicit WIP2AsnDB(std::filesystem::path Path);
 	~WIP2AsnDB();
 
+	WIP2AsnDB(WIP2AsnDB const&) = delete;
+	WIP2AsnDB& operator=(WIP2AsnDB const&) = delete;
+
 	bool Init();
 
+	// Parses the TSV in parallel chunks and writes the index for it to IndexOutPath
+	static bool BuildIndex(std::filesystem::path const& TSVPath, std::filesystem::path const& IndexOutPath);
+
+	static std::filesystem::path GetIndexPath(std::filesystem::path TSVPath) { return TSVPath += ".idx"; }
+
 	[[nodiscard]] std::optional<WIP2AsnLookupResult> Lookup(WIPAddress const& IP) const;
 
 	[[nodiscard]] std::size_t GetSize() const;
@@ -15,10 +15,12 @@ struct WMemoryStatEntry
 {
 	std::string Name;
 	WBytes      Usage;
+	bool        bComparison{}; // Not in use, e.g. what a different layout would need. Not part of any total
+
 	template <class Archive>
 	void serialize(Archive& Ar)
 	{
-		Ar(Name, Usage);
+		Ar(Name, Usage, bComparison);
 	}
 };
 
@@ -18,7 +18,7 @@ enum EMessageType : int8_t
 	MT_Invalid = -1,
 	MT_TrafficTree,
 	MT_TrafficTreeUpdate,
-	MT_AppIconAtlasData,
+	MT_AppIconAtlasDelta,
 	MT_RuleUpdate,
 	MT_Handshake,
 	MT_ConnectionHistory,
@@ -35,6 +35,12 @@ enum EMessageType : int8_t
 	MT_IPLookupResponse,
 	MT_DaemonConfig,
 	MT_DaemonLog,
+	MT_PeerPageRequest,
+	MT_PeerPage,
+	MT_PipelineMetrics,
+	MT_TrafficTreeChunk,
+	MT_ClientHandshake,
+	MT_SyncVersion,
 
 	MT_Count
 };
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2026, Alex <uni@vrsal.cc>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Types.hpp"
+
+// Log-linear buckets like an HDR histogram: every power of two is split into eight linear sub-buckets,
+// so a recorded value is never off by more than 12.5% and the whole 64 bit range fits into 496 buckets
+namespace WHistogramBuckets
+{
+	constexpr uint32_t    SubBucketBits = 3;
+	constexpr uint32_t    SubBucketCount = 1u << SubBucketBits;
+	constexpr std::size_t Count = (64 - SubBucketBits + 1) * SubBucketCount;
+
+	constexpr std::size_t GetIndex(uint64_t const Value)
+	{
+		if (Value < SubBucketCount)
+		{
+			return static_cast<std::size_t>(Value);
+		}
+		auto const Shift = static_cast<uint32_t>(std::bit_width(Value)) - 1 - SubBucketBits;
+		return (Shift + 1) * SubBucketCount + ((Value >> Shift) & (SubBucketCount - 1));
+	}
+
+	constexpr uint64_t GetLowerBound(std::size_t const Index)
+	{
+		if (Index < SubBucketCount)
+		{
+			return Index;
+		}
+		return (SubBucketCount + Index % SubBucketCount) << (Index / SubBucketCount - 1);
+	}
+
+	constexpr uint64_t GetUpperBound(std::size_t const Index)
+	{
+		return Index + 1 < Count ? GetLowerBound(Index + 1) - 1 : UINT64_MAX;
+	}
+} // namespace WHistogramBuckets
+
+// Values are in nanoseconds, counts only ever grow so the difference of two snapshots
+// describes what happened in between
+struct WLatencyHistogram
+{
+	std::string           Name{};
+	std::vector<uint64_t> Buckets{};
+	uint64_t              Count{};
+	uint64_t              Sum{};
+	uint64_t              Max{};
+
+	void Record(uint64_t const Value)
+	{
+		if (Buckets.empty())
+		{
+			Buckets.resize(WHistogramBuckets::Count);
+		}
+		++Buckets[WHistogramBuckets::GetIndex(Value)];
+		++Count;
+		Sum += Value;
+		Max = std::max(Max, Value);
+	}
+
+	[[nodiscard]] double GetMean() const
+	{
+		return Count > 0 ? static_cast<double>(Sum) / static_cast<double>(Count) : 0.0;
+	}
+
+	// Upper bound of the bucket the percentile falls into, Percentile is in [0, 1]
+	[[nodiscard]] uint64_t GetPercentile(double const Percentile) const
+	{
+		if (Count == 0)
+		{
+			return 0;
+		}
+		auto const Target = std::max<uint64_t>(1, static_cast<uint64_t>(Percentile * static_cast<double>(Count)));
+		uint64_t   Seen = 0;
+		for (std::size_t i = 0; i < Buckets.size(); ++i)
+		{
+			Seen += Buckets[i];
+			if (Seen >= Target)
+			{
+				return std::min(WHistogramBuckets::GetUpperBound(i), Max);
+			}
+		}
+		return Max;
+	}
+
+	// What was recorded since Previous was taken, Max can't be subtracted and stays the all-time value
+	[[nodiscard]] WLatencyHistogram Since(WLatencyHistogram const& Previous) const
+	{
+		if (Previous.Count > Count || Previous.Buckets.size() != Buckets.size())
+		{
+			return *this;
+		}
+		WLatencyHistogram Result{ Name, Buckets, Count - Previous.Count, Sum - Previous.Sum, Max };
+		for (std::size_t i = 0; i < Buckets.size(); ++i)
+		{
+			Result.Buckets[i] -= std::min(Previous.Buckets[i], Buckets[i]);
+		}
+		return Result;
+	}
+
+	// Most buckets are empty, so only the used ones go over the wire
+	template <class Archive>
+	void save(Archive& Ar) const
+	{
+		std::vector<uint16_t> Indices{};
+		std::vector<uint64_t> Counts{};
+		for (std::size_t i = 0; i < Buckets.size(); ++i)
+		{
+			if (Buckets[i] > 0)
+			{
+				Indices.push_back(static_cast<uint16_t>(i));
+				Counts.push_back(Buckets[i]);
+			}
+		}
+		Ar(Name, Count, Sum, Max, Indices, Counts);
+	}
+
+	template <class Archive>
+	void load(Archive& Ar)
+	{
+		std::vector<uint16_t> Indices{};
+		std::vector<uint64_t> Counts{};
+		Ar(Name, Count, Sum, Max, Indices, Counts);
+		Buckets.assign(WHistogramBuckets::Count, 0);
+		for (std::size_t i = 0; i < std::min(Indices.size(), Counts.size()); ++i)
+		{
+			if (Indices[i] < Buckets.size())
+			{
+				Buckets[Indices[i]] = Counts[i];
+			}
+		}
+	}
+};
+
+struct WPipelineEventCount
+{
+	std::string Name{};
+	uint64_t    Total{};
+
+	template <class Archive>
+	void serialize(Archive& Ar)
+	{
+		Ar(Name, Total);
+	}
+};
+
+struct WClientSendBacklog
+{
+	std::string Name{};
+	WBytes      Backlog{}; // Queued but not yet written to the client
+
+	template <class Archive>
+	void serialize(Archive& Ar)
+	{
+		Ar(Name, Backlog);
+	}
+};
+
+// Everything except the queue depth and the client backlog is a running total since the daemon started,
+// clients compute rates and recent percentiles from two consecutive messages
+struct WPipelineMetrics
+{
+	WMsec                            Timestamp{}; // Monotonic, only meaningful relative to another message
+	std::vector<WPipelineEventCount> Events{};
+	uint64_t                         RingDrops{};
+	uint64_t                         QueueDepth{};
+	uint64_t                         PeakQueueDepth{}; // Since the previous message
+	std::vector<WLatencyHistogram>   Histograms{};
+	std::vector<WClientSendBacklog>  Clients{};
+
+	template <class Archive>
+	void serialize(Archive& Ar)
+	{
+		Ar(Timestamp, Events, RingDrops, QueueDepth, PeakQueueDepth, Histograms, Clients);
+	}
+};
@@ -4,42 +4,157 @@
  */
 
 #pragma once
+#include <cassert>
 #include <functional>
 #include <memory>
 #include <mutex>
-#include <condition_variable>
+#include <optional>
+#include <type_traits>
+#include <vector>
 
+// Runs tasks somewhere else, e.g. on a worker pool
+class IExecutor
+{
+public:
+	virtual ~IExecutor() = default;
+
+	virtual void Post(std::function<void()> Task) = 0;
+};
+
+/**
+ * Result of an operation that finishes on another thread. Neither side ever waits for the other:
+ * if Finish comes first the result is kept until a continuation is attached with Then,
+ * otherwise the continuation runs as soon as the result arrives.
+ * Copies share the same state. Only the first Finish counts and there is a single continuation.
+ */
 template <typename T>
 class TPromise
 {
+public:
+	using WValue = std::remove_cvref_t<T>;
+
+private:
 	struct WSharedState
 	{
-		std::function<void(T)>  Callback;
-		std::mutex              Mutex;
-		std::condition_variable CV;
-		bool                    Ready = false;
+		std::mutex             Mutex;
+		std::optional<WValue>  Value{};
+		std::function<void(T)> Callback{};
+		IExecutor*             Executor{};
 	};
 
 	std::shared_ptr<WSharedState> SharedState;
 
+	static void Run(std::function<void(T)> Callback, IExecutor* Executor, WValue const& Value)
+	{
+		if (Executor)
+		{
+			Executor->Post([Callback = std::move(Callback), Value] { Callback(Value); });
+		}
+		else
+		{
+			Callback(Value);
+		}
+	}
+
 public:
 	TPromise() { SharedState = std::make_shared<WSharedState>(); }
 	virtual ~TPromise() = default;
 
-	void Finish(T const& Result) const
+	void Finish(WValue const& Result) const
 	{
-		std::unique_lock Lock(SharedState->Mutex);
-		SharedState->CV.wait(Lock, [this] { return SharedState->Ready; });
-		SharedState->Callback(Result);
+		std::function<void(T)> Callback{};
+		IExecutor*             Executor{};
+		{
+			std::scoped_lock Lock(SharedState->Mutex);
+			if (SharedState->Value)
+			{
+				return;
+			}
+			SharedState->Value.emplace(Result);
+			if (!SharedState->Callback)
+			{
+				return;
+			}
+			Callback = std::move(SharedState->Callback);
+			Executor = SharedState->Executor;
+		}
+		Run(std::move(Callback), Executor, Result);
 	}
 
-	void Then(std::function<void(T)> Callback)
+	// Runs on the thread that finishes the promise, or right away if it's finished already
+	void Then(std::function<void(T)> Callback) const { Then(nullptr, std::move(Callback)); }
+
+	// Runs on the executor instead, which has to outlive the promise
+	void Then(IExecutor& Executor, std::function<void(T)> Callback) const { Then(&Executor, std::move(Callback)); }
+
+	void Then(IExecutor* Executor, std::function<void(T)> Callback) const
 	{
 		{
 			std::scoped_lock Lock(SharedState->Mutex);
-			SharedState->Callback = Callback;
-			SharedState->Ready = true;
+			assert(!SharedState->Callback && "Promise already has a continuation");
+			if (!SharedState->Value)
+			{
+				SharedState->Callback = std::move(Callback);
+				SharedState->Executor = Executor;
+				return;
+			}
 		}
-		SharedState->CV.notify_one();
+		// The value isn't touched anymore once it's set, so it can be read without the lock
+		Run(std::move(Callback), Executor, *SharedState->Value);
+	}
+
+	[[nodiscard]] bool IsFinished() const
+	{
+		std::scoped_lock Lock(SharedState->Mutex);
+		return SharedState->Value.has_value();
+	}
+};
+
+// Finishes once all promises are finished, with their results in the same order. Nothing waits for the promises:
+// the last one to finish also finishes the combined promise, on the executor if one is given
+template <typename T>
+TPromise<std::vector<typename TPromise<T>::WValue> const&> WhenAll(
+	std::vector<TPromise<T>> const& Promises, IExecutor* Executor = nullptr)
+{
+	using WValue = typename TPromise<T>::WValue;
+
+	struct WAllState
+	{
+		std::mutex                           Mutex;
+		std::vector<std::optional<WValue>>   Results{};
+		std::size_t                          Remaining{};
+		TPromise<std::vector<WValue> const&> Promise{};
+	};
+
+	auto State = std::make_shared<WAllState>();
+	State->Results.resize(Promises.size());
+	State->Remaining = Promises.size();
+	auto Result = State->Promise;
+	if (Promises.empty())
+	{
+		Result.Finish({});
+		return Result;
+	}
+
+	for (std::size_t i = 0; i < Promises.size(); ++i)
+	{
+		Promises[i].Then(Executor, [State, i](T Value) {
+			std::vector<WValue> All{};
+			{
+				std::scoped_lock Lock(State->Mutex);
+				State->Results[i].emplace(Value);
+				if (--State->Remaining > 0)
+				{
+					return;
+				}
+				All.reserve(State->Results.size());
+				for (auto& Entry : State->Results)
+				{
+					All.push_back(std::move(*Entry));
+				}
+			}
+			State->Promise.Finish(All);
+		});
 	}
-};
\ No newline at end of file
+	return Result;
+}
@@ -91,6 +91,10 @@ public:
 
 	ssize_t ReceiveRaw(void* Buffer, size_t Capacity);
 
+	// For sockets that are polled from somewhere else instead of the listen thread, call once the socket is readable.
+	// Reads once and emits OnData for every complete frame, returns false if the connection was closed
+	bool ReceiveAvailable();
+
 	template <typename T>
 	ssize_t SendMessage(T const& Message)
 	{